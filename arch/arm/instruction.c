@@ -2,6 +2,7 @@
 #include "jit/instruction.h"
 #include "jit/vars.h"
 #include "jit/lir-printer.h"
+#include "jit/ssa.h"
 #include "arch/registers.h"
 
 
@@ -57,7 +58,7 @@ int insn_defs(struct compilation_unit *cu, struct insn *insn, struct var_info **
 	return nr;
 }
 
-int insn_uses(struct insn *insn, struct var_info **uses)
+int insn_uses(struct compilation_unit *cu, struct insn *insn, struct var_info **uses)
 {
 	unsigned long flags;
 	int nr = 0;
@@ -308,3 +309,24 @@ bool insn_is_mov_imm_reg(struct insn *insn)
 
 	return false;
 }
+
+void ssa_classify_insn(struct compilation_unit *cu, struct basic_block *bb,
+		       struct insn *insn, struct ssa_insn_info *info)
+{
+	assert(!"not implemented");
+}
+
+int ssa_remove_array_check(struct compilation_unit *cu, struct basic_block *bb,
+			   struct insn *insn)
+{
+	assert(!"not implemented");
+
+	return -1;
+}
+
+struct insn *ssa_const_insn(struct var_info *var, long imm)
+{
+	assert(!"not implemented");
+
+	return NULL;
+}
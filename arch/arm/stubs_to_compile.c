@@ -26,6 +26,11 @@ void *emit_ic_check(struct buffer *buf)
 	assert(!"not implemented");
 }
 
+void *emit_patchable_entry(struct buffer *buf)
+{
+	assert(!"not implemented");
+}
+
 void emit_ic_miss_handler(struct buffer *buf, void *ic_check,
 				struct vm_method *vmm)
 {
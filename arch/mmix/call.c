@@ -24,9 +24,15 @@
  * Please refer to the file LICENSE for details.
  */
 
+#include "jit/exception.h"
+
 #include "vm/method.h"
 #include "vm/call.h"
 
 void native_call(struct vm_method *method, void *target, unsigned long *args, union jvalue *result)
 {
 }
+
+void exception_return(void)
+{
+}
@@ -118,4 +118,9 @@ static inline bool insn_is_call(struct insn *insn)
 	return false;
 }
 
+static inline bool insn_is_copy(struct insn *insn)
+{
+	return false;
+}
+
 #endif /* __ARCH_INSTRUCTION_H */
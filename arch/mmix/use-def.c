@@ -45,7 +45,7 @@ int insn_defs(struct compilation_unit *cu, struct insn *insn, struct var_info **
 	return nr;
 }
 
-int insn_uses(struct insn *insn, struct var_info **uses)
+int insn_uses(struct compilation_unit *cu, struct insn *insn, struct var_info **uses)
 {
 	struct insn_info *info;
 	int nr = 0;
@@ -127,6 +127,15 @@ void fixup_direct_calls(struct jit_trampoline *trampoline, unsigned long target)
 {
 }
 
+void retarget_direct_calls(struct jit_trampoline *from, struct jit_trampoline *to)
+{
+}
+
+void fixup_entry_point(void *entry, void *target)
+{
+	assert(!"not implemented");
+}
+
 void emit_unlock(struct buffer *buffer, struct vm_object *vo)
 {
 	assert(!"not implemented");
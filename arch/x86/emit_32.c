@@ -242,11 +242,8 @@ static void __emit_branch(struct buffer *buf, struct basic_block *bb,
 		insn->flags |= INSN_FLAG_BACKPATCH_RESOLUTION;
 		insn->operand.resolution_block = &bb->resolution_blocks[idx];
 	} else if (target_bb->is_emitted) {
-		struct insn *target_insn =
-		    list_first_entry(&target_bb->insn_list, struct insn,
-			       insn_list_node);
-
-		addr = branch_rel_addr(insn, target_insn->mach_offset);
+		/* The peephole optimizer can leave a basic block empty. */
+		addr = branch_rel_addr(insn, target_bb->mach_offset);
 	} else
 		insn->flags |= INSN_FLAG_BACKPATCH_BRANCH;
 
@@ -1018,6 +1015,29 @@ void emit_unlock_this(struct buffer *buf, unsigned long frame_size)
 	__emit_pop_reg(buf, MACH_REG_EAX);
 }
 
+/*
+ * Emits an 8-byte aligned 5-byte nop that fixup_entry_point() can replace
+ * with a jump. Returns the address of the nop.
+ */
+void *emit_patchable_entry(struct buffer *buf)
+{
+	void *entry;
+
+	while ((unsigned long) buffer_current(buf) & 7)
+		emit(buf, 0x90);
+
+	entry = buffer_current(buf);
+
+	/* nopl 0x0(%eax,%eax,1) */
+	emit(buf, 0x0f);
+	emit(buf, 0x1f);
+	emit(buf, 0x44);
+	emit(buf, 0x00);
+	emit(buf, 0x00);
+
+	return entry;
+}
+
 void *emit_ic_check(struct buffer *buf)
 {
 	void *jne_addr;
@@ -1210,10 +1230,18 @@ static emit_fn_t emitters[] = {
 	DECL_EMITTER(INSN_ADDSS_XMM_XMM, insn_encode),
 	DECL_EMITTER(INSN_ADD_IMM_REG, insn_encode),
 	DECL_EMITTER(INSN_ADD_REG_REG, insn_encode),
+	DECL_EMITTER(INSN_ANDPD_XMM_XMM, insn_encode),
+	DECL_EMITTER(INSN_ANDPS_XMM_XMM, insn_encode),
 	DECL_EMITTER(INSN_AND_REG_REG, insn_encode),
+	DECL_EMITTER(INSN_BSF_REG_REG, insn_encode),
+	DECL_EMITTER(INSN_BSR_REG_REG, insn_encode),
+	DECL_EMITTER(INSN_BSWAP_REG, insn_encode),
 	DECL_EMITTER(INSN_CALL_REG, insn_encode),
 	DECL_EMITTER(INSN_CALL_REL, emit_call),
 	DECL_EMITTER(INSN_CLTD_REG_REG, insn_encode),
+	DECL_EMITTER(INSN_CMOVE_REG_REG, insn_encode),
+	DECL_EMITTER(INSN_CMOVG_REG_REG, insn_encode),
+	DECL_EMITTER(INSN_CMOVL_REG_REG, insn_encode),
 	DECL_EMITTER(INSN_DIVSD_XMM_XMM, insn_encode),
 	DECL_EMITTER(INSN_DIVSS_XMM_XMM, insn_encode),
 	DECL_EMITTER(INSN_FLD_64_MEMLOCAL, insn_encode),
@@ -1229,6 +1257,8 @@ static emit_fn_t emitters[] = {
 	DECL_EMITTER(INSN_JMP_MEMBASE, insn_encode),
 	DECL_EMITTER(INSN_JMP_MEMINDEX, insn_encode),
 	DECL_EMITTER(INSN_JNE_BRANCH, emit_jne_branch),
+	DECL_EMITTER(INSN_LZCNT_REG_REG, insn_encode),
+	DECL_EMITTER(INSN_MOVD_XMM_REG, insn_encode),
 	DECL_EMITTER(INSN_MOVSD_MEMBASE_XMM, insn_encode),
 	DECL_EMITTER(INSN_MOVSD_MEMDISP_XMM, insn_encode),
 	DECL_EMITTER(INSN_MOVSD_MEMLOCAL_XMM, insn_encode),
@@ -1259,19 +1289,24 @@ static emit_fn_t emitters[] = {
 	DECL_EMITTER(INSN_NEG_REG, insn_encode),
 	DECL_EMITTER(INSN_NOP, insn_encode),
 	DECL_EMITTER(INSN_OR_REG_REG, insn_encode),
+	DECL_EMITTER(INSN_POPCNT_REG_REG, insn_encode),
 	DECL_EMITTER(INSN_POP_MEMLOCAL, insn_encode),
 	DECL_EMITTER(INSN_POP_REG, insn_encode),
 	DECL_EMITTER(INSN_PUSH_MEMLOCAL, insn_encode),
 	DECL_EMITTER(INSN_PUSH_REG, insn_encode),
 	DECL_EMITTER(INSN_RET, insn_encode),
+	DECL_EMITTER(INSN_ROL_IMM_REG, insn_encode),
+	DECL_EMITTER(INSN_ROR_IMM_REG, insn_encode),
 	DECL_EMITTER(INSN_SAR_IMM_REG, insn_encode),
 	DECL_EMITTER(INSN_SAR_REG_REG, insn_encode),
 	DECL_EMITTER(INSN_SHL_REG_REG, insn_encode),
 	DECL_EMITTER(INSN_SHR_REG_REG, insn_encode),
+	DECL_EMITTER(INSN_SQRTSD_XMM_XMM, insn_encode),
 	DECL_EMITTER(INSN_SUBSD_XMM_XMM, insn_encode),
 	DECL_EMITTER(INSN_SUBSS_XMM_XMM, insn_encode),
 	DECL_EMITTER(INSN_SUB_IMM_REG, insn_encode),
 	DECL_EMITTER(INSN_SUB_REG_REG, insn_encode),
+	DECL_EMITTER(INSN_TZCNT_REG_REG, insn_encode),
 	DECL_EMITTER(INSN_XORPD_XMM_XMM, insn_encode),
 	DECL_EMITTER(INSN_XORPS_XMM_XMM, insn_encode),
 	DECL_EMITTER(INSN_XOR_MEMBASE_REG, insn_encode),
@@ -1328,6 +1363,7 @@ static emit_fn_t emitters[] = {
 	DECL_EMITTER(INSN_SUB_MEMBASE_REG, insn_encode),
 	DECL_EMITTER(INSN_TEST_IMM_MEMDISP, emit_test_imm_memdisp),
 	DECL_EMITTER(INSN_TEST_MEMBASE_REG, insn_encode),
+	DECL_EMITTER(INSN_TEST_REG_REG, insn_encode),
 	DECL_EMITTER(INSN_SAVE_CALLER_REGS, emit_pseudo),
 	DECL_EMITTER(INSN_RESTORE_CALLER_REGS, emit_pseudo),
 	DECL_EMITTER(INSN_RESTORE_CALLER_REGS_I32, emit_pseudo),
@@ -248,11 +248,8 @@ static void __emit_branch(struct buffer *buf, struct basic_block *bb,
 		insn->flags |= INSN_FLAG_BACKPATCH_RESOLUTION;
 		insn->operand.resolution_block = &bb->resolution_blocks[idx];
 	} else if (target_bb->is_emitted) {
-		struct insn *target_insn =
-		    list_first_entry(&target_bb->insn_list, struct insn,
-			       insn_list_node);
-
-		addr = branch_rel_addr(insn, target_insn->mach_offset);
+		/* The peephole optimizer can leave a basic block empty. */
+		addr = branch_rel_addr(insn, target_bb->mach_offset);
 	} else
 		insn->flags |= INSN_FLAG_BACKPATCH_BRANCH;
 
@@ -831,6 +828,13 @@ static void emit_test_membase_reg(struct insn *insn, struct buffer *buf, struct
 	emit_membase_reg(buf, is_64bit_bin_reg_op(&insn->src, &insn->dest), 0x85, &insn->src, &insn->dest);
 }
 
+static void emit_test_reg_reg(struct insn *insn, struct buffer *buf, struct basic_block *bb)
+{
+	int rex_w = is_64bit_bin_reg_op(&insn->src, &insn->dest);
+
+	emit_reg_reg(buf, rex_w, 0x85, &insn->src, &insn->dest);
+}
+
 static void emit_indirect_jump_reg(struct buffer *buf, enum machine_reg reg)
 {
 	unsigned char reg_num = x86_encode_reg(reg);
@@ -1053,6 +1057,24 @@ static void emit_mov_reg_memindex(struct insn *insn, struct buffer *buf, struct
 			    mach_reg(&insn->dest.base_reg));
 }
 
+static void emit_lock_cmpxchg_reg_memindex(struct insn *insn, struct buffer *buf, struct basic_block *bb)
+{
+	unsigned char opc[] = { 0x0f, 0xb1 };
+
+	emit(buf, 0xf0);	/* LOCK prefix */
+	__emit_lopc_memindex(buf, is_64bit_reg(&insn->src), opc, ARRAY_SIZE(opc),
+			     insn->dest.shift, mach_reg(&insn->dest.index_reg),
+			     mach_reg(&insn->dest.base_reg),
+			     x86_encode_reg(mach_reg(&insn->src.reg)));
+}
+
+static void emit_mfence(struct insn *insn, struct buffer *buf, struct basic_block *bb)
+{
+	emit(buf, 0x0f);
+	emit(buf, 0xae);
+	emit(buf, 0xf0);
+}
+
 static void __emit_mov_imm_membase(struct buffer *buf, long imm, enum machine_reg base, long disp)
 {
 	__emit_membase(buf, 0, 0xc7, base, disp, 0);
@@ -1450,6 +1472,29 @@ void emit_unlock_this(struct buffer *buf, unsigned long frame_size)
 }
 
 
+/*
+ * Emits an 8-byte aligned 5-byte nop that fixup_entry_point() can replace
+ * with a jump. Returns the address of the nop.
+ */
+void *emit_patchable_entry(struct buffer *buf)
+{
+	void *entry;
+
+	while ((unsigned long) buffer_current(buf) & 7)
+		emit(buf, 0x90);
+
+	entry = buffer_current(buf);
+
+	/* nopl 0x0(%eax,%eax,1) */
+	emit(buf, 0x0f);
+	emit(buf, 0x1f);
+	emit(buf, 0x44);
+	emit(buf, 0x00);
+	emit(buf, 0x00);
+
+	return entry;
+}
+
 void *emit_ic_check(struct buffer *buf)
 {
 	return NULL;
@@ -1624,10 +1669,18 @@ static emit_fn_t emitters[] = {
 	DECL_EMITTER(INSN_ADDSS_XMM_XMM, insn_encode),
 	DECL_EMITTER(INSN_ADD_IMM_REG, insn_encode),
 	DECL_EMITTER(INSN_ADD_REG_REG, insn_encode),
+	DECL_EMITTER(INSN_ANDPD_XMM_XMM, insn_encode),
+	DECL_EMITTER(INSN_ANDPS_XMM_XMM, insn_encode),
 	DECL_EMITTER(INSN_AND_REG_REG, insn_encode),
+	DECL_EMITTER(INSN_BSF_REG_REG, insn_encode),
+	DECL_EMITTER(INSN_BSR_REG_REG, insn_encode),
+	DECL_EMITTER(INSN_BSWAP_REG, insn_encode),
 	DECL_EMITTER(INSN_CALL_REG, insn_encode),
 	DECL_EMITTER(INSN_CALL_REL, emit_call),
 	DECL_EMITTER(INSN_CLTD_REG_REG, insn_encode),
+	DECL_EMITTER(INSN_CMOVE_REG_REG, insn_encode),
+	DECL_EMITTER(INSN_CMOVG_REG_REG, insn_encode),
+	DECL_EMITTER(INSN_CMOVL_REG_REG, insn_encode),
 	DECL_EMITTER(INSN_DIVSD_XMM_XMM, insn_encode),
 	DECL_EMITTER(INSN_DIVSS_XMM_XMM, insn_encode),
 	DECL_EMITTER(INSN_FLD_64_MEMLOCAL, insn_encode),
@@ -1643,6 +1696,8 @@ static emit_fn_t emitters[] = {
 	DECL_EMITTER(INSN_JMP_MEMBASE, insn_encode),
 	DECL_EMITTER(INSN_JMP_MEMINDEX, insn_encode),
 	DECL_EMITTER(INSN_JNE_BRANCH, emit_jne_branch),
+	DECL_EMITTER(INSN_LZCNT_REG_REG, insn_encode),
+	DECL_EMITTER(INSN_MOVD_XMM_REG, insn_encode),
 	DECL_EMITTER(INSN_MOVSD_MEMBASE_XMM, insn_encode),
 	DECL_EMITTER(INSN_MOVSD_MEMDISP_XMM, insn_encode),
 	DECL_EMITTER(INSN_MOVSD_MEMLOCAL_XMM, insn_encode),
@@ -1673,19 +1728,24 @@ static emit_fn_t emitters[] = {
 	DECL_EMITTER(INSN_NEG_REG, insn_encode),
 	DECL_EMITTER(INSN_NOP, insn_encode),
 	DECL_EMITTER(INSN_OR_REG_REG, insn_encode),
+	DECL_EMITTER(INSN_POPCNT_REG_REG, insn_encode),
 	DECL_EMITTER(INSN_POP_MEMLOCAL, insn_encode),
 	DECL_EMITTER(INSN_POP_REG, insn_encode),
 	DECL_EMITTER(INSN_PUSH_MEMLOCAL, insn_encode),
 	DECL_EMITTER(INSN_PUSH_REG, insn_encode),
 	DECL_EMITTER(INSN_RET, insn_encode),
+	DECL_EMITTER(INSN_ROL_IMM_REG, insn_encode),
+	DECL_EMITTER(INSN_ROR_IMM_REG, insn_encode),
 	DECL_EMITTER(INSN_SAR_IMM_REG, insn_encode),
 	DECL_EMITTER(INSN_SAR_REG_REG, insn_encode),
 	DECL_EMITTER(INSN_SHL_REG_REG, insn_encode),
 	DECL_EMITTER(INSN_SHR_REG_REG, insn_encode),
+	DECL_EMITTER(INSN_SQRTSD_XMM_XMM, insn_encode),
 	DECL_EMITTER(INSN_SUBSD_XMM_XMM, insn_encode),
 	DECL_EMITTER(INSN_SUBSS_XMM_XMM, insn_encode),
 	DECL_EMITTER(INSN_SUB_IMM_REG, insn_encode),
 	DECL_EMITTER(INSN_SUB_REG_REG, insn_encode),
+	DECL_EMITTER(INSN_TZCNT_REG_REG, insn_encode),
 	DECL_EMITTER(INSN_XORPD_XMM_XMM, insn_encode),
 	DECL_EMITTER(INSN_XORPS_XMM_XMM, insn_encode),
 	DECL_EMITTER(INSN_XOR_MEMBASE_REG, insn_encode),
@@ -1698,6 +1758,8 @@ static emit_fn_t emitters[] = {
 	DECL_EMITTER(INSN_CONV_XMM_TO_XMM64, emit_conv_fpu_to_fpu),
 	DECL_EMITTER(INSN_CONV_XMM64_TO_XMM, emit_conv_fpu_to_fpu),
 	DECL_EMITTER(INSN_DIV_REG_REG, emit_div_reg_reg),
+	DECL_EMITTER(INSN_LOCK_CMPXCHG_REG_MEMINDEX, emit_lock_cmpxchg_reg_memindex),
+	DECL_EMITTER(INSN_MFENCE, emit_mfence),
 	DECL_EMITTER(INSN_MOV_MEMBASE_REG, emit_mov_membase_reg),
 	DECL_EMITTER(INSN_MOV_MEMDISP_REG, emit_mov_memdisp_reg),
 	DECL_EMITTER(INSN_MOV_MEMINDEX_REG, emit_mov_memindex_reg),
@@ -1712,6 +1774,7 @@ static emit_fn_t emitters[] = {
 	DECL_EMITTER(INSN_MUL_REG_REG, emit_mul_reg_reg),
 	DECL_EMITTER(INSN_PUSH_IMM, emit_push_imm),
 	DECL_EMITTER(INSN_TEST_MEMBASE_REG, emit_test_membase_reg),
+	DECL_EMITTER(INSN_TEST_REG_REG, emit_test_reg_reg),
 	DECL_EMITTER(INSN_TEST_IMM_MEMDISP, emit_test_imm_memdisp),
 	DECL_EMITTER(INSN_SAVE_CALLER_REGS, emit_pseudo),
 	DECL_EMITTER(INSN_RESTORE_CALLER_REGS, emit_pseudo),
@@ -211,10 +211,18 @@ static uint64_t encode_table[NR_INSN_TYPES] = {
 	[INSN_ADD_IMM_REG]		= OPCODE(0x81) | OPCODE_EXT(0)   | ADDMODE_IMM_REG | WIDTH_FULL | REX_W_PREFIX,
 	[INSN_ADD_MEMBASE_REG]		= OPCODE(0x03) | ADDMODE_RM_REG  | WIDTH_FULL | REX_W_PREFIX,
 	[INSN_ADD_REG_REG]		= OPCODE(0x01) | ADDMODE_REG_REG | DIR_REVERSED | WIDTH_FULL | REX_W_PREFIX,
+	[INSN_ANDPD_XMM_XMM]		= OPERAND_SIZE_PREFIX | ESCAPE_OPC_BYTE | OPCODE(0x54) | ADDMODE_REG_REG | WIDTH_FULL,
+	[INSN_ANDPS_XMM_XMM]		= ESCAPE_OPC_BYTE | OPCODE(0x54) | ADDMODE_REG_REG | WIDTH_FULL,
 	[INSN_AND_MEMBASE_REG]		= OPCODE(0x23) | ADDMODE_RM_REG  | WIDTH_FULL | REX_W_PREFIX,
 	[INSN_AND_REG_REG]		= OPCODE(0x21) | ADDMODE_REG_REG | DIR_REVERSED | WIDTH_FULL | REX_W_PREFIX,
+	[INSN_BSF_REG_REG]		= OPCODE(0xbc) | ESCAPE_OPC_BYTE | ADDMODE_REG_REG | WIDTH_FULL | REX_W_PREFIX,
+	[INSN_BSR_REG_REG]		= OPCODE(0xbd) | ESCAPE_OPC_BYTE | ADDMODE_REG_REG | WIDTH_FULL | REX_W_PREFIX,
+	[INSN_BSWAP_REG]		= OPCODE(0xc8) | ESCAPE_OPC_BYTE | OPC_REG | ADDMODE_REG | DIR_REVERSED | WIDTH_FULL | REX_W_PREFIX,
 	[INSN_CALL_REG]			= OPCODE(0xFF) | OPCODE_EXT(2)   | ADDMODE_RM | WIDTH_FULL,
 	[INSN_CLTD_REG_REG]		= OPCODE(0x99) | WIDTH_FULL | REX_W_PREFIX,
+	[INSN_CMOVE_REG_REG]		= OPCODE(0x44) | ESCAPE_OPC_BYTE | ADDMODE_REG_REG | WIDTH_FULL | REX_W_PREFIX,
+	[INSN_CMOVG_REG_REG]		= OPCODE(0x4f) | ESCAPE_OPC_BYTE | ADDMODE_REG_REG | WIDTH_FULL | REX_W_PREFIX,
+	[INSN_CMOVL_REG_REG]		= OPCODE(0x4c) | ESCAPE_OPC_BYTE | ADDMODE_REG_REG | WIDTH_FULL | REX_W_PREFIX,
 	[INSN_CMP_IMM_REG]		= OPCODE(0x81) | OPCODE_EXT(7)   | ADDMODE_IMM_REG | WIDTH_FULL | REX_W_PREFIX,
 	[INSN_CMP_MEMBASE_REG]		= OPCODE(0x3b) | ADDMODE_RM_REG  | WIDTH_FULL | REX_W_PREFIX,
 	[INSN_CMP_REG_REG]		= OPCODE(0x39) | ADDMODE_REG_REG | DIR_REVERSED | WIDTH_FULL | REX_W_PREFIX,
@@ -227,6 +235,8 @@ static uint64_t encode_table[NR_INSN_TYPES] = {
 	[INSN_IC_CALL]			= INVALID_INSN,
 	[INSN_JMP_MEMBASE]		= OPCODE(0xff) | OPCODE_EXT(4)   | ADDMODE_RM | WIDTH_FULL,
 	[INSN_JMP_MEMINDEX]		= OPCODE(0xff) | OPCODE_EXT(4)   | ADDMODE_RM | DIR_REVERSED | INDEX | WIDTH_FULL,
+	[INSN_LZCNT_REG_REG]		= REPE_PREFIX  | ESCAPE_OPC_BYTE | OPCODE(0xbd) | ADDMODE_REG_REG | WIDTH_FULL | REX_W_PREFIX,
+	[INSN_MOVD_XMM_REG]		= OPERAND_SIZE_PREFIX | ESCAPE_OPC_BYTE | OPCODE(0x7e) | ADDMODE_REG_REG | DIR_REVERSED | WIDTH_FULL | REX_W_PREFIX,
 	[INSN_MOVSD_MEMBASE_XMM]	= REPNE_PREFIX | ESCAPE_OPC_BYTE | OPCODE(0x10) | ADDMODE_RM_REG | WIDTH_64,
 	[INSN_MOVSD_MEMDISP_XMM]	= REPNE_PREFIX | ESCAPE_OPC_BYTE | OPCODE(0x10) | ADDMODE_MEMDISP_REG | WIDTH_64,
 	[INSN_MOVSD_MEMLOCAL_XMM]	= REPNE_PREFIX | ESCAPE_OPC_BYTE | OPCODE(0x10) | ADDMODE_MEMLOCAL_REG | WIDTH_64,
@@ -258,11 +268,14 @@ static uint64_t encode_table[NR_INSN_TYPES] = {
 	[INSN_OR_MEMBASE_REG]		= OPCODE(0x0b) | ADDMODE_RM_REG  | WIDTH_FULL | REX_W_PREFIX,
 	[INSN_OR_REG_REG]		= OPCODE(0x09) | ADDMODE_REG_REG | DIR_REVERSED | WIDTH_FULL | REX_W_PREFIX,
 	[INSN_PHI]			= INVALID_INSN,
+	[INSN_POPCNT_REG_REG]		= REPE_PREFIX  | ESCAPE_OPC_BYTE | OPCODE(0xb8) | ADDMODE_REG_REG | WIDTH_FULL | REX_W_PREFIX,
 	[INSN_POP_MEMLOCAL]		= OPCODE(0x8f) | OPCODE_EXT(0)   | ADDMODE_MEMLOCAL| WIDTH_FULL,
 	[INSN_POP_REG]			= OPCODE(0x58) | OPC_REG         | ADDMODE_REG     | DIR_REVERSED | WIDTH_FULL,
 	[INSN_PUSH_MEMLOCAL]		= OPCODE(0xff) | OPCODE_EXT(6)   | ADDMODE_MEMLOCAL| WIDTH_FULL,
 	[INSN_PUSH_REG]			= OPCODE(0x50) | OPC_REG         | ADDMODE_REG     | WIDTH_FULL,
 	[INSN_RET]			= OPCODE(0xc3) | ADDMODE_IMPLIED,
+	[INSN_ROL_IMM_REG]		= OPCODE(0xc1) | OPCODE_EXT(0)   | ADDMODE_IMM8_REG | DIR_REVERSED | WIDTH_FULL | REX_W_PREFIX,
+	[INSN_ROR_IMM_REG]		= OPCODE(0xc1) | OPCODE_EXT(1)   | ADDMODE_IMM8_REG | DIR_REVERSED | WIDTH_FULL | REX_W_PREFIX,
 	[INSN_SAR_IMM_REG]		= OPCODE(0xc1) | OPCODE_EXT(7)   | ADDMODE_IMM8_REG | DIR_REVERSED | WIDTH_FULL | REX_W_PREFIX,
 	[INSN_SAR_REG_REG]		= OPCODE(0xd3) | OPCODE_EXT(7)   | ADDMODE_REG_REG | DIR_REVERSED | WIDTH_FULL | REX_W_PREFIX,
 	[INSN_SBB_IMM_REG]		= OPCODE(0x81) | OPCODE_EXT(3)   | ADDMODE_IMM_REG | WIDTH_FULL | REX_W_PREFIX,
@@ -270,12 +283,15 @@ static uint64_t encode_table[NR_INSN_TYPES] = {
 	[INSN_SBB_REG_REG]		= OPCODE(0x19) | ADDMODE_REG_REG | DIR_REVERSED | WIDTH_FULL | REX_W_PREFIX,
 	[INSN_SHL_REG_REG]		= OPCODE(0xd3) | OPCODE_EXT(4)   | ADDMODE_REG_REG|DIR_REVERSED | WIDTH_FULL | REX_W_PREFIX,
 	[INSN_SHR_REG_REG]		= OPCODE(0xd3) | OPCODE_EXT(5)   | ADDMODE_REG_REG|DIR_REVERSED | WIDTH_FULL | REX_W_PREFIX,
+	[INSN_SQRTSD_XMM_XMM]		= REPNE_PREFIX | ESCAPE_OPC_BYTE | OPCODE(0x51) | ADDMODE_REG_REG | WIDTH_64,
 	[INSN_SUBSD_XMM_XMM]		= REPNE_PREFIX | ESCAPE_OPC_BYTE | OPCODE(0x5c) | ADDMODE_REG_REG | WIDTH_64,
 	[INSN_SUBSS_XMM_XMM]		= REPE_PREFIX  | ESCAPE_OPC_BYTE | OPCODE(0x5c) | ADDMODE_REG_REG | WIDTH_FULL,
 	[INSN_SUB_IMM_REG]		= OPCODE(0x81) | OPCODE_EXT(5)   | ADDMODE_IMM_REG | WIDTH_FULL | REX_W_PREFIX,
 	[INSN_SUB_MEMBASE_REG]		= OPCODE(0x2b) | ADDMODE_RM_REG  | WIDTH_FULL | REX_W_PREFIX,
 	[INSN_SUB_REG_REG]		= OPCODE(0x29) | ADDMODE_REG_REG | DIR_REVERSED | WIDTH_FULL | REX_W_PREFIX,
 	[INSN_TEST_MEMBASE_REG]		= OPCODE(0x85) | ADDMODE_RM_REG  | WIDTH_FULL | REX_W_PREFIX,
+	[INSN_TEST_REG_REG]		= OPCODE(0x85) | ADDMODE_REG_REG | DIR_REVERSED | WIDTH_FULL | REX_W_PREFIX,
+	[INSN_TZCNT_REG_REG]		= REPE_PREFIX  | ESCAPE_OPC_BYTE | OPCODE(0xbc) | ADDMODE_REG_REG | WIDTH_FULL | REX_W_PREFIX,
 	[INSN_XORPD_XMM_XMM]		= OPERAND_SIZE_PREFIX | ESCAPE_OPC_BYTE | OPCODE(0x57) | ADDMODE_REG_REG | WIDTH_FULL,
 	[INSN_XORPS_XMM_XMM]		= ESCAPE_OPC_BYTE | OPCODE(0x57) | ADDMODE_REG_REG | WIDTH_FULL,
 	[INSN_XOR_MEMBASE_REG]		= OPCODE(0x33) | ADDMODE_RM_REG  | WIDTH_FULL | REX_W_PREFIX,
@@ -7,6 +7,7 @@
 #include "valgrind/valgrind.h"
 
 #include <pthread.h>
+#include <stdint.h>
 
 static inline bool is_rex_prefix(unsigned char opc)
 {
@@ -22,6 +23,16 @@ static inline bool is_sse_insn(unsigned char *opc)
 	return (opc[0] & 0xfe) == 0xf2 && opc[1] == 0x0f;
 }
 
+static void fixup_call_site(struct fixup_site *site, void *target)
+{
+	void *site_addr;
+
+	site_addr = fixup_site_addr(site);
+	cpu_write_u32(site_addr+1, x86_call_disp(site_addr, target));
+
+	VALGRIND_DISCARD_TRANSLATIONS(site_addr, X86_CALL_INSN_SIZE);
+}
+
 /*
  * This fixes relative calls generated by EXPR_INVOKE.
  *
@@ -45,20 +56,67 @@ void fixup_direct_calls(struct jit_trampoline *t, unsigned long target)
 	pthread_mutex_lock(&t->mutex);
 
 	list_for_each_entry_safe(this, next, &t->fixup_site_list, list_node) {
-		unsigned long new_target;
-		void *site_addr;
+		fixup_call_site(this, (void *) target);
+
+		/* Kept for retarget_direct_calls() */
+		list_move(&this->list_node, &t->patched_site_list);
+	}
+
+	pthread_mutex_unlock(&t->mutex);
+}
+
+/*
+ * Moves all call sites of trampoline @from to trampoline @to. This is used
+ * when a method is recompiled: call sites that were already fixed up to
+ * call the old code are reverted to call the new trampoline.
+ */
+void retarget_direct_calls(struct jit_trampoline *from, struct jit_trampoline *to)
+{
+	struct fixup_site *this, *next;
+	void *target;
 
-		site_addr = fixup_site_addr(this);
-		new_target = x86_call_disp(site_addr, (void *) target);
-		cpu_write_u32(site_addr+1, new_target);
+	target = buffer_ptr(to->objcode);
 
-		VALGRIND_DISCARD_TRANSLATIONS(site_addr, X86_CALL_INSN_SIZE);
+	pthread_mutex_lock(&from->mutex);
+	pthread_mutex_lock(&to->mutex);
 
-		list_del(&this->list_node);
-		free_fixup_site(this);
+	list_for_each_entry_safe(this, next, &from->fixup_site_list, list_node) {
+		fixup_call_site(this, target);
+		this->target = to;
+		list_move(&this->list_node, &to->fixup_site_list);
 	}
 
-	pthread_mutex_unlock(&t->mutex);
+	list_for_each_entry_safe(this, next, &from->patched_site_list, list_node) {
+		fixup_call_site(this, target);
+		this->target = to;
+		list_move(&this->list_node, &to->fixup_site_list);
+	}
+
+	pthread_mutex_unlock(&to->mutex);
+	pthread_mutex_unlock(&from->mutex);
+}
+
+/*
+ * Replaces the nop emitted by emit_patchable_entry() with a jump to
+ * @target. The entry is 8-byte aligned so the whole instruction is written
+ * with one atomic store.
+ */
+void fixup_entry_point(void *entry, void *target)
+{
+	uint64_t old, new;
+	unsigned char *insn;
+
+	insn = (unsigned char *) &new;
+
+	do {
+		old = *(volatile uint64_t *) entry;
+		new = old;
+
+		insn[0] = 0xe9;	/* jmp rel32 */
+		cpu_write_u32(insn + 1, x86_call_disp(entry, target));
+	} while (!__sync_bool_compare_and_swap((uint64_t *) entry, old, new));
+
+	VALGRIND_DISCARD_TRANSLATIONS(entry, X86_CALL_INSN_SIZE);
 }
 
 static void do_fixup_static(void *site_addr, int skip_count, void *new_target)
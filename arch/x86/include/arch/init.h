@@ -2,15 +2,40 @@
 #define X86_INIT_H 1
 
 #include <stdbool.h>
+#include <stdint.h>
 
-#define X86_FEATURE_SSE 	25
-#define X86_FEATURE_SSE2	26
+/*
+ * CPU features are numbered like in Linux: 32 * word + bit, where the
+ * word says which CPUID register the bit is in.
+ */
+#define X86_FEATURE(word, bit)	((word) * 32 + (bit))
 
-extern unsigned long x86_cpu_features;
+/* CPUID.01H:EDX */
+#define X86_FEATURE_CMOV	X86_FEATURE(0, 15)
+#define X86_FEATURE_SSE 	X86_FEATURE(0, 25)
+#define X86_FEATURE_SSE2	X86_FEATURE(0, 26)
 
-static inline bool cpu_has(unsigned char feature)
+/* CPUID.01H:ECX */
+#define X86_FEATURE_SSE4_1	X86_FEATURE(1, 19)
+#define X86_FEATURE_SSE4_2	X86_FEATURE(1, 20)
+#define X86_FEATURE_POPCNT	X86_FEATURE(1, 23)
+#define X86_FEATURE_AVX		X86_FEATURE(1, 28)
+
+/* CPUID.(EAX=07H, ECX=0):EBX */
+#define X86_FEATURE_BMI1	X86_FEATURE(2, 3)	/* TZCNT */
+#define X86_FEATURE_AVX2	X86_FEATURE(2, 5)
+#define X86_FEATURE_BMI2	X86_FEATURE(2, 8)
+
+/* CPUID.80000001H:ECX */
+#define X86_FEATURE_ABM		X86_FEATURE(3, 5)	/* LZCNT */
+
+#define NR_X86_FEATURE_WORDS	4
+
+extern uint32_t x86_cpu_features[NR_X86_FEATURE_WORDS];
+
+static inline bool cpu_has(unsigned int feature)
 {
-	return x86_cpu_features & (1UL << feature);
+	return x86_cpu_features[feature / 32] & (1U << (feature % 32));
 }
 
 void arch_init(void);
@@ -98,11 +98,19 @@ enum insn_type {
 	INSN_ADD_IMM_REG,
 	INSN_ADD_MEMBASE_REG,
 	INSN_ADD_REG_REG,
+	INSN_ANDPD_XMM_XMM,
+	INSN_ANDPS_XMM_XMM,
 	INSN_AND_MEMBASE_REG,
 	INSN_AND_REG_REG,
+	INSN_BSF_REG_REG,
+	INSN_BSR_REG_REG,
+	INSN_BSWAP_REG,
 	INSN_CALL_REG,
 	INSN_CALL_REL,
 	INSN_CLTD_REG_REG,	/* CDQ in Intel manuals */
+	INSN_CMOVE_REG_REG,
+	INSN_CMOVG_REG_REG,
+	INSN_CMOVL_REG_REG,
 	INSN_CMP_IMM_REG,
 	INSN_CMP_MEMBASE_REG,
 	INSN_CMP_REG_REG,
@@ -138,6 +146,10 @@ enum insn_type {
 	INSN_JMP_MEMBASE,
 	INSN_JMP_MEMINDEX,
 	INSN_JNE_BRANCH,
+	INSN_LOCK_CMPXCHG_REG_MEMINDEX,
+	INSN_LZCNT_REG_REG,
+	INSN_MFENCE,
+	INSN_MOVD_XMM_REG,
 	INSN_MOVSD_MEMBASE_XMM,
 	INSN_MOVSD_MEMDISP_XMM,
 	INSN_MOVSD_MEMINDEX_XMM,
@@ -190,12 +202,15 @@ enum insn_type {
 	INSN_OR_MEMBASE_REG,
 	INSN_OR_REG_REG,
 	INSN_PHI,
+	INSN_POPCNT_REG_REG,
 	INSN_POP_MEMLOCAL,
 	INSN_POP_REG,
 	INSN_PUSH_IMM,
 	INSN_PUSH_MEMLOCAL,
 	INSN_PUSH_REG,
 	INSN_RET,
+	INSN_ROL_IMM_REG,
+	INSN_ROR_IMM_REG,
 	INSN_SAR_IMM_REG,
 	INSN_SAR_REG_REG,
 	INSN_SBB_IMM_REG,
@@ -203,6 +218,7 @@ enum insn_type {
 	INSN_SBB_REG_REG,
 	INSN_SHL_REG_REG,
 	INSN_SHR_REG_REG,
+	INSN_SQRTSD_XMM_XMM,
 	INSN_SUBSD_XMM_XMM,
 	INSN_SUBSS_XMM_XMM,
 	INSN_SUB_IMM_REG,
@@ -210,6 +226,8 @@ enum insn_type {
 	INSN_SUB_REG_REG,
 	INSN_TEST_IMM_MEMDISP,
 	INSN_TEST_MEMBASE_REG,
+	INSN_TEST_REG_REG,
+	INSN_TZCNT_REG_REG,
 	INSN_XORPD_XMM_XMM,
 	INSN_XOR_MEMBASE_REG,
 	INSN_XOR_REG_REG,
@@ -232,6 +250,7 @@ enum insn_flag_type {
 	INSN_FLAG_KNOWN_BC_OFFSET	= 1U << 2,
 	INSN_FLAG_BACKPATCH_BRANCH	= 1U << 3,
 	INSN_FLAG_BACKPATCH_RESOLUTION	= 1U << 4,
+	INSN_FLAG_VOLATILE		= 1U << 5,	/* reads a volatile field */
 };
 
 struct insn {
@@ -318,6 +337,7 @@ struct insn *jump_insn(struct basic_block *bb);
 bool insn_is_mov_imm_reg(struct insn *insn);
 bool insn_is_branch(struct insn *insn);
 bool insn_is_jmp_mem(struct insn *insn);
+bool insn_flags_consumed(struct basic_block *bb, struct insn *insn);
 unsigned long nr_srcs_phi(struct insn *insn);
 
 static inline bool insn_is_call(struct insn *insn)
@@ -0,0 +1,43 @@
+#ifndef JATO_X86_INTRINSICS_H
+#define JATO_X86_INTRINSICS_H
+
+#include "arch/init.h"
+
+#include "jit/expression.h"
+
+#include "vm/types.h"
+
+#include <stdbool.h>
+
+/*
+ * Returns true if the instruction selector can emit @op for operands of
+ * type @vm_type on this CPU.
+ */
+static inline bool arch_has_intrinsic_op(int op, enum vm_type vm_type)
+{
+#ifdef CONFIG_32_BIT
+	/* 64-bit integers live in register pairs. */
+	if (vm_type == J_LONG || op == OP_DOUBLE_BITS)
+		return false;
+#endif
+	if (op == OP_BITCOUNT)
+		return cpu_has(X86_FEATURE_POPCNT);
+
+	return true;
+}
+
+/*
+ * Returns true if the instruction selector can emit sun.misc.Unsafe
+ * accesses inline.
+ */
+static inline bool arch_has_unsafe_intrinsics(void)
+{
+#ifdef CONFIG_32_BIT
+	/* The offsets are longs which live in register pairs. */
+	return false;
+#else
+	return true;
+#endif
+}
+
+#endif /* JATO_X86_INTRINSICS_H */
@@ -0,0 +1,12 @@
+#ifndef JATO_X86_STRING_H
+#define JATO_X86_STRING_H
+
+#ifdef CONFIG_X86_64
+void arch_init_string_ops(void);
+#else
+static inline void arch_init_string_ops(void)
+{
+}
+#endif
+
+#endif /* JATO_X86_STRING_H */
@@ -6,7 +6,13 @@
 
 #include <fpu_control.h>
 
-unsigned long x86_cpu_features;
+uint32_t x86_cpu_features[NR_X86_FEATURE_WORDS];
+
+/* CPUID.01H:ECX */
+#define X86_CPUID_OSXSAVE	(1U << 27)
+
+/* XCR0 bits for SSE and AVX register state */
+#define X86_XCR0_SSE_AVX	0x06
 
 static inline void cpuid(unsigned int *eax, unsigned int *ebx,
 			 unsigned int *ecx, unsigned int *edx)
@@ -19,17 +25,76 @@ static inline void cpuid(unsigned int *eax, unsigned int *ebx,
 	    : "0" (*eax), "2" (*ecx));
 }
 
+static inline uint64_t xgetbv(unsigned int index)
+{
+	uint32_t eax, edx;
+
+	asm(".byte 0x0f, 0x01, 0xd0"	/* xgetbv */
+	    : "=a" (eax), "=d" (edx)
+	    : "c" (index));
+
+	return ((uint64_t) edx << 32) | eax;
+}
+
+/*
+ * AVX instructions fault unless the OS saves the YMM registers on
+ * context switches.
+ */
+static bool os_saves_avx_state(unsigned int cpuid_1_ecx)
+{
+	if (!(cpuid_1_ecx & X86_CPUID_OSXSAVE))
+		return false;
+
+	return (xgetbv(0) & X86_XCR0_SSE_AVX) == X86_XCR0_SSE_AVX;
+}
+
 static void init_cpu_features(void)
 {
 	unsigned int eax, ebx, ecx, edx;
+	unsigned int max_leaf;
+
+	eax = 0x00;
+	ecx = 0x00;
+
+	cpuid(&eax, &ebx, &ecx, &edx);
+
+	max_leaf = eax;
 
 	eax = 0x01;
 	ecx = 0x00;
 
 	cpuid(&eax, &ebx, &ecx, &edx);
 
-	x86_cpu_features = edx;
+	x86_cpu_features[0] = edx;
+	x86_cpu_features[1] = ecx;
+
+	if (max_leaf >= 0x07) {
+		eax = 0x07;
+		ecx = 0x00;
+
+		cpuid(&eax, &ebx, &ecx, &edx);
+
+		x86_cpu_features[2] = ebx;
+	}
+
+	eax = 0x80000000;
+	ecx = 0x00;
+
+	cpuid(&eax, &ebx, &ecx, &edx);
+
+	if (eax >= 0x80000001) {
+		eax = 0x80000001;
+		ecx = 0x00;
+
+		cpuid(&eax, &ebx, &ecx, &edx);
+
+		x86_cpu_features[3] = ecx;
+	}
 
+	if (!os_saves_avx_state(x86_cpu_features[1])) {
+		x86_cpu_features[1] &= ~(1U << (X86_FEATURE_AVX % 32));
+		x86_cpu_features[2] &= ~(1U << (X86_FEATURE_AVX2 % 32));
+	}
 }
 
 static void setup_fpu(void)
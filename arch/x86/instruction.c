@@ -26,11 +26,18 @@
 
 #include "jit/bc-offset-mapping.h"
 #include "jit/compilation-unit.h"
+#include "jit/exception.h"
 #include "jit/instruction.h"
+#include "jit/stack-slot.h"
+#include "jit/ssa.h"
 #include "jit/vars.h"
 
 #include "lib/arena.h"
 
+#include "vm/object.h"
+
+#include "arch/stack-frame.h"
+
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
@@ -778,6 +785,7 @@ enum {
 	USE_FP			= (1U << 12),	/* frame pointer */
 	TYPE_BRANCH		= (1U << 13),
 	TYPE_CALL		= (1U << 14),
+	USE_xAX			= (1U << 15),	/* implicit use of accumulator */
 };
 
 static unsigned long insn_flags[] = {
@@ -790,11 +798,19 @@ static unsigned long insn_flags[] = {
 	[INSN_ADD_IMM_REG]			= USE_DST | DEF_DST,
 	[INSN_ADD_MEMBASE_REG]			= USE_SRC | USE_DST | DEF_DST,
 	[INSN_ADD_REG_REG]			= USE_SRC | USE_DST | DEF_DST,
+	[INSN_ANDPD_XMM_XMM]			= USE_SRC | USE_DST | DEF_DST,
+	[INSN_ANDPS_XMM_XMM]			= USE_SRC | USE_DST | DEF_DST,
 	[INSN_AND_MEMBASE_REG]			= USE_SRC | USE_DST | DEF_DST,
 	[INSN_AND_REG_REG]			= USE_SRC | USE_DST | DEF_DST,
+	[INSN_BSF_REG_REG]			= USE_SRC | DEF_DST,
+	[INSN_BSR_REG_REG]			= USE_SRC | DEF_DST,
+	[INSN_BSWAP_REG]			= USE_DST | DEF_DST,
 	[INSN_CALL_REG]				= USE_DST | DEF_NONE | TYPE_CALL,
 	[INSN_CALL_REL]				= USE_NONE | DEF_NONE | TYPE_CALL,
 	[INSN_CLTD_REG_REG]			= USE_SRC | DEF_SRC | DEF_DST,
+	[INSN_CMOVE_REG_REG]			= USE_SRC | USE_DST | DEF_DST,
+	[INSN_CMOVG_REG_REG]			= USE_SRC | USE_DST | DEF_DST,
+	[INSN_CMOVL_REG_REG]			= USE_SRC | USE_DST | DEF_DST,
 	[INSN_CMP_IMM_REG]			= USE_DST,
 	[INSN_CMP_MEMBASE_REG]			= USE_SRC | USE_DST,
 	[INSN_CMP_REG_REG]			= USE_SRC | USE_DST,
@@ -830,6 +846,10 @@ static unsigned long insn_flags[] = {
 	[INSN_JMP_MEMBASE]			= USE_DST | DEF_NONE | TYPE_BRANCH,
 	[INSN_JMP_MEMINDEX]			= USE_IDX_DST | USE_DST | DEF_NONE | TYPE_BRANCH,
 	[INSN_JNE_BRANCH]			= USE_NONE | DEF_NONE | TYPE_BRANCH,
+	[INSN_LOCK_CMPXCHG_REG_MEMINDEX]	= USE_SRC | USE_DST | USE_IDX_DST | USE_xAX | DEF_xAX,
+	[INSN_LZCNT_REG_REG]			= USE_SRC | DEF_DST,
+	[INSN_MFENCE]				= USE_NONE | DEF_NONE,
+	[INSN_MOVD_XMM_REG]			= USE_SRC | DEF_DST,
 	[INSN_MOVSD_MEMBASE_XMM]		= USE_SRC | DEF_DST,
 	[INSN_MOVSD_MEMDISP_XMM]		= USE_NONE | DEF_DST,
 	[INSN_MOVSD_MEMINDEX_XMM]		= USE_SRC | USE_IDX_SRC | DEF_DST,
@@ -882,12 +902,15 @@ static unsigned long insn_flags[] = {
 	[INSN_OR_MEMBASE_REG]			= USE_SRC | USE_DST | DEF_DST,
 	[INSN_OR_REG_REG]			= USE_SRC | USE_DST | DEF_DST,
 	[INSN_PHI]				= USE_SRC | DEF_DST,
+	[INSN_POPCNT_REG_REG]			= USE_SRC | DEF_DST,
 	[INSN_POP_MEMLOCAL]			= USE_SRC | DEF_NONE,
 	[INSN_POP_REG]				= USE_NONE | DEF_DST,
 	[INSN_PUSH_IMM]				= USE_NONE | DEF_NONE,
 	[INSN_PUSH_MEMLOCAL]			= USE_SRC | DEF_NONE,
 	[INSN_PUSH_REG]				= USE_SRC | DEF_NONE,
 	[INSN_RET]				= USE_NONE | DEF_NONE | TYPE_BRANCH,
+	[INSN_ROL_IMM_REG]			= USE_DST | DEF_DST,
+	[INSN_ROR_IMM_REG]			= USE_DST | DEF_DST,
 	[INSN_SAR_IMM_REG]			= USE_DST | DEF_DST,
 	[INSN_SAR_REG_REG]			= USE_SRC | USE_DST | DEF_DST,
 	[INSN_SBB_IMM_REG]			= USE_DST | DEF_DST,
@@ -895,6 +918,7 @@ static unsigned long insn_flags[] = {
 	[INSN_SBB_REG_REG]			= USE_SRC | USE_DST | DEF_DST,
 	[INSN_SHL_REG_REG]			= USE_SRC | USE_DST | DEF_DST,
 	[INSN_SHR_REG_REG]			= USE_SRC | USE_DST | DEF_DST,
+	[INSN_SQRTSD_XMM_XMM]			= USE_SRC | DEF_DST,
 	[INSN_SUBSD_XMM_XMM]			= USE_SRC | USE_DST | DEF_DST,
 	[INSN_SUBSS_XMM_XMM]			= USE_SRC | USE_DST | DEF_DST,
 	[INSN_SUB_IMM_REG]			= USE_DST | DEF_DST,
@@ -902,6 +926,8 @@ static unsigned long insn_flags[] = {
 	[INSN_SUB_REG_REG]			= USE_SRC | USE_DST | DEF_DST,
 	[INSN_TEST_IMM_MEMDISP]			= USE_NONE | DEF_NONE,
 	[INSN_TEST_MEMBASE_REG]			= USE_SRC | USE_DST | DEF_NONE,
+	[INSN_TEST_REG_REG]			= USE_SRC | USE_DST | DEF_NONE,
+	[INSN_TZCNT_REG_REG]			= USE_SRC | DEF_DST,
 	[INSN_XORPD_XMM_XMM]			= USE_SRC | USE_DST | DEF_DST,
 	[INSN_XOR_MEMBASE_REG]			= USE_SRC | USE_DST | DEF_DST,
 	[INSN_XOR_REG_REG]			= USE_SRC | USE_DST | DEF_DST,
@@ -1014,7 +1040,7 @@ int insn_defs_reg(struct insn *insn, struct use_position **regs)
 	return nr;
 }
 
-int insn_uses(struct insn *insn, struct var_info **uses)
+int insn_uses(struct compilation_unit *cu, struct insn *insn, struct var_info **uses)
 {
 	unsigned long flags;
 	int nr = 0;
@@ -1033,6 +1059,9 @@ int insn_uses(struct insn *insn, struct var_info **uses)
 	if (flags & USE_IDX_DST)
 		uses[nr++] = insn->dest.index_reg.interval->var_info;
 
+	if (flags & USE_xAX)
+		uses[nr++] = cu->fixed_var_infos[MACH_REG_xAX];
+
 	return nr;
 }
 
@@ -1133,3 +1162,592 @@ unsigned long nr_srcs_phi(struct insn *insn)
 
 	return insn->nr_srcs;
 }
+
+/*
+ *	Support for array bounds check elimination
+ */
+
+static struct insn *insn_before(struct basic_block *bb, struct insn *insn)
+{
+	if (!insn || insn->insn_list_node.prev == &bb->insn_list)
+		return NULL;
+
+	return prev_insn(insn);
+}
+
+static struct insn *insn_after(struct basic_block *bb, struct insn *insn)
+{
+	if (!insn || insn->insn_list_node.next == &bb->insn_list)
+		return NULL;
+
+	return next_insn(insn);
+}
+
+static struct var_info *reg_var(struct use_position *reg)
+{
+	return reg->interval->var_info;
+}
+
+static bool reg_is_fixed(struct use_position *reg, enum machine_reg mach_reg)
+{
+	struct live_interval *it = reg->interval;
+
+	return interval_has_fixed_reg(it) && (enum machine_reg) it->reg == mach_reg;
+}
+
+static struct stack_slot *
+frame_disp_to_local_slot(struct compilation_unit *cu, long disp)
+{
+	struct stack_frame *frame = cu->stack_frame;
+
+	for (unsigned long i = 0; i < frame->nr_local_slots; i++) {
+		struct stack_slot *slot = get_local_slot(frame, i);
+
+		if ((long) slot_offset(slot) == disp)
+			return slot;
+	}
+
+	return NULL;
+}
+
+static int branch_cond(enum insn_type type, enum ssa_cond *cond)
+{
+	switch (type) {
+	case INSN_JE_BRANCH:
+		*cond = SSA_COND_EQ;
+		break;
+	case INSN_JNE_BRANCH:
+		*cond = SSA_COND_NE;
+		break;
+	case INSN_JL_BRANCH:
+		*cond = SSA_COND_LT;
+		break;
+	case INSN_JGE_BRANCH:
+		*cond = SSA_COND_GE;
+		break;
+	case INSN_JG_BRANCH:
+		*cond = SSA_COND_GT;
+		break;
+	case INSN_JLE_BRANCH:
+		*cond = SSA_COND_LE;
+		break;
+	default:
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * Matches the instruction sequence that STMT_ARRAY_CHECK is selected to
+ * around the call to vm_object_check_array(). Fills in the operands of
+ * the check and returns the number of instructions stored in @insns or -1
+ * if the sequence has been changed by some other pass.
+ */
+static int array_check_insns(struct basic_block *bb, struct insn *call,
+			     struct ssa_insn_info *info, struct insn **insns)
+{
+	struct insn *array, *index, *insn;
+	int nr = 0;
+
+	index = NULL;
+	array = NULL;
+
+#ifdef CONFIG_X86_32
+	array = insn_before(bb, call);
+	index = insn_before(bb, array);
+
+	if (!array || array->type != INSN_PUSH_REG || !index)
+		return -1;
+
+	info->var = reg_var(&array->operand.reg);
+
+	if (index->type == INSN_PUSH_REG) {
+		info->src = reg_var(&index->operand.reg);
+	} else if (index->type == INSN_PUSH_IMM) {
+		info->has_imm = true;
+		info->imm = (long) index->operand.imm;
+	} else
+		return -1;
+
+	insns[nr++] = index;
+	insns[nr++] = array;
+	insns[nr++] = call;
+
+	/* method_args_cleanup() */
+	insn = insn_after(bb, call);
+	if (!insn || insn->type != INSN_ADD_IMM_REG)
+		return -1;
+
+	insns[nr++] = insn;
+#else
+	struct insn *save;
+
+	index = insn_before(bb, call);
+	array = insn_before(bb, index);
+	save = insn_before(bb, array);
+
+	if (!index || !array || !save || save->type != INSN_SAVE_CALLER_REGS)
+		return -1;
+
+	if (array->type != INSN_MOV_REG_REG || !reg_is_fixed(&array->dest.reg, MACH_REG_RDI))
+		return -1;
+
+	if (!reg_is_fixed(&index->dest.reg, MACH_REG_RSI))
+		return -1;
+
+	info->var = reg_var(&array->src.reg);
+
+	if (index->type == INSN_MOV_REG_REG) {
+		info->src = reg_var(&index->src.reg);
+	} else if (index->type == INSN_MOV_IMM_REG) {
+		info->has_imm = true;
+		info->imm = (long) index->src.imm;
+	} else
+		return -1;
+
+	insns[nr++] = save;
+	insns[nr++] = array;
+	insns[nr++] = index;
+	insns[nr++] = call;
+
+	insn = insn_after(bb, call);
+	if (!insn || insn->type != INSN_RESTORE_CALLER_REGS)
+		return -1;
+
+	insns[nr++] = insn;
+#endif
+	return nr;
+}
+
+/*
+ * Matches the result move of EXPR_NEWARRAY and fills in the number of
+ * elements of the new array.
+ */
+static bool new_array_insns(struct basic_block *bb, struct insn *mov,
+			    struct ssa_insn_info *info)
+{
+	struct insn *call, *size;
+
+#ifdef CONFIG_X86_32
+	call = insn_before(bb, mov);
+	size = insn_before(bb, insn_before(bb, call));
+
+	if (!call || !size)
+		return false;
+
+	if (size->type == INSN_PUSH_REG)
+		info->src = reg_var(&size->operand.reg);
+	else
+		return false;
+#else
+	call = insn_before(bb, insn_before(bb, mov));
+	size = insn_before(bb, insn_before(bb, call));
+
+	if (!call || !size || !reg_is_fixed(&size->dest.reg, MACH_REG_RSI))
+		return false;
+
+	if (size->type == INSN_MOV_REG_REG) {
+		info->src = reg_var(&size->src.reg);
+	} else if (size->type == INSN_MOV_IMM_REG) {
+		info->has_imm = true;
+		info->imm = (long) size->src.imm;
+	} else
+		return false;
+#endif
+	return insn_is_call_to(call, vm_object_alloc_primitive_array);
+}
+
+/*
+ * Returns true if the instruction after @insn reads the flags @insn sets,
+ * like the ADC that follows the ADD of the low halves of a long addition.
+ */
+bool insn_flags_consumed(struct basic_block *bb, struct insn *insn)
+{
+	struct insn *next = insn_after(bb, insn);
+
+	if (!next)
+		return false;
+
+	switch (next->type) {
+	case INSN_ADC_IMM_REG:
+	case INSN_ADC_MEMBASE_REG:
+	case INSN_ADC_REG_REG:
+	case INSN_CMOVE_REG_REG:
+	case INSN_CMOVG_REG_REG:
+	case INSN_CMOVL_REG_REG:
+	case INSN_SBB_IMM_REG:
+	case INSN_SBB_MEMBASE_REG:
+	case INSN_SBB_REG_REG:
+		return true;
+	default:
+		return insn_is_branch(next) && next->type != INSN_JMP_BRANCH;
+	}
+}
+
+static bool arith_op(enum insn_type type, enum ssa_op *op)
+{
+	switch (type) {
+	case INSN_ADD_REG_REG:
+		*op = SSA_OP_ADD;
+		break;
+	case INSN_SUB_REG_REG:
+		*op = SSA_OP_SUB;
+		break;
+	case INSN_MUL_REG_REG:
+		*op = SSA_OP_MUL;
+		break;
+	case INSN_AND_REG_REG:
+		*op = SSA_OP_AND;
+		break;
+	case INSN_OR_REG_REG:
+		*op = SSA_OP_OR;
+		break;
+	case INSN_XOR_REG_REG:
+		*op = SSA_OP_XOR;
+		break;
+	case INSN_NEG_REG:
+		*op = SSA_OP_NEG;
+		break;
+	default:
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ * Returns true if @var holds the exception guard address that
+ * select_exception_test() loads rather than a reference.
+ */
+static bool is_exception_guard(struct var_info *var)
+{
+	struct insn *def = ssa_def_insn(var);
+
+	return def && def->type == INSN_MOV_THREAD_LOCAL_MEMDISP_REG;
+}
+
+static unsigned long insn_effects(struct insn *insn)
+{
+	switch (insn->type) {
+	case INSN_ADC_IMM_REG:
+	case INSN_ADC_REG_REG:
+	case INSN_ADDSD_XMM_XMM:
+	case INSN_ADDSS_XMM_XMM:
+	case INSN_ADD_IMM_REG:
+	case INSN_ADD_REG_REG:
+	case INSN_ANDPD_XMM_XMM:
+	case INSN_ANDPS_XMM_XMM:
+	case INSN_AND_REG_REG:
+	case INSN_BSF_REG_REG:
+	case INSN_BSR_REG_REG:
+	case INSN_BSWAP_REG:
+	case INSN_CLTD_REG_REG:
+	case INSN_CMOVE_REG_REG:
+	case INSN_CMOVG_REG_REG:
+	case INSN_CMOVL_REG_REG:
+	case INSN_CMP_IMM_REG:
+	case INSN_CMP_REG_REG:
+	case INSN_CONV_XMM64_TO_XMM:
+	case INSN_CONV_XMM_TO_XMM64:
+	case INSN_DIVSD_XMM_XMM:
+	case INSN_DIVSS_XMM_XMM:
+	case INSN_JE_BRANCH:
+	case INSN_JGE_BRANCH:
+	case INSN_JG_BRANCH:
+	case INSN_JLE_BRANCH:
+	case INSN_JL_BRANCH:
+	case INSN_JMP_BRANCH:
+	case INSN_JNE_BRANCH:
+	case INSN_LZCNT_REG_REG:
+	case INSN_MOVD_XMM_REG:
+	case INSN_MOVSD_XMM_XMM:
+	case INSN_MOVSS_XMM_XMM:
+	case INSN_MOVSXD_REG_REG:
+	case INSN_MOVSX_16_REG_REG:
+	case INSN_MOVSX_8_REG_REG:
+	case INSN_MOVZX_16_REG_REG:
+	case INSN_MOV_IMM_REG:
+	case INSN_MOV_REG_REG:
+	case INSN_MOV_THREAD_LOCAL_MEMDISP_REG:
+	case INSN_MULSD_XMM_XMM:
+	case INSN_MULSS_XMM_XMM:
+	case INSN_MUL_REG_EAX:
+	case INSN_MUL_REG_REG:
+	case INSN_NEG_REG:
+	case INSN_NOP:
+	case INSN_OR_REG_REG:
+	case INSN_PHI:
+	case INSN_POPCNT_REG_REG:
+	case INSN_ROL_IMM_REG:
+	case INSN_ROR_IMM_REG:
+	case INSN_SAR_IMM_REG:
+	case INSN_SAR_REG_REG:
+	case INSN_SBB_IMM_REG:
+	case INSN_SBB_REG_REG:
+	case INSN_SHL_REG_REG:
+	case INSN_SHR_REG_REG:
+	case INSN_SQRTSD_XMM_XMM:
+	case INSN_SUBSD_XMM_XMM:
+	case INSN_SUBSS_XMM_XMM:
+	case INSN_SUB_IMM_REG:
+	case INSN_SUB_REG_REG:
+	case INSN_TEST_REG_REG:
+	case INSN_TZCNT_REG_REG:
+	case INSN_XORPD_XMM_XMM:
+	case INSN_XORPS_XMM_XMM:
+	case INSN_XOR_REG_REG:
+	/* Local variable slots and the native stack are not memory here. */
+	case INSN_FLD_64_MEMLOCAL:
+	case INSN_FLD_MEMLOCAL:
+	case INSN_FSTP_64_MEMLOCAL:
+	case INSN_FSTP_MEMLOCAL:
+	case INSN_MOVSD_MEMLOCAL_XMM:
+	case INSN_MOVSD_XMM_MEMLOCAL:
+	case INSN_MOVSS_MEMLOCAL_XMM:
+	case INSN_MOVSS_XMM_MEMLOCAL:
+	case INSN_MOV_IMM_MEMLOCAL:
+	case INSN_MOV_MEMLOCAL_REG:
+	case INSN_MOV_REG_MEMLOCAL:
+	case INSN_POP_MEMLOCAL:
+	case INSN_POP_REG:
+	case INSN_PUSH_IMM:
+	case INSN_PUSH_MEMLOCAL:
+	case INSN_PUSH_REG:
+		return 0;
+	case INSN_ADC_MEMBASE_REG:
+	case INSN_ADDSD_MEMDISP_XMM:
+	case INSN_ADD_MEMBASE_REG:
+	case INSN_AND_MEMBASE_REG:
+	case INSN_CMP_MEMBASE_REG:
+	case INSN_DIV_MEMBASE_REG:
+	case INSN_DIV_REG_REG:
+	case INSN_FILD_64_MEMBASE:
+	case INSN_FLD_64_MEMBASE:
+	case INSN_FLD_MEMBASE:
+	case INSN_MOVSD_MEMBASE_XMM:
+	case INSN_MOVSD_MEMDISP_XMM:
+	case INSN_MOVSD_MEMINDEX_XMM:
+	case INSN_MOVSS_MEMBASE_XMM:
+	case INSN_MOVSS_MEMDISP_XMM:
+	case INSN_MOVSS_MEMINDEX_XMM:
+	case INSN_MOVSX_16_MEMBASE_REG:
+	case INSN_MOVSX_8_MEMBASE_REG:
+	case INSN_MOV_MEMBASE_REG:
+	case INSN_MOV_MEMDISP_REG:
+	case INSN_MOV_MEMINDEX_REG:
+	case INSN_MULSD_MEMDISP_XMM:
+	case INSN_MUL_MEMBASE_EAX:
+	case INSN_OR_MEMBASE_REG:
+	case INSN_SBB_MEMBASE_REG:
+	case INSN_SUB_MEMBASE_REG:
+	case INSN_TEST_IMM_MEMDISP:
+	case INSN_TEST_MEMBASE_REG:
+	case INSN_XOR_MEMBASE_REG:
+		if (insn->flags & INSN_FLAG_VOLATILE)
+			break;
+
+		return SSA_EFFECT_TRAP;
+	default:
+		break;
+	}
+
+	return SSA_EFFECT_WRITE | SSA_EFFECT_TRAP;
+}
+
+void ssa_classify_insn(struct compilation_unit *cu, struct basic_block *bb,
+		       struct insn *insn, struct ssa_insn_info *info)
+{
+	struct use_position *reg = NULL;
+	struct insn *insns[8];
+
+	memset(info, 0, sizeof *info);
+
+	switch (insn->type) {
+	case INSN_MOV_IMM_REG:
+		info->kind = SSA_INSN_CONST;
+		info->var = reg_var(&insn->dest.reg);
+		info->imm = (long) insn->src.imm;
+		break;
+	case INSN_ADD_REG_REG:
+	case INSN_SUB_REG_REG:
+	case INSN_MUL_REG_REG:
+	case INSN_AND_REG_REG:
+	case INSN_OR_REG_REG:
+	case INSN_XOR_REG_REG:
+	case INSN_NEG_REG:
+		hash_map_get(cu->insn_add_ons, insn, (void **) &reg);
+		if (!reg || insn_flags_consumed(bb, insn))
+			break;
+
+		arith_op(insn->type, &info->op);
+
+		info->kind = SSA_INSN_ARITH;
+		info->var = reg_var(&insn->dest.reg);
+		info->src = reg_var(reg);
+
+		if (insn->type != INSN_NEG_REG)
+			info->src2 = reg_var(&insn->src.reg);
+		break;
+	case INSN_TEST_MEMBASE_REG:
+		if (insn->src.disp != 0)
+			break;
+
+		if (reg_var(&insn->src.base_reg) != reg_var(&insn->dest.reg))
+			break;
+
+		if (interval_has_fixed_reg(insn->dest.reg.interval))
+			break;
+
+		if (is_exception_guard(reg_var(&insn->dest.reg)))
+			break;
+
+		info->kind = SSA_INSN_NULL_CHECK;
+		info->var = reg_var(&insn->dest.reg);
+		break;
+	case INSN_ADD_IMM_REG:
+	case INSN_SUB_IMM_REG:
+		hash_map_get(cu->insn_add_ons, insn, (void **) &reg);
+		if (!reg || insn_flags_consumed(bb, insn))
+			break;
+
+		info->kind = SSA_INSN_ADD_IMM;
+		info->var = reg_var(&insn->dest.reg);
+		info->src = reg_var(reg);
+		info->imm = (long) insn->src.imm;
+
+		if (insn->type == INSN_SUB_IMM_REG)
+			info->imm = -info->imm;
+		break;
+	case INSN_MOV_MEMLOCAL_REG:
+		info->kind = SSA_INSN_LOAD_LOCAL;
+		info->var = reg_var(&insn->dest.reg);
+		info->slot = insn->src.slot;
+		break;
+	case INSN_MOV_REG_MEMLOCAL:
+		info->kind = SSA_INSN_STORE_LOCAL;
+		info->src = reg_var(&insn->src.reg);
+		info->slot = insn->dest.slot;
+		break;
+	case INSN_MOV_IMM_MEMLOCAL:
+		info->kind = SSA_INSN_STORE_LOCAL;
+		info->has_imm = true;
+		info->imm = (long) insn->src.imm;
+		info->slot = insn->dest.slot;
+		break;
+	case INSN_MOVSS_XMM_MEMLOCAL:
+	case INSN_MOVSD_XMM_MEMLOCAL:
+		info->kind = SSA_INSN_STORE_LOCAL;
+		info->slot = insn->dest.slot;
+		info->wide = insn->type == INSN_MOVSD_XMM_MEMLOCAL;
+		break;
+	case INSN_FSTP_MEMLOCAL:
+	case INSN_FSTP_64_MEMLOCAL:
+	case INSN_POP_MEMLOCAL:
+		info->kind = SSA_INSN_STORE_LOCAL;
+		info->slot = insn->operand.slot;
+		info->wide = insn->type != INSN_FSTP_MEMLOCAL;
+		break;
+	case INSN_MOV_MEMBASE_REG:
+		if (insn->flags & INSN_FLAG_VOLATILE)
+			break;
+
+		info->kind = SSA_INSN_LOAD_MEMBASE;
+		info->var = reg_var(&insn->dest.reg);
+		info->src = reg_var(&insn->src.base_reg);
+		info->imm = insn->src.disp;
+		break;
+	case INSN_CMP_REG_REG:
+		info->kind = SSA_INSN_CMP;
+		info->var = reg_var(&insn->dest.reg);
+		info->src = reg_var(&insn->src.reg);
+		break;
+	case INSN_CMP_IMM_REG:
+		info->kind = SSA_INSN_CMP;
+		info->var = reg_var(&insn->dest.reg);
+		info->has_imm = true;
+		info->imm = (long) insn->src.imm;
+		break;
+	case INSN_CMP_MEMBASE_REG:
+		if (!reg_is_fixed(&insn->src.base_reg, MACH_REG_xBP))
+			break;
+
+		info->slot = frame_disp_to_local_slot(cu, insn->src.disp);
+		if (!info->slot)
+			break;
+
+		info->kind = SSA_INSN_CMP;
+		info->var = reg_var(&insn->dest.reg);
+		break;
+	case INSN_JE_BRANCH:
+	case INSN_JNE_BRANCH:
+	case INSN_JL_BRANCH:
+	case INSN_JGE_BRANCH:
+	case INSN_JG_BRANCH:
+	case INSN_JLE_BRANCH:
+		if (branch_cond(insn->type, &info->cond))
+			break;
+
+		info->kind = SSA_INSN_BRANCH;
+		info->target = insn->operand.branch_target;
+		break;
+	case INSN_MOV_REG_REG:
+		if (!reg_is_fixed(&insn->src.reg, MACH_REG_xAX))
+			break;
+
+		if (!new_array_insns(bb, insn, info))
+			break;
+
+		info->kind = SSA_INSN_NEW_ARRAY;
+		info->var = reg_var(&insn->dest.reg);
+		break;
+	case INSN_CALL_REL:
+		if (!insn_is_call_to(insn, vm_object_check_array))
+			break;
+
+		if (array_check_insns(bb, insn, info, insns) < 0)
+			break;
+
+		info->kind = SSA_INSN_ARRAY_CHECK;
+		break;
+	default:
+		break;
+	}
+
+	if (info->kind == SSA_INSN_OTHER)
+		memset(info, 0, sizeof *info);
+
+	info->effects = insn_effects(insn);
+}
+
+struct insn *ssa_const_insn(struct var_info *var, long imm)
+{
+	return imm_reg_insn(INSN_MOV_IMM_REG, imm, var);
+}
+
+/*
+ * Removes the bounds check that calls vm_object_check_array() at @call
+ * together with its argument setup.
+ */
+int ssa_remove_array_check(struct compilation_unit *cu, struct basic_block *bb,
+			   struct insn *call)
+{
+	struct ssa_insn_info info;
+	struct insn *insns[8];
+	int nr;
+
+	memset(&info, 0, sizeof info);
+
+	nr = array_check_insns(bb, call, &info, insns);
+	if (nr < 0)
+		return -1;
+
+	for (int i = 0; i < nr; i++) {
+		if (insn_use_def(insns[i]))
+			hash_map_remove(cu->insn_add_ons, insns[i]);
+
+		remove_insn(insns[i]);
+	}
+
+	return 0;
+}
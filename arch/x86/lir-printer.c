@@ -297,6 +297,95 @@ static int print_addsd_memdisp_reg(struct string *str, struct insn *insn)
 	return print_memdisp_reg(str, insn);
 }
 
+static int print_andpd_xmm_xmm(struct string *str, struct insn *insn)
+{
+	print_func_name(str);
+	return print_reg_reg(str, insn);
+}
+
+static int print_andps_xmm_xmm(struct string *str, struct insn *insn)
+{
+	print_func_name(str);
+	return print_reg_reg(str, insn);
+}
+
+static int print_bsf_reg_reg(struct string *str, struct insn *insn)
+{
+	print_func_name(str);
+	return print_reg_reg(str, insn);
+}
+
+static int print_bsr_reg_reg(struct string *str, struct insn *insn)
+{
+	print_func_name(str);
+	return print_reg_reg(str, insn);
+}
+
+static int print_bswap_reg(struct string *str, struct insn *insn)
+{
+	print_func_name(str);
+	return print_reg(str, &insn->dest);
+}
+
+static int print_cmove_reg_reg(struct string *str, struct insn *insn)
+{
+	print_func_name(str);
+	return print_reg_reg(str, insn);
+}
+
+static int print_cmovg_reg_reg(struct string *str, struct insn *insn)
+{
+	print_func_name(str);
+	return print_reg_reg(str, insn);
+}
+
+static int print_cmovl_reg_reg(struct string *str, struct insn *insn)
+{
+	print_func_name(str);
+	return print_reg_reg(str, insn);
+}
+
+static int print_lzcnt_reg_reg(struct string *str, struct insn *insn)
+{
+	print_func_name(str);
+	return print_reg_reg(str, insn);
+}
+
+static int print_mfence(struct string *str, struct insn *insn)
+{
+	return print_func_name(str);
+}
+
+static int print_movd_xmm_reg(struct string *str, struct insn *insn)
+{
+	print_func_name(str);
+	return print_reg_reg(str, insn);
+}
+
+static int print_popcnt_reg_reg(struct string *str, struct insn *insn)
+{
+	print_func_name(str);
+	return print_reg_reg(str, insn);
+}
+
+static int print_rol_imm_reg(struct string *str, struct insn *insn)
+{
+	print_func_name(str);
+	return print_imm_reg(str, insn);
+}
+
+static int print_ror_imm_reg(struct string *str, struct insn *insn)
+{
+	print_func_name(str);
+	return print_imm_reg(str, insn);
+}
+
+static int print_sqrtsd_xmm_xmm(struct string *str, struct insn *insn)
+{
+	print_func_name(str);
+	return print_reg_reg(str, insn);
+}
+
 static int print_subss_xmm_xmm(struct string *str, struct insn *insn)
 {
 	print_func_name(str);
@@ -596,6 +685,12 @@ static int print_jne_branch(struct string *str, struct insn *insn)
 	return print_branch(str, &insn->operand);
 }
 
+static int print_lock_cmpxchg_reg_memindex(struct string *str, struct insn *insn)
+{
+	print_func_name(str);
+	return print_reg_memindex(str, insn);
+}
+
 static int print_mov_imm_membase(struct string *str, struct insn *insn)
 {
 	print_func_name(str);
@@ -957,6 +1052,18 @@ static int print_test_membase_reg(struct string *str, struct insn *insn)
 	return print_membase_reg(str, insn);
 }
 
+static int print_test_reg_reg(struct string *str, struct insn *insn)
+{
+	print_func_name(str);
+	return print_reg_reg(str, insn);
+}
+
+static int print_tzcnt_reg_reg(struct string *str, struct insn *insn)
+{
+	print_func_name(str);
+	return print_reg_reg(str, insn);
+}
+
 static int print_xor_membase_reg(struct string *str, struct insn *insn)
 {
 	print_func_name(str);
@@ -1023,11 +1130,19 @@ static print_insn_fn insn_printers[] = {
 	[INSN_ADD_IMM_REG] = print_add_imm_reg,
 	[INSN_ADD_MEMBASE_REG] = print_add_membase_reg,
 	[INSN_ADD_REG_REG] = print_add_reg_reg,
+	[INSN_ANDPD_XMM_XMM] = print_andpd_xmm_xmm,
+	[INSN_ANDPS_XMM_XMM] = print_andps_xmm_xmm,
 	[INSN_AND_MEMBASE_REG] = print_and_membase_reg,
 	[INSN_AND_REG_REG] = print_and_reg_reg,
+	[INSN_BSF_REG_REG] = print_bsf_reg_reg,
+	[INSN_BSR_REG_REG] = print_bsr_reg_reg,
+	[INSN_BSWAP_REG] = print_bswap_reg,
 	[INSN_CALL_REG] = print_call_reg,
 	[INSN_CALL_REL] = print_call_rel,
 	[INSN_CLTD_REG_REG] = print_cltd_reg_reg,	/* CDQ in Intel manuals*/
+	[INSN_CMOVE_REG_REG] = print_cmove_reg_reg,
+	[INSN_CMOVG_REG_REG] = print_cmovg_reg_reg,
+	[INSN_CMOVL_REG_REG] = print_cmovl_reg_reg,
 	[INSN_CMP_IMM_REG] = print_cmp_imm_reg,
 	[INSN_CMP_MEMBASE_REG] = print_cmp_membase_reg,
 	[INSN_CMP_REG_REG] = print_cmp_reg_reg,
@@ -1063,6 +1178,10 @@ static print_insn_fn insn_printers[] = {
 	[INSN_JMP_MEMBASE] = print_jmp_membase,
 	[INSN_JMP_MEMINDEX] = print_jmp_memindex,
 	[INSN_JNE_BRANCH] = print_jne_branch,
+	[INSN_LOCK_CMPXCHG_REG_MEMINDEX] = print_lock_cmpxchg_reg_memindex,
+	[INSN_LZCNT_REG_REG] = print_lzcnt_reg_reg,
+	[INSN_MFENCE] = print_mfence,
+	[INSN_MOVD_XMM_REG] = print_movd_xmm_reg,
 	[INSN_MOVSD_MEMBASE_XMM] = print_movsd_membase_xmm,
 	[INSN_MOVSD_MEMDISP_XMM] = print_movsd_memdisp_xmm,
 	[INSN_MOVSD_MEMINDEX_XMM] = print_movsd_memindex_xmm,
@@ -1112,12 +1231,15 @@ static print_insn_fn insn_printers[] = {
 	[INSN_OR_MEMBASE_REG] = print_or_membase_reg,
 	[INSN_OR_REG_REG] = print_or_reg_reg,
 	[INSN_PHI] = print_phi,
+	[INSN_POPCNT_REG_REG] = print_popcnt_reg_reg,
 	[INSN_POP_MEMLOCAL] = print_pop_memlocal,
 	[INSN_POP_REG] = print_pop_reg,
 	[INSN_PUSH_IMM] = print_push_imm,
 	[INSN_PUSH_MEMLOCAL] = print_push_memlocal,
 	[INSN_PUSH_REG] = print_push_reg,
 	[INSN_RET] = print_ret,
+	[INSN_ROL_IMM_REG] = print_rol_imm_reg,
+	[INSN_ROR_IMM_REG] = print_ror_imm_reg,
 	[INSN_SAR_IMM_REG] = print_sar_imm_reg,
 	[INSN_SAR_REG_REG] = print_sar_reg_reg,
 	[INSN_SBB_IMM_REG] = print_sbb_imm_reg,
@@ -1125,6 +1247,7 @@ static print_insn_fn insn_printers[] = {
 	[INSN_SBB_REG_REG] = print_sbb_reg_reg,
 	[INSN_SHL_REG_REG] = print_shl_reg_reg,
 	[INSN_SHR_REG_REG] = print_shr_reg_reg,
+	[INSN_SQRTSD_XMM_XMM] = print_sqrtsd_xmm_xmm,
 	[INSN_SUBSD_XMM_XMM] = print_subsd_xmm_xmm,
 	[INSN_SUBSS_XMM_XMM] = print_subss_xmm_xmm,
 	[INSN_SUB_IMM_REG] = print_sub_imm_reg,
@@ -1132,6 +1255,8 @@ static print_insn_fn insn_printers[] = {
 	[INSN_SUB_REG_REG] = print_sub_reg_reg,
 	[INSN_TEST_IMM_MEMDISP] = print_test_imm_memdisp,
 	[INSN_TEST_MEMBASE_REG] = print_test_membase_reg,
+	[INSN_TEST_REG_REG] = print_test_reg_reg,
+	[INSN_TZCNT_REG_REG] = print_tzcnt_reg_reg,
 	[INSN_XORPD_XMM_XMM] = print_xor_64_xmm_reg_reg,
 	[INSN_XORPS_XMM_XMM] = print_xor_xmm_reg_reg,
 	[INSN_XOR_MEMBASE_REG] = print_xor_membase_reg,
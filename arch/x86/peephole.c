@@ -3,28 +3,342 @@
 #include "arch/instruction.h"
 
 #include "jit/basic-block.h"
+#include "jit/compiler.h"
+#include "jit/instruction.h"
 #include "jit/ssa.h"
 
+#include "vm/method.h"
+#include "vm/class.h"
+#include "vm/signal.h"
+#include "vm/system.h"
+#include "vm/trace.h"
+
+/*
+ * Returns the memory operand through which @insn dereferences a heap
+ * object or NULL if the instruction does not access memory that way.
+ */
+static struct operand *heap_access_operand(struct insn *insn)
+{
+	switch (insn->type) {
+	case INSN_CMP_MEMBASE_REG:
+	case INSN_MOV_MEMBASE_REG:
+	case INSN_MOVSX_8_MEMBASE_REG:
+	case INSN_MOVSX_16_MEMBASE_REG:
+	case INSN_MOVSD_MEMBASE_XMM:
+	case INSN_MOVSS_MEMBASE_XMM:
+	case INSN_TEST_MEMBASE_REG:
+		return &insn->src;
+	case INSN_MOV_IMM_MEMBASE:
+	case INSN_MOV_REG_MEMBASE:
+	case INSN_MOVSD_XMM_MEMBASE:
+	case INSN_MOVSS_XMM_MEMBASE:
+		return &insn->dest;
+	default:
+		return NULL;
+	}
+}
+
+/*
+ * Returns true if @insn can not fault or have side effects and leaves
+ * @reg intact. These are the register moves and spill code that register
+ * allocation puts between a null check and the dereference.
+ */
+static bool is_transparent_move(struct insn *insn, enum machine_reg reg)
+{
+	switch (insn->type) {
+	case INSN_MOV_REG_REG:
+	case INSN_MOV_IMM_REG:
+	case INSN_MOV_MEMLOCAL_REG:
+		return mach_reg(&insn->dest.reg) != reg;
+	case INSN_MOV_REG_MEMLOCAL:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/*
+ * An explicit null check is a "test 0(%reg), %reg" that faults when the
+ * reference is null. If the same bytecode instruction dereferences the
+ * reference at a small offset right after the check, the dereference
+ * itself faults inside the null guard page and the check is redundant.
+ */
+static bool is_implicit_null_check(struct insn *check, struct basic_block *bb)
+{
+	enum machine_reg ref;
+	struct operand *mem;
+	struct insn *insn;
+
+	if (check->src.disp != 0)
+		return false;
+
+	ref = mach_reg(&check->src.base_reg);
+	if (ref != mach_reg(&check->dest.reg))
+		return false;
+
+	for (insn = next_insn(check); &insn->insn_list_node != &bb->insn_list; insn = next_insn(insn)) {
+		if (insn->bc_offset != check->bc_offset)
+			return false;
+
+		mem = heap_access_operand(insn);
+		if (mem) {
+			return mach_reg(&mem->base_reg) == ref &&
+				mem->disp >= 0 && (unsigned long) mem->disp < NULL_GUARD_SIZE;
+		}
+
+		if (!is_transparent_move(insn, ref))
+			return false;
+	}
+
+	return false;
+}
+
+static struct insn *insn_before(struct basic_block *bb, struct insn *insn)
+{
+	if (insn->insn_list_node.prev == &bb->insn_list)
+		return NULL;
+
+	return prev_insn(insn);
+}
+
+static bool same_reg(struct operand *a, struct operand *b)
+{
+	return mach_reg(&a->reg) == mach_reg(&b->reg);
+}
+
+/*
+ * Peephole rules. A rule looks at an instruction of the type it is
+ * registered for and at the instructions before it in the same basic
+ * block. It may remove or rewrite the instruction it is given but no
+ * other instruction, and returns true if it changed something.
+ */
+
+static bool remove_self_move(struct compilation_unit *cu, struct basic_block *bb, struct insn *insn)
+{
+	if (!same_reg(&insn->src, &insn->dest))
+		return false;
+
+	remove_insn(insn);
+	return true;
+}
+
+/*
+ * Removes the second move of "mov %a, %b; mov %b, %a" and of a move that
+ * is repeated right after itself.
+ */
+static bool remove_mov_chain(struct compilation_unit *cu, struct basic_block *bb, struct insn *insn)
+{
+	struct insn *prev = insn_before(bb, insn);
+
+	if (!prev || prev->type != INSN_MOV_REG_REG)
+		return false;
+
+	if (same_reg(&prev->src, &insn->dest) && same_reg(&prev->dest, &insn->src))
+		goto remove;
+
+	if (same_reg(&prev->src, &insn->src) && same_reg(&prev->dest, &insn->dest)
+	    && !same_reg(&insn->src, &insn->dest))
+		goto remove;
+
+	return false;
+remove:
+	remove_insn(insn);
+	return true;
+}
+
+/*
+ * A reload of the stack slot that the previous instruction spilled to is
+ * either redundant or a register move. Spills and reloads of general
+ * purpose registers always move the full register.
+ */
+static bool remove_reload_after_spill(struct compilation_unit *cu, struct basic_block *bb, struct insn *insn)
+{
+	struct insn *spill = insn_before(bb, insn);
+
+	if (!spill || spill->type != INSN_MOV_REG_MEMLOCAL)
+		return false;
+
+	if (spill->dest.slot != insn->src.slot)
+		return false;
+
+	if (is_xmm_reg(mach_reg(&spill->src.reg)) || is_xmm_reg(mach_reg(&insn->dest.reg)))
+		return false;
+
+	if (same_reg(&spill->src, &insn->dest)) {
+		remove_insn(insn);
+		return true;
+	}
+
+	insn->type = INSN_MOV_REG_REG;
+	insn->src.type = OPERAND_REG;
+	init_register(&insn->src.reg, insn, spill->src.reg.interval);
+
+	return true;
+}
+
+static bool remove_add_zero(struct compilation_unit *cu, struct basic_block *bb, struct insn *insn)
+{
+	if (insn->src.imm != 0 || insn_flags_consumed(bb, insn))
+		return false;
+
+	remove_insn(insn);
+	return true;
+}
+
+/*
+ * "test %reg, %reg" sets the flags exactly like "cmp $0, %reg" but has no
+ * immediate operand.
+ */
+static bool cmp_zero_to_test(struct compilation_unit *cu, struct basic_block *bb, struct insn *insn)
+{
+	if (insn->src.imm != 0)
+		return false;
+
+	insn->type = INSN_TEST_REG_REG;
+	insn->src.type = OPERAND_REG;
+	init_register(&insn->src.reg, insn, insn->dest.reg.interval);
+
+	return true;
+}
+
+/*
+ * Basic blocks are emitted in list order and the exit block right after
+ * the last one, so an unconditional jump to the next block falls through
+ * unless the edge needs a resolution block.
+ */
+static bool remove_jump_to_next(struct compilation_unit *cu, struct basic_block *bb, struct insn *insn)
+{
+	struct basic_block *target = insn->operand.branch_target;
+	struct basic_block *next;
+	int idx;
+
+	if (insn->insn_list_node.next != &bb->insn_list)
+		return false;
+
+	if (bb->bb_list_node.next == &cu->bb_list)
+		next = cu->exit_bb;
+	else
+		next = list_entry(bb->bb_list_node.next, struct basic_block, bb_list_node);
+
+	if (target != next)
+		return false;
+
+	idx = bb_lookup_successor_index(bb, target);
+	if (idx < 0 || branch_needs_resolution_block(bb, idx))
+		return false;
+
+	remove_insn(insn);
+	return true;
+}
+
+static bool remove_implicit_null_check(struct compilation_unit *cu, struct basic_block *bb, struct insn *insn)
+{
+	if (!is_implicit_null_check(insn, bb))
+		return false;
+
+	remove_insn(insn);
+	return true;
+}
+
+struct peephole_rule {
+	const char		*name;
+	enum insn_type		type;
+	bool			(*apply)(struct compilation_unit *, struct basic_block *, struct insn *);
+};
+
+static struct peephole_rule peephole_rules[] = {
+	{ "self-move",		INSN_MOV_REG_REG,	remove_self_move },
+	{ "self-move",		INSN_MOVSD_XMM_XMM,	remove_self_move },
+	{ "self-move",		INSN_MOVSS_XMM_XMM,	remove_self_move },
+	{ "mov-chain",		INSN_MOV_REG_REG,	remove_mov_chain },
+	{ "reload-after-spill",	INSN_MOV_MEMLOCAL_REG,	remove_reload_after_spill },
+	{ "add-zero",		INSN_ADD_IMM_REG,	remove_add_zero },
+	{ "add-zero",		INSN_SUB_IMM_REG,	remove_add_zero },
+	{ "cmp-zero",		INSN_CMP_IMM_REG,	cmp_zero_to_test },
+	{ "jump-to-next",	INSN_JMP_BRANCH,	remove_jump_to_next },
+	{ "null-check",		INSN_TEST_MEMBASE_REG,	remove_implicit_null_check },
+};
+
+#define NR_PEEPHOLE_RULES ARRAY_SIZE(peephole_rules)
+
+static unsigned long nr_insns(struct compilation_unit *cu)
+{
+	unsigned long nr = 0;
+	struct basic_block *bb;
+	struct insn *insn;
+
+	for_each_basic_block(bb, &cu->bb_list) {
+		for_each_insn(insn, &bb->insn_list)
+			nr++;
+	}
+
+	return nr;
+}
+
+static void trace_peephole(struct compilation_unit *cu, unsigned long *hits,
+			   unsigned long before, unsigned long after)
+{
+	unsigned int i, j;
+
+	if (!cu_matches_regex(cu))
+		return;
+
+	trace_printf("Peephole Optimizer: %s.%s%s\n",
+		cu->method->class->name, cu->method->name, cu->method->type);
+
+	for (i = 0; i < NR_PEEPHOLE_RULES; i++) {
+		unsigned long nr = 0;
+
+		/* Rules registered for several types share a line. */
+		for (j = 0; j < i; j++) {
+			if (peephole_rules[j].apply == peephole_rules[i].apply)
+				break;
+		}
+		if (j < i)
+			continue;
+
+		for (j = i; j < NR_PEEPHOLE_RULES; j++) {
+			if (peephole_rules[j].apply == peephole_rules[i].apply)
+				nr += hits[j];
+		}
+
+		if (nr)
+			trace_printf("  %-20s %lu\n", peephole_rules[i].name, nr);
+	}
+
+	trace_printf("  LIR instructions: %lu -> %lu\n", before, after);
+}
+
 int peephole_optimize(struct compilation_unit *cu)
 {
-#ifdef CONFIG_X86_32
+	unsigned long hits[NR_PEEPHOLE_RULES] = { 0 };
+	unsigned long before = 0;
 	struct basic_block *bb;
+	unsigned int i;
+
+	if (opt_trace_peephole)
+		before = nr_insns(cu);
 
 	for_each_basic_block(bb, &cu->bb_list) {
 		struct insn *this, *next;
 
 		list_for_each_entry_safe(this, next, &bb->insn_list, insn_list_node) {
-			switch (this->type) {
-			case INSN_MOV_REG_REG:
-				if (mach_reg(&this->src.reg) == mach_reg(&this->dest.reg))
-					remove_insn(this);
-				break;
-			default:
-				break;
+			for (i = 0; i < NR_PEEPHOLE_RULES; i++) {
+				struct peephole_rule *rule = &peephole_rules[i];
+
+				if (rule->type != this->type)
+					continue;
+
+				if (rule->apply(cu, bb, this)) {
+					hits[i]++;
+					break;
+				}
 			}
 		}
 	}
-#endif
+
+	if (opt_trace_peephole)
+		trace_peephole(cu, hits, before, nr_insns(cu));
 
 	return 0;
 }
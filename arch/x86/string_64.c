@@ -0,0 +1,128 @@
+/*
+ * AVX2 versions of the java.lang.String primitives.
+ *
+ * This file is released under the GPL version 2. Please refer to the file
+ * LICENSE for details.
+ *
+ * A char[] element is a 64-bit word with the character in the low 16
+ * bits, so a YMM register holds four characters. The packed-character
+ * SSE4.2 string instructions don't apply to that layout; the loops below
+ * mask each lane to 16 bits and use plain compares instead. The functions
+ * are compiled for AVX2 regardless of the build flags and only installed
+ * if the CPU supports it.
+ */
+
+#include "arch/string.h"
+#include "arch/init.h"
+
+#include "vm/string.h"
+
+#include <immintrin.h>
+
+#define LANES		4
+
+/* 31^1 .. 31^4 modulo 2^32 */
+#define P1		31U
+#define P2		(P1 * 31U)
+#define P3		(P2 * 31U)
+#define P4		(P3 * 31U)
+
+static inline __attribute__((target("avx2")))
+__m256i load_chars(const unsigned long *s, __m256i mask)
+{
+	return _mm256_and_si256(_mm256_loadu_si256((const __m256i *) s), mask);
+}
+
+static __attribute__((target("avx2")))
+jint string_mismatch_avx2(const unsigned long *s1, const unsigned long *s2, jint count)
+{
+	const __m256i mask = _mm256_set1_epi64x(0xffff);
+	jint i;
+
+	for (i = 0; i + LANES <= count; i += LANES) {
+		__m256i eq;
+		unsigned int bits;
+
+		eq = _mm256_cmpeq_epi64(load_chars(&s1[i], mask), load_chars(&s2[i], mask));
+
+		bits = _mm256_movemask_pd(_mm256_castsi256_pd(eq));
+		if (bits != 0xf)
+			return i + __builtin_ctz(~bits);
+	}
+
+	for (; i < count; i++) {
+		if ((jchar) s1[i] != (jchar) s2[i])
+			break;
+	}
+
+	return i;
+}
+
+static __attribute__((target("avx2")))
+jint string_index_of_avx2(const unsigned long *s, jint count, jchar c)
+{
+	const __m256i mask = _mm256_set1_epi64x(0xffff);
+	const __m256i needle = _mm256_set1_epi64x(c);
+	jint i;
+
+	for (i = 0; i + LANES <= count; i += LANES) {
+		__m256i eq;
+		unsigned int bits;
+
+		eq = _mm256_cmpeq_epi64(load_chars(&s[i], mask), needle);
+
+		bits = _mm256_movemask_pd(_mm256_castsi256_pd(eq));
+		if (bits)
+			return i + __builtin_ctz(bits);
+	}
+
+	for (; i < count; i++) {
+		if ((jchar) s[i] == c)
+			return i;
+	}
+
+	return -1;
+}
+
+/*
+ * Lane j accumulates the characters at j, j + 4, j + 8, ... and is
+ * multiplied by 31^4 before each step. That leaves every character with
+ * its weight in the scalar hash divided by 31^(3 - j), which combining the
+ * lanes with weights 31^3 .. 31^0 makes up for. Only the low 32 bits of a
+ * lane matter and _mm256_mul_epu32() ignores the rest.
+ */
+static __attribute__((target("avx2")))
+jint string_hash_avx2(const unsigned long *s, jint count)
+{
+	const __m256i mask = _mm256_set1_epi64x(0xffff);
+	const __m256i p4 = _mm256_set1_epi64x(P4);
+	__m256i acc = _mm256_setzero_si256();
+	uint64_t lanes[LANES];
+	uint32_t hash;
+	jint i;
+
+	for (i = 0; i + LANES <= count; i += LANES) {
+		acc = _mm256_mul_epu32(acc, p4);
+		acc = _mm256_add_epi64(acc, load_chars(&s[i], mask));
+	}
+
+	_mm256_storeu_si256((__m256i *) lanes, acc);
+
+	hash = (uint32_t) lanes[0] * P3 + (uint32_t) lanes[1] * P2 +
+		(uint32_t) lanes[2] * P1 + (uint32_t) lanes[3];
+
+	for (; i < count; i++)
+		hash = 31 * hash + (jchar) s[i];
+
+	return hash;
+}
+
+void arch_init_string_ops(void)
+{
+	if (!cpu_has(X86_FEATURE_AVX2))
+		return;
+
+	string_ops.mismatch	= string_mismatch_avx2;
+	string_ops.index_of	= string_index_of_avx2;
+	string_ops.hash		= string_hash_avx2;
+}
@@ -34,12 +34,12 @@
 #include "cafebabe/attribute_info.h"
 
 enum cafebabe_verification_type_info_tag {
-	CAFEBABE_VERIFICATION_TAG_TOP_VARIABLE_INFO = 1,
-	CAFEBABE_VERIFICATION_TAG_INTEGER_VARIABLE_INFO = 2,
-	CAFEBABE_VERIFICATION_TAG_FLOAT_VARIABLE_INFO = 3,
+	CAFEBABE_VERIFICATION_TAG_TOP_VARIABLE_INFO = 0,
+	CAFEBABE_VERIFICATION_TAG_INTEGER_VARIABLE_INFO = 1,
+	CAFEBABE_VERIFICATION_TAG_FLOAT_VARIABLE_INFO = 2,
+	CAFEBABE_VERIFICATION_TAG_DOUBLE_VARIABLE_INFO = 3,
 	CAFEBABE_VERIFICATION_TAG_LONG_VARIABLE_INFO = 4,
-	CAFEBABE_VERIFICATION_TAG_DOUBLE_VARIABLE_INFO = 5,
-	CAFEBABE_VERIFICATION_TAG_NULL_VARIABLE_INFO = 6,
+	CAFEBABE_VERIFICATION_TAG_NULL_VARIABLE_INFO = 5,
 	CAFEBABE_VERIFICATION_TAG_UNINITIALIZEDTHIS_VARIABLE_INFO = 6,
 	CAFEBABE_VERIFICATION_TAG_OBJECT_VARIABLE_INFO = 7,
 	CAFEBABE_VERIFICATION_TAG_UNINITIALIZED_VARIABLE_INFO = 8,
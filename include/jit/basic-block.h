@@ -57,8 +57,8 @@ struct basic_block {
 		/* Dominance frontier set of the basic block. */
 		struct bitset *dom_frontier;
 
-		/* Number of predecessors excluding exception handler blocks. */
-		unsigned long nr_predecessors_no_eh;
+		/* Number of predecessors excluding unreachable blocks. */
+		unsigned long nr_reachable_predecessors;
 
 		/*
 		 * Position of the current basic block in the predecessors
@@ -92,10 +92,12 @@ struct basic_block {
 		int loop_start;
 
 		/*
-		 * Flag used for exception handler basic blocks, to mark
-		 * the fact that they have been renamed or not
+		 * Is this basic block reachable from an exception handler?
+		 * Values that are defined in the entry block must not be
+		 * live in such blocks because the handler entry would see
+		 * them too.
 		 */
-		bool is_renamed;
+		bool eh_reachable;
 	};
 
 	/*
@@ -0,0 +1,16 @@
+#ifndef JIT_CHA_H
+#define JIT_CHA_H
+
+#include <stdbool.h>
+
+struct compilation_unit;
+struct parse_context;
+struct vm_method;
+
+extern bool opt_cha_enabled;
+
+bool cha_devirtualize(struct parse_context *ctx, struct vm_method *target);
+void cha_method_overridden(struct vm_method *vmm);
+void cha_install(struct compilation_unit *cu);
+
+#endif
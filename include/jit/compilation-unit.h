@@ -19,11 +19,15 @@
 #include <pthread.h>
 #include <semaphore.h>
 
+struct eh_cache_entry;
+struct exception_handler;
 struct buffer;
 struct vm_method;
 struct insn;
 enum machine_reg;
 
+#define NR_EH_CACHE_ENTRIES 4
+
 enum compilation_state {
 	COMPILATION_STATE_INITIAL,
 	COMPILATION_STATE_COMPILING,
@@ -31,8 +35,9 @@ enum compilation_state {
 };
 
 enum {
-	CU_FLAG_ARRAY_OPC,
-	CU_FLAG_REGALLOC_DONE,
+	CU_FLAG_ARRAY_OPC	= 1U << 0,
+	CU_FLAG_REGALLOC_DONE	= 1U << 1,
+	CU_FLAG_LARGE_METHOD	= 1U << 2,	/* see opt_large_method_size */
 };
 
 struct compilation_unit {
@@ -144,11 +149,17 @@ struct compilation_unit {
 	unsigned long last_insn;
 
 	/*
-	 * Contains native pointers of exception handlers. Indices to
-	 * this table are the same as for exception table in code
-	 * attribute.
+	 * Exception handler table with native handler pointers and
+	 * resolved catch classes. Entries are in the same order as the
+	 * exception table in code attribute. See jit/exception.c.
+	 */
+	struct exception_handler *exception_handlers;
+
+	/*
+	 * Handler lookups made at throw sites of this method. Slots are
+	 * filled once with cmpxchg and never replaced.
 	 */
-	void **exception_handlers;
+	struct eh_cache_entry *eh_cache[NR_EH_CACHE_ENTRIES];
 
 	/*
 	 * These stack slot for storing temporary results within one monoburg
@@ -162,6 +173,25 @@ struct compilation_unit {
 
 	struct arena *arena;
 
+	/*
+	 * Class hierarchy analysis state, see jit/cha.c. The flags are
+	 * protected by cha_mutex.
+	 */
+	bool cha_dependent;
+	bool cha_installed;
+	bool cha_invalid;
+
+	/*
+	 * Entry point and trampoline of the code this compilation unit
+	 * replaces. Stale vtable entries may still point to them.
+	 */
+	void *cha_replaced_entry;
+	void *cha_replaced_trampoline;
+
+	/* Bitmap of argument slots that are stored to, see cha.c. */
+	bool cha_args_scanned;
+	uint64_t cha_stored_args;
+
 	/*
 	 * This is used for ARM where we have an immediate of less than 8 bit
 	 * so, to store the larger immediate we use a constant literal pool
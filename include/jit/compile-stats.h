@@ -0,0 +1,26 @@
+#ifndef JATO_JIT_COMPILE_STATS_H
+#define JATO_JIT_COMPILE_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+enum compile_phase {
+	COMPILE_PHASE_PARSE,
+	COMPILE_PHASE_TREE_IR,
+	COMPILE_PHASE_SELECT,
+	COMPILE_PHASE_SSA,
+	COMPILE_PHASE_LIVENESS,
+	COMPILE_PHASE_REGALLOC,
+	COMPILE_PHASE_SPILL_RELOAD,
+	COMPILE_PHASE_PEEPHOLE,
+	COMPILE_PHASE_EMIT,
+	COMPILE_PHASE_MAX
+};
+
+extern bool opt_log_compile;
+
+void compile_phase_end(enum compile_phase phase, uint64_t *start);
+void compile_stats_record(bool large_method);
+void compile_stats_exit(void);
+
+#endif /* JATO_JIT_COMPILE_STATS_H */
@@ -38,7 +38,9 @@ struct fixup_site {
 struct jit_trampoline {
 	struct buffer *objcode;
 	struct list_head fixup_site_list;
-	/* This mutex is protecting operations on fixup_site_list */
+	/* Call sites that already call the compiled code directly */
+	struct list_head patched_site_list;
+	/* This mutex is protecting operations on the fixup site lists */
 	pthread_mutex_t mutex;
 };
 
@@ -63,6 +65,8 @@ void do_convert_statement(struct basic_block *bb, struct statement *stmt,
 int compile(struct compilation_unit *);
 int analyze_control_flow(struct compilation_unit *);
 int convert_to_ir(struct compilation_unit *);
+int remove_null_checks(struct compilation_unit *cu);
+int scalar_replace_allocations(struct compilation_unit *cu);
 int analyze_liveness(struct compilation_unit *);
 int select_instructions(struct compilation_unit *cu);
 int compute_dfns(struct compilation_unit *cu);
@@ -73,6 +77,9 @@ int ssa_to_lir(struct compilation_unit *cu);
 int dce(struct compilation_unit *cu);
 void imm_copy_propagation(struct compilation_unit *cu);
 void abc_removal(struct compilation_unit *cu);
+int sccp(struct compilation_unit *cu);
+int gvn(struct compilation_unit *cu);
+int licm(struct compilation_unit *cu);
 int allocate_registers(struct compilation_unit *cu);
 int mark_clobbers(struct compilation_unit *cu);
 int insert_spill_reload_insns(struct compilation_unit *cu);
@@ -111,6 +118,8 @@ bool is_native(unsigned long eip);
 bool is_on_heap(unsigned long addr);
 
 void fixup_direct_calls(struct jit_trampoline *trampoline, unsigned long target);
+void retarget_direct_calls(struct jit_trampoline *from, struct jit_trampoline *to);
+void fixup_entry_point(void *entry, void *target);
 
 extern bool opt_trace_method;
 extern regex_t method_trace_regex;
@@ -125,6 +134,7 @@ extern bool opt_trace_lir;
 extern bool opt_trace_liveness;
 extern bool opt_trace_regalloc;
 extern bool opt_trace_machine_code;
+extern bool opt_trace_peephole;
 extern bool opt_trace_magic_trampoline;
 extern bool opt_trace_bytecode_offset;
 extern bool opt_trace_invoke;
@@ -135,6 +145,7 @@ extern bool opt_trace_compile;
 extern bool opt_print_compilation;
 
 extern bool opt_ssa_enable;
+extern unsigned long opt_large_method_size;
 extern bool running_on_valgrind;
 
 bool method_matches_regex(struct vm_method *vmm);
@@ -154,6 +165,7 @@ void trace_lir(struct compilation_unit *);
 void trace_liveness(struct compilation_unit *);
 void trace_regalloc(struct compilation_unit *);
 void trace_machine_code(struct compilation_unit *);
+void trace_code_size(struct compilation_unit *);
 void trace_invoke(struct compilation_unit *);
 void trace_exception(struct compilation_unit *, struct jit_stack_frame *, unsigned char *);
 void trace_exception_handler(struct compilation_unit *, unsigned char *);
@@ -2,6 +2,7 @@
 #define JATO_JIT_EXCEPTION_H
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "cafebabe/code_attribute.h"
 
@@ -18,6 +19,7 @@
 
 struct cafebabe_code_attribute_exception;
 struct compilation_unit;
+struct vm_class;
 struct jit_stack_frame;
 struct vm_object;
 struct vm_method;
@@ -38,6 +40,8 @@ extern __thread void *trampoline_exception_guard;
 extern void *exceptions_guard_page;
 extern void *trampoline_exceptions_guard_page;
 
+extern bool opt_fast_throw;
+
 struct cafebabe_code_attribute_exception *
 lookup_eh_entry(struct vm_method *method, unsigned long target);
 
@@ -53,18 +57,59 @@ unsigned char *throw_exception(struct compilation_unit *cu,
 void throw_from_trampoline(void *ctx, struct vm_object *exception);
 void unwind(void);
 void exception_check(void);
+void exception_return(void);
 void signal_exception(struct vm_object *obj);
 void signal_new_exception_v(struct vm_class *vmc, const char *template, va_list args);
 void signal_new_exception(struct vm_class *vmc, const char *template, ...);
 void signal_new_exception_with_cause(struct vm_class *vmc,
 				     struct vm_object *cause,
 				     const char *template, ...);
+void signal_implicit_exception(struct vm_class *vmc, const char *message,
+			       unsigned long site);
 void clear_exception(void);
 void init_exceptions(void);
 void thread_init_exceptions(void);
 void print_exception_table(const struct vm_method *,
 	const struct cafebabe_code_attribute_exception *, int);
+
+/*
+ * Exception table entry of a compiled method. The catch class is resolved
+ * the first time an exception is dispatched through the handler and stays
+ * NULL for handlers that catch everything (finally blocks).
+ */
+struct exception_handler {
+	unsigned long		start_pc;
+	unsigned long		end_pc;
+	uint16_t		catch_type;
+	struct vm_class		*catch_class;
+	unsigned char		*native_ptr;
+};
+
+/*
+ * Remembers which handler, if any, catches exceptions of @class thrown at
+ * @native_ptr. A NULL @handler means the exception leaves the method.
+ */
+struct eh_cache_entry {
+	unsigned char		*native_ptr;
+	struct vm_class		*class;
+	unsigned char		*handler;
+};
+
 int build_exception_handlers_table(struct compilation_unit *cu);
+void free_exception_handlers_table(struct compilation_unit *cu);
+
+/*
+ * JIT code does not test for an exception after calling runtime helpers
+ * that use this. A helper that has signalled an exception calls it right
+ * before returning, and it then returns to exception_return instead. That
+ * stub dispatches the exception at the call site like unwind does. The
+ * redirection only happens when the helper was called from JIT code.
+ */
+#define helper_return_on_exception()					\
+	__helper_return_on_exception(__builtin_frame_address(0))
+
+void __helper_return_on_exception(void *frame);
+unsigned long exception_return_address(void);
 
 static inline bool
 exception_covers(struct cafebabe_code_attribute_exception *eh, unsigned long offset)
@@ -52,6 +52,9 @@ enum expression_type {
 	EXPR_MIMIC_STACK_SLOT,
 	EXPR_LOOKUPSWITCH_BSEARCH,
 	EXPR_TRUNCATION,
+	EXPR_UNSAFE_FIELD,
+	EXPR_COMPARE_AND_SWAP,
+	EXPR_CAS_VALUES,
 	EXPR_LAST,	/* Not a real type. Keep this last. */
 };
 
@@ -98,6 +101,12 @@ enum binary_operator {
 	OP_DDIV,
 	OP_DREM,
 
+	/* Intrinsics, see jit/intrinsics.c */
+	OP_MIN,
+	OP_MAX,
+	OP_ROL,
+	OP_ROR,
+
 	BINOP_LAST,	/* Not a real operator. Keep this last. */
 };
 
@@ -105,6 +114,18 @@ enum unary_operator {
 	OP_NEG	= BINOP_LAST,
 	OP_FNEG,
 	OP_DNEG,
+
+	/* Intrinsics, see jit/intrinsics.c */
+	OP_ABS,
+	OP_FABS,
+	OP_DABS,
+	OP_DSQRT,
+	OP_BITCOUNT,
+	OP_LEADING_ZEROS,
+	OP_TRAILING_ZEROS,
+	OP_BSWAP,
+	OP_FLOAT_BITS,
+	OP_DOUBLE_BITS,
 	OP_LAST,	/* Not a real operator. Keep this last. */
 };
 
@@ -270,6 +291,34 @@ struct expression {
 			struct tree_node *key;
 			struct lookupswitch *lookupswitch_table;
 		};
+
+		/*  EXPR_UNSAFE_FIELD represents the memory at a byte offset
+		    from an object reference as accessed by sun.misc.Unsafe.
+		    The reference is not null checked. This expression type
+		    can be used as either lvalue or rvalue.  */
+		struct {
+			struct tree_node *unsafe_objectref;
+			struct tree_node *unsafe_offset;
+		};
+
+		/*  EXPR_COMPARE_AND_SWAP atomically stores cas_update to
+		    cas_field, which is an EXPR_UNSAFE_FIELD, if it holds
+		    cas_expect. It evaluates to J_INT 1 if the value was
+		    stored and to 0 otherwise. This expression type can be
+		    used as an rvalue only.  */
+		struct {
+			struct tree_node *cas_field;
+			struct tree_node *cas_values;
+		};
+
+		/*  EXPR_CAS_VALUES holds the operands of
+		    EXPR_COMPARE_AND_SWAP that don't fit in a binary tree
+		    node. This expression does not evaluate to a value and
+		    is used for instruction selection only.  */
+		struct {
+			struct tree_node *cas_expect;
+			struct tree_node *cas_update;
+		};
 	};
 };
 
@@ -341,6 +390,8 @@ struct expression *dup_expr(struct parse_context *, struct expression *);
 struct expression *get_pure_expr(struct parse_context *, struct expression *);
 struct expression *lookupswitch_bsearch_expr(struct expression *, struct lookupswitch *);
 struct expression *truncation_expr(enum vm_type, struct expression *);
+struct expression *unsafe_field_expr(enum vm_type, struct expression *, struct expression *);
+struct expression *compare_and_swap_expr(struct expression *, struct expression *, struct expression *);
 unsigned long nr_args(struct expression *);
 int expr_nr_kids(struct expression *);
 int expr_is_pure(struct expression *);
@@ -0,0 +1,15 @@
+#ifndef JIT_INLINE_H
+#define JIT_INLINE_H
+
+#include <stdbool.h>
+
+struct parse_context;
+struct vm_method;
+
+extern bool opt_inline_enabled;
+
+int inline_invoke(struct parse_context *ctx, struct vm_method *target, bool *inlined);
+int inline_devirtualized_invoke(struct parse_context *ctx, struct vm_method *target,
+				bool *inlined);
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef JIT_INTRINSICS_H
+#define JIT_INTRINSICS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+struct vm_method;
+
+/*
+ * sun.misc.Unsafe accesses that the JIT emits inline.
+ */
+enum unsafe_op {
+	UNSAFE_NONE,
+	UNSAFE_GET_VOLATILE,
+	UNSAFE_PUT,
+	UNSAFE_PUT_VOLATILE,
+	UNSAFE_COMPARE_AND_SWAP,
+};
+
+struct intrinsic {
+	const char		*class_name;
+	const char		*method_name;
+	const char		*method_type;
+
+	/*
+	 * C function that is called directly from JIT code instead of the
+	 * method. It takes the same arguments as the method.
+	 */
+	void			*func;
+
+	/*
+	 * Unary or binary operator that replaces the call if @func is NULL.
+	 * The operator takes the method arguments as its operands.
+	 */
+	int			op;
+
+	/*
+	 * Memory access that replaces a call to a sun.misc.Unsafe method.
+	 * The first method argument is the object and the second one the
+	 * byte offset of the accessed field or array element.
+	 */
+	enum unsafe_op		unsafe;
+};
+
+#define DEFINE_INTRINSIC(_class_name, _method_name, _method_type, _func) \
+	{ .class_name = _class_name, .method_name = _method_name,	\
+	  .method_type = _method_type, .func = _func }
+
+#define DEFINE_INTRINSIC_OP(_class_name, _method_name, _method_type, _op) \
+	{ .class_name = _class_name, .method_name = _method_name,	\
+	  .method_type = _method_type, .op = _op }
+
+#define DEFINE_INTRINSIC_UNSAFE(_method_name, _method_type, _unsafe)	\
+	{ .class_name = "sun/misc/Unsafe", .method_name = _method_name,	\
+	  .method_type = _method_type, .unsafe = _unsafe }
+
+extern bool opt_intrinsics_enabled;
+
+struct intrinsic *lookup_intrinsic(struct vm_method *vmm);
+
+static inline bool intrinsic_is_unsafe(struct intrinsic *intrinsic)
+{
+	return intrinsic->unsafe != UNSAFE_NONE;
+}
+
+static inline bool intrinsic_is_op(struct intrinsic *intrinsic)
+{
+	return intrinsic->func == NULL && !intrinsic_is_unsafe(intrinsic);
+}
+
+#endif
@@ -3,6 +3,15 @@
 
 #include "lib/hash-map.h"
 
+#include <stdbool.h>
+
+struct basic_block;
+struct bitset;
+struct compilation_unit;
+struct insn;
+struct stack_slot;
+struct var_info;
+
 /*
  * The work and inserted arrays from the LIR
  * to SSA algorithm initially contain no block.
@@ -25,14 +34,67 @@ struct dce {
 	struct dce *next;
 };
 
-struct array_size_acc {
-	bool active;
-	long size;
+/*
+ * Instruction kinds that the optimizations on SSA form know about. The
+ * comments describe how the fields of struct ssa_insn_info are filled in
+ * for each kind.
+ */
+enum ssa_insn_kind {
+	SSA_INSN_OTHER,
+	SSA_INSN_CONST,		/* var = imm */
+	SSA_INSN_ADD_IMM,	/* var = src + imm */
+	SSA_INSN_ARITH,		/* var = src op src2, or op src if src2 is NULL */
+	SSA_INSN_LOAD_LOCAL,	/* var = slot */
+	SSA_INSN_STORE_LOCAL,	/* slot = src, or imm if has_imm */
+	SSA_INSN_LOAD_MEMBASE,	/* var = *(src + imm) */
+	SSA_INSN_CMP,		/* compare var with src, slot or imm */
+	SSA_INSN_BRANCH,	/* if (cond) goto target */
+	SSA_INSN_NEW_ARRAY,	/* var = new primitive array of src or imm elements */
+	SSA_INSN_ARRAY_CHECK,	/* bounds check of var[src] or var[imm] */
+	SSA_INSN_NULL_CHECK,	/* throw NullPointerException if var is null */
 };
 
-struct reg_value_acc {
-	bool active;
-	long val;
+enum ssa_op {
+	SSA_OP_ADD,
+	SSA_OP_SUB,
+	SSA_OP_MUL,
+	SSA_OP_AND,
+	SSA_OP_OR,
+	SSA_OP_XOR,
+	SSA_OP_NEG,
+};
+
+/*
+ * Side effects of an instruction. Every instruction gets these, whatever
+ * its kind. Stores to local variable slots are SSA_INSN_STORE_LOCAL and
+ * are not counted as memory writes.
+ */
+#define SSA_EFFECT_WRITE	(1UL << 0)	/* writes memory or calls */
+#define SSA_EFFECT_TRAP		(1UL << 1)	/* can fault or throw */
+
+enum ssa_cond {
+	SSA_COND_EQ,
+	SSA_COND_NE,
+	SSA_COND_LT,
+	SSA_COND_GE,
+	SSA_COND_GT,
+	SSA_COND_LE,
+};
+
+struct ssa_insn_info {
+	enum ssa_insn_kind kind;
+	enum ssa_op op;
+	unsigned long effects;
+	struct var_info *var;
+	struct var_info *src;
+	struct var_info *src2;
+	struct stack_slot *slot;
+	struct basic_block *target;
+	enum ssa_cond cond;
+	bool has_imm;
+	/* A store of a 64-bit value also overwrites the next slot.  */
+	bool wide;
+	long imm;
 };
 
 /*
@@ -40,6 +102,19 @@ struct reg_value_acc {
  */
 void recompute_insn_positions(struct compilation_unit *);
 void remove_insn(struct insn *insn);
+void ssa_remove_insn(struct compilation_unit *, struct insn *);
+void ssa_replace_uses(struct var_info *from, struct var_info *to);
+struct insn *ssa_def_insn(struct var_info *);
+struct bitset *ssa_eh_uses(struct compilation_unit *);
+
+/*
+ * Functions defined in arch/<arch>/instruction.c
+ */
+void ssa_classify_insn(struct compilation_unit *, struct basic_block *,
+		       struct insn *, struct ssa_insn_info *);
+int ssa_remove_array_check(struct compilation_unit *, struct basic_block *,
+			   struct insn *);
+struct insn *ssa_const_insn(struct var_info *, long);
 
 /*
  * Functions defined in jit/liveness.c
@@ -118,7 +118,13 @@ struct statement {
 		/* STMT_INVOKE, STMT_INVOKEVIRTUAL, STMT_INVOKEINTERFACE */
 		struct {
 			struct expression *invoke_result;
+
+			/* C function to call instead, see jit/intrinsics.c */
+			void *invoke_intrinsic;
 		};
+
+		/* STMT_STORE that must be followed by a full memory barrier */
+		bool store_volatile;
 	};
 
 	struct list_head stmt_list_node;
@@ -139,7 +145,8 @@ struct statement *alloc_statement(enum statement_type);
 void free_statement(struct statement *);
 int stmt_nr_kids(struct statement *);
 
-struct tableswitch *alloc_tableswitch(struct tableswitch_info *, struct compilation_unit *, struct basic_block *, unsigned long);
+struct tableswitch *alloc_tableswitch(struct tableswitch_info *, struct compilation_unit *, unsigned long);
+struct tableswitch *alloc_dense_lookupswitch(struct lookupswitch_info *, struct compilation_unit *, struct basic_block *, unsigned long);
 void free_tableswitch(struct tableswitch *);
 struct lookupswitch *alloc_lookupswitch(struct lookupswitch_info *, struct compilation_unit *, struct basic_block *, unsigned long);
 void free_lookupswitch(struct lookupswitch *);
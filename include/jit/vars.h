@@ -104,6 +104,16 @@ struct live_interval {
 	/* The live interval where spill happened.  */
 	struct live_interval *spill_parent;
 
+	/* Interval whose register this interval should preferably get. The
+	   register is the one @hint or its child has at @hint_pos.  */
+	struct live_interval *hint;
+	unsigned long hint_pos;
+
+	/* Sorted use positions for next_use_pos() during register
+	   allocation or NULL. See interval_cache_use_positions().  */
+	unsigned long *use_pos_cache;
+	unsigned long nr_use_pos_cache;
+
 	/* See enum interval_flag_type for details.  */
 	uint8_t flags;
 
@@ -193,6 +203,8 @@ int interval_add_range(struct compilation_unit *, struct live_interval *, unsign
 struct live_range *interval_range_at(struct live_interval *, unsigned long);
 void interval_expire_ranges_before(struct live_interval *, unsigned long);
 void interval_restore_expired_ranges(struct live_interval *);
+void interval_cache_use_positions(struct live_interval *);
+void interval_free_use_positions_cache(struct live_interval *);
 
 static inline unsigned long first_use_pos(struct live_interval *it)
 {
@@ -17,6 +17,7 @@ void set_bit(unsigned long *, unsigned long);
 void clear_bit(unsigned long *, unsigned long);
 void bitset_union_to(struct bitset *, struct bitset *);
 void bitset_sub(struct bitset *, struct bitset *);
+void bitset_intersect_to(struct bitset *, struct bitset *);
 bool bitset_equal(struct bitset *, struct bitset *);
 void bitset_clear_all(struct bitset *);
 void bitset_set_all(struct bitset *);
@@ -1,15 +1,26 @@
 #ifndef _VM_RADIX_TREE
 #define _VM_RADIX_TREE
 
+#include <stdbool.h>
+
 struct radix_tree {
 	struct radix_tree_node *	root;
 	int				bits_per_level;
 	int				level_count;
+
+	/*
+	 * When set, radix_tree_lookup() and radix_tree_lookup_prev() may be
+	 * called without locking and concurrently with one writer. Nodes
+	 * are then never freed before free_radix_tree(); lookups skip the
+	 * ones left empty by looking at ->nr_values.
+	 */
+	bool				lockless_lookup;
 };
 
 struct radix_tree_node {
 	struct radix_tree_node *	parent;
 	int				count;	/* number of nonempty slots */
+	unsigned long			nr_values; /* number of values below */
 	void *				slots[0];
 };
 
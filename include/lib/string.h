@@ -14,6 +14,8 @@ void init_string_intern(void);
 struct string *string_from_cstr(char *s);
 struct string *string_from_cstr_dup(const char *s);
 struct string *string_intern_cstr(const char *s);
+struct string *string_intern_cstrn(const char *s, unsigned long len);
+struct string *string_intern_find(const char *s);
 struct string *alloc_str(void);
 void free_str(struct string *);
 
@@ -62,6 +62,24 @@ struct vm_class {
 	struct vm_field *fields;
 	unsigned int nr_methods;
 	struct vm_method *methods;
+
+	/*
+	 * Open addressing hash tables of the fields and methods declared by
+	 * this class. Entries are keyed by interned name and descriptor so
+	 * probing only compares pointers.
+	 */
+	unsigned int field_hash_mask;
+	struct vm_field **field_hash;
+	unsigned int method_hash_mask;
+	struct vm_method **method_hash;
+
+	/*
+	 * Resolved constant pool entries indexed by constant pool index.
+	 * Each slot holds a 'struct vm_class', 'struct vm_field' or
+	 * 'struct vm_method' pointer depending on the entry tag, or NULL if
+	 * the entry hasn't been resolved yet.
+	 */
+	void **resolved_entries;
 	unsigned int nr_annotations;
 	struct vm_annotation **annotations;
 
@@ -118,6 +136,7 @@ int vm_class_link(struct vm_class *vmc, const struct cafebabe_class *class);
 int vm_class_link_primitive_class(struct vm_class *vmc, const char *class_name);
 int vm_class_link_array_class(struct vm_class *vmc, struct vm_class *elem_class, const char *class_name);
 int vm_class_init(struct vm_class *vmc);
+bool vm_class_is_initialized(struct vm_class *vmc);
 int vm_class_ensure_object(struct vm_class *vmc);
 int vm_class_setup_object(struct vm_class *vmc);
 
@@ -17,6 +17,7 @@ struct vm_field {
 	unsigned int field_index;
 	const struct cafebabe_field_info *field;
 
+	/* Interned, see utf8_intern() */
 	char *name;
 	char *type;
 
@@ -45,6 +46,11 @@ static inline bool vm_field_is_final(const struct vm_field *vmf)
 	return vmf->field->access_flags & CAFEBABE_FIELD_ACC_FINAL;
 }
 
+static inline bool vm_field_is_volatile(const struct vm_field *vmf)
+{
+	return vmf->field->access_flags & CAFEBABE_FIELD_ACC_VOLATILE;
+}
+
 static inline bool vm_field_is_public(const struct vm_field *vmf)
 {
 	return vmf->field->access_flags & CAFEBABE_FIELD_ACC_PUBLIC;
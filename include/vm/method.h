@@ -19,6 +19,8 @@
 
 #include "lib/buffer.h"
 
+struct reflection_invoker;
+struct cha_dependency;
 struct vm_class;
 
 #ifdef CONFIG_ARGS_MAP
@@ -41,6 +43,7 @@ struct vm_method {
 	unsigned int itable_index;
 	const struct cafebabe_method_info *method;
 
+	/* Interned, see utf8_intern() */
 	char *name;
 	char *type;
 	int args_count;
@@ -51,6 +54,11 @@ struct vm_method {
 	struct list_head args;
 	struct vm_type_info return_type;
 
+	/* Parsed lazily, see vm_method_load_code() */
+	const struct cafebabe_attribute_info *code_attribute_info;
+	bool code_loaded;
+	/* Class of the error that the first failed attempt signalled */
+	struct vm_class *code_load_error;
 	struct cafebabe_code_attribute code_attribute;
 	struct cafebabe_line_number_table_attribute line_number_table_attribute;
 	struct cafebabe_stack_map_table_attribute stack_map_table_attribute;
@@ -59,6 +67,16 @@ struct vm_method {
 	struct compilation_unit *compilation_unit;
 	struct jit_trampoline *trampoline;
 
+	/*
+	 * Set when a loaded subclass overrides this method. Compiled code
+	 * that assumes otherwise is listed in cha_dependents.
+	 */
+	bool overridden;
+	struct cha_dependency *cha_dependents;
+
+	/* Built on the first reflective call, see runtime/reflection.c. */
+	struct reflection_invoker *reflection_invoker;
+
 	char flags;
 
 	unsigned int nr_annotations;
@@ -69,6 +87,7 @@ struct vm_method {
 #define VM_METHOD_FLAG_VM_NATIVE	(1 << 1)
 #define VM_METHOD_FLAG_TRACE		(1 << 2)
 #define VM_METHOD_FLAG_TRACE_GATE	(1 << 3)
+#define VM_METHOD_FLAG_MISSING		(1 << 4)
 
 unsigned int vm_method_arg_stack_count(struct vm_method *vmm);
 
@@ -84,6 +103,9 @@ int vm_method_init_from_interface(struct vm_method *vmm, struct vm_class *vmc,
 
 int vm_method_init_annotation(struct vm_method *vmm);
 
+int vm_method_load_code(struct vm_method *vmm);
+int vm_method_reset_jit(struct vm_method *vmm);
+
 static inline bool vm_method_is_public(struct vm_method *vmm)
 {
 	return vmm->method->access_flags & CAFEBABE_METHOD_ACC_PUBLIC;
@@ -167,7 +189,9 @@ static inline bool vm_method_is_special(struct vm_method *vmm)
 
 static inline bool vm_method_is_compiled(struct vm_method *vmm)
 {
-	return compilation_unit_is_compiled(vmm->compilation_unit);
+	struct compilation_unit *cu = vmm->compilation_unit;
+
+	return cu && compilation_unit_is_compiled(cu);
 }
 
 static inline enum vm_type method_return_type(struct vm_method *method)
@@ -177,6 +201,7 @@ static inline enum vm_type method_return_type(struct vm_method *method)
 }
 
 int vm_method_prepare_jit(struct vm_method *vmm);
+int vm_method_ensure_jit(struct vm_method *vmm);
 
 static inline void *vm_method_entry_point(struct vm_method *vmm)
 {
@@ -187,26 +212,12 @@ static inline void *vm_method_ic_entry_point(struct vm_method *vmm)
 	return cu_ic_entry_point(vmm->compilation_unit);
 }
 
-static inline void *vm_method_trampoline_ptr(struct vm_method *vmm)
-{
-	return buffer_ptr(vmm->trampoline->objcode);
-}
-
-static inline void *vm_method_call_ptr(struct vm_method *vmm)
-{
-	void *result;
-
-	if (vm_method_is_compiled(vmm))
-		result = vm_method_entry_point(vmm);
-	else
-		result = vm_method_trampoline_ptr(vmm);
-
-	return result;
-}
+void *vm_method_trampoline_ptr(struct vm_method *vmm);
+void *vm_method_call_ptr(struct vm_method *vmm);
 
 static inline bool vm_method_is_missing(struct vm_method *vmm)
 {
-	return !vmm->compilation_unit;
+	return vmm->flags & VM_METHOD_FLAG_MISSING;
 }
 
 #endif
@@ -84,6 +84,10 @@ void array_store_check(struct vm_object *arrayref, struct vm_object *obj);
 void array_store_check_vmtype(struct vm_object *arrayref, enum vm_type vm_type);
 void array_size_check(int size);
 void multiarray_size_check(int n, ...);
+void vm_array_copy(struct vm_object *src, jint src_start,
+		   struct vm_object *dest, jint dest_start, jint len);
+void array_copy(struct vm_object *src, jint src_start,
+		struct vm_object *dest, jint dest_start, jint len);
 char *vm_string_to_cstr(const struct vm_object *string);
 char *vm_string_classname_to_cstr(const struct vm_object *string);
 
@@ -8,6 +8,14 @@
  */
 typedef unsigned long (*signal_bh_fn)(unsigned long);
 
+/*
+ * The first page of the address space is never mapped so any access to it
+ * from JIT code is a null pointer dereference. This lets us drop explicit
+ * null checks that are followed by an access at a small offset from the
+ * object reference.
+ */
+#define NULL_GUARD_SIZE		4096UL
+
 void setup_signal_handlers(void);
 int install_signal_bh(void *ctx, signal_bh_fn bh);
 unsigned long throw_from_signal_bh(unsigned long jit_addr);
@@ -0,0 +1,28 @@
+#ifndef JATO_VM_STARTUP_H
+#define JATO_VM_STARTUP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct vm_method;
+
+enum startup_phase {
+	STARTUP_PHASE_GC_INIT,
+	STARTUP_PHASE_CLASSLOADER_INIT,
+	STARTUP_PHASE_INIT_CLASSPATH,
+	STARTUP_PHASE_PRELOAD_VM_CLASSES,
+	STARTUP_PHASE_INIT_THREADING,
+	STARTUP_PHASE_MAX
+};
+
+extern bool opt_log_startup;
+
+uint64_t startup_clock(void);
+
+void startup_log_init(void);
+void startup_phase_end(enum startup_phase phase, uint64_t start);
+void startup_record_compile(struct vm_method *vmm, uint64_t start);
+void startup_enter_main(void);
+void startup_log_exit(void);
+
+#endif /* JATO_VM_STARTUP_H */
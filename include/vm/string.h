@@ -1,9 +1,33 @@
 #ifndef JATO_STRING_H
 #define JATO_STRING_H
 
+#include "vm/jni.h"
+
 struct vm_object;
 
+/*
+ * Primitives over the characters of a java.lang.String. Every char[]
+ * element takes a machine word and only its low 16 bits hold the
+ * character, so the implementations must ignore the upper bits.
+ */
+struct string_ops {
+	/* Returns the index of the first difference or @count. */
+	jint (*mismatch)(const unsigned long *s1, const unsigned long *s2, jint count);
+	/* Returns the index of the first @c or -1. */
+	jint (*index_of)(const unsigned long *s, jint count, jchar c);
+	/* Returns the String.hashCode() of the characters. */
+	jint (*hash)(const unsigned long *s, jint count);
+};
+
+extern struct string_ops string_ops;
+
 void init_literals_hash_map(void);
 struct vm_object *vm_string_intern(struct vm_object *string);
 
+jint string_equals(struct vm_object *self, struct vm_object *other);
+jint string_compare_to(struct vm_object *self, struct vm_object *other);
+jint string_index_of_char(struct vm_object *self, jint c);
+jint string_index_of(struct vm_object *self, struct vm_object *str);
+jint string_hash_code(struct vm_object *self);
+
 #endif /* JATO_STRING_H */
@@ -24,6 +24,13 @@ enum vm_thread_state {
 	VM_THREAD_STATE_INCONSISTENT,
 };
 
+/* Values of the futex word that sun.misc.Unsafe.park() sleeps on */
+enum vm_thread_park_state {
+	VM_THREAD_PARK_WAITING = -1,
+	VM_THREAD_PARK_NONE,
+	VM_THREAD_PARK_PERMIT,
+};
+
 struct vm_thread {
 	pthread_mutex_t mutex;
 
@@ -43,9 +50,7 @@ struct vm_thread {
 	enum vm_thread_state thread_state;
 
 	/* Needed by sun.misc.Unsafe.park() */
-	pthread_mutex_t park_mutex;
-	pthread_cond_t park_cond;
-	bool unpark_called;
+	atomic_t park_state;
 
 	struct vm_exec_env *ee;
 };
@@ -3,11 +3,13 @@
 
 #include <stdint.h>
 
+struct cafebabe_constant_info_utf8;
 struct vm_object;
 
 int utf8_char_count(const uint8_t *bytes, unsigned int n, unsigned int *res);
 struct vm_object *utf8_to_char_array(const uint8_t *bytes, unsigned int n);
 char *dots_to_slash(const char *utf);
 char *slash_to_dots(const char *utf);
+char *utf8_intern(const struct cafebabe_constant_info_utf8 *utf8);
 
 #endif /* JATO_VM_UTF8_H */
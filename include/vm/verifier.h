@@ -5,6 +5,7 @@
 #include "lib/list.h"
 
 extern bool opt_trace_verifier;
+extern bool opt_verify_all;
 
 #define vrf_err(format, args...) opt_trace_verifier ? do_warn("%s: " format, __func__, ## args) : 0
 
@@ -102,6 +103,10 @@ int transition_verifier_local_var(struct verifier_local_var *varsc, struct verif
 int transition_verifier_state(struct verifier_state *s1, struct verifier_state *s2);
 
 int vm_method_verify(struct vm_method *vmm);
+void verify_error(int err, unsigned long pos, struct verifier_context *vrf);
+
+bool vm_method_needs_type_checking(struct vm_method *vmm);
+int verify_stack_maps(struct verifier_context *vrf);
 
 typedef int (*verify_fn_t) (struct verifier_block *);
 
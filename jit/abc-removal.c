@@ -29,104 +29,973 @@
 #include "jit/compilation-unit.h"
 #include "jit/compiler.h"
 #include "jit/instruction.h"
+#include "jit/stack-slot.h"
 #include "jit/ssa.h"
 #include "jit/vars.h"
 
 #include "lib/bitset.h"
-#include "lib/radix-tree.h"
 
-#include <stdio.h>
+#include "vm/method.h"
+#include "vm/object.h"
 
-void abc_removal(struct compilation_unit *cu)
-{
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/*
+ * Array bounds check elimination
+ *
+ * A check of array[index] is removed when the index is known to be
+ * non-negative and below the length of the array:
+ *
+ *   - The upper bound comes from a branch that guards the check, that
+ *     is, a conditional branch at the end of the single predecessor of
+ *     a block that dominates the check. "i < a.length", "i < n" where n
+ *     holds a.length, and comparisons against the constant length of a
+ *     freshly allocated array are recognized.
+ *
+ *   - Java locals live in stack slots, so loop induction variables are
+ *     tracked through the slots: a slot is non-negative if every value
+ *     stored into it is non-negative. "i + 1" is non-negative when i is
+ *     and a guard bounds i from above, which rules out overflow.
+ *
+ *   - Two loads of a local have the same value if the local is not
+ *     stored to on any path between them.
+ *
+ * A check that is dominated by a check of the same array and index is
+ * removed as well. Loop-invariant checks are not hoisted out of loops
+ * because that would throw the exception before the side effects of the
+ * earlier iterations.
+ */
+
+#define ABC_MAX_DEPTH	4
+
+struct abc_def {
+	struct insn *insn;
+	struct basic_block *bb;
+	unsigned long nr_defs;
+};
+
+struct abc_slot {
+	unsigned long nr_stores;
+	struct insn *store;
+	struct basic_block *store_bb;
+	bool eh_store;
+	bool nonneg;
+	/* 0 if not computed yet, 1 if the store runs at most once, 2 if not */
+	int runs_once;
+};
+
+/* A value that is read from an SSA variable, a local or an immediate */
+struct abc_value {
+	struct var_info *var;
+	struct stack_slot *slot;
+	struct insn *insn;
 	struct basic_block *bb;
-	struct insn *insn, *tmp;
-	struct reg_value_acc regs_value[cu->ssa_nr_vregs];
-	struct array_size_acc arrays_value[cu->ssa_nr_vregs];
-	int index = 0, nr_array_check = 0;
+	bool has_imm;
+	long imm;
+};
+
+/* Relation that holds on entry to a basic block */
+struct abc_fact {
+	struct insn *insn;
+	struct basic_block *bb;
+	enum ssa_cond cond;
+	struct abc_value lhs;
+	struct abc_value rhs;
+};
+
+struct abc_check {
+	struct insn *insn;
+	struct basic_block *bb;
+	struct abc_value array;
+	struct abc_value index;
+	bool remove;
+};
+
+struct abc_context {
+	struct compilation_unit *cu;
+	struct abc_def *defs;
+	unsigned long nr_vregs;
+	struct abc_slot *slots;
+	unsigned long nr_slots;
+	unsigned long nr_args;
+	struct bitset *visited;
+	struct basic_block **worklist;
+};
+
+/*
+ * Code that is reachable from exception handlers is left alone. Nothing
+ * outside of it can be reached from a handler so the facts we derive for
+ * the rest of the method don't need to consider exceptional control flow.
+ */
+static bool bb_is_eh(struct compilation_unit *cu, struct basic_block *bb)
+{
+	return bb->eh_reachable || (!bb->dfn && cu->entry_bb != bb);
+}
+
+static bool bb_dominates(struct basic_block *dom, struct basic_block *bb)
+{
+	return dom == bb || test_bit(bb->dominators->bits, dom->dfn);
+}
+
+/*
+ * Returns true if @a is executed before @b whenever @b is executed.
+ */
+static bool point_dominates(struct insn *a, struct basic_block *a_bb,
+			    struct insn *b, struct basic_block *b_bb)
+{
+	struct insn *insn;
+
+	if (a_bb != b_bb)
+		return bb_dominates(a_bb, b_bb);
+
+	for_each_insn(insn, &a_bb->insn_list) {
+		if (insn == a)
+			return true;
+		if (insn == b)
+			return false;
+	}
+
+	return false;
+}
+
+static int int_imm(long imm)
+{
+	return (int32_t) imm;
+}
+
+static void classify(struct abc_context *ctx, struct basic_block *bb,
+		     struct insn *insn, struct ssa_insn_info *info)
+{
+	ssa_classify_insn(ctx->cu, bb, insn, info);
+
+	/* The immediates we care about are Java ints.  */
+	if (info->kind != SSA_INSN_LOAD_MEMBASE)
+		info->imm = int_imm(info->imm);
+}
+
+static bool local_slot_index(struct abc_context *ctx, struct stack_slot *slot,
+			     unsigned long *idx)
+{
+	struct stack_frame *frame = ctx->cu->stack_frame;
+
+	if (!slot || slot < frame->local_slots ||
+	    slot >= frame->local_slots + frame->nr_local_slots)
+		return false;
+
+	*idx = slot->index;
+	return true;
+}
+
+static bool insn_stores_slot(struct abc_context *ctx, struct basic_block *bb,
+			     struct insn *insn, unsigned long idx)
+{
+	struct ssa_insn_info info;
+	unsigned long store_idx;
+
+	classify(ctx, bb, insn, &info);
+
+	if (info.kind != SSA_INSN_STORE_LOCAL)
+		return false;
+
+	if (!local_slot_index(ctx, info.slot, &store_idx))
+		return false;
+
+	return store_idx == idx || (info.wide && store_idx + 1 == idx);
+}
+
+/*
+ * Returns true if a store to local @idx is between @from and @to in @bb.
+ * A NULL @from means the start of the block and a NULL @to its end.
+ */
+static bool range_stores_slot(struct abc_context *ctx, struct basic_block *bb,
+			      struct insn *from, struct insn *to,
+			      unsigned long idx)
+{
+	struct insn *insn;
+	bool active = from == NULL;
+
+	for_each_insn(insn, &bb->insn_list) {
+		if (insn == to)
+			break;
+
+		if (active && insn_stores_slot(ctx, bb, insn, idx))
+			return true;
+
+		if (insn == from)
+			active = true;
+	}
+
+	return false;
+}
+
+/*
+ * Returns true if local @idx is not stored to on any path from @from to
+ * @to that does not pass @from again. @from must dominate @to.
+ */
+static bool slot_unchanged(struct abc_context *ctx, unsigned long idx,
+			   struct insn *from, struct basic_block *from_bb,
+			   struct insn *to, struct basic_block *to_bb)
+{
+	struct compilation_unit *cu = ctx->cu;
+	unsigned long head = 0, tail = 0;
+	bool whole_to_bb = false;
+
+	if (from_bb == to_bb)
+		return !range_stores_slot(ctx, from_bb, from, to, idx);
+
+	if (range_stores_slot(ctx, from_bb, from, NULL, idx))
+		return false;
+
+	bitset_clear_all(ctx->visited);
+
+	ctx->worklist[tail++] = to_bb;
+
+	while (head < tail) {
+		struct basic_block *bb = ctx->worklist[head++];
+
+		for (unsigned long i = 0; i < bb->nr_predecessors; i++) {
+			struct basic_block *pred = bb->predecessors[i];
+
+			if (pred == from_bb)
+				continue;
+
+			if (bb_is_eh(cu, pred) || pred == cu->entry_bb)
+				return false;
+
+			if (pred == to_bb) {
+				whole_to_bb = true;
+				continue;
+			}
+
+			if (test_bit(ctx->visited->bits, pred->dfn))
+				continue;
+
+			set_bit(ctx->visited->bits, pred->dfn);
+			ctx->worklist[tail++] = pred;
+		}
+	}
+
+	for (unsigned long i = 1; i < tail; i++) {
+		if (range_stores_slot(ctx, ctx->worklist[i], NULL, NULL, idx))
+			return false;
+	}
+
+	return !range_stores_slot(ctx, to_bb, NULL, whole_to_bb ? NULL : to, idx);
+}
+
+static bool store_runs_once(struct abc_context *ctx, struct abc_slot *slot)
+{
+	unsigned long head = 0, tail = 0;
+
+	if (slot->runs_once)
+		return slot->runs_once == 1;
+
+	slot->runs_once = 1;
+
+	bitset_clear_all(ctx->visited);
+
+	ctx->worklist[tail++] = slot->store_bb;
+
+	while (head < tail && slot->runs_once == 1) {
+		struct basic_block *bb = ctx->worklist[head++];
+
+		for (unsigned long i = 0; i < bb->nr_successors; i++) {
+			struct basic_block *succ = bb->successors[i];
+
+			if (succ == slot->store_bb) {
+				slot->runs_once = 2;
+				break;
+			}
+
+			if (bb_is_eh(ctx->cu, succ))
+				continue;
+
+			if (test_bit(ctx->visited->bits, succ->dfn))
+				continue;
+
+			set_bit(ctx->visited->bits, succ->dfn);
+			ctx->worklist[tail++] = succ;
+		}
+	}
+
+	return slot->runs_once == 1;
+}
+
+/*
+ * Returns the only store to local @idx if the local is assigned exactly
+ * once and the assignment is executed before @insn.
+ */
+static struct insn *single_store(struct abc_context *ctx, unsigned long idx,
+				 struct insn *insn, struct basic_block *bb)
+{
+	struct abc_slot *slot = &ctx->slots[idx];
+
+	if (idx < ctx->nr_args || slot->nr_stores != 1 || slot->eh_store)
+		return NULL;
+
+	if (!store_runs_once(ctx, slot))
+		return NULL;
+
+	if (!point_dominates(slot->store, slot->store_bb, insn, bb))
+		return NULL;
+
+	return slot->store;
+}
+
+static bool var_def(struct abc_context *ctx, struct var_info *var,
+		    struct ssa_insn_info *info, struct abc_def **def_p)
+{
+	struct abc_def *def;
+
+	if (!var || interval_has_fixed_reg(var->interval))
+		return false;
+
+	if (var->vreg >= ctx->nr_vregs)
+		return false;
+
+	def = &ctx->defs[var->vreg];
+	if (def->nr_defs != 1 || bb_is_eh(ctx->cu, def->bb))
+		return false;
+
+	classify(ctx, def->bb, def->insn, info);
+
+	if (def_p)
+		*def_p = def;
+
+	return true;
+}
+
+static void var_value(struct abc_context *ctx, struct var_info *var,
+		      struct abc_value *value)
+{
+	struct ssa_insn_info info;
+	struct abc_def *def;
+
+	*value = (struct abc_value) { .var = var };
+
+	if (!var_def(ctx, var, &info, &def))
+		return;
+
+	switch (info.kind) {
+	case SSA_INSN_CONST:
+		value->has_imm = true;
+		value->imm = info.imm;
+		break;
+	case SSA_INSN_LOAD_LOCAL:
+		value->slot = info.slot;
+		value->insn = def->insn;
+		value->bb = def->bb;
+		break;
+	default:
+		break;
+	}
+}
+
+static bool var_is_tracked(struct abc_context *ctx, struct var_info *var)
+{
+	struct ssa_insn_info info;
+
+	return var_def(ctx, var, &info, NULL);
+}
+
+/*
+ * Returns true if @b holds the same value as @a. @point is where a fact
+ * about @a was established; @a is read before @point.
+ */
+static bool same_value(struct abc_context *ctx, struct abc_value *a,
+		       struct insn *point, struct basic_block *point_bb,
+		       struct abc_value *b)
+{
+	unsigned long idx;
+
+	if (a->has_imm || b->has_imm)
+		return a->has_imm && b->has_imm && a->imm == b->imm;
+
+	if (a->var && a->var == b->var && var_is_tracked(ctx, a->var))
+		return true;
+
+	if (!a->slot || a->slot != b->slot)
+		return false;
+
+	if (!local_slot_index(ctx, a->slot, &idx))
+		return false;
+
+	if (!ctx->slots[idx].nr_stores)
+		return true;
+
+	if (single_store(ctx, idx, a->insn, a->bb) &&
+	    single_store(ctx, idx, b->insn, b->bb))
+		return true;
+
+	if (!point_dominates(point, point_bb, b->insn, b->bb) &&
+	    !point_dominates(b->insn, b->bb, point, point_bb))
+		return false;
+
+	if (point_dominates(a->insn, a->bb, b->insn, b->bb))
+		return slot_unchanged(ctx, idx, a->insn, a->bb, b->insn, b->bb);
+
+	if (point_dominates(b->insn, b->bb, a->insn, a->bb))
+		return slot_unchanged(ctx, idx, b->insn, b->bb, a->insn, a->bb);
+
+	return false;
+}
+
+static unsigned long nr_normal_successors(struct compilation_unit *cu,
+					  struct basic_block *bb)
+{
+	unsigned long ret = 0;
+
+	for (unsigned long i = 0; i < bb->nr_successors; i++) {
+		if (!bb_is_eh(cu, bb->successors[i]))
+			ret++;
+	}
+
+	return ret;
+}
+
+static enum ssa_cond negate_cond(enum ssa_cond cond)
+{
+	switch (cond) {
+	case SSA_COND_EQ:
+		return SSA_COND_NE;
+	case SSA_COND_NE:
+		return SSA_COND_EQ;
+	case SSA_COND_LT:
+		return SSA_COND_GE;
+	case SSA_COND_GE:
+		return SSA_COND_LT;
+	case SSA_COND_GT:
+		return SSA_COND_LE;
+	case SSA_COND_LE:
+		return SSA_COND_GT;
+	}
+
+	return cond;
+}
+
+/*
+ * Returns true if @bb is entered only from a conditional branch and
+ * stores the relation that holds on entry to @bb in @fact.
+ */
+static bool edge_fact(struct abc_context *ctx, struct basic_block *bb,
+		      struct abc_fact *fact)
+{
+	struct ssa_insn_info branch, cmp;
+	struct basic_block *pred;
+	struct insn *last;
+
+	if (bb->nr_predecessors != 1)
+		return false;
+
+	pred = bb->predecessors[0];
+	if (bb_is_eh(ctx->cu, pred) || list_is_empty(&pred->insn_list))
+		return false;
+
+	if (nr_normal_successors(ctx->cu, pred) != 2)
+		return false;
+
+	last = bb_last_insn(pred);
+	if (last == bb_first_insn(pred))
+		return false;
+
+	classify(ctx, pred, last, &branch);
+	if (branch.kind != SSA_INSN_BRANCH)
+		return false;
+
+	classify(ctx, pred, prev_insn(last), &cmp);
+	if (cmp.kind != SSA_INSN_CMP)
+		return false;
+
+	fact->insn = prev_insn(last);
+	fact->bb = pred;
+	fact->cond = branch.target == bb ? branch.cond : negate_cond(branch.cond);
+
+	var_value(ctx, cmp.var, &fact->lhs);
+
+	if (cmp.src) {
+		var_value(ctx, cmp.src, &fact->rhs);
+	} else if (cmp.slot) {
+		fact->rhs = (struct abc_value) {
+			.slot	= cmp.slot,
+			.insn	= fact->insn,
+			.bb	= pred,
+		};
+	} else {
+		fact->rhs = (struct abc_value) {
+			.has_imm	= true,
+			.imm		= cmp.imm,
+		};
+	}
+
+	return true;
+}
+
+/* Stores @lo and @hi if the fact says lo < hi.  */
+static bool fact_upper(struct abc_fact *fact, struct abc_value *lo,
+		       struct abc_value *hi)
+{
+	switch (fact->cond) {
+	case SSA_COND_LT:
+		*lo = fact->lhs;
+		*hi = fact->rhs;
+		return true;
+	case SSA_COND_GT:
+		*lo = fact->rhs;
+		*hi = fact->lhs;
+		return true;
+	case SSA_COND_LE:
+		if (!fact->rhs.has_imm || fact->rhs.imm == INT32_MAX)
+			return false;
+
+		*lo = fact->lhs;
+		*hi = (struct abc_value) {
+			.has_imm	= true,
+			.imm		= fact->rhs.imm + 1,
+		};
+		return true;
+	default:
+		return false;
+	}
+}
+
+/* Returns true if the fact says that its left-hand side is >= 0.  */
+static bool fact_nonneg(struct abc_fact *fact)
+{
+	if (!fact->rhs.has_imm)
+		return false;
+
+	switch (fact->cond) {
+	case SSA_COND_GE:
+		return fact->rhs.imm >= 0;
+	case SSA_COND_GT:
+		return fact->rhs.imm >= -1;
+	default:
+		return false;
+	}
+}
+
+#define for_each_dominator(bb, ctx, start)				\
+	for (bb = start; bb; bb = bb == (ctx)->cu->entry_bb ?		\
+		     NULL : (ctx)->cu->doms[bb->dfn])
 
-	for (unsigned i = 0; i < cu->ssa_nr_vregs; i++) {
-		regs_value[i].active = false;
+static bool has_upper_bound(struct abc_context *ctx, struct abc_value *value,
+			    struct basic_block *bb)
+{
+	struct abc_value lo, hi;
+	struct abc_fact fact;
+	struct basic_block *dom;
+
+	for_each_dominator(dom, ctx, bb) {
+		if (!edge_fact(ctx, dom, &fact) || !fact_upper(&fact, &lo, &hi))
+			continue;
 
-		arrays_value[i].active = false;
+		if (same_value(ctx, &lo, fact.insn, fact.bb, value))
+			return true;
 	}
 
-	for_each_basic_block(bb, &cu->bb_list)
-		list_for_each_entry(insn, &bb->insn_list, insn_list_node)
-			if (insn_is_call_to(insn, vm_object_alloc_primitive_array))
-				nr_array_check++;
+	return false;
+}
+
+static bool is_nonneg(struct abc_context *ctx, struct abc_value *value,
+		      struct basic_block *bb, int depth)
+{
+	struct ssa_insn_info info;
+	struct abc_def *def;
+	struct abc_value src;
+	struct abc_fact fact;
+	struct basic_block *dom;
+	unsigned long idx;
+
+	if (value->has_imm)
+		return value->imm >= 0;
+
+	if (local_slot_index(ctx, value->slot, &idx) && ctx->slots[idx].nonneg)
+		return true;
+
+	if (depth < ABC_MAX_DEPTH && var_def(ctx, value->var, &info, &def) &&
+	    info.kind == SSA_INSN_ADD_IMM) {
+		var_value(ctx, info.src, &src);
 
-	struct insn *delete[nr_array_check];
+		if (info.imm == 0 && is_nonneg(ctx, &src, def->bb, depth + 1))
+			return true;
+
+		/* The upper bound rules out overflow. */
+		if (info.imm == 1 && is_nonneg(ctx, &src, def->bb, depth + 1) &&
+		    has_upper_bound(ctx, &src, def->bb))
+			return true;
+	}
+
+	for_each_dominator(dom, ctx, bb) {
+		if (!edge_fact(ctx, dom, &fact) || !fact_nonneg(&fact))
+			continue;
+
+		if (same_value(ctx, &fact.lhs, fact.insn, fact.bb, value))
+			return true;
+	}
+
+	return false;
+}
+
+static bool new_array_length(struct abc_context *ctx, struct var_info *var,
+			     long *len)
+{
+	struct ssa_insn_info info, size;
+
+	if (!var_def(ctx, var, &info, NULL) || info.kind != SSA_INSN_NEW_ARRAY)
+		return false;
+
+	if (info.has_imm) {
+		*len = info.imm;
+	} else if (var_def(ctx, info.src, &size, NULL) && size.kind == SSA_INSN_CONST) {
+		*len = size.imm;
+	} else
+		return false;
+
+	return *len >= 0;
+}
+
+static struct var_info *stored_var(struct abc_context *ctx, unsigned long idx,
+				   struct insn *insn, struct basic_block *bb,
+				   struct insn **store_p)
+{
+	struct ssa_insn_info info;
+	struct insn *store;
+
+	store = single_store(ctx, idx, insn, bb);
+	if (!store)
+		return NULL;
+
+	classify(ctx, ctx->slots[idx].store_bb, store, &info);
+
+	*store_p = store;
+
+	return info.src;
+}
+
+static bool array_const_length(struct abc_context *ctx, struct abc_value *array,
+			       long *len)
+{
+	struct insn *store;
+	unsigned long idx;
+
+	if (new_array_length(ctx, array->var, len))
+		return true;
+
+	if (!local_slot_index(ctx, array->slot, &idx))
+		return false;
+
+	return new_array_length(ctx, stored_var(ctx, idx, array->insn, array->bb, &store), len);
+}
+
+/*
+ * Returns true if @value is the length of @array. @point is where a fact
+ * about @value was established.
+ */
+static bool is_array_length(struct abc_context *ctx, struct abc_value *value,
+			    struct insn *point, struct basic_block *point_bb,
+			    struct abc_value *array)
+{
+	struct ssa_insn_info info;
+	struct abc_value base;
+	struct insn *store = NULL;
+	struct var_info *var;
+	unsigned long idx;
+
+	var = value->var;
+
+	if (!var_def(ctx, var, &info, NULL) || info.kind != SSA_INSN_LOAD_MEMBASE) {
+		/* A local that holds the length, e.g. "int n = a.length;" */
+		if (!local_slot_index(ctx, value->slot, &idx))
+			return false;
+
+		var = stored_var(ctx, idx, value->insn, value->bb, &store);
+		if (!var_def(ctx, var, &info, NULL) || info.kind != SSA_INSN_LOAD_MEMBASE)
+			return false;
+
+		point = store;
+		point_bb = ctx->slots[idx].store_bb;
+	}
+
+	if (info.imm != (long) offsetof(struct vm_array, array_length))
+		return false;
+
+	var_value(ctx, info.src, &base);
+
+	return same_value(ctx, &base, point, point_bb, array);
+}
+
+static bool below_length(struct abc_context *ctx, struct abc_check *check)
+{
+	struct abc_value lo, hi;
+	struct abc_fact fact;
+	struct basic_block *dom;
+	bool has_len;
+	long len = 0;
 
-	for_each_basic_block(bb, &cu->bb_list) {
-		list_for_each_entry_safe(insn, tmp, &bb->insn_list, insn_list_node) {
-			if (insn_is_mov_imm_reg(insn)) {
-				uint32_t reg = insn->dest.reg.interval->var_info->vreg;
+	has_len = array_const_length(ctx, &check->array, &len);
 
-				regs_value[reg].active = true;
-				regs_value[reg].val = insn->src.imm;
+	if (check->index.has_imm)
+		return has_len && check->index.imm < len;
+
+	for_each_dominator(dom, ctx, check->bb) {
+		if (!edge_fact(ctx, dom, &fact) || !fact_upper(&fact, &lo, &hi))
+			continue;
+
+		if (!same_value(ctx, &lo, fact.insn, fact.bb, &check->index))
+			continue;
+
+		if (hi.has_imm) {
+			if (has_len && hi.imm <= len)
+				return true;
+		} else if (is_array_length(ctx, &hi, fact.insn, fact.bb, &check->array))
+			return true;
+	}
+
+	return false;
+}
+
+static bool check_is_redundant(struct abc_context *ctx, struct abc_check *checks,
+			       unsigned long nr_checks, struct abc_check *check)
+{
+	for (unsigned long i = 0; i < nr_checks; i++) {
+		struct abc_check *dom = &checks[i];
+
+		if (dom == check)
+			continue;
+
+		if (!point_dominates(dom->insn, dom->bb, check->insn, check->bb))
+			continue;
+
+		if (same_value(ctx, &dom->array, dom->insn, dom->bb, &check->array) &&
+		    same_value(ctx, &dom->index, dom->insn, dom->bb, &check->index))
+			return true;
+	}
+
+	return false;
+}
+
+static void record_store(struct abc_context *ctx, struct basic_block *bb,
+			 struct insn *insn, unsigned long idx)
+{
+	struct abc_slot *slot;
+
+	if (idx >= ctx->nr_slots)
+		return;
+
+	slot = &ctx->slots[idx];
+	slot->nr_stores++;
+	slot->store = insn;
+	slot->store_bb = bb;
+
+	if (bb_is_eh(ctx->cu, bb))
+		slot->eh_store = true;
+}
+
+static void collect_defs_and_stores(struct abc_context *ctx)
+{
+	struct use_position *regs[MAX_REG_OPERANDS + 1];
+	struct ssa_insn_info info;
+	struct basic_block *bb;
+	struct insn *insn;
+	unsigned long idx;
+
+	for_each_basic_block(bb, &ctx->cu->bb_list) {
+		for_each_insn(insn, &bb->insn_list) {
+			int nr_defs = insn_defs_reg(insn, regs);
+
+			for (int i = 0; i < nr_defs; i++) {
+				struct var_info *var = regs[i]->interval->var_info;
+
+				if (var->vreg >= ctx->nr_vregs)
+					continue;
+
+				ctx->defs[var->vreg].nr_defs++;
+				ctx->defs[var->vreg].insn = insn;
+				ctx->defs[var->vreg].bb = bb;
 			}
 
-			if (insn_is_call_to(insn, vm_object_alloc_primitive_array)) {
-				struct insn *insn_push_size, *insn_mov_eax_array;
-				uint32_t size_reg, array_reg;
+			classify(ctx, bb, insn, &info);
+
+			if (info.kind != SSA_INSN_STORE_LOCAL)
+				continue;
+
+			if (!local_slot_index(ctx, info.slot, &idx))
+				continue;
+
+			record_store(ctx, bb, insn, idx);
+			if (info.wide)
+				record_store(ctx, bb, insn, idx + 1);
+		}
+	}
+}
+
+static bool store_is_nonneg(struct abc_context *ctx, struct basic_block *bb,
+			    struct ssa_insn_info *info)
+{
+	struct abc_value value;
+
+	if (info->wide)
+		return false;
+
+	if (info->has_imm)
+		return info->imm >= 0;
+
+	if (!info->src)
+		return false;
+
+	var_value(ctx, info->src, &value);
 
-				insn_push_size = list_entry(insn->insn_list_node.prev->prev->prev,
-								struct insn, insn_list_node);
-				size_reg = insn_push_size->src.reg.interval->var_info->vreg;
+	return is_nonneg(ctx, &value, bb, 0);
+}
+
+/*
+ * Computes the locals that only ever hold non-negative values. We start
+ * by assuming that all locals that are assigned are non-negative and
+ * drop the ones that are assigned a value which is not known to be
+ * non-negative until nothing changes.
+ */
+static void compute_nonneg_slots(struct abc_context *ctx)
+{
+	struct ssa_insn_info info;
+	struct basic_block *bb;
+	struct insn *insn;
+	unsigned long idx;
+	bool changed;
+
+	for (idx = 0; idx < ctx->nr_slots; idx++) {
+		struct abc_slot *slot = &ctx->slots[idx];
+
+		slot->nonneg = idx >= ctx->nr_args && slot->nr_stores && !slot->eh_store;
+	}
+
+	do {
+		changed = false;
 
-				insn_mov_eax_array = list_entry(insn->insn_list_node.next,
-								struct insn, insn_list_node);
-				array_reg = insn_mov_eax_array->dest.reg.interval->var_info->vreg;
+		for_each_basic_block(bb, &ctx->cu->bb_list) {
+			if (bb_is_eh(ctx->cu, bb))
+				continue;
 
-				if (regs_value[size_reg].active) {
-					arrays_value[array_reg].active = true;
-					arrays_value[array_reg].size = regs_value[size_reg].val;
-				}
+			for_each_insn(insn, &bb->insn_list) {
+				classify(ctx, bb, insn, &info);
+
+				if (info.kind != SSA_INSN_STORE_LOCAL)
+					continue;
+
+				if (!local_slot_index(ctx, info.slot, &idx))
+					continue;
+
+				if (!ctx->slots[idx].nonneg)
+					continue;
+
+				if (store_is_nonneg(ctx, bb, &info))
+					continue;
+
+				ctx->slots[idx].nonneg = false;
+				changed = true;
 			}
+		}
+	} while (changed);
+}
+
+static unsigned long collect_checks(struct abc_context *ctx,
+				    struct abc_check *checks)
+{
+	struct ssa_insn_info info;
+	struct basic_block *bb;
+	struct insn *insn;
+	unsigned long nr = 0;
 
-			if (insn_is_call_to(insn, vm_object_check_array)) {
-				struct insn *insn_push_index, *insn_push_array;
-				uint32_t index_reg, array_reg;
+	for_each_basic_block(bb, &ctx->cu->bb_list) {
+		if (bb_is_eh(ctx->cu, bb))
+			continue;
 
-				insn_push_index = list_entry(insn->insn_list_node.prev->prev,
-								struct insn, insn_list_node);
-				index_reg = insn_push_index->src.reg.interval->var_info->vreg;
+		for_each_insn(insn, &bb->insn_list) {
+			if (!insn_is_call_to(insn, vm_object_check_array))
+				continue;
 
-				insn_push_array = list_entry(insn->insn_list_node.prev,
-								struct insn, insn_list_node);
-				array_reg = insn_push_array->src.reg.interval->var_info->vreg;
+			classify(ctx, bb, insn, &info);
+			if (info.kind != SSA_INSN_ARRAY_CHECK)
+				continue;
 
-				if (regs_value[index_reg].active && arrays_value[array_reg].active) {
-					if (regs_value[index_reg].val < arrays_value[array_reg].size)
-						delete[index++] = insn;
-				}
+			if (!checks) {
+				nr++;
+				continue;
 			}
+
+			checks[nr].insn = insn;
+			checks[nr].bb = bb;
+			checks[nr].remove = false;
+
+			var_value(ctx, info.var, &checks[nr].array);
+
+			if (info.src)
+				var_value(ctx, info.src, &checks[nr].index);
+			else
+				checks[nr].index = (struct abc_value) {
+					.has_imm	= true,
+					.imm		= info.imm,
+				};
+			nr++;
 		}
 	}
 
-	for (int i = 0; i < index; i++) {
-		struct insn *insn_push_index, *insn_push_array,
-			*insn, *insn_args_cleanup,
-			*insn_exception_test1, *insn_exception_test2;
-
-		insn = delete[i];
-		insn_push_index = list_entry(insn->insn_list_node.prev->prev,
-					struct insn, insn_list_node);
-		insn_push_array = list_entry(insn->insn_list_node.prev,
-					struct insn, insn_list_node);
-		insn_args_cleanup = list_entry(insn->insn_list_node.next,
-					struct insn, insn_list_node);
-		insn_exception_test1 = list_entry(insn->insn_list_node.next->next,
-					struct insn, insn_list_node);
-		insn_exception_test2 = list_entry(insn->insn_list_node.next->next->next,
-					struct insn, insn_list_node);
-
-		remove_insn(insn);
-		remove_insn(insn_push_index);
-		remove_insn(insn_push_array);
-		remove_insn(insn_args_cleanup);
-		remove_insn(insn_exception_test1);
-		remove_insn(insn_exception_test2);
+	return nr;
+}
+
+void abc_removal(struct compilation_unit *cu)
+{
+	struct abc_check *checks = NULL;
+	struct abc_context ctx;
+	unsigned long nr_checks;
+
+	if (!(cu->flags & CU_FLAG_ARRAY_OPC))
+		return;
+
+	ctx = (struct abc_context) {
+		.cu		= cu,
+		.nr_vregs	= cu->ssa_nr_vregs,
+		.nr_slots	= cu->stack_frame->nr_local_slots,
+		.nr_args	= vm_method_arg_stack_count(cu->method),
+	};
+
+	nr_checks = collect_checks(&ctx, NULL);
+	if (!nr_checks)
+		return;
+
+	ctx.defs = calloc(ctx.nr_vregs, sizeof *ctx.defs);
+	ctx.slots = calloc(ctx.nr_slots + 1, sizeof *ctx.slots);
+	ctx.visited = alloc_bitset(cu->nr_bb);
+	ctx.worklist = malloc(cu->nr_bb * sizeof *ctx.worklist);
+	checks = malloc(nr_checks * sizeof *checks);
+
+	if (!ctx.defs || !ctx.slots || !ctx.visited || !ctx.worklist || !checks)
+		goto out;
+
+	collect_defs_and_stores(&ctx);
+
+	compute_nonneg_slots(&ctx);
+
+	nr_checks = collect_checks(&ctx, checks);
+
+	for (unsigned long i = 0; i < nr_checks; i++) {
+		struct abc_check *check = &checks[i];
+
+		if (is_nonneg(&ctx, &check->index, check->bb, 0) && below_length(&ctx, check))
+			check->remove = true;
+		else if (check_is_redundant(&ctx, checks, nr_checks, check))
+			check->remove = true;
+	}
+
+	for (unsigned long i = 0; i < nr_checks; i++) {
+		if (checks[i].remove)
+			ssa_remove_array_check(cu, checks[i].bb, checks[i].insn);
 	}
+out:
+	free(checks);
+	free(ctx.worklist);
+	free(ctx.visited);
+	free(ctx.slots);
+	free(ctx.defs);
 }
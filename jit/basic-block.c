@@ -223,7 +223,7 @@ static void ssa_bb_move(struct basic_block *from, struct basic_block *to)
 
 	to->dom_frontier = from->dom_frontier;
 	from->dom_frontier = NULL;
-	to->nr_predecessors_no_eh = from->nr_predecessors_no_eh;
+	to->nr_reachable_predecessors = from->nr_reachable_predecessors;
 	to->positions_as_predecessor = from->positions_as_predecessor;
 	from->positions_as_predecessor = NULL;
 	to->dom_successors = from->dom_successors;
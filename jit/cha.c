@@ -0,0 +1,279 @@
+/*
+ * Class hierarchy analysis.
+ *
+ * This file is released under the GPL version 2. Please refer to the file
+ * LICENSE for details.
+ *
+ * A virtual method that is not overridden by any loaded class can be
+ * invoked directly, which makes the call site inlinable and avoids the
+ * vtable lookup. setup_vtable() marks methods as overridden when a
+ * subclass is linked. Compiled code that relies on a method not being
+ * overridden is recorded as a dependent of that method and is replaced
+ * when the assumption breaks: the entry point of the old code is patched
+ * to jump to a fresh trampoline and all call sites that were fixed up to
+ * call the old code directly are pointed back to the trampoline.
+ *
+ * We don't deoptimize activations that are already running the old code.
+ * This is safe because calls are only bound when the receiver is a
+ * parameter the method never stores to: the receiver object existed
+ * before the activation started so its class was linked before the
+ * overriding class was. Such a receiver can never dispatch to the new
+ * method.
+ */
+
+#include "jit/cha.h"
+
+#include "jit/compilation-unit.h"
+#include "jit/expression.h"
+#include "jit/compiler.h"
+
+#include "vm/bytecode.h"
+#include "vm/method.h"
+#include "vm/class.h"
+#include "vm/die.h"
+
+#include "lib/stack.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+bool opt_cha_enabled = true;
+
+struct cha_dependency {
+	struct compilation_unit *cu;
+	struct cha_dependency *next;
+};
+
+/* Protects vm_method::overridden, ::cha_dependents and cu->cha_* flags */
+static pthread_mutex_t cha_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* Returns a bitmap of the reference locals that @vmm stores to. */
+static uint64_t stored_locals(struct vm_method *vmm)
+{
+	struct cafebabe_code_attribute *code = &vmm->code_attribute;
+	uint64_t ret = 0;
+	unsigned long pc;
+
+	bytecode_for_each_insn(code->code, code->code_length, pc) {
+		const unsigned char *insn = code->code + pc;
+		unsigned int idx;
+
+		switch (insn[0]) {
+		case OPC_ASTORE:
+			idx = read_u8(insn + 1);
+			break;
+		case OPC_ASTORE_0 ... OPC_ASTORE_3:
+			idx = insn[0] - OPC_ASTORE_0;
+			break;
+		case OPC_WIDE:
+			if (insn[1] != OPC_ASTORE)
+				continue;
+			idx = read_u16(insn + 2);
+			break;
+		default:
+			continue;
+		}
+
+		if (idx < 64)
+			ret |= 1ULL << idx;
+	}
+
+	return ret;
+}
+
+static bool receiver_preexists(struct parse_context *ctx, struct vm_method *target)
+{
+	struct stack *stack = ctx->bb->mimic_stack;
+	struct compilation_unit *cu = ctx->cu;
+	struct expression *receiver;
+	unsigned long nr_values, idx;
+
+	nr_values = count_java_arguments(target) + 1;
+	if (stack->nr_elements < nr_values)
+		return false;
+
+	receiver = stack->elements[stack->nr_elements - nr_values];
+
+	if (expr_type(receiver) != EXPR_LOCAL || receiver->vm_type != J_REFERENCE)
+		return false;
+
+	idx = receiver->local_index;
+	if (idx >= vm_method_arg_stack_count(cu->method) || idx >= 64)
+		return false;
+
+	if (!cu->cha_args_scanned) {
+		cu->cha_stored_args = stored_locals(cu->method);
+		cu->cha_args_scanned = true;
+	}
+
+	return !(cu->cha_stored_args & (1ULL << idx));
+}
+
+static bool add_dependency(struct compilation_unit *cu, struct vm_method *target)
+{
+	struct cha_dependency *dep;
+	bool ret = false;
+
+	pthread_mutex_lock(&cha_mutex);
+
+	if (target->overridden)
+		goto out_unlock;
+
+	for (dep = target->cha_dependents; dep; dep = dep->next) {
+		if (dep->cu == cu)
+			goto out_bound;
+	}
+
+	dep = malloc(sizeof *dep);
+	if (!dep)
+		goto out_unlock;
+
+	dep->cu = cu;
+	dep->next = target->cha_dependents;
+	target->cha_dependents = dep;
+
+out_bound:
+	cu->cha_dependent = true;
+	ret = true;
+out_unlock:
+	pthread_mutex_unlock(&cha_mutex);
+
+	return ret;
+}
+
+/*
+ * Returns true if the invokevirtual of @target being converted can be
+ * bound directly to @target. The compilation unit then depends on @target
+ * not being overridden.
+ */
+bool cha_devirtualize(struct parse_context *ctx, struct vm_method *target)
+{
+	if (!opt_cha_enabled)
+		return false;
+
+	if (target->flags & VM_METHOD_FLAG_MISSING)
+		return false;
+
+	if (vm_method_is_static(target) || vm_method_is_abstract(target))
+		return false;
+
+	if (vm_class_is_interface(target->class))
+		return false;
+
+	if (!receiver_preexists(ctx, target))
+		return false;
+
+	return add_dependency(ctx->cu, target);
+}
+
+/*
+ * Redirects the code of @cu to the method's trampoline. If @cu is still
+ * the method's compilation unit, the method gets a new one first so that
+ * the next invocation compiles it without the broken assumptions.
+ */
+static void replace_code(struct compilation_unit *cu)
+{
+	struct jit_trampoline *old_trampoline = NULL;
+	struct vm_method *vmm = cu->method;
+	struct compilation_unit *new_cu;
+
+	if (cu == vmm->compilation_unit) {
+		old_trampoline = vmm->trampoline;
+
+		if (vm_method_reset_jit(vmm))
+			die("out of memory");
+
+		new_cu = vmm->compilation_unit;
+		new_cu->cha_replaced_entry = cu_entry_point(cu);
+		new_cu->cha_replaced_trampoline = buffer_ptr(old_trampoline->objcode);
+	}
+
+	fixup_entry_point(cu_entry_point(cu), vm_method_trampoline_ptr(vmm));
+
+	if (old_trampoline)
+		retarget_direct_calls(old_trampoline, vmm->trampoline);
+
+	if (method_is_virtual(vmm))
+		vmm->class->vtable.native_ptr[vmm->virtual_index]
+			= vm_method_trampoline_ptr(vmm);
+}
+
+/*
+ * Marks @cu invalid. Returns true if the caller must replace its code.
+ * Code that is still being compiled is replaced by cha_install() once the
+ * entry point is known. Called with cha_mutex held.
+ */
+static bool invalidate(struct compilation_unit *cu)
+{
+	if (cu->cha_invalid)
+		return false;
+
+	cu->cha_invalid = true;
+
+	return cu->cha_installed;
+}
+
+/*
+ * Called by setup_vtable() when a class that overrides @vmm is linked.
+ */
+void cha_method_overridden(struct vm_method *vmm)
+{
+	struct cha_dependency *dep, *next, *stale = NULL;
+
+	pthread_mutex_lock(&cha_mutex);
+
+	if (vmm->overridden) {
+		pthread_mutex_unlock(&cha_mutex);
+		return;
+	}
+
+	vmm->overridden = true;
+
+	for (dep = vmm->cha_dependents; dep; dep = next) {
+		next = dep->next;
+
+		if (invalidate(dep->cu)) {
+			dep->next = stale;
+			stale = dep;
+		} else
+			free(dep);
+	}
+
+	vmm->cha_dependents = NULL;
+
+	pthread_mutex_unlock(&cha_mutex);
+
+	/*
+	 * Replacing code allocates a compilation unit and a trampoline so do
+	 * it without cha_mutex. invalidate() hands each unit to one thread.
+	 */
+	for (dep = stale; dep; dep = next) {
+		next = dep->next;
+
+		replace_code(dep->cu);
+		free(dep);
+	}
+}
+
+/*
+ * Called after @cu has been compiled. Replaces the code right away if an
+ * assumption broke during compilation.
+ */
+void cha_install(struct compilation_unit *cu)
+{
+	bool invalid;
+
+	if (!cu->cha_dependent)
+		return;
+
+	pthread_mutex_lock(&cha_mutex);
+
+	cu->cha_installed = true;
+	invalid = cu->cha_invalid;
+
+	pthread_mutex_unlock(&cha_mutex);
+
+	if (invalid)
+		replace_code(cu);
+}
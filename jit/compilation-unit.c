@@ -30,6 +30,7 @@
 #include "jit/args.h"
 #include "jit/basic-block.h"
 #include "jit/compilation-unit.h"
+#include "jit/exception.h"
 #include "jit/instruction.h"
 #include "jit/stack-slot.h"
 #include "jit/statement.h"
@@ -247,7 +248,7 @@ void free_compilation_unit(struct compilation_unit *cu)
 	free_lookupswitch_list(cu);
 	free_tableswitch_list(cu);
 	free_lir_insn_map(cu);
-	free(cu->exception_handlers);
+	free_exception_handlers_table(cu);
 	free_constant_pool(cu->pool_head);
 	free(cu);
 }
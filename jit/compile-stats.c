@@ -0,0 +1,92 @@
+/*
+ * JIT compile time statistics.
+ *
+ * This file is released under the GPL version 2. Please refer to the file
+ * LICENSE for details.
+ *
+ * The time compile() spends in each phase is summed up over all compiled
+ * methods and reported when the VM exits.
+ */
+
+#include "jit/compile-stats.h"
+
+#include "vm/startup.h"
+
+#include <pthread.h>
+#include <stdio.h>
+
+bool opt_log_compile;
+
+static const char *compile_phase_names[COMPILE_PHASE_MAX] = {
+	[COMPILE_PHASE_PARSE]		= "parse",
+	[COMPILE_PHASE_TREE_IR]		= "tree_ir",
+	[COMPILE_PHASE_SELECT]		= "select",
+	[COMPILE_PHASE_SSA]		= "ssa",
+	[COMPILE_PHASE_LIVENESS]	= "liveness",
+	[COMPILE_PHASE_REGALLOC]	= "regalloc",
+	[COMPILE_PHASE_SPILL_RELOAD]	= "spill_reload",
+	[COMPILE_PHASE_PEEPHOLE]	= "peephole",
+	[COMPILE_PHASE_EMIT]		= "emit",
+};
+
+static uint64_t compile_phase_time[COMPILE_PHASE_MAX];
+
+static unsigned long nr_compiled;
+static unsigned long nr_compiled_large;
+
+static pthread_mutex_t compile_stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * Adds the time since @start to @phase and sets @start to the current time
+ * so that consecutive phases can share one clock reading.
+ */
+void compile_phase_end(enum compile_phase phase, uint64_t *start)
+{
+	uint64_t now;
+
+	if (!opt_log_compile)
+		return;
+
+	now = startup_clock();
+
+	pthread_mutex_lock(&compile_stats_mutex);
+	compile_phase_time[phase] += now - *start;
+	pthread_mutex_unlock(&compile_stats_mutex);
+
+	*start = now;
+}
+
+void compile_stats_record(bool large_method)
+{
+	if (!opt_log_compile)
+		return;
+
+	pthread_mutex_lock(&compile_stats_mutex);
+
+	nr_compiled++;
+	if (large_method)
+		nr_compiled_large++;
+
+	pthread_mutex_unlock(&compile_stats_mutex);
+}
+
+void compile_stats_exit(void)
+{
+	uint64_t total = 0;
+
+	if (!opt_log_compile)
+		return;
+
+	pthread_mutex_lock(&compile_stats_mutex);
+
+	for (unsigned int i = 0; i < COMPILE_PHASE_MAX; i++) {
+		fprintf(stderr, "compile: %-32s %10.3f ms\n",
+			compile_phase_names[i], compile_phase_time[i] / 1000000.0);
+		total += compile_phase_time[i];
+	}
+
+	fprintf(stderr, "compile: %-32s %10.3f ms\n", "total", total / 1000000.0);
+	fprintf(stderr, "compile: %lu methods, %lu large\n", nr_compiled, nr_compiled_large);
+
+	pthread_mutex_unlock(&compile_stats_mutex);
+}
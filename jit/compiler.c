@@ -14,12 +14,14 @@
 #include "jit/compilation-unit.h"
 #include "jit/statement.h"
 #include "jit/bc-offset-mapping.h"
+#include "jit/compile-stats.h"
 #include "jit/exception.h"
 #include "jit/perf-map.h"
 #include "jit/subroutine.h"
 
 #include "vm/class.h"
 #include "vm/method.h"
+#include "vm/startup.h"
 #include "vm/trace.h"
 
 #include <errno.h>
@@ -51,16 +53,33 @@ static void perf_append_cu(struct compilation_unit *cu)
 	perf_map_append(symbol, addr, size);
 }
 
-static bool uses_array_ops(struct compilation_unit *cu)
+/*
+ * Methods with more bytecode than this are compiled in a cheaper mode: no
+ * SSA optimizations and a simpler register allocation. Large generated
+ * methods like parsers and state machines would otherwise take seconds to
+ * compile.
+ */
+unsigned long opt_large_method_size = 8000;
+
+static bool is_large_method(struct vm_method *vmm)
 {
-	return cu->flags & CU_FLAG_ARRAY_OPC;
+	return vmm->code_attribute.code_length > opt_large_method_size;
 }
 
 int compile(struct compilation_unit *cu)
 {
 	bool ssa_enable;
+	uint64_t start;
+	uint64_t phase;
 	int err;
 
+	start = opt_log_startup ? startup_clock() : 0;
+	phase = opt_log_compile ? startup_clock() : 0;
+
+	err = vm_method_load_code(cu->method);
+	if (err)
+		goto out;
+
 	if (opt_print_compilation)
 		print_compilation(cu->method);
 
@@ -78,11 +97,24 @@ int compile(struct compilation_unit *cu)
 	if (err)
 		goto out;
 
+	compile_phase_end(COMPILE_PHASE_PARSE, &phase);
+
 	err = convert_to_ir(cu);
 	if (err)
 		goto out;
 
-	ssa_enable = opt_ssa_enable && uses_array_ops(cu);
+	err = remove_null_checks(cu);
+	if (err)
+		goto out;
+
+	err = scalar_replace_allocations(cu);
+	if (err)
+		goto out;
+
+	if (is_large_method(cu->method))
+		cu->flags |= CU_FLAG_LARGE_METHOD;
+
+	ssa_enable = opt_ssa_enable && !(cu->flags & CU_FLAG_LARGE_METHOD);
 
 	if (ssa_enable) {
 		err = compute_dfns(cu);
@@ -96,12 +128,16 @@ int compile(struct compilation_unit *cu)
 	if (opt_trace_tree_ir)
 		trace_tree_ir(cu);
 
+	compile_phase_end(COMPILE_PHASE_TREE_IR, &phase);
+
 	err = select_instructions(cu);
 	if (err)
 		goto out;
 
 	compute_insn_positions(cu);
 
+	compile_phase_end(COMPILE_PHASE_SELECT, &phase);
+
 	if (opt_trace_lir)
 		trace_lir(cu);
 
@@ -121,8 +157,20 @@ int compile(struct compilation_unit *cu)
 		if(opt_trace_ssa)
 			trace_ssa(cu);
 
+		err = sccp(cu);
+		if (err)
+			goto out;
+
 		imm_copy_propagation(cu);
 
+		err = gvn(cu);
+		if (err)
+			goto out;
+
+		err = licm(cu);
+		if (err)
+			goto out;
+
 		abc_removal(cu);
 
 		err = dce(cu);
@@ -132,6 +180,8 @@ int compile(struct compilation_unit *cu)
 		err = ssa_to_lir(cu);
 		if (err)
 			goto out;
+
+		compile_phase_end(COMPILE_PHASE_SSA, &phase);
 	}
 
 	err = analyze_liveness(cu);
@@ -141,10 +191,14 @@ int compile(struct compilation_unit *cu)
 	if (opt_trace_liveness)
 		trace_liveness(cu);
 
+	compile_phase_end(COMPILE_PHASE_LIVENESS, &phase);
+
 	err = allocate_registers(cu);
 	if (err)
 		goto out;
 
+	compile_phase_end(COMPILE_PHASE_REGALLOC, &phase);
+
 	err = mark_clobbers(cu);
 	if (err)
 		goto out;
@@ -156,6 +210,8 @@ int compile(struct compilation_unit *cu)
 	if (opt_trace_regalloc)
 		trace_regalloc(cu);
 
+	compile_phase_end(COMPILE_PHASE_SPILL_RELOAD, &phase);
+
 	err = convert_ic_calls(cu);
 	if (err)
 		goto out;
@@ -166,6 +222,8 @@ int compile(struct compilation_unit *cu)
 	if (err)
 		goto out;
 
+	compile_phase_end(COMPILE_PHASE_PEEPHOLE, &phase);
+
 	err = emit_machine_code(cu);
 	if (err)
 		goto out;
@@ -174,12 +232,20 @@ int compile(struct compilation_unit *cu)
 	if (err)
 		goto out;
 
+	if (opt_trace_peephole)
+		trace_code_size(cu);
+
 	if (opt_trace_machine_code)
 		trace_machine_code(cu);
 
 	resolve_fixup_offsets(cu);
 
+	compile_phase_end(COMPILE_PHASE_EMIT, &phase);
+	compile_stats_record(cu->flags & CU_FLAG_LARGE_METHOD);
+
 	perf_append_cu(cu);
+
+	startup_record_compile(cu->method, start);
   out:
 	if (opt_trace_compile)
 		trace_flush();
@@ -39,9 +39,13 @@
  * compilation unit. Only method entry address is stored in the tree
  * structure, so that inserting and removing compilation unit mapping
  * is fast.
+ *
+ * Lookups take no locks so that stack walks, exception unwinding and
+ * signal handlers do not contend on a shared lock word. They are
+ * async-signal-safe. Updates are serialized by cu_map_mutex.
  */
 static struct radix_tree *cu_map;
-static pthread_rwlock_t cu_map_rwlock = PTHREAD_RWLOCK_INITIALIZER;
+static pthread_mutex_t cu_map_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 #define BITS_PER_LEVEL 6
 
@@ -52,33 +56,29 @@ void init_cu_mapping(void)
 	cu_map = alloc_radix_tree(BITS_PER_LEVEL, key_bits);
 	if (!cu_map)
 		die("out of memory");
+
+	cu_map->lockless_lookup = true;
 }
 
 int add_cu_mapping(unsigned long addr, struct compilation_unit *cu)
 {
 	int result;
 
-	pthread_rwlock_wrlock(&cu_map_rwlock);
+	pthread_mutex_lock(&cu_map_mutex);
 	result = radix_tree_insert(cu_map, addr, cu);
-	pthread_rwlock_unlock(&cu_map_rwlock);
+	pthread_mutex_unlock(&cu_map_mutex);
 
 	return result;
 }
 
 void remove_cu_mapping(unsigned long addr)
 {
-	pthread_rwlock_wrlock(&cu_map_rwlock);
+	pthread_mutex_lock(&cu_map_mutex);
 	radix_tree_remove(cu_map, addr);
-	pthread_rwlock_unlock(&cu_map_rwlock);
+	pthread_mutex_unlock(&cu_map_mutex);
 }
 
 struct compilation_unit *jit_lookup_cu(unsigned long addr)
 {
-	struct compilation_unit *cu;
-
-	pthread_rwlock_rdlock(&cu_map_rwlock);
-	cu = radix_tree_lookup_prev(cu_map, addr);
-	pthread_rwlock_unlock(&cu_map_rwlock);
-
-	return cu;
+	return radix_tree_lookup_prev(cu_map, addr);
 }
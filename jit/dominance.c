@@ -57,8 +57,29 @@ static void do_compute_dfns(struct basic_block *bb, struct basic_block **df_arra
 	}
 }
 
+static void mark_eh_reachable(struct basic_block *bb)
+{
+	unsigned int i;
+
+	if (bb->eh_reachable)
+		return;
+
+	bb->eh_reachable = true;
+
+	for (i = 0; i < bb->nr_successors; i++)
+		mark_eh_reachable(bb->successors[i]);
+}
+
+/*
+ * Exception handlers have no predecessors in the control flow graph
+ * because they are entered from any instruction in their try blocks that
+ * can throw. We number them as if the entry block had an edge to each of
+ * them, which makes them immediate dominator tree children of the entry
+ * block.
+ */
 int compute_dfns(struct compilation_unit *cu)
 {
+	struct basic_block *bb;
 	int dfn = 0;
 
 	cu->bb_df_array	= zalloc(sizeof(struct basic_block *) * nr_bblocks(cu));
@@ -69,6 +90,23 @@ int compute_dfns(struct compilation_unit *cu)
 
 	do_compute_dfns(cu->entry_bb, cu->bb_df_array, &dfn, cu->entry_bb);
 
+	for_each_basic_block(bb, &cu->bb_list) {
+		if (!bb->is_eh)
+			continue;
+
+		if (!bb->dfn && bb != cu->entry_bb) {
+			dfn++;
+
+			bb->dfn			= dfn;
+
+			cu->bb_df_array[bb->dfn]	= bb;
+
+			do_compute_dfns(bb, cu->bb_df_array, &dfn, cu->entry_bb);
+		}
+
+		mark_eh_reachable(bb);
+	}
+
 	return 0;
 }
 
@@ -118,6 +156,18 @@ int compute_dom(struct compilation_unit *cu)
 			if (!b || !b->dfn)
 				continue;
 
+			/*
+			 * The virtual edge from the entry block makes it the
+			 * immediate dominator of every exception handler.
+			 */
+			if (b->is_eh && b != start) {
+				if (cu->doms[b->dfn] != start) {
+					cu->doms[b->dfn]	= start;
+					changed		= true;
+				}
+				continue;
+			}
+
 			new_idom	= NULL;
 			for (i = 0; i < b->nr_predecessors; i++) {
 				struct basic_block *p = b->predecessors[i];
@@ -172,7 +222,11 @@ int compute_dom_frontier(struct compilation_unit *cu)
 	}
 
 	for_each_basic_block(b, &cu->bb_list) {
-		if (b->nr_predecessors >= 2) {
+		if (!b->dfn && b != start)
+			continue;
+
+		/* Exception handlers have a virtual edge from the entry block. */
+		if (b->nr_predecessors + b->is_eh >= 2) {
 			unsigned int i;
 
 			for (i = 0; i < b->nr_predecessors; i++) {
@@ -206,7 +206,14 @@ int emit_machine_code(struct compilation_unit *cu)
 		ic_check = emit_ic_check(buf);
 	}
 
-	cu->entry_point = buffer_current(buf);
+	/*
+	 * Code that depends on class hierarchy assumptions is redirected at
+	 * its entry point when the assumptions break. See jit/cha.c.
+	 */
+	if (cu->cha_dependent)
+		cu->entry_point = emit_patchable_entry(buf);
+	else
+		cu->entry_point = buffer_current(buf);
 
 	emit_prolog(cu->objcode, cu->stack_frame, frame_size);
 
@@ -275,6 +282,7 @@ struct jit_trampoline *alloc_jit_trampoline(void)
 		goto failed;
 
 	INIT_LIST_HEAD(&trampoline->fixup_site_list);
+	INIT_LIST_HEAD(&trampoline->patched_site_list);
 	pthread_mutex_init(&trampoline->mutex, NULL);
 
 	return trampoline;
@@ -103,7 +103,9 @@ int emulate_dcmpg(double value1, double value2)
 int32_t emulate_idiv(int32_t value1, int32_t value2)
 {
 	if (value2 == 0) {
-		signal_new_exception(vm_java_lang_ArithmeticException, "division by zero");
+		signal_implicit_exception(vm_java_lang_ArithmeticException, "division by zero",
+					  (unsigned long) __builtin_return_address(0));
+		helper_return_on_exception();
 		return 0;
 	}
 
@@ -113,7 +115,9 @@ int32_t emulate_idiv(int32_t value1, int32_t value2)
 int32_t emulate_irem(int32_t value1, int32_t value2)
 {
 	if (value2 == 0) {
-		signal_new_exception(vm_java_lang_ArithmeticException, "division by zero");
+		signal_implicit_exception(vm_java_lang_ArithmeticException, "division by zero",
+					  (unsigned long) __builtin_return_address(0));
+		helper_return_on_exception();
 		return 0;
 	}
 
@@ -123,8 +127,9 @@ int32_t emulate_irem(int32_t value1, int32_t value2)
 long long emulate_ldiv(long long value1, long long value2)
 {
 	if (value2 == 0) {
-		signal_new_exception(vm_java_lang_ArithmeticException,
-					"division by zero");
+		signal_implicit_exception(vm_java_lang_ArithmeticException, "division by zero",
+					  (unsigned long) __builtin_return_address(0));
+		helper_return_on_exception();
 		return 0;
 	}
 
@@ -134,8 +139,9 @@ long long emulate_ldiv(long long value1, long long value2)
 long long emulate_lrem(long long value1, long long value2)
 {
 	if (value2 == 0) {
-		signal_new_exception(vm_java_lang_ArithmeticException,
-					"division by zero");
+		signal_implicit_exception(vm_java_lang_ArithmeticException, "division by zero",
+					  (unsigned long) __builtin_return_address(0));
+		helper_return_on_exception();
 		return 0;
 	}
 
@@ -0,0 +1,625 @@
+/*
+ * Escape analysis and scalar replacement.
+ *
+ * This file is released under the GPL version 2. Please refer to the file
+ * LICENSE for details.
+ *
+ * An object allocated with 'new' does not escape if its reference is only
+ * copied between local variables and temporaries, used to access its own
+ * fields, and locked. Such an allocation is removed and every field that
+ * is accessed gets a temporary of its own which is initialized to the
+ * default value at the allocation site. Monitor operations on the object
+ * are dropped because no other thread can ever see it.
+ *
+ * The analysis runs on the tree IR after inlining so small constructors
+ * and accessors that were inlined do not make the object escape. Any other
+ * use of the reference, including passing it to a method that was not
+ * inlined, comparing it, or storing it to the heap, makes it escape.
+ *
+ * The variables that hold the reference must not be assigned any other
+ * value. Bytecode that passes the verifier can then only read a variable
+ * after the allocation that it was last copied from so the scalars always
+ * describe the right object, even if the allocation is inside a loop.
+ * Methods with exception handlers are skipped because temporaries are not
+ * preserved across exception edges.
+ */
+
+#include "jit/compilation-unit.h"
+#include "jit/basic-block.h"
+#include "jit/expression.h"
+#include "jit/statement.h"
+#include "jit/compiler.h"
+
+#include "lib/bitset.h"
+
+#include "vm/method.h"
+#include "vm/class.h"
+#include "vm/field.h"
+#include "vm/types.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+struct scalar_field {
+	struct vm_field *field;
+	struct expression *scalar;
+};
+
+struct escape_context {
+	struct compilation_unit *cu;
+	unsigned long nr_locals;
+
+	/* The allocation that is analyzed. */
+	struct statement *alloc;
+
+	/* Local variables and temporaries that hold the reference. */
+	struct bitset *locals;
+	struct var_info **temps;
+	unsigned long nr_temps;
+
+	/* Fields that are accessed through the reference. */
+	struct scalar_field *fields;
+	unsigned long nr_fields;
+};
+
+static bool is_alias_temp(struct escape_context *ctx, struct var_info *var)
+{
+	unsigned long i;
+
+	for (i = 0; i < ctx->nr_temps; i++) {
+		if (ctx->temps[i] == var)
+			return true;
+	}
+
+	return false;
+}
+
+static bool is_alias(struct escape_context *ctx, struct expression *expr)
+{
+	if (expr_type(expr) == EXPR_NULL_CHECK)
+		expr = to_expr(expr->null_check_ref);
+
+	if (expr->vm_type != J_REFERENCE)
+		return false;
+
+	switch (expr_type(expr)) {
+	case EXPR_LOCAL:
+		return expr->local_index < ctx->nr_locals &&
+			test_bit(ctx->locals->bits, expr->local_index);
+	case EXPR_TEMPORARY:
+		return is_alias_temp(ctx, expr->tmp_low);
+	default:
+		return false;
+	}
+}
+
+static int add_alias(struct escape_context *ctx, struct expression *expr)
+{
+	struct var_info **temps;
+
+	if (is_alias(ctx, expr))
+		return 0;
+
+	if (expr_type(expr) == EXPR_LOCAL) {
+		if (expr->local_index >= ctx->nr_locals)
+			return -EINVAL;
+
+		set_bit(ctx->locals->bits, expr->local_index);
+		return 1;
+	}
+
+	temps = realloc(ctx->temps, (ctx->nr_temps + 1) * sizeof(*temps));
+	if (!temps)
+		return -ENOMEM;
+
+	temps[ctx->nr_temps++] = expr->tmp_low;
+	ctx->temps = temps;
+
+	return 1;
+}
+
+/*
+ * Returns true if a store to @dest overwrites one of the variables that
+ * hold the reference.
+ */
+static bool writes_alias(struct escape_context *ctx, struct expression *dest)
+{
+	unsigned long idx;
+	int i;
+
+	switch (expr_type(dest)) {
+	case EXPR_LOCAL:
+	case EXPR_FLOAT_LOCAL:
+		for (i = 0; i < vm_type_slot_size(dest->vm_type); i++) {
+			idx = dest->local_index + i;
+			if (idx < ctx->nr_locals && test_bit(ctx->locals->bits, idx))
+				return true;
+		}
+		return false;
+	case EXPR_TEMPORARY:
+		return is_alias_temp(ctx, dest->tmp_low);
+	default:
+		return false;
+	}
+}
+
+static bool is_variable(struct expression *expr)
+{
+	if (expr->vm_type != J_REFERENCE)
+		return false;
+
+	return expr_type(expr) == EXPR_LOCAL || expr_type(expr) == EXPR_TEMPORARY;
+}
+
+static bool is_alias_copy(struct escape_context *ctx, struct statement *stmt)
+{
+	if (stmt_type(stmt) != STMT_STORE)
+		return false;
+
+	return is_variable(to_expr(stmt->store_dest)) && is_alias(ctx, to_expr(stmt->store_src));
+}
+
+static int compute_aliases(struct escape_context *ctx)
+{
+	struct basic_block *bb;
+	struct statement *stmt;
+	bool changed;
+	int err;
+
+	err = add_alias(ctx, to_expr(ctx->alloc->store_dest));
+	if (err < 0)
+		return err;
+
+	do {
+		changed = false;
+
+		for_each_basic_block(bb, &ctx->cu->bb_list) {
+			for_each_stmt(stmt, &bb->stmt_list) {
+				if (!is_alias_copy(ctx, stmt))
+					continue;
+
+				err = add_alias(ctx, to_expr(stmt->store_dest));
+				if (err < 0)
+					return err;
+
+				if (err)
+					changed = true;
+			}
+		}
+	} while (changed);
+
+	return 0;
+}
+
+static bool is_field_access(struct escape_context *ctx, struct expression *expr)
+{
+	switch (expr_type(expr)) {
+	case EXPR_INSTANCE_FIELD:
+	case EXPR_FLOAT_INSTANCE_FIELD:
+		return is_alias(ctx, to_expr(expr->objectref_expression));
+	default:
+		return false;
+	}
+}
+
+static enum vm_type scalar_type(struct vm_field *field)
+{
+	enum vm_type type = vm_field_type(field);
+
+	switch (type) {
+	case J_BOOLEAN:
+	case J_BYTE:
+	case J_CHAR:
+	case J_SHORT:
+		return J_INT;
+	default:
+		return type;
+	}
+}
+
+static struct expression *lookup_scalar(struct escape_context *ctx, struct vm_field *field)
+{
+	unsigned long i;
+
+	for (i = 0; i < ctx->nr_fields; i++) {
+		if (ctx->fields[i].field == field)
+			return ctx->fields[i].scalar;
+	}
+
+	return NULL;
+}
+
+static int add_field(struct escape_context *ctx, struct vm_field *field)
+{
+	struct scalar_field *fields;
+
+	if (lookup_scalar(ctx, field))
+		return 0;
+
+	fields = realloc(ctx->fields, (ctx->nr_fields + 1) * sizeof(*fields));
+	if (!fields)
+		return -ENOMEM;
+
+	ctx->fields = fields;
+
+	fields[ctx->nr_fields].field = field;
+	fields[ctx->nr_fields].scalar = temporary_expr(scalar_type(field), ctx->cu);
+	if (!fields[ctx->nr_fields].scalar)
+		return -ENOMEM;
+
+	ctx->nr_fields++;
+
+	return 0;
+}
+
+/*
+ * Returns zero if the reference does not escape through @expr which is
+ * evaluated as an rvalue.
+ */
+static int check_expr(struct escape_context *ctx, struct expression *expr)
+{
+	int i, err;
+
+	if (is_alias(ctx, expr))
+		return -EINVAL;
+
+	if (is_field_access(ctx, expr))
+		return add_field(ctx, expr->instance_field);
+
+	for (i = 0; i < expr_nr_kids(expr); i++) {
+		if (!expr->node.kids[i])
+			continue;
+
+		err = check_expr(ctx, to_expr(expr->node.kids[i]));
+		if (err)
+			return err;
+	}
+
+	return 0;
+}
+
+static bool is_removable_use(struct escape_context *ctx, struct statement *stmt)
+{
+	switch (stmt_type(stmt)) {
+	case STMT_EXPRESSION:
+	case STMT_MONITOR_ENTER:
+	case STMT_MONITOR_EXIT:
+		return is_alias(ctx, to_expr(stmt->expression));
+	case STMT_STORE:
+		return stmt == ctx->alloc || is_alias_copy(ctx, stmt);
+	default:
+		return false;
+	}
+}
+
+static int check_stmt(struct escape_context *ctx, struct statement *stmt)
+{
+	struct expression *dest, *result;
+	int i, err;
+
+	if (is_removable_use(ctx, stmt))
+		return 0;
+
+	switch (stmt_type(stmt)) {
+	case STMT_STORE:
+		dest = to_expr(stmt->store_dest);
+
+		/* The variables must not hold anything else. */
+		if (writes_alias(ctx, dest))
+			return -EINVAL;
+
+		if (is_field_access(ctx, dest)) {
+			err = add_field(ctx, dest->instance_field);
+			if (err)
+				return err;
+
+			return check_expr(ctx, to_expr(stmt->store_src));
+		}
+		break;
+	case STMT_INVOKE:
+	case STMT_INVOKEVIRTUAL:
+	case STMT_INVOKEINTERFACE:
+		result = stmt->invoke_result;
+		if (result && writes_alias(ctx, result))
+			return -EINVAL;
+		break;
+	default:
+		break;
+	}
+
+	for (i = 0; i < stmt_nr_kids(stmt); i++) {
+		if (!stmt->node.kids[i])
+			continue;
+
+		err = check_expr(ctx, to_expr(stmt->node.kids[i]));
+		if (err)
+			return err;
+	}
+
+	return 0;
+}
+
+static int check_uses(struct escape_context *ctx)
+{
+	struct basic_block *bb;
+	struct statement *stmt;
+	int err;
+
+	for_each_basic_block(bb, &ctx->cu->bb_list) {
+		for_each_stmt(stmt, &bb->stmt_list) {
+			err = check_stmt(ctx, stmt);
+			if (err)
+				return err;
+		}
+	}
+
+	return 0;
+}
+
+static struct expression *scalar_get(struct escape_context *ctx, struct vm_field *field)
+{
+	struct expression *scalar = lookup_scalar(ctx, field);
+
+	expr_get(scalar);
+
+	return scalar;
+}
+
+static void replace_field_loads(struct escape_context *ctx, struct tree_node **kidp)
+{
+	struct expression *expr = to_expr(*kidp);
+	int i;
+
+	if (is_field_access(ctx, expr)) {
+		*kidp = &scalar_get(ctx, expr->instance_field)->node;
+		expr_put(expr);
+		return;
+	}
+
+	for (i = 0; i < expr_nr_kids(expr); i++) {
+		if (expr->node.kids[i])
+			replace_field_loads(ctx, &expr->node.kids[i]);
+	}
+}
+
+static struct expression *default_value(enum vm_type type)
+{
+	if (vm_type_is_float(type))
+		return fvalue_expr(type, 0.0);
+
+	return value_expr(type, 0);
+}
+
+static int insert_store_before(struct statement *pos, struct expression *dest,
+			       struct expression *src)
+{
+	struct statement *stmt;
+
+	stmt = alloc_statement(STMT_STORE);
+	if (!stmt) {
+		expr_put(dest);
+		expr_put(src);
+		return -ENOMEM;
+	}
+
+	stmt->store_dest = &dest->node;
+	stmt->store_src = &src->node;
+	stmt->bytecode_offset = pos->bytecode_offset;
+
+	list_add_tail(&stmt->stmt_list_node, &pos->stmt_list_node);
+
+	return 0;
+}
+
+static int initialize_scalars(struct escape_context *ctx)
+{
+	unsigned long i;
+	int err;
+
+	for (i = 0; i < ctx->nr_fields; i++) {
+		struct expression *scalar = ctx->fields[i].scalar;
+		struct expression *zero;
+
+		zero = default_value(scalar->vm_type);
+		if (!zero)
+			return -ENOMEM;
+
+		expr_get(scalar);
+
+		err = insert_store_before(ctx->alloc, scalar, zero);
+		if (err)
+			return err;
+	}
+
+	return 0;
+}
+
+static int rewrite_field_store(struct escape_context *ctx, struct statement *stmt)
+{
+	struct expression *dest, *src;
+	struct vm_field *field;
+	enum vm_type type;
+
+	dest = to_expr(stmt->store_dest);
+	field = dest->instance_field;
+
+	stmt->store_dest = &scalar_get(ctx, field)->node;
+	expr_put(dest);
+
+	/* Stores to sub-word fields are truncated by the memory access. */
+	type = vm_field_type(field);
+	if (type == J_BYTE || type == J_CHAR || type == J_SHORT) {
+		src = truncation_expr(type, to_expr(stmt->store_src));
+		if (!src)
+			return -ENOMEM;
+
+		stmt->store_src = &src->node;
+	}
+
+	return 0;
+}
+
+static int rewrite_stmt(struct escape_context *ctx, struct statement *stmt)
+{
+	int i;
+
+	if (stmt_type(stmt) == STMT_STORE && is_field_access(ctx, to_expr(stmt->store_dest))) {
+		replace_field_loads(ctx, &stmt->store_src);
+
+		return rewrite_field_store(ctx, stmt);
+	}
+
+	for (i = 0; i < stmt_nr_kids(stmt); i++) {
+		if (stmt->node.kids[i])
+			replace_field_loads(ctx, &stmt->node.kids[i]);
+	}
+
+	return 0;
+}
+
+static int replace_allocation(struct escape_context *ctx)
+{
+	struct basic_block *bb;
+	int err;
+
+	err = initialize_scalars(ctx);
+	if (err)
+		return err;
+
+	for_each_basic_block(bb, &ctx->cu->bb_list) {
+		struct statement *stmt, *next;
+
+		list_for_each_entry_safe(stmt, next, &bb->stmt_list, stmt_list_node) {
+			if (is_removable_use(ctx, stmt)) {
+				list_del(&stmt->stmt_list_node);
+				free_statement(stmt);
+				continue;
+			}
+
+			err = rewrite_stmt(ctx, stmt);
+			if (err)
+				return err;
+		}
+	}
+
+	return 0;
+}
+
+static bool is_candidate(struct statement *stmt)
+{
+	struct expression *dest, *src;
+	struct vm_class *vmc;
+
+	if (stmt_type(stmt) != STMT_STORE)
+		return false;
+
+	src = to_expr(stmt->store_src);
+	dest = to_expr(stmt->store_dest);
+
+	if (expr_type(src) != EXPR_NEW || !is_variable(dest))
+		return false;
+
+	vmc = src->class;
+
+	/* The allocation would run the class initializer or throw. */
+	if (vm_class_is_abstract(vmc) || vm_class_is_interface(vmc))
+		return false;
+
+	return vm_class_is_initialized(vmc);
+}
+
+static void reset_context(struct escape_context *ctx, struct statement *alloc)
+{
+	unsigned long i;
+
+	for (i = 0; i < ctx->nr_fields; i++)
+		expr_put(ctx->fields[i].scalar);
+
+	free(ctx->fields);
+	free(ctx->temps);
+
+	ctx->alloc = alloc;
+	ctx->fields = NULL;
+	ctx->nr_fields = 0;
+	ctx->temps = NULL;
+	ctx->nr_temps = 0;
+
+	bitset_clear_all(ctx->locals);
+}
+
+static int analyze_allocation(struct escape_context *ctx, struct statement *alloc)
+{
+	int err;
+
+	reset_context(ctx, alloc);
+
+	err = compute_aliases(ctx);
+	if (err)
+		return err;
+
+	err = check_uses(ctx);
+	if (err)
+		return err;
+
+	return replace_allocation(ctx);
+}
+
+int scalar_replace_allocations(struct compilation_unit *cu)
+{
+	struct statement **allocs = NULL;
+	unsigned long nr_allocs = 0, i;
+	struct escape_context ctx;
+	struct basic_block *bb;
+	struct statement *stmt;
+	int err = 0;
+
+	if (cu->method->code_attribute.exception_table_length)
+		return 0;
+
+	for_each_basic_block(bb, &cu->bb_list) {
+		for_each_stmt(stmt, &bb->stmt_list) {
+			struct statement **new_allocs;
+
+			if (!is_candidate(stmt))
+				continue;
+
+			new_allocs = realloc(allocs, (nr_allocs + 1) * sizeof(*allocs));
+			if (!new_allocs) {
+				free(allocs);
+				return -ENOMEM;
+			}
+
+			allocs = new_allocs;
+			allocs[nr_allocs++] = stmt;
+		}
+	}
+
+	if (!nr_allocs)
+		return 0;
+
+	memset(&ctx, 0, sizeof(ctx));
+
+	ctx.cu = cu;
+	ctx.nr_locals = cu->method->code_attribute.max_locals;
+
+	ctx.locals = alloc_bitset(ctx.nr_locals + 1);
+	if (!ctx.locals) {
+		free(allocs);
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < nr_allocs; i++) {
+		err = analyze_allocation(&ctx, allocs[i]);
+		if (err == -ENOMEM)
+			break;
+
+		err = 0;
+	}
+
+	reset_context(&ctx, NULL);
+	free(ctx.locals);
+	free(allocs);
+
+	return err;
+}
@@ -32,6 +32,7 @@
 #include "jit/basic-block.h"
 #include "jit/exception.h"
 #include "jit/compiler.h"
+#include "jit/text.h"
 
 #include "lib/buffer.h"
 #include "lib/guard-page.h"
@@ -45,6 +46,7 @@
 #include "vm/call.h"
 #include "vm/die.h"
 #include "vm/errors.h"
+#include "vm/system.h"
 
 #include "arch/stack-frame.h"
 #include "arch/instruction.h"
@@ -53,6 +55,9 @@
 __thread void *exception_guard = NULL;
 __thread void *trampoline_exception_guard = NULL;
 
+/* Return address into JIT code of a helper redirected to exception_return */
+static __thread unsigned long helper_return_address;
+
 void *exceptions_guard_page;
 void *trampoline_exceptions_guard_page;
 
@@ -156,6 +161,127 @@ void signal_new_exception(struct vm_class *vmc, const char *template, ...)
 	va_end(args);
 }
 
+/*
+ * Fast-throw mode. Implicit exceptions raised by JIT code at a throw site
+ * that has thrown more than FAST_THROW_THRESHOLD times reuse a shared
+ * preallocated exception that has no message and an empty stack trace.
+ * This skips object allocation, constructor calls and the stack walk of
+ * fillInStackTrace() for code that uses such exceptions for control flow.
+ */
+bool opt_fast_throw;
+
+#define FAST_THROW_THRESHOLD	100
+#define NR_FAST_THROW_SITES	256
+
+/*
+ * Throw site counters are hashed by address and updated without locking.
+ * A lost update or a collision only changes when a site turns hot.
+ */
+static struct fast_throw_site {
+	unsigned long		addr;
+	unsigned long		count;
+} fast_throw_sites[NR_FAST_THROW_SITES];
+
+static struct fast_throw_exception {
+	struct vm_class		**class;
+	struct vm_object	*object;
+} fast_throw_exceptions[] = {
+	{ &vm_java_lang_NullPointerException },
+	{ &vm_java_lang_ArithmeticException },
+	{ &vm_java_lang_ArrayIndexOutOfBoundsException },
+};
+
+static bool fast_throw_site_is_hot(unsigned long addr)
+{
+	struct fast_throw_site *site;
+
+	site = &fast_throw_sites[(addr >> 2) % NR_FAST_THROW_SITES];
+	if (site->addr != addr) {
+		site->addr = addr;
+		site->count = 0;
+	}
+
+	return ++site->count > FAST_THROW_THRESHOLD;
+}
+
+static struct vm_object *alloc_fast_throw_exception(struct vm_class *vmc)
+{
+	struct vm_object *stack_trace;
+	struct vm_object *obj;
+
+	obj = new_exception(vmc, NULL);
+	if (!obj || exception_occurred())
+		return NULL;
+
+	stack_trace = vm_object_alloc_array(vm_array_of_java_lang_StackTraceElement, 0);
+	if (!stack_trace)
+		return NULL;
+
+	vm_call_method(vm_java_lang_Throwable_setStackTrace, obj, stack_trace);
+	if (exception_occurred())
+		return NULL;
+
+	return obj;
+}
+
+static struct vm_object *fast_throw_exception(struct vm_class *vmc)
+{
+	struct fast_throw_exception *fte;
+	struct vm_object *obj;
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(fast_throw_exceptions); i++) {
+		fte = &fast_throw_exceptions[i];
+		if (*fte->class == vmc)
+			break;
+	}
+
+	if (i == ARRAY_SIZE(fast_throw_exceptions))
+		return NULL;
+
+	if (fte->object)
+		return fte->object;
+
+	obj = alloc_fast_throw_exception(vmc);
+	if (!obj) {
+		clear_exception();
+		return NULL;
+	}
+
+	/* Threads racing here throw their own instance once. */
+	__sync_bool_compare_and_swap(&fte->object, NULL, obj);
+
+	return obj;
+}
+
+/**
+ * signal_implicit_exception - signals an exception that JIT code raises
+ *         implicitly, for example a null pointer dereference or an
+ *         integer division by zero.
+ *
+ * @vmc: exception class
+ * @message: exception message or NULL
+ * @site: native address in JIT code that raised the exception
+ */
+void signal_implicit_exception(struct vm_class *vmc, const char *message,
+			       unsigned long site)
+{
+	struct vm_object *exception;
+
+	if (opt_fast_throw && fast_throw_site_is_hot(site)) {
+		exception = fast_throw_exception(vmc);
+		if (exception) {
+			signal_exception(exception);
+			return;
+		}
+	}
+
+	if (message)
+		signal_new_exception(vmc, "%s", message);
+	else
+		signal_new_exception(vmc, NULL);
+}
+
 void signal_new_exception_with_cause(struct vm_class *vmc,
 				     struct vm_object *cause,
 				     const char *template, ...)
@@ -220,6 +346,34 @@ void signal_new_exception_with_cause(struct vm_class *vmc,
 	signal_exception(exception);
 }
 
+/**
+ * __helper_return_on_exception - makes the runtime helper whose frame is
+ *         @frame return to exception_return if an exception has been
+ *         signalled and the helper was called from JIT code.
+ */
+void __helper_return_on_exception(void *frame)
+{
+	struct native_stack_frame *helper_frame = frame;
+
+	if (!exception_occurred())
+		return;
+
+	if (!is_jit_text((void *) helper_frame->return_address))
+		return;
+
+	helper_return_address = helper_frame->return_address;
+	helper_frame->return_address = (unsigned long) exception_return;
+}
+
+/*
+ * Called by exception_return to get the return address that the helper
+ * would have returned to.
+ */
+unsigned long exception_return_address(void)
+{
+	return helper_return_address;
+}
+
 void clear_exception(void)
 {
 	trampoline_exception_guard = &trampoline_exception_guard;
@@ -254,6 +408,11 @@ static unsigned char *eh_native_ptr(struct compilation_unit *cu,
 	return bb_native_ptr(bb);
 }
 
+/*
+ * Catch classes are not resolved here because this runs under the JIT text
+ * lock and loading a class can run Java code. find_handler() resolves them
+ * on the first throw and caches the result in the handler.
+ */
 int build_exception_handlers_table(struct compilation_unit *cu)
 {
 	struct vm_method *method;
@@ -266,59 +425,163 @@ int build_exception_handlers_table(struct compilation_unit *cu)
 	if (size == 0)
 		return 0;
 
-	cu->exception_handlers = malloc(sizeof(void *) * size);
+	cu->exception_handlers = malloc(sizeof(struct exception_handler) * size);
 	if (!cu->exception_handlers)
 		return -ENOMEM;
 
 	for (i = 0; i < size; i++) {
 		struct cafebabe_code_attribute_exception *eh
 			= &method->code_attribute.exception_table[i];
+		struct exception_handler *handler = &cu->exception_handlers[i];
 
-		cu->exception_handlers[i] = eh_native_ptr(cu, eh);
+		handler->start_pc	= eh->start_pc;
+		handler->end_pc		= eh->end_pc;
+		handler->catch_type	= eh->catch_type;
+		handler->catch_class	= NULL;
+		handler->native_ptr	= eh_native_ptr(cu, eh);
 	}
 
 	return 0;
 }
 
+void free_exception_handlers_table(struct compilation_unit *cu)
+{
+	unsigned int i;
+
+	for (i = 0; i < NR_EH_CACHE_ENTRIES; i++)
+		free(cu->eh_cache[i]);
+
+	free(cu->exception_handlers);
+}
+
 /**
  * find_handler - return native pointer to exception handler for given
- *                @exception_class and @bc_offset of source.
+ *                @exception_class and @bc_offset of source. @cacheable is
+ *                cleared if the answer depends on a catch class that could
+ *                not be resolved.
  */
 static unsigned char *find_handler(struct compilation_unit *cu,
-	struct vm_class *exception_class, unsigned long bc_offset)
+	struct vm_class *exception_class, unsigned long bc_offset,
+	bool *cacheable)
 {
-	struct cafebabe_code_attribute_exception *eh;
-	struct vm_method *method;
+	struct exception_handler *handler;
 	int size;
 	int i;
 
-	method = cu->method;
-	size = method->code_attribute.exception_table_length;
+	size = cu->method->code_attribute.exception_table_length;
 
 	for (i = 0; i < size; i++) {
 		struct vm_class *catch_class;
 
-		eh = &method->code_attribute.exception_table[i];
-		if (!exception_covers(eh, bc_offset))
+		handler = &cu->exception_handlers[i];
+		if (bc_offset < handler->start_pc || bc_offset >= handler->end_pc)
 			continue;
 
 		/* This matches to everything. */
-		if (eh->catch_type == 0)
-			break;
-
-		catch_class = vm_class_resolve_class(method->class,
-			eh->catch_type);
+		if (handler->catch_type == 0)
+			return handler->native_ptr;
+
+		catch_class = handler->catch_class;
+		if (!catch_class) {
+			catch_class = vm_class_resolve_class(cu->method->class,
+				handler->catch_type);
+			if (!catch_class) {
+				*cacheable = false;
+				continue;
+			}
+			handler->catch_class = catch_class;
+		}
 
 		if (vm_class_is_assignable_from(catch_class, exception_class))
-			break;
+			return handler->native_ptr;
 	}
 
-	if (i < size)
-		return cu->exception_handlers[i];
-
 	return NULL;
 }
 
+/*
+ * Looks up the handler decision for @class at @native_ptr from an earlier
+ * throw. Returns false if there is none.
+ */
+static bool eh_cache_lookup(struct compilation_unit *cu, unsigned char *native_ptr,
+			    struct vm_class *class, unsigned char **handler)
+{
+	unsigned int i;
+
+	for (i = 0; i < NR_EH_CACHE_ENTRIES; i++) {
+		struct eh_cache_entry *entry = cu->eh_cache[i];
+
+		if (!entry)
+			return false;
+
+		if (entry->native_ptr == native_ptr && entry->class == class) {
+			*handler = entry->handler;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+ * Entries are published with a full barrier and never modified or freed
+ * while the compilation unit is alive so readers need no locking. Evicting
+ * an entry would mean freeing it under a concurrent reader, and there is no
+ * grace period mechanism to tell when that is safe. A method rarely has more
+ * than a few hot throw sites, so the first decisions keep their slots and
+ * later ones fall back to an uncached find_handler().
+ */
+static void eh_cache_insert(struct compilation_unit *cu, unsigned char *native_ptr,
+			    struct vm_class *class, unsigned char *handler)
+{
+	struct eh_cache_entry *entry;
+	unsigned int i;
+
+	entry = malloc(sizeof *entry);
+	if (!entry)
+		return;
+
+	entry->native_ptr	= native_ptr;
+	entry->class		= class;
+	entry->handler		= handler;
+
+	for (i = 0; i < NR_EH_CACHE_ENTRIES; i++) {
+		if (__sync_bool_compare_and_swap(&cu->eh_cache[i], NULL, entry))
+			return;
+	}
+
+	free(entry);
+}
+
+/*
+ * Returns the handler in @cu that catches @exception thrown at
+ * @native_ptr or NULL if the exception leaves the method.
+ */
+static unsigned char *lookup_handler(struct compilation_unit *cu,
+	struct vm_object *exception, unsigned char *native_ptr)
+{
+	unsigned long bc_offset;
+	unsigned char *eh_ptr;
+	bool cacheable;
+
+	if (!cu->exception_handlers)
+		return NULL;
+
+	if (eh_cache_lookup(cu, native_ptr, exception->class, &eh_ptr))
+		return eh_ptr;
+
+	bc_offset = jit_lookup_bc_offset(cu, native_ptr);
+	if (bc_offset == BC_OFFSET_UNKNOWN)
+		return NULL;
+
+	cacheable = true;
+	eh_ptr = find_handler(cu, exception->class, bc_offset, &cacheable);
+	if (cacheable)
+		eh_cache_insert(cu, native_ptr, exception->class, eh_ptr);
+
+	return eh_ptr;
+}
+
 static bool
 is_inside_exit_unlock(struct compilation_unit *cu, unsigned char *ptr)
 {
@@ -352,11 +615,8 @@ throw_from_jit(struct compilation_unit *cu, struct jit_stack_frame *frame,
 	       unsigned char *native_ptr)
 {
 	struct vm_object *exception;
-	unsigned long bc_offset;
 	unsigned char *eh_ptr;
 
-	eh_ptr = NULL;
-
 	exception = exception_occurred();
 	assert(exception != NULL);
 
@@ -371,17 +631,14 @@ throw_from_jit(struct compilation_unit *cu, struct jit_stack_frame *frame,
 
 	clear_exception();
 
-	bc_offset = jit_lookup_bc_offset(cu, native_ptr);
-	if (bc_offset != BC_OFFSET_UNKNOWN) {
-		eh_ptr = find_handler(cu, exception->class, bc_offset);
-		if (eh_ptr != NULL) {
-			signal_exception(exception);
+	eh_ptr = lookup_handler(cu, exception, native_ptr);
+	if (eh_ptr != NULL) {
+		signal_exception(exception);
 
-			if (opt_trace_exceptions)
-				trace_exception_handler(cu, eh_ptr);
+		if (opt_trace_exceptions)
+			trace_exception_handler(cu, eh_ptr);
 
-			return eh_ptr;
-		}
+		return eh_ptr;
 	}
 
 	signal_exception(exception);
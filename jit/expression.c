@@ -26,6 +26,9 @@ int expr_nr_kids(struct expression *expr)
 	case EXPR_ARRAY_DEREF:
 	case EXPR_BINOP:
 	case EXPR_ARGS_LIST:
+	case EXPR_UNSAFE_FIELD:
+	case EXPR_COMPARE_AND_SWAP:
+	case EXPR_CAS_VALUES:
 		return 2;
 	case EXPR_UNARY_OP:
 	case EXPR_TRUNCATION:
@@ -102,9 +105,12 @@ int expr_is_pure(struct expression *expr)
 	case EXPR_LOOKUPSWITCH_BSEARCH:
 	case EXPR_INSTANCE_FIELD:
 	case EXPR_FLOAT_INSTANCE_FIELD:
+	case EXPR_UNSAFE_FIELD:
+	case EXPR_CAS_VALUES:
 
 		/* These expression types should be always assumed to
 		   have side-effects. */
+	case EXPR_COMPARE_AND_SWAP:
 	case EXPR_NEWARRAY:
 	case EXPR_ANEWARRAY:
 	case EXPR_MULTIANEWARRAY:
@@ -571,3 +577,45 @@ struct expression *truncation_expr(enum vm_type to_type,
 
 	return expr;
 }
+
+struct expression *unsafe_field_expr(enum vm_type vm_type,
+				     struct expression *objectref,
+				     struct expression *offset)
+{
+	struct expression *expr;
+
+	expr = alloc_expression(EXPR_UNSAFE_FIELD, vm_type);
+	if (!expr)
+		return NULL;
+
+	expr->unsafe_objectref = &objectref->node;
+	expr->unsafe_offset = &offset->node;
+
+	return expr;
+}
+
+struct expression *compare_and_swap_expr(struct expression *field,
+					 struct expression *expect,
+					 struct expression *update)
+{
+	struct expression *values;
+	struct expression *expr;
+
+	values = alloc_expression(EXPR_CAS_VALUES, field->vm_type);
+	if (!values)
+		return NULL;
+
+	expr = alloc_expression(EXPR_COMPARE_AND_SWAP, J_INT);
+	if (!expr) {
+		expr_put(values);
+		return NULL;
+	}
+
+	values->cas_expect = &expect->node;
+	values->cas_update = &update->node;
+
+	expr->cas_field = &field->node;
+	expr->cas_values = &values->node;
+
+	return expr;
+}
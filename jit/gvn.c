@@ -0,0 +1,445 @@
+/*
+ * Global value numbering on SSA form.
+ *
+ * This file is released under the GPL version 2. Please refer to the file
+ * LICENSE for details.
+ *
+ * We walk the dominator tree and keep a scoped table of the values that
+ * are available at the current instruction. An instruction that computes
+ * a value that is already in the table is removed and its uses are made
+ * to use the earlier value. This catches repeated arithmetic, repeated
+ * loads of the same field or array length, repeated loads of the same
+ * local variable and null checks of a reference that has already been
+ * checked.
+ *
+ * Pure arithmetic is available everywhere below its definition in the
+ * dominator tree. Loads are only valid as long as memory has not changed
+ * in between: every instruction that writes memory or calls starts a new
+ * memory generation and a load is only reused within the generation it
+ * was entered in. Loads of local variables are killed by stores to the
+ * same slot. A block that can be entered from anywhere else than its
+ * immediate dominator starts with fresh generations because we don't know
+ * what happened on the other paths.
+ */
+
+#include "jit/compilation-unit.h"
+#include "jit/compiler.h"
+#include "jit/instruction.h"
+#include "jit/stack-slot.h"
+#include "jit/ssa.h"
+#include "jit/vars.h"
+
+#include "lib/bitset.h"
+#include "lib/hash-map.h"
+
+#include <stdlib.h>
+
+struct gvn_key {
+	enum ssa_insn_kind kind;
+	enum ssa_op op;
+	enum vm_type vm_type;
+	struct var_info *src;
+	struct var_info *src2;
+	struct stack_slot *slot;
+	long imm;
+};
+
+struct gvn_value {
+	struct gvn_key key;
+	struct var_info *var;
+	struct basic_block *bb;
+	/* Memory or slot generation the value was computed in */
+	unsigned long generation;
+	unsigned long epoch;
+	/* The value with the same key in an enclosing scope */
+	struct gvn_value *shadowed;
+	struct gvn_value *next;
+};
+
+struct gvn_slot_undo {
+	unsigned long idx;
+	unsigned long generation;
+};
+
+struct gvn_context {
+	struct compilation_unit *cu;
+	struct hash_map *values;
+	struct bitset *eh_uses;
+
+	unsigned long next_generation;
+	unsigned long heap_generation;
+	unsigned long epoch;
+
+	unsigned long nr_slots;
+	unsigned long *slot_generation;
+
+	struct gvn_slot_undo *undo;
+	unsigned long nr_undo;
+	unsigned long max_undo;
+};
+
+static unsigned long gvn_key_hash(const void *key)
+{
+	const struct gvn_key *k = key;
+	unsigned long hash;
+
+	hash = k->kind;
+	hash = hash * 31 + k->op;
+	hash = hash * 31 + k->vm_type;
+	hash = hash * 31 + ((unsigned long) k->src >> 4);
+	hash = hash * 31 + ((unsigned long) k->src2 >> 4);
+	hash = hash * 31 + ((unsigned long) k->slot >> 4);
+	hash = hash * 31 + k->imm;
+
+	return hash;
+}
+
+static bool gvn_key_equals(const void *key1, const void *key2)
+{
+	const struct gvn_key *k1 = key1, *k2 = key2;
+
+	return k1->kind == k2->kind && k1->op == k2->op &&
+		k1->vm_type == k2->vm_type && k1->src == k2->src &&
+		k1->src2 == k2->src2 && k1->slot == k2->slot &&
+		k1->imm == k2->imm;
+}
+
+static struct key_operations gvn_key_ops = {
+	.hash		= gvn_key_hash,
+	.equals		= gvn_key_equals,
+};
+
+static bool var_is_fixed(struct var_info *var)
+{
+	return var && interval_has_fixed_reg(var->interval);
+}
+
+static bool op_is_commutative(enum ssa_op op)
+{
+	switch (op) {
+	case SSA_OP_ADD:
+	case SSA_OP_MUL:
+	case SSA_OP_AND:
+	case SSA_OP_OR:
+	case SSA_OP_XOR:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static bool local_slot_index(struct compilation_unit *cu,
+			     struct stack_slot *slot, unsigned long *idx)
+{
+	struct stack_frame *frame = cu->stack_frame;
+
+	if (!slot || slot < frame->local_slots ||
+	    slot >= frame->local_slots + frame->nr_local_slots)
+		return false;
+
+	*idx = slot->index;
+	return true;
+}
+
+/*
+ * Fills in the key for the value @info computes. Returns false if the
+ * instruction is not a candidate for value numbering.
+ */
+static bool gvn_key_init(struct gvn_context *ctx, struct ssa_insn_info *info,
+			 struct gvn_key *key)
+{
+	unsigned long idx;
+
+	*key = (struct gvn_key) { .kind = info->kind };
+
+	switch (info->kind) {
+	case SSA_INSN_ARITH:
+	case SSA_INSN_ADD_IMM:
+		if (var_is_fixed(info->var) || var_is_fixed(info->src) ||
+		    var_is_fixed(info->src2))
+			return false;
+
+		key->op		= info->op;
+		key->vm_type	= info->var->vm_type;
+		key->src	= info->src;
+		key->src2	= info->src2;
+		key->imm	= info->imm;
+
+		if (info->kind == SSA_INSN_ARITH && op_is_commutative(info->op) &&
+		    key->src2->vreg < key->src->vreg) {
+			key->src	= info->src2;
+			key->src2	= info->src;
+		}
+		return true;
+	case SSA_INSN_LOAD_MEMBASE:
+		if (var_is_fixed(info->var) || var_is_fixed(info->src))
+			return false;
+
+		key->vm_type	= info->var->vm_type;
+		key->src	= info->src;
+		key->imm	= info->imm;
+		return true;
+	case SSA_INSN_LOAD_LOCAL:
+		if (var_is_fixed(info->var))
+			return false;
+
+		if (!local_slot_index(ctx->cu, info->slot, &idx) || idx >= ctx->nr_slots)
+			return false;
+
+		key->vm_type	= info->var->vm_type;
+		key->slot	= info->slot;
+		return true;
+	case SSA_INSN_NULL_CHECK:
+		key->src	= info->var;
+		return true;
+	default:
+		return false;
+	}
+}
+
+static unsigned long current_generation(struct gvn_context *ctx,
+					struct gvn_key *key)
+{
+	switch (key->kind) {
+	case SSA_INSN_LOAD_MEMBASE:
+		return ctx->heap_generation;
+	case SSA_INSN_LOAD_LOCAL:
+		return ctx->slot_generation[key->slot->index];
+	default:
+		return 0;
+	}
+}
+
+static bool value_is_valid(struct gvn_context *ctx, struct gvn_value *value)
+{
+	if (value->key.kind == SSA_INSN_LOAD_LOCAL && value->epoch != ctx->epoch)
+		return false;
+
+	return value->generation == current_generation(ctx, &value->key);
+}
+
+static struct gvn_value *lookup_value(struct gvn_context *ctx,
+				      struct gvn_key *key)
+{
+	struct gvn_value *value = NULL;
+
+	if (hash_map_get(ctx->values, key, (void **) &value))
+		return NULL;
+
+	if (!value_is_valid(ctx, value))
+		return NULL;
+
+	return value;
+}
+
+static int insert_value(struct gvn_context *ctx, struct gvn_key *key,
+			struct ssa_insn_info *info, struct basic_block *bb,
+			struct gvn_value **scope)
+{
+	struct gvn_value *value;
+
+	value = malloc(sizeof *value);
+	if (!value)
+		return -ENOMEM;
+
+	value->key		= *key;
+	value->var		= info->var;
+	value->bb		= bb;
+	value->generation	= current_generation(ctx, key);
+	value->epoch		= ctx->epoch;
+	value->shadowed		= NULL;
+
+	hash_map_get(ctx->values, key, (void **) &value->shadowed);
+
+	if (hash_map_put(ctx->values, &value->key, value)) {
+		free(value);
+		return -ENOMEM;
+	}
+
+	value->next	= *scope;
+	*scope		= value;
+
+	return 0;
+}
+
+static void pop_scope(struct gvn_context *ctx, struct gvn_value *scope)
+{
+	struct gvn_value *value, *next;
+
+	for (value = scope; value; value = next) {
+		next = value->next;
+
+		if (value->shadowed)
+			hash_map_put(ctx->values, &value->key, value->shadowed);
+		else
+			hash_map_remove(ctx->values, &value->key);
+
+		free(value);
+	}
+}
+
+static int kill_slot(struct gvn_context *ctx, unsigned long idx)
+{
+	if (idx >= ctx->nr_slots)
+		return 0;
+
+	if (ctx->nr_undo == ctx->max_undo) {
+		unsigned long max = ctx->max_undo ? ctx->max_undo * 2 : 16;
+		struct gvn_slot_undo *undo;
+
+		undo = realloc(ctx->undo, max * sizeof *undo);
+		if (!undo)
+			return -ENOMEM;
+
+		ctx->undo	= undo;
+		ctx->max_undo	= max;
+	}
+
+	ctx->undo[ctx->nr_undo++] = (struct gvn_slot_undo) {
+		.idx		= idx,
+		.generation	= ctx->slot_generation[idx],
+	};
+
+	ctx->slot_generation[idx] = ++ctx->next_generation;
+
+	return 0;
+}
+
+static int record_store(struct gvn_context *ctx, struct ssa_insn_info *info)
+{
+	unsigned long idx;
+	int err;
+
+	if (!local_slot_index(ctx->cu, info->slot, &idx))
+		return 0;
+
+	err = kill_slot(ctx, idx);
+	if (err)
+		return err;
+
+	if (info->wide)
+		err = kill_slot(ctx, idx + 1);
+
+	return err;
+}
+
+/*
+ * Replaces the value that @insn computes with @value. Returns false if
+ * that is not allowed.
+ */
+static bool replace_value(struct gvn_context *ctx, struct insn *insn,
+			  struct ssa_insn_info *info, struct gvn_value *value)
+{
+	if (info->kind != SSA_INSN_NULL_CHECK) {
+		if (value->bb == ctx->cu->entry_bb &&
+		    test_bit(ctx->eh_uses->bits, info->var->vreg))
+			return false;
+
+		ssa_replace_uses(info->var, value->var);
+	}
+
+	ssa_remove_insn(ctx->cu, insn);
+
+	return true;
+}
+
+static bool keeps_memory_state(struct basic_block *bb, struct basic_block *idom)
+{
+	return !bb->is_eh && bb->nr_predecessors == 1 && bb->predecessors[0] == idom;
+}
+
+static int gvn_block(struct gvn_context *ctx, struct basic_block *bb,
+		     struct basic_block *idom)
+{
+	unsigned long heap_generation, epoch, nr_undo;
+	struct gvn_value *scope = NULL;
+	struct insn *insn, *tmp;
+	int err = 0;
+
+	heap_generation	= ctx->heap_generation;
+	epoch		= ctx->epoch;
+	nr_undo		= ctx->nr_undo;
+
+	if (!idom || !keeps_memory_state(bb, idom)) {
+		ctx->heap_generation	= ++ctx->next_generation;
+		ctx->epoch		= ++ctx->next_generation;
+	}
+
+	list_for_each_entry_safe(insn, tmp, &bb->insn_list, insn_list_node) {
+		struct ssa_insn_info info;
+		struct gvn_value *value;
+		struct gvn_key key;
+
+		if (insn_is_phi(insn))
+			continue;
+
+		ssa_classify_insn(ctx->cu, bb, insn, &info);
+
+		if (gvn_key_init(ctx, &info, &key)) {
+			value = lookup_value(ctx, &key);
+
+			if (value && replace_value(ctx, insn, &info, value))
+				continue;
+
+			err = insert_value(ctx, &key, &info, bb, &scope);
+			if (err)
+				goto out;
+		}
+
+		if (info.kind == SSA_INSN_STORE_LOCAL) {
+			err = record_store(ctx, &info);
+			if (err)
+				goto out;
+		}
+
+		if (info.effects & SSA_EFFECT_WRITE)
+			ctx->heap_generation = ++ctx->next_generation;
+	}
+
+	for (unsigned long i = 0; i < bb->nr_dom_successors; i++) {
+		err = gvn_block(ctx, bb->dom_successors[i], bb);
+		if (err)
+			break;
+	}
+out:
+	pop_scope(ctx, scope);
+
+	while (ctx->nr_undo > nr_undo) {
+		struct gvn_slot_undo *undo = &ctx->undo[--ctx->nr_undo];
+
+		ctx->slot_generation[undo->idx] = undo->generation;
+	}
+
+	ctx->heap_generation	= heap_generation;
+	ctx->epoch		= epoch;
+
+	return err;
+}
+
+int gvn(struct compilation_unit *cu)
+{
+	struct gvn_context ctx;
+	int err = -ENOMEM;
+
+	ctx = (struct gvn_context) {
+		.cu		= cu,
+		.nr_slots	= cu->stack_frame->nr_local_slots,
+	};
+
+	ctx.values = alloc_hash_map(&gvn_key_ops);
+	ctx.eh_uses = ssa_eh_uses(cu);
+	ctx.slot_generation = calloc(ctx.nr_slots + 1, sizeof *ctx.slot_generation);
+
+	if (!ctx.values || !ctx.eh_uses || !ctx.slot_generation)
+		goto out;
+
+	err = gvn_block(&ctx, cu->entry_bb, NULL);
+out:
+	free(ctx.undo);
+	free(ctx.slot_generation);
+	free(ctx.eh_uses);
+	if (ctx.values)
+		free_hash_map(ctx.values);
+
+	return err;
+}
@@ -0,0 +1,804 @@
+/*
+ * Method inlining for the bytecode to IR converter.
+ *
+ * This file is released under the GPL version 2. Please refer to the file
+ * LICENSE for details.
+ *
+ * Calls to small statically bound methods are replaced by the IR of the
+ * callee at the call site. Only straight-line methods whose body cannot
+ * throw are inlined: field accesses must go through 'this', static fields
+ * must belong to initialized classes and nested calls must themselves be
+ * inlinable. The receiver is null checked before the inlined body so the
+ * only exception an inlined call can raise is thrown at the invoke
+ * instruction, exactly like for a real call.
+ *
+ * Inlined statements get the bytecode offset of the invoke instruction so
+ * the caller's exception handler ranges, bytecode offset map and stack
+ * traces stay the same as without inlining.
+ */
+
+#include "jit/inline.h"
+
+#include "jit/bc-offset-mapping.h"
+#include "jit/compilation-unit.h"
+#include "jit/expression.h"
+#include "jit/exception.h"
+#include "jit/statement.h"
+#include "jit/compiler.h"
+#include "jit/args.h"
+
+#include "vm/bytecode.h"
+#include "vm/opcodes.h"
+#include "vm/method.h"
+#include "vm/object.h"
+#include "vm/class.h"
+#include "vm/field.h"
+#include "vm/die.h"
+
+#include "lib/stack.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+bool opt_inline_enabled = true;
+
+#define INLINE_MAX_CODE_SIZE	35
+#define INLINE_MAX_DEPTH	3
+#define INLINE_MAX_METHODS	8
+#define INLINE_MAX_STACK	8
+#define INLINE_MAX_LOCALS	8
+
+struct inline_context {
+	struct parse_context		*ctx;
+
+	/* Callees whose compile_mutex we hold while their code is read. */
+	struct compilation_unit		*locked[INLINE_MAX_METHODS];
+	unsigned int			nr_locked;
+};
+
+struct inline_frame {
+	struct vm_method		*method;
+	struct expression		*locals[INLINE_MAX_LOCALS];
+	struct expression		*stack[INLINE_MAX_STACK];
+	unsigned int			sp;
+};
+
+static bool invoke_is_statically_bound(unsigned char opc, struct vm_method *target)
+{
+	if (target->flags & VM_METHOD_FLAG_MISSING)
+		return false;
+
+	switch (opc) {
+	case OPC_INVOKESTATIC:
+		return vm_method_is_static(target) && vm_class_is_initialized(target->class);
+	case OPC_INVOKESPECIAL:
+		return !vm_method_is_static(target);
+	case OPC_INVOKEVIRTUAL:
+		if (vm_method_is_static(target))
+			return false;
+
+		if (vm_method_is_private(target) || vm_class_is_final(target->class))
+			return true;
+
+		/*
+		 * Final methods are not enforced for classpath classes, see
+		 * vm_method_overrides_final().
+		 */
+		return vm_method_is_final(target)
+			&& strncmp("java/", target->class->name, strlen("java/"));
+	default:
+		return false;
+	}
+}
+
+static bool lock_callee(struct inline_context *ictx, struct vm_method *vmm)
+{
+	struct compilation_unit *cu;
+	unsigned int i;
+
+	if (vmm == ictx->ctx->cu->method)
+		return false;
+
+	if (vm_method_ensure_jit(vmm)) {
+		clear_exception();
+		return false;
+	}
+
+	cu = vmm->compilation_unit;
+
+	for (i = 0; i < ictx->nr_locked; i++) {
+		if (ictx->locked[i] == cu)
+			return vmm->code_loaded;
+	}
+
+	if (ictx->nr_locked == INLINE_MAX_METHODS)
+		return false;
+
+	/*
+	 * Never wait for the lock: the callee might be compiling and
+	 * inlining the method we are compiling right now.
+	 */
+	if (pthread_mutex_trylock(&cu->compile_mutex) != 0)
+		return false;
+
+	ictx->locked[ictx->nr_locked++] = cu;
+
+	if (vm_method_load_code(vmm)) {
+		clear_exception();
+		return false;
+	}
+
+	return true;
+}
+
+static void unlock_callees(struct inline_context *ictx)
+{
+	unsigned int i;
+
+	for (i = 0; i < ictx->nr_locked; i++)
+		pthread_mutex_unlock(&ictx->locked[i]->compile_mutex);
+}
+
+static struct vm_field *resolve_field(struct vm_method *vmm, uint16_t idx)
+{
+	struct vm_field *vmf;
+
+	vmf = vm_class_resolve_field_recursive(vmm->class, idx);
+	if (!vmf)
+		clear_exception();
+
+	return vmf;
+}
+
+static struct vm_method *resolve_method(struct vm_method *vmm, unsigned char opc, uint16_t idx)
+{
+	struct vm_method *target;
+	uint16_t access_flags;
+
+	access_flags = opc == OPC_INVOKEVIRTUAL ? 0 : CAFEBABE_CLASS_ACC_STATIC;
+
+	target = vm_class_resolve_method_recursive(vmm->class, idx, access_flags);
+	if (!target)
+		clear_exception();
+
+	return target;
+}
+
+static unsigned int nr_arg_values(struct vm_method *vmm)
+{
+	return count_java_arguments(vmm) + (vm_method_is_static(vmm) ? 0 : 1);
+}
+
+static bool is_inlinable(struct inline_context *ictx, struct vm_method *vmm,
+			 unsigned char invoke_opc, unsigned int depth);
+
+/*
+ * Checks the callee body. The simulated operand stack only tracks which
+ * values are the 'this' reference of the method.
+ */
+static bool check_code(struct inline_context *ictx, struct vm_method *vmm,
+		       unsigned int depth)
+{
+	struct cafebabe_code_attribute *code = &vmm->code_attribute;
+	bool stack[INLINE_MAX_STACK];
+	struct bytecode_buffer buffer;
+	unsigned int nr_locals;
+	unsigned int sp = 0;
+
+	nr_locals = vm_method_arg_stack_count(vmm);
+
+	buffer.buffer = code->code;
+	buffer.pos = 0;
+
+	while (buffer.pos < code->code_length) {
+		unsigned char opc = bytecode_read_u8(&buffer);
+		struct vm_method *target;
+		struct vm_field *vmf;
+		unsigned int idx, n;
+		bool is_this = false;
+
+		switch (opc) {
+		case OPC_NOP:
+			continue;
+		case OPC_ILOAD:
+		case OPC_LLOAD:
+		case OPC_FLOAD:
+		case OPC_DLOAD:
+		case OPC_ALOAD:
+			idx = bytecode_read_u8(&buffer);
+			goto load;
+		case OPC_ILOAD_0 ... OPC_ILOAD_3:
+			idx = opc - OPC_ILOAD_0;
+			goto load;
+		case OPC_LLOAD_0 ... OPC_LLOAD_3:
+			idx = opc - OPC_LLOAD_0;
+			goto load;
+		case OPC_FLOAD_0 ... OPC_FLOAD_3:
+			idx = opc - OPC_FLOAD_0;
+			goto load;
+		case OPC_DLOAD_0 ... OPC_DLOAD_3:
+			idx = opc - OPC_DLOAD_0;
+			goto load;
+		case OPC_ALOAD_0 ... OPC_ALOAD_3:
+			idx = opc - OPC_ALOAD_0;
+		load:
+			if (idx >= nr_locals)
+				return false;
+
+			is_this = idx == 0 && !vm_method_is_static(vmm)
+				&& (opc == OPC_ALOAD_0 || opc == OPC_ALOAD);
+			break;
+		case OPC_BIPUSH:
+			bytecode_read_u8(&buffer);
+			break;
+		case OPC_SIPUSH:
+			bytecode_read_u16(&buffer);
+			break;
+		case OPC_ACONST_NULL:
+		case OPC_ICONST_M1 ... OPC_ICONST_5:
+		case OPC_LCONST_0 ... OPC_LCONST_1:
+		case OPC_FCONST_0 ... OPC_FCONST_2:
+		case OPC_DCONST_0 ... OPC_DCONST_1:
+			break;
+		case OPC_INEG:
+		case OPC_LNEG:
+			if (sp < 1)
+				return false;
+			sp--;
+			break;
+		case OPC_IADD: case OPC_LADD: case OPC_FADD: case OPC_DADD:
+		case OPC_ISUB: case OPC_LSUB: case OPC_FSUB: case OPC_DSUB:
+		case OPC_IMUL: case OPC_LMUL: case OPC_FMUL: case OPC_DMUL:
+		case OPC_ISHL: case OPC_LSHL:
+		case OPC_ISHR: case OPC_LSHR:
+		case OPC_IUSHR: case OPC_LUSHR:
+		case OPC_IAND: case OPC_LAND:
+		case OPC_IOR: case OPC_LOR:
+		case OPC_IXOR: case OPC_LXOR:
+			if (sp < 2)
+				return false;
+			sp -= 2;
+			break;
+		case OPC_GETFIELD:
+		case OPC_PUTFIELD:
+			vmf = resolve_field(vmm, bytecode_read_u16(&buffer));
+			if (!vmf || vm_field_is_static(vmf))
+				return false;
+
+			n = opc == OPC_PUTFIELD ? 2 : 1;
+			if (sp < n || !stack[sp - n])
+				return false;
+
+			sp -= n;
+			if (opc == OPC_PUTFIELD)
+				continue;
+			break;
+		case OPC_GETSTATIC:
+		case OPC_PUTSTATIC:
+			vmf = resolve_field(vmm, bytecode_read_u16(&buffer));
+			if (!vmf || !vm_field_is_static(vmf))
+				return false;
+
+			if (!vm_class_is_initialized(vmf->class))
+				return false;
+
+			if (opc == OPC_GETSTATIC)
+				break;
+
+			if (sp < 1)
+				return false;
+			sp--;
+			continue;
+		case OPC_INVOKESPECIAL:
+		case OPC_INVOKESTATIC:
+		case OPC_INVOKEVIRTUAL:
+			target = resolve_method(vmm, opc, bytecode_read_u16(&buffer));
+			if (!target || !invoke_is_statically_bound(opc, target))
+				return false;
+
+			n = nr_arg_values(target);
+			if (sp < n)
+				return false;
+
+			/* The receiver must be our own, already null checked. */
+			if (!vm_method_is_static(target) && !stack[sp - n])
+				return false;
+
+			if (!is_inlinable(ictx, target, opc, depth + 1))
+				return false;
+
+			sp -= n;
+			if (method_return_type(target) == J_VOID)
+				continue;
+			break;
+		case OPC_IRETURN:
+		case OPC_LRETURN:
+		case OPC_FRETURN:
+		case OPC_DRETURN:
+		case OPC_ARETURN:
+			if (sp != 1 || method_return_type(vmm) == J_VOID)
+				return false;
+			return buffer.pos == code->code_length;
+		case OPC_RETURN:
+			if (sp != 0)
+				return false;
+			return buffer.pos == code->code_length;
+		default:
+			return false;
+		}
+
+		if (sp == INLINE_MAX_STACK)
+			return false;
+
+		stack[sp++] = is_this;
+	}
+
+	return false;
+}
+
+static bool is_inlinable(struct inline_context *ictx, struct vm_method *vmm,
+			 unsigned char invoke_opc, unsigned int depth)
+{
+	struct cafebabe_code_attribute *code;
+
+	if (depth >= INLINE_MAX_DEPTH)
+		return false;
+
+	if (!invoke_is_statically_bound(invoke_opc, vmm))
+		return false;
+
+	if (vm_method_is_native(vmm) || vm_method_is_abstract(vmm)
+	    || method_is_synchronized(vmm))
+		return false;
+
+	if (vm_method_arg_stack_count(vmm) > INLINE_MAX_LOCALS)
+		return false;
+
+	if (!lock_callee(ictx, vmm))
+		return false;
+
+	code = &vmm->code_attribute;
+
+	if (code->code_length > INLINE_MAX_CODE_SIZE)
+		return false;
+
+	if (code->exception_table_length)
+		return false;
+
+	return check_code(ictx, vmm, depth);
+}
+
+static void frame_push(struct inline_context *ictx, struct inline_frame *frame,
+		       struct expression *expr)
+{
+	tree_patch_bc_offset(&expr->node, ictx->ctx->offset);
+
+	expr->vm_type = mimic_stack_type(expr->vm_type);
+
+	assert(frame->sp < INLINE_MAX_STACK);
+	frame->stack[frame->sp++] = expr;
+}
+
+static struct expression *frame_pop(struct inline_frame *frame)
+{
+	assert(frame->sp > 0);
+
+	return frame->stack[--frame->sp];
+}
+
+/*
+ * Pops the arguments of @target and stores them into @locals indexed by
+ * their local variable slot. The last argument is on top of the stack.
+ */
+static void pop_frame_args(struct inline_frame *frame, struct vm_method *target,
+			   struct expression **locals)
+{
+	unsigned int nr_values, slot;
+
+	nr_values = nr_arg_values(target);
+	slot = vm_method_arg_stack_count(target);
+
+	while (nr_values--) {
+		struct expression *expr = frame_pop(frame);
+
+		slot -= vm_type_slot_size(expr->vm_type);
+		locals[slot] = expr;
+	}
+}
+
+static int emit_store(struct parse_context *ctx, struct expression *dest,
+		      struct expression *src)
+{
+	struct statement *stmt;
+
+	stmt = alloc_statement(STMT_STORE);
+	if (!stmt) {
+		expr_put(dest);
+		expr_put(src);
+		return -ENOMEM;
+	}
+
+	stmt->store_dest = &dest->node;
+	stmt->store_src = &src->node;
+	convert_statement(ctx, stmt);
+
+	return 0;
+}
+
+static int emit_binop(struct inline_context *ictx, struct inline_frame *frame,
+		      enum vm_type vm_type, enum binary_operator op)
+{
+	struct expression *left, *right, *expr;
+
+	right = frame_pop(frame);
+	left = frame_pop(frame);
+
+	expr = binop_expr(vm_type, op, left, right);
+	if (!expr)
+		return -ENOMEM;
+
+	frame_push(ictx, frame, expr);
+	return 0;
+}
+
+static int emit_method(struct inline_context *ictx, struct vm_method *vmm,
+		       struct expression **args, struct expression **result);
+
+static int emit_invoke(struct inline_context *ictx, struct inline_frame *frame,
+		       unsigned char opc, uint16_t idx)
+{
+	struct expression *locals[INLINE_MAX_LOCALS];
+	struct expression *result;
+	struct vm_method *target;
+	int err;
+
+	target = resolve_method(frame->method, opc, idx);
+	assert(target != NULL);
+
+	memset(locals, 0, sizeof(locals));
+	pop_frame_args(frame, target, locals);
+
+	err = emit_method(ictx, target, locals, &result);
+	if (err)
+		return err;
+
+	if (result)
+		frame_push(ictx, frame, result);
+
+	return 0;
+}
+
+static int emit_code(struct inline_context *ictx, struct inline_frame *frame,
+		     struct expression **result)
+{
+	struct cafebabe_code_attribute *code = &frame->method->code_attribute;
+	struct parse_context *ctx = ictx->ctx;
+	struct bytecode_buffer buffer;
+
+	buffer.buffer = code->code;
+	buffer.pos = 0;
+
+	for (;;) {
+		unsigned char opc = bytecode_read_u8(&buffer);
+		struct expression *expr, *objectref, *value;
+		struct vm_field *vmf;
+		unsigned int idx;
+		int err = 0;
+
+		switch (opc) {
+		case OPC_NOP:
+			break;
+		case OPC_ILOAD:
+		case OPC_LLOAD:
+		case OPC_FLOAD:
+		case OPC_DLOAD:
+		case OPC_ALOAD:
+			idx = bytecode_read_u8(&buffer);
+			goto load;
+		case OPC_ILOAD_0 ... OPC_ILOAD_3:
+			idx = opc - OPC_ILOAD_0;
+			goto load;
+		case OPC_LLOAD_0 ... OPC_LLOAD_3:
+			idx = opc - OPC_LLOAD_0;
+			goto load;
+		case OPC_FLOAD_0 ... OPC_FLOAD_3:
+			idx = opc - OPC_FLOAD_0;
+			goto load;
+		case OPC_DLOAD_0 ... OPC_DLOAD_3:
+			idx = opc - OPC_DLOAD_0;
+			goto load;
+		case OPC_ALOAD_0 ... OPC_ALOAD_3:
+			idx = opc - OPC_ALOAD_0;
+		load:
+			expr_get(frame->locals[idx]);
+			frame_push(ictx, frame, frame->locals[idx]);
+			break;
+		case OPC_ACONST_NULL:
+			expr = value_expr(J_REFERENCE, 0);
+			goto push;
+		case OPC_ICONST_M1 ... OPC_ICONST_5:
+			expr = value_expr(J_INT, opc - OPC_ICONST_0);
+			goto push;
+		case OPC_LCONST_0 ... OPC_LCONST_1:
+			expr = value_expr(J_LONG, opc - OPC_LCONST_0);
+			goto push;
+		case OPC_FCONST_0 ... OPC_FCONST_2:
+			expr = fvalue_expr(J_FLOAT, opc - OPC_FCONST_0);
+			goto push;
+		case OPC_DCONST_0 ... OPC_DCONST_1:
+			expr = fvalue_expr(J_DOUBLE, opc - OPC_DCONST_0);
+			goto push;
+		case OPC_BIPUSH:
+			expr = value_expr(J_INT, bytecode_read_s8(&buffer));
+			goto push;
+		case OPC_SIPUSH:
+			expr = value_expr(J_INT, bytecode_read_s16(&buffer));
+		push:
+			if (!expr)
+				return -ENOMEM;
+
+			frame_push(ictx, frame, expr);
+			break;
+		case OPC_INEG:
+		case OPC_LNEG:
+			value = frame_pop(frame);
+			expr = unary_op_expr(opc == OPC_INEG ? J_INT : J_LONG, OP_NEG, value);
+			goto push;
+		case OPC_IADD: err = emit_binop(ictx, frame, J_INT, OP_ADD); break;
+		case OPC_LADD: err = emit_binop(ictx, frame, J_LONG, OP_ADD); break;
+		case OPC_FADD: err = emit_binop(ictx, frame, J_FLOAT, OP_FADD); break;
+		case OPC_DADD: err = emit_binop(ictx, frame, J_DOUBLE, OP_DADD); break;
+		case OPC_ISUB: err = emit_binop(ictx, frame, J_INT, OP_SUB); break;
+		case OPC_LSUB: err = emit_binop(ictx, frame, J_LONG, OP_SUB); break;
+		case OPC_FSUB: err = emit_binop(ictx, frame, J_FLOAT, OP_FSUB); break;
+		case OPC_DSUB: err = emit_binop(ictx, frame, J_DOUBLE, OP_DSUB); break;
+		case OPC_IMUL: err = emit_binop(ictx, frame, J_INT, OP_MUL); break;
+		case OPC_LMUL: err = emit_binop(ictx, frame, J_LONG, OP_MUL_64); break;
+		case OPC_FMUL: err = emit_binop(ictx, frame, J_FLOAT, OP_FMUL); break;
+		case OPC_DMUL: err = emit_binop(ictx, frame, J_DOUBLE, OP_DMUL); break;
+		case OPC_ISHL: err = emit_binop(ictx, frame, J_INT, OP_SHL); break;
+		case OPC_LSHL: err = emit_binop(ictx, frame, J_LONG, OP_SHL_64); break;
+		case OPC_ISHR: err = emit_binop(ictx, frame, J_INT, OP_SHR); break;
+		case OPC_LSHR: err = emit_binop(ictx, frame, J_LONG, OP_SHR_64); break;
+		case OPC_IUSHR: err = emit_binop(ictx, frame, J_INT, OP_USHR); break;
+		case OPC_LUSHR: err = emit_binop(ictx, frame, J_LONG, OP_USHR_64); break;
+		case OPC_IAND: err = emit_binop(ictx, frame, J_INT, OP_AND); break;
+		case OPC_LAND: err = emit_binop(ictx, frame, J_LONG, OP_AND); break;
+		case OPC_IOR: err = emit_binop(ictx, frame, J_INT, OP_OR); break;
+		case OPC_LOR: err = emit_binop(ictx, frame, J_LONG, OP_OR); break;
+		case OPC_IXOR: err = emit_binop(ictx, frame, J_INT, OP_XOR); break;
+		case OPC_LXOR: err = emit_binop(ictx, frame, J_LONG, OP_XOR); break;
+		case OPC_GETFIELD:
+			vmf = resolve_field(frame->method, bytecode_read_u16(&buffer));
+			objectref = frame_pop(frame);
+
+			value = instance_field_expr(vm_field_type(vmf), vmf, objectref);
+			if (!value)
+				return -ENOMEM;
+
+			/* Load the field now, see convert_getfield(). */
+			expr = dup_expr(ctx, value);
+			goto push;
+		case OPC_PUTFIELD:
+			vmf = resolve_field(frame->method, bytecode_read_u16(&buffer));
+			value = frame_pop(frame);
+			objectref = frame_pop(frame);
+
+			expr = instance_field_expr(vm_field_type(vmf), vmf, objectref);
+			if (!expr)
+				return -ENOMEM;
+
+			err = emit_store(ctx, expr, value);
+			break;
+		case OPC_GETSTATIC:
+			vmf = resolve_field(frame->method, bytecode_read_u16(&buffer));
+
+			value = class_field_expr(vm_field_type(vmf), vmf);
+			if (!value)
+				return -ENOMEM;
+
+			expr = dup_expr(ctx, value);
+			goto push;
+		case OPC_PUTSTATIC:
+			vmf = resolve_field(frame->method, bytecode_read_u16(&buffer));
+			value = frame_pop(frame);
+
+			expr = class_field_expr(vm_field_type(vmf), vmf);
+			if (!expr)
+				return -ENOMEM;
+
+			err = emit_store(ctx, expr, value);
+			break;
+		case OPC_INVOKESPECIAL:
+		case OPC_INVOKESTATIC:
+		case OPC_INVOKEVIRTUAL:
+			err = emit_invoke(ictx, frame, opc, bytecode_read_u16(&buffer));
+			break;
+		case OPC_IRETURN:
+		case OPC_LRETURN:
+		case OPC_FRETURN:
+		case OPC_DRETURN:
+		case OPC_ARETURN:
+			*result = frame_pop(frame);
+			return 0;
+		case OPC_RETURN:
+			*result = NULL;
+			return 0;
+		default:
+			/* check_code() should have rejected the method */
+			return warn("unexpected opcode %u in inlined method", opc), -EINVAL;
+		}
+
+		if (err)
+			return err;
+	}
+}
+
+/*
+ * Emits the body of @vmm with @args as its local variables. The references
+ * to @args are consumed.
+ */
+static int emit_method(struct inline_context *ictx, struct vm_method *vmm,
+		       struct expression **args, struct expression **result)
+{
+	struct inline_frame frame;
+	unsigned int i;
+	int err;
+
+	frame.method = vmm;
+	frame.sp = 0;
+	memcpy(frame.locals, args, sizeof(frame.locals));
+
+	err = emit_code(ictx, &frame, result);
+
+	for (i = 0; i < INLINE_MAX_LOCALS; i++) {
+		if (frame.locals[i])
+			expr_put(frame.locals[i]);
+	}
+
+	return err;
+}
+
+static int emit_null_check(struct parse_context *ctx, struct expression *objectref)
+{
+	struct expression *expr;
+	struct statement *stmt;
+
+	expr_get(objectref);
+
+	expr = null_check_expr(objectref);
+	if (!expr)
+		return -ENOMEM;
+
+	stmt = alloc_statement(STMT_EXPRESSION);
+	if (!stmt) {
+		expr_put(expr);
+		return -ENOMEM;
+	}
+
+	stmt->expression = &expr->node;
+	convert_statement(ctx, stmt);
+
+	return 0;
+}
+
+static int do_inline_invoke(struct inline_context *ictx, struct vm_method *target)
+{
+	struct expression *locals[INLINE_MAX_LOCALS];
+	struct parse_context *ctx = ictx->ctx;
+	struct expression **args_array;
+	struct expression *result;
+	struct list_head *mark;
+	unsigned long nr_args, i;
+	int err;
+
+	nr_args = vm_method_arg_stack_count(target);
+
+	args_array = pop_args(ctx->bb->mimic_stack, nr_args);
+	if (!args_array)
+		return -ENOMEM;
+
+	memset(locals, 0, sizeof(locals));
+
+	/* See convert_and_add_args() for the layout of args_array. */
+	for (i = 0; i < nr_args; i += vm_type_slot_size(args_array[i]->vm_type)) {
+		unsigned long slot;
+
+		slot = nr_args - i - vm_type_slot_size(args_array[i]->vm_type);
+		locals[slot] = get_pure_expr(ctx, args_array[i]);
+	}
+
+	free(args_array);
+
+	/*
+	 * Keep the arguments and remember where the inlined statements start
+	 * so that a failure can be undone and the call emitted normally.
+	 */
+	for (i = 0; i < INLINE_MAX_LOCALS; i++) {
+		if (locals[i])
+			expr_get(locals[i]);
+	}
+
+	mark = ctx->bb->stmt_list.prev;
+
+	if (!vm_method_is_static(target)) {
+		err = emit_null_check(ctx, locals[0]);
+		if (err)
+			goto error_undo;
+	}
+
+	err = emit_method(ictx, target, locals, &result);
+	if (err)
+		goto error_undo;
+
+	if (result)
+		convert_expression(ctx, result);
+
+	for (i = 0; i < INLINE_MAX_LOCALS; i++) {
+		if (locals[i])
+			expr_put(locals[i]);
+	}
+
+	return 0;
+
+error_undo:
+	while (ctx->bb->stmt_list.prev != mark) {
+		struct statement *stmt = bb_remove_last_stmt(ctx->bb);
+
+		free_statement(stmt);
+	}
+
+	/* The arguments go back on the mimic stack in push order. */
+	for (i = 0; i < INLINE_MAX_LOCALS; i++) {
+		if (locals[i])
+			stack_push(ctx->bb->mimic_stack, locals[i]);
+	}
+
+	return err;
+}
+
+static int do_inline(struct parse_context *ctx, struct vm_method *target,
+		     unsigned char invoke_opc, bool *inlined)
+{
+	struct inline_context ictx;
+
+	*inlined = false;
+
+	if (!opt_inline_enabled || opt_trace_invoke)
+		return 0;
+
+	ictx.ctx = ctx;
+	ictx.nr_locked = 0;
+
+	/*
+	 * A failed inline attempt leaves the parse context as it was so the
+	 * caller falls back to a normal invoke.
+	 */
+	if (is_inlinable(&ictx, target, invoke_opc, 0))
+		*inlined = do_inline_invoke(&ictx, target) == 0;
+
+	unlock_callees(&ictx);
+
+	return 0;
+}
+
+/*
+ * Tries to inline the call to @target at the invoke instruction being
+ * converted. @inlined is set if the call was replaced by the callee's IR.
+ */
+int inline_invoke(struct parse_context *ctx, struct vm_method *target, bool *inlined)
+{
+	return do_inline(ctx, target, ctx->opc, inlined);
+}
+
+/*
+ * Like inline_invoke() but for an invokevirtual that class hierarchy
+ * analysis has bound to @target.
+ */
+int inline_devirtualized_invoke(struct parse_context *ctx, struct vm_method *target,
+				bool *inlined)
+{
+	return do_inline(ctx, target, OPC_INVOKESPECIAL, inlined);
+}
@@ -104,6 +104,10 @@ struct live_interval *alloc_interval(struct compilation_unit *cu, struct var_inf
 		interval->prev_child = NULL;
 		interval->spill_slot = NULL;
 		interval->spill_parent = NULL;
+		interval->hint = NULL;
+		interval->hint_pos = 0;
+		interval->use_pos_cache = NULL;
+		interval->nr_use_pos_cache = 0;
 		interval->spill_reload_reg.interval = interval;
 		interval->spill_reload_reg.vm_type = var->vm_type;
 		INIT_LIST_HEAD(&interval->interval_node);
@@ -125,6 +129,7 @@ void free_interval(struct compilation_unit *cu, struct live_interval *interval)
 		arena_free(cu->arena, this);
 	}
 
+	interval_free_use_positions_cache(interval);
 	arena_free(cu->arena, interval);
 }
 
@@ -169,14 +174,93 @@ split_interval_at(struct compilation_unit *cu, struct live_interval *interval, u
 	new->prev_child = interval;
 	interval->next_child = new;
 
+	if (interval->use_pos_cache) {
+		interval_cache_use_positions(interval);
+		interval_cache_use_positions(new);
+	}
+
 	return new;
 }
 
+static int compare_pos(const void *a, const void *b)
+{
+	unsigned long x = *(const unsigned long *) a;
+	unsigned long y = *(const unsigned long *) b;
+
+	if (x < y)
+		return -1;
+
+	return x > y;
+}
+
+/*
+ * Builds a sorted array of the use positions of @it so that next_use_pos()
+ * does a binary search instead of walking the use position list. The
+ * array is rebuilt when the interval is split and must be freed with
+ * interval_free_use_positions_cache() before use positions are added or
+ * removed otherwise.
+ */
+void interval_cache_use_positions(struct live_interval *it)
+{
+	struct use_position *this;
+	unsigned long *cache;
+	unsigned long nr = 0;
+
+	list_for_each_entry(this, &it->use_positions, use_pos_list)
+		nr += 2;
+
+	cache = realloc(it->use_pos_cache, (nr + 1) * sizeof *cache);
+	if (!cache) {
+		interval_free_use_positions_cache(it);
+		return;
+	}
+
+	nr = 0;
+
+	list_for_each_entry(this, &it->use_positions, use_pos_list)
+		nr += get_lir_positions(this, &cache[nr]);
+
+	qsort(cache, nr, sizeof *cache, compare_pos);
+
+	it->use_pos_cache = cache;
+	it->nr_use_pos_cache = nr;
+}
+
+void interval_free_use_positions_cache(struct live_interval *it)
+{
+	free(it->use_pos_cache);
+
+	it->use_pos_cache = NULL;
+	it->nr_use_pos_cache = 0;
+}
+
+static unsigned long cached_next_use_pos(struct live_interval *it, unsigned long pos)
+{
+	unsigned long lo = 0, hi = it->nr_use_pos_cache;
+
+	while (lo < hi) {
+		unsigned long mid = lo + (hi - lo) / 2;
+
+		if (it->use_pos_cache[mid] < pos)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (lo == it->nr_use_pos_cache)
+		return LONG_MAX;
+
+	return it->use_pos_cache[lo];
+}
+
 unsigned long next_use_pos(struct live_interval *it, unsigned long pos)
 {
 	struct use_position *this;
 	unsigned long min = LONG_MAX;
 
+	if (it->use_pos_cache)
+		return cached_next_use_pos(it, pos);
+
 	list_for_each_entry(this, &it->use_positions, use_pos_list) {
 		unsigned long use_pos[2];
 		int nr_use_pos;
@@ -0,0 +1,145 @@
+/*
+ * JIT intrinsics.
+ *
+ * This file is released under the GPL version 2. Please refer to the file
+ * LICENSE for details.
+ *
+ * Some library methods are called so often that the regular invocation
+ * path shows up in profiles. The JIT replaces calls to them with direct
+ * calls to C functions that implement the method. Unlike VM natives they
+ * don't go through the native stack bookkeeping and the exception test
+ * after the call: the functions use helper_return_on_exception() to
+ * dispatch exceptions they throw. Virtual methods are replaced only if
+ * they can't be overridden, like the methods of the final java.lang.String.
+ *
+ * Simple arithmetic and bit manipulation methods are not called at all.
+ * They are converted to IR operators that the instruction selector emits
+ * as a few machine instructions. Whether an operator is available can
+ * depend on the CPU, see arch_has_intrinsic_op().
+ *
+ * The volatile accesses and compare-and-swap operations of
+ * sun.misc.Unsafe that java.util.concurrent is built on are emitted as
+ * plain loads and stores, memory barriers and locked instructions, see
+ * arch_has_unsafe_intrinsics().
+ */
+
+#include "jit/intrinsics.h"
+#include "jit/expression.h"
+
+#include "arch/intrinsics.h"
+
+#include "vm/method.h"
+#include "vm/object.h"
+#include "vm/string.h"
+#include "vm/class.h"
+#include "vm/system.h"
+
+#include <string.h>
+
+bool opt_intrinsics_enabled = true;
+
+static struct intrinsic intrinsics[] = {
+	DEFINE_INTRINSIC("java/lang/System", "arraycopy",
+			 "(Ljava/lang/Object;ILjava/lang/Object;II)V", array_copy),
+	DEFINE_INTRINSIC("java/lang/VMSystem", "arraycopy",
+			 "(Ljava/lang/Object;ILjava/lang/Object;II)V", array_copy),
+
+	DEFINE_INTRINSIC("java/lang/String", "equals", "(Ljava/lang/Object;)Z", string_equals),
+	DEFINE_INTRINSIC("java/lang/String", "compareTo", "(Ljava/lang/String;)I", string_compare_to),
+	DEFINE_INTRINSIC("java/lang/String", "indexOf", "(I)I", string_index_of_char),
+	DEFINE_INTRINSIC("java/lang/String", "indexOf", "(Ljava/lang/String;)I", string_index_of),
+	DEFINE_INTRINSIC("java/lang/String", "hashCode", "()I", string_hash_code),
+
+	DEFINE_INTRINSIC_OP("java/lang/Math", "sqrt", "(D)D", OP_DSQRT),
+	DEFINE_INTRINSIC_OP("java/lang/Math", "abs", "(I)I", OP_ABS),
+	DEFINE_INTRINSIC_OP("java/lang/Math", "abs", "(J)J", OP_ABS),
+	DEFINE_INTRINSIC_OP("java/lang/Math", "abs", "(F)F", OP_FABS),
+	DEFINE_INTRINSIC_OP("java/lang/Math", "abs", "(D)D", OP_DABS),
+	DEFINE_INTRINSIC_OP("java/lang/Math", "min", "(II)I", OP_MIN),
+	DEFINE_INTRINSIC_OP("java/lang/Math", "min", "(JJ)J", OP_MIN),
+	DEFINE_INTRINSIC_OP("java/lang/Math", "max", "(II)I", OP_MAX),
+	DEFINE_INTRINSIC_OP("java/lang/Math", "max", "(JJ)J", OP_MAX),
+
+	DEFINE_INTRINSIC_OP("java/lang/StrictMath", "sqrt", "(D)D", OP_DSQRT),
+	DEFINE_INTRINSIC_OP("java/lang/StrictMath", "abs", "(I)I", OP_ABS),
+	DEFINE_INTRINSIC_OP("java/lang/StrictMath", "abs", "(J)J", OP_ABS),
+	DEFINE_INTRINSIC_OP("java/lang/StrictMath", "abs", "(F)F", OP_FABS),
+	DEFINE_INTRINSIC_OP("java/lang/StrictMath", "abs", "(D)D", OP_DABS),
+	DEFINE_INTRINSIC_OP("java/lang/StrictMath", "min", "(II)I", OP_MIN),
+	DEFINE_INTRINSIC_OP("java/lang/StrictMath", "min", "(JJ)J", OP_MIN),
+	DEFINE_INTRINSIC_OP("java/lang/StrictMath", "max", "(II)I", OP_MAX),
+	DEFINE_INTRINSIC_OP("java/lang/StrictMath", "max", "(JJ)J", OP_MAX),
+
+	DEFINE_INTRINSIC_OP("java/lang/Integer", "bitCount", "(I)I", OP_BITCOUNT),
+	DEFINE_INTRINSIC_OP("java/lang/Integer", "numberOfLeadingZeros", "(I)I", OP_LEADING_ZEROS),
+	DEFINE_INTRINSIC_OP("java/lang/Integer", "numberOfTrailingZeros", "(I)I", OP_TRAILING_ZEROS),
+	DEFINE_INTRINSIC_OP("java/lang/Integer", "reverseBytes", "(I)I", OP_BSWAP),
+	DEFINE_INTRINSIC_OP("java/lang/Integer", "rotateLeft", "(II)I", OP_ROL),
+	DEFINE_INTRINSIC_OP("java/lang/Integer", "rotateRight", "(II)I", OP_ROR),
+
+	DEFINE_INTRINSIC_OP("java/lang/Long", "bitCount", "(J)I", OP_BITCOUNT),
+	DEFINE_INTRINSIC_OP("java/lang/Long", "numberOfLeadingZeros", "(J)I", OP_LEADING_ZEROS),
+	DEFINE_INTRINSIC_OP("java/lang/Long", "numberOfTrailingZeros", "(J)I", OP_TRAILING_ZEROS),
+	DEFINE_INTRINSIC_OP("java/lang/Long", "reverseBytes", "(J)J", OP_BSWAP),
+	DEFINE_INTRINSIC_OP("java/lang/Long", "rotateLeft", "(JI)J", OP_ROL),
+	DEFINE_INTRINSIC_OP("java/lang/Long", "rotateRight", "(JI)J", OP_ROR),
+
+	DEFINE_INTRINSIC_OP("java/lang/Float", "floatToRawIntBits", "(F)I", OP_FLOAT_BITS),
+	DEFINE_INTRINSIC_OP("java/lang/Double", "doubleToRawLongBits", "(D)J", OP_DOUBLE_BITS),
+
+	DEFINE_INTRINSIC_UNSAFE("getIntVolatile", "(Ljava/lang/Object;J)I", UNSAFE_GET_VOLATILE),
+	DEFINE_INTRINSIC_UNSAFE("getLongVolatile", "(Ljava/lang/Object;J)J", UNSAFE_GET_VOLATILE),
+	DEFINE_INTRINSIC_UNSAFE("getObjectVolatile", "(Ljava/lang/Object;J)Ljava/lang/Object;", UNSAFE_GET_VOLATILE),
+	DEFINE_INTRINSIC_UNSAFE("putLong", "(Ljava/lang/Object;JJ)V", UNSAFE_PUT),
+	DEFINE_INTRINSIC_UNSAFE("putObject", "(Ljava/lang/Object;JLjava/lang/Object;)V", UNSAFE_PUT),
+	DEFINE_INTRINSIC_UNSAFE("putIntVolatile", "(Ljava/lang/Object;JI)V", UNSAFE_PUT_VOLATILE),
+	DEFINE_INTRINSIC_UNSAFE("putLongVolatile", "(Ljava/lang/Object;JJ)V", UNSAFE_PUT_VOLATILE),
+	DEFINE_INTRINSIC_UNSAFE("putObjectVolatile", "(Ljava/lang/Object;JLjava/lang/Object;)V", UNSAFE_PUT_VOLATILE),
+	DEFINE_INTRINSIC_UNSAFE("compareAndSwapInt", "(Ljava/lang/Object;JII)Z", UNSAFE_COMPARE_AND_SWAP),
+	DEFINE_INTRINSIC_UNSAFE("compareAndSwapLong", "(Ljava/lang/Object;JJJ)Z", UNSAFE_COMPARE_AND_SWAP),
+	DEFINE_INTRINSIC_UNSAFE("compareAndSwapObject", "(Ljava/lang/Object;JLjava/lang/Object;Ljava/lang/Object;)Z", UNSAFE_COMPARE_AND_SWAP),
+};
+
+#define NR_INTRINSICS ARRAY_SIZE(intrinsics)
+
+/*
+ * Returns the type of the first operand of an intrinsic operator.
+ */
+static enum vm_type intrinsic_operand_type(struct vm_method *vmm)
+{
+	return str_to_type(vmm->type + 1);
+}
+
+/*
+ * Returns the intrinsic that implements @vmm or NULL if calls to @vmm
+ * must go through the method.
+ */
+struct intrinsic *lookup_intrinsic(struct vm_method *vmm)
+{
+	unsigned int i;
+
+	if (!opt_intrinsics_enabled)
+		return NULL;
+
+	for (i = 0; i < NR_INTRINSICS; i++) {
+		struct intrinsic *intrinsic = &intrinsics[i];
+
+		if (strcmp(intrinsic->class_name, vmm->class->name))
+			continue;
+
+		if (strcmp(intrinsic->method_name, vmm->name) ||
+		    strcmp(intrinsic->method_type, vmm->type))
+			continue;
+
+		if (intrinsic_is_op(intrinsic) &&
+		    !arch_has_intrinsic_op(intrinsic->op, intrinsic_operand_type(vmm)))
+			return NULL;
+
+		if (intrinsic_is_unsafe(intrinsic) && !arch_has_unsafe_intrinsics())
+			return NULL;
+
+		return intrinsic;
+	}
+
+	return NULL;
+}
@@ -12,6 +12,9 @@
 
 #include "jit/statement.h"
 #include "jit/compiler.h"
+#include "jit/intrinsics.h"
+#include "jit/inline.h"
+#include "jit/cha.h"
 #include "jit/args.h"
 
 #include "vm/bytecode.h"
@@ -194,6 +197,119 @@ static void null_check_this_arg(struct expression *arg)
 	null_check_this_arg(to_expr(arg->args_left));
 }
 
+static int convert_intrinsic(struct parse_context *ctx,
+			     struct vm_method *invoke_target,
+			     struct intrinsic *intrinsic)
+{
+	struct statement *stmt;
+	int err;
+
+	stmt = invoke_stmt(ctx, STMT_INVOKE, invoke_target);
+	if (!stmt)
+		return warn("out of memory"), -ENOMEM;
+
+	stmt->invoke_intrinsic = intrinsic->func;
+
+	err = convert_and_add_args(ctx, invoke_target, stmt);
+	if (err)
+		goto failed;
+
+	if (!vm_method_is_static(invoke_target))
+		null_check_this_arg(to_expr(stmt->args_list));
+
+	insert_invoke_stmt(ctx, stmt);
+	return 0;
+      failed:
+	free_statement(stmt);
+	return err;
+}
+
+/*
+ * Replaces a call to a sun.misc.Unsafe method with the memory access of
+ * @intrinsic. The Unsafe instance is only null checked.
+ */
+static int convert_unsafe_intrinsic(struct parse_context *ctx,
+				    struct vm_method *invoke_target,
+				    struct intrinsic *intrinsic)
+{
+	struct expression *expect, *update, *value;
+	struct expression *objectref, *offset;
+	struct expression *field, *expr;
+	struct expression *unsafe;
+	struct statement *stmt;
+
+	expect = update = value = NULL;
+
+	switch (intrinsic->unsafe) {
+	case UNSAFE_PUT:
+	case UNSAFE_PUT_VOLATILE:
+		value = stack_pop(ctx->bb->mimic_stack);
+		break;
+	case UNSAFE_COMPARE_AND_SWAP:
+		update = stack_pop(ctx->bb->mimic_stack);
+		expect = stack_pop(ctx->bb->mimic_stack);
+		break;
+	default:
+		break;
+	}
+
+	offset = stack_pop(ctx->bb->mimic_stack);
+	objectref = stack_pop(ctx->bb->mimic_stack);
+	unsafe = null_check_expr(stack_pop(ctx->bb->mimic_stack));
+	if (!unsafe)
+		return warn("out of memory"), -ENOMEM;
+
+	stmt = alloc_statement(STMT_EXPRESSION);
+	if (!stmt)
+		return warn("out of memory"), -ENOMEM;
+
+	stmt->expression = &unsafe->node;
+	convert_statement(ctx, stmt);
+
+	switch (intrinsic->unsafe) {
+	case UNSAFE_GET_VOLATILE:
+		field = unsafe_field_expr(method_return_type(invoke_target), objectref, offset);
+		if (!field)
+			return warn("out of memory"), -ENOMEM;
+
+		convert_expression(ctx, dup_expr(ctx, field));
+		break;
+	case UNSAFE_PUT:
+	case UNSAFE_PUT_VOLATILE:
+		field = unsafe_field_expr(value->vm_type, objectref, offset);
+		if (!field)
+			return warn("out of memory"), -ENOMEM;
+
+		stmt = alloc_statement(STMT_STORE);
+		if (!stmt) {
+			expr_put(field);
+			return warn("out of memory"), -ENOMEM;
+		}
+		stmt->store_dest = &field->node;
+		stmt->store_src = &value->node;
+		stmt->store_volatile = intrinsic->unsafe == UNSAFE_PUT_VOLATILE;
+		convert_statement(ctx, stmt);
+		break;
+	case UNSAFE_COMPARE_AND_SWAP:
+		field = unsafe_field_expr(update->vm_type, objectref, offset);
+		if (!field)
+			return warn("out of memory"), -ENOMEM;
+
+		expr = compare_and_swap_expr(field, expect, update);
+		if (!expr) {
+			expr_put(field);
+			return warn("out of memory"), -ENOMEM;
+		}
+
+		convert_expression(ctx, dup_expr(ctx, expr));
+		break;
+	default:
+		assert(!"invalid unsafe intrinsic");
+	}
+
+	return 0;
+}
+
 int convert_invokeinterface(struct parse_context *ctx)
 {
 	struct vm_method *invoke_target;
@@ -235,14 +351,39 @@ failed:
 int convert_invokevirtual(struct parse_context *ctx)
 {
 	struct vm_method *invoke_target;
+	struct intrinsic *intrinsic;
 	struct statement *stmt;
+	bool devirtualized;
+	bool inlined;
 	int err = -ENOMEM;
 
 	invoke_target = resolve_invoke_target(ctx, 0);
 	if (!invoke_target)
 		return warn("unable to resolve invocation target"), -EINVAL;
 
-	stmt = invoke_stmt(ctx, STMT_INVOKEVIRTUAL, invoke_target);
+	/* Intrinsics can only replace methods that are never overridden. */
+	if (vm_method_is_final(invoke_target) || vm_class_is_final(invoke_target->class)) {
+		intrinsic = lookup_intrinsic(invoke_target);
+		if (intrinsic && intrinsic_is_unsafe(intrinsic))
+			return convert_unsafe_intrinsic(ctx, invoke_target, intrinsic);
+
+		if (intrinsic && !intrinsic_is_op(intrinsic))
+			return convert_intrinsic(ctx, invoke_target, intrinsic);
+	}
+
+	err = inline_invoke(ctx, invoke_target, &inlined);
+	if (err || inlined)
+		return err;
+
+	devirtualized = cha_devirtualize(ctx, invoke_target);
+	if (devirtualized) {
+		err = inline_devirtualized_invoke(ctx, invoke_target, &inlined);
+		if (err || inlined)
+			return err;
+	}
+
+	stmt = invoke_stmt(ctx, devirtualized ? STMT_INVOKE : STMT_INVOKEVIRTUAL,
+			   invoke_target);
 	if (!stmt)
 		return warn("out of memory"), -ENOMEM;
 
@@ -250,6 +391,9 @@ int convert_invokevirtual(struct parse_context *ctx)
 	if (err)
 		goto failed;
 
+	if (devirtualized)
+		null_check_this_arg(to_expr(stmt->args_list));
+
 	insert_invoke_stmt(ctx, stmt);
 	return 0;
       failed:
@@ -261,12 +405,17 @@ int convert_invokespecial(struct parse_context *ctx)
 {
 	struct vm_method *invoke_target;
 	struct statement *stmt;
+	bool inlined;
 	int err;
 
 	invoke_target = resolve_invoke_target(ctx, CAFEBABE_CLASS_ACC_STATIC);
 	if (!invoke_target)
 		return warn("unable to resolve invocation target"), -EINVAL;
 
+	err = inline_invoke(ctx, invoke_target, &inlined);
+	if (err || inlined)
+		return err;
+
 	stmt = invoke_stmt(ctx, STMT_INVOKE, invoke_target);
 	if (!stmt)
 		return warn("out of memory"), -ENOMEM;
@@ -284,16 +433,73 @@ int convert_invokespecial(struct parse_context *ctx)
 	return err;
 }
 
+/*
+ * Replaces the call with the operator of @intrinsic. Rotates are only
+ * converted if the distance is a constant.
+ */
+static int convert_intrinsic_op(struct parse_context *ctx,
+				struct vm_method *invoke_target,
+				struct intrinsic *intrinsic, bool *converted)
+{
+	struct expression *left, *right, *expr;
+	enum vm_type vm_type;
+
+	*converted = false;
+
+	vm_type = method_return_type(invoke_target);
+
+	if (intrinsic->op < BINOP_LAST) {
+		right = stack_peek(ctx->bb->mimic_stack);
+
+		if ((intrinsic->op == OP_ROL || intrinsic->op == OP_ROR) &&
+		    expr_type(right) != EXPR_VALUE)
+			return 0;
+
+		right = stack_pop(ctx->bb->mimic_stack);
+		left = stack_pop(ctx->bb->mimic_stack);
+
+		expr = binop_expr(vm_type, intrinsic->op, left, right);
+	} else {
+		left = stack_pop(ctx->bb->mimic_stack);
+
+		expr = unary_op_expr(vm_type, intrinsic->op, left);
+	}
+
+	if (!expr)
+		return warn("out of memory"), -ENOMEM;
+
+	convert_expression(ctx, expr);
+	*converted = true;
+	return 0;
+}
+
 int convert_invokestatic(struct parse_context *ctx)
 {
+	struct intrinsic *intrinsic;
 	struct vm_method *invoke_target;
 	struct statement *stmt;
+	bool converted;
+	bool inlined;
 	int err;
 
 	invoke_target = resolve_invoke_target(ctx, CAFEBABE_CLASS_ACC_STATIC);
 	if (!invoke_target)
 		return warn("unable to resolve invocation target"), -EINVAL;
 
+	intrinsic = lookup_intrinsic(invoke_target);
+	if (intrinsic && !intrinsic_is_op(intrinsic))
+		return convert_intrinsic(ctx, invoke_target, intrinsic);
+
+	if (intrinsic) {
+		err = convert_intrinsic_op(ctx, invoke_target, intrinsic, &converted);
+		if (err || converted)
+			return err;
+	}
+
+	err = inline_invoke(ctx, invoke_target, &inlined);
+	if (err || inlined)
+		return err;
+
 	stmt = invoke_stmt(ctx, STMT_INVOKE, invoke_target);
 	if (!stmt)
 		return warn("out of memory"), -ENOMEM;
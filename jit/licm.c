@@ -0,0 +1,450 @@
+/*
+ * Loop-invariant code motion on SSA form.
+ *
+ * This file is released under the GPL version 2. Please refer to the file
+ * LICENSE for details.
+ *
+ * Instructions in a loop whose operands are defined outside of it are
+ * moved to the end of the loop preheader, the single block outside of the
+ * loop that enters it. Loops are processed innermost first so that an
+ * instruction can travel out of a whole loop nest.
+ *
+ * Arithmetic and loads of local variables that the loop doesn't store to
+ * can't fault and are moved from anywhere in the loop. Loads from memory
+ * and null checks are only moved out of loops that don't write memory or
+ * call and only when they are at the start of the loop header, before
+ * anything that can throw or has side effects. The header runs every time
+ * the preheader does, so such an instruction would have faulted in the
+ * first iteration anyway, with the same bytecode offset.
+ *
+ * Loops that exception handlers jump into are not touched because the
+ * handler code is not dominated by the loop header.
+ */
+
+#include "jit/compilation-unit.h"
+#include "jit/compiler.h"
+#include "jit/instruction.h"
+#include "jit/stack-slot.h"
+#include "jit/ssa.h"
+#include "jit/vars.h"
+
+#include "lib/bitset.h"
+
+#include <stdlib.h>
+
+struct licm_context {
+	struct compilation_unit *cu;
+	struct bitset *eh_uses;
+	/* Block that defines a variable, indexed by vreg */
+	struct basic_block **def_bbs;
+	unsigned long nr_vregs;
+};
+
+struct licm_loop {
+	struct basic_block *header;
+	struct basic_block *preheader;
+	struct bitset *blocks;
+	bool has_writes;
+};
+
+static bool var_is_fixed(struct var_info *var)
+{
+	return interval_has_fixed_reg(var->interval);
+}
+
+static struct basic_block *def_bb(struct licm_context *ctx, struct var_info *var)
+{
+	if (var->vreg >= ctx->nr_vregs)
+		return NULL;
+
+	return ctx->def_bbs[var->vreg];
+}
+
+static bool in_loop(struct licm_loop *loop, struct basic_block *bb)
+{
+	return bb && test_bit(loop->blocks->bits, bb->dfn);
+}
+
+static int init_def_bbs(struct licm_context *ctx)
+{
+	struct compilation_unit *cu = ctx->cu;
+	struct basic_block *bb;
+	struct insn *insn;
+
+	ctx->nr_vregs = cu->ssa_nr_vregs;
+	ctx->def_bbs = calloc(ctx->nr_vregs, sizeof *ctx->def_bbs);
+	if (!ctx->def_bbs)
+		return -ENOMEM;
+
+	for_each_basic_block(bb, &cu->bb_list) {
+		if (!bb->dfn && bb != cu->entry_bb)
+			continue;
+
+		for_each_insn(insn, &bb->insn_list) {
+			struct use_position *defs[MAX_REG_OPERANDS + 1];
+			int nr_defs;
+
+			nr_defs = insn_defs_reg(insn, defs);
+			for (int i = 0; i < nr_defs; i++) {
+				struct var_info *var = defs[i]->interval->var_info;
+
+				if (var->vreg < ctx->nr_vregs)
+					ctx->def_bbs[var->vreg] = bb;
+			}
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Returns the preheader of the loop or NULL if the loop can't be handled.
+ */
+static struct basic_block *find_preheader(struct licm_loop *loop)
+{
+	struct basic_block *header = loop->header, *preheader = NULL;
+	struct insn *last;
+
+	if (header->is_eh)
+		return NULL;
+
+	for (unsigned long i = 0; i < header->nr_predecessors; i++) {
+		struct basic_block *pred = header->predecessors[i];
+
+		if (in_loop(loop, pred))
+			continue;
+
+		if (preheader)
+			return NULL;
+
+		preheader = pred;
+	}
+
+	if (!preheader || preheader->nr_successors != 1)
+		return NULL;
+
+	if (!preheader->dfn && preheader != header->b_parent->entry_bb)
+		return NULL;
+
+	last = bb_last_insn(preheader);
+	if (last && insn_is_branch(last) && !insn_is_jmp_branch(last))
+		return NULL;
+
+	return preheader;
+}
+
+static bool init_loop(struct licm_context *ctx, struct licm_loop *loop,
+		      struct basic_block *header)
+{
+	struct compilation_unit *cu = ctx->cu;
+
+	*loop = (struct licm_loop) {
+		.header		= header,
+		.blocks		= header->natural_loop,
+	};
+
+	for (unsigned long i = 0; i < nr_bblocks(cu); i++) {
+		struct basic_block *bb = cu->bb_df_array[i];
+		struct insn *insn;
+
+		if (!bb || !in_loop(loop, bb))
+			continue;
+
+		if (bb != header && !test_bit(bb->dominators->bits, header->dfn))
+			return false;
+
+		for_each_insn(insn, &bb->insn_list) {
+			struct ssa_insn_info info;
+
+			ssa_classify_insn(cu, bb, insn, &info);
+
+			if (info.effects & SSA_EFFECT_WRITE)
+				loop->has_writes = true;
+		}
+	}
+
+	loop->preheader = find_preheader(loop);
+
+	return loop->preheader != NULL;
+}
+
+static bool local_slot_index(struct compilation_unit *cu,
+			     struct stack_slot *slot, unsigned long *idx)
+{
+	struct stack_frame *frame = cu->stack_frame;
+
+	if (!slot || slot < frame->local_slots ||
+	    slot >= frame->local_slots + frame->nr_local_slots)
+		return false;
+
+	*idx = slot->index;
+	return true;
+}
+
+/*
+ * Returns true if the loop may store to the Java local variable in @slot.
+ * Scratch slots are treated as always stored to.
+ */
+static bool slot_is_stored(struct licm_context *ctx, struct licm_loop *loop,
+			   struct stack_slot *slot)
+{
+	struct compilation_unit *cu = ctx->cu;
+	unsigned long idx;
+
+	if (!local_slot_index(cu, slot, &idx))
+		return true;
+
+	for (unsigned long i = 0; i < nr_bblocks(cu); i++) {
+		struct basic_block *bb = cu->bb_df_array[i];
+		struct insn *insn;
+
+		if (!bb || !in_loop(loop, bb))
+			continue;
+
+		for_each_insn(insn, &bb->insn_list) {
+			struct ssa_insn_info info;
+			unsigned long store_idx;
+
+			ssa_classify_insn(cu, bb, insn, &info);
+			if (info.kind != SSA_INSN_STORE_LOCAL)
+				continue;
+
+			if (!local_slot_index(cu, info.slot, &store_idx))
+				continue;
+
+			if (store_idx == idx || (info.wide && store_idx + 1 == idx))
+				return true;
+		}
+	}
+
+	return false;
+}
+
+static bool uses_only_in(struct var_info *var, struct insn *def, struct insn *insn)
+{
+	struct use_position *reg;
+
+	list_for_each_entry(reg, &var->interval->use_positions, use_pos_list) {
+		if (reg->insn != def && reg->insn != insn)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Returns true if @var has the same value everywhere in the loop. A
+ * constant that is defined in the loop and only used by @insn is moved
+ * together with it and is returned in @konst.
+ */
+static bool operand_is_invariant(struct licm_context *ctx, struct licm_loop *loop,
+				 struct insn *insn, struct var_info *var,
+				 struct insn **konst)
+{
+	struct basic_block *bb;
+	struct insn *def;
+
+	if (!var)
+		return true;
+
+	if (var_is_fixed(var))
+		return false;
+
+	bb = def_bb(ctx, var);
+
+	/*
+	 * Values that the entry block defines must not become live in code
+	 * that exception handlers reach. See ssa_eh_uses().
+	 */
+	if (bb == ctx->cu->entry_bb && loop->preheader->eh_reachable &&
+	    loop->preheader != ctx->cu->entry_bb)
+		return false;
+
+	if (!in_loop(loop, bb))
+		return true;
+
+	def = ssa_def_insn(var);
+	if (!def || !insn_is_mov_imm_reg(def) || !uses_only_in(var, def, insn))
+		return false;
+
+	if (loop->preheader == ctx->cu->entry_bb &&
+	    test_bit(ctx->eh_uses->bits, var->vreg))
+		return false;
+
+	*konst = def;
+	return true;
+}
+
+/*
+ * Returns true if @insn is preceded in the loop header only by
+ * instructions that can't fault or have side effects.
+ */
+static bool starts_header(struct licm_context *ctx, struct licm_loop *loop,
+			  struct basic_block *bb, struct insn *insn)
+{
+	struct insn *this;
+
+	if (bb != loop->header)
+		return false;
+
+	for_each_insn(this, &bb->insn_list) {
+		struct ssa_insn_info info;
+
+		if (this == insn)
+			return true;
+
+		if (insn_is_phi(this))
+			continue;
+
+		ssa_classify_insn(ctx->cu, bb, this, &info);
+
+		if (info.effects || info.kind == SSA_INSN_STORE_LOCAL)
+			return false;
+	}
+
+	return false;
+}
+
+static bool is_invariant(struct licm_context *ctx, struct licm_loop *loop,
+			 struct basic_block *bb, struct insn *insn,
+			 struct ssa_insn_info *info, struct insn **konsts)
+{
+	switch (info->kind) {
+	case SSA_INSN_ARITH:
+		return operand_is_invariant(ctx, loop, insn, info->src, &konsts[0]) &&
+			operand_is_invariant(ctx, loop, insn, info->src2, &konsts[1]);
+	case SSA_INSN_ADD_IMM:
+		return operand_is_invariant(ctx, loop, insn, info->src, &konsts[0]);
+	case SSA_INSN_LOAD_LOCAL:
+		return !slot_is_stored(ctx, loop, info->slot);
+	case SSA_INSN_LOAD_MEMBASE:
+	case SSA_INSN_NULL_CHECK:
+		if (loop->has_writes || !starts_header(ctx, loop, bb, insn))
+			return false;
+
+		if (info->kind == SSA_INSN_LOAD_MEMBASE)
+			return operand_is_invariant(ctx, loop, insn, info->src, &konsts[0]) && !konsts[0];
+
+		return operand_is_invariant(ctx, loop, insn, info->var, &konsts[0]) && !konsts[0];
+	default:
+		return false;
+	}
+}
+
+static void move_insn(struct licm_context *ctx, struct licm_loop *loop,
+		      struct insn *insn)
+{
+	struct basic_block *preheader = loop->preheader;
+	struct use_position *defs[MAX_REG_OPERANDS + 1];
+	struct insn *last;
+	int nr_defs;
+
+	list_del(&insn->insn_list_node);
+
+	last = bb_last_insn(preheader);
+	if (last && insn_is_jmp_branch(last))
+		list_add_tail(&insn->insn_list_node, &last->insn_list_node);
+	else
+		list_add_tail(&insn->insn_list_node, &preheader->insn_list);
+
+	nr_defs = insn_defs_reg(insn, defs);
+	for (int i = 0; i < nr_defs; i++) {
+		struct var_info *var = defs[i]->interval->var_info;
+
+		if (var->vreg < ctx->nr_vregs)
+			ctx->def_bbs[var->vreg] = preheader;
+	}
+}
+
+static bool hoist_insn(struct licm_context *ctx, struct licm_loop *loop,
+		       struct basic_block *bb, struct insn *insn)
+{
+	struct insn *konsts[2] = { NULL, NULL };
+	struct ssa_insn_info info;
+
+	ssa_classify_insn(ctx->cu, bb, insn, &info);
+
+	if (info.kind != SSA_INSN_NULL_CHECK) {
+		if (!info.var || var_is_fixed(info.var))
+			return false;
+
+		if (loop->preheader == ctx->cu->entry_bb &&
+		    test_bit(ctx->eh_uses->bits, info.var->vreg))
+			return false;
+	}
+
+	if (!is_invariant(ctx, loop, bb, insn, &info, konsts))
+		return false;
+
+	for (int i = 0; i < 2; i++) {
+		if (konsts[i] && konsts[i] != konsts[1 - i])
+			move_insn(ctx, loop, konsts[i]);
+	}
+
+	if (konsts[0] && konsts[0] == konsts[1])
+		move_insn(ctx, loop, konsts[0]);
+
+	move_insn(ctx, loop, insn);
+
+	return true;
+}
+
+static void hoist_loop(struct licm_context *ctx, struct basic_block *header)
+{
+	struct compilation_unit *cu = ctx->cu;
+	struct licm_loop loop;
+	bool changed;
+
+	if (!init_loop(ctx, &loop, header))
+		return;
+
+	do {
+		changed = false;
+
+		for (unsigned long i = 0; i < nr_bblocks(cu); i++) {
+			struct basic_block *bb = cu->bb_df_array[i];
+			struct insn *insn, *tmp;
+
+			if (!bb || !in_loop(&loop, bb))
+				continue;
+
+			list_for_each_entry_safe(insn, tmp, &bb->insn_list, insn_list_node) {
+				if (insn_is_phi(insn))
+					continue;
+
+				if (hoist_insn(ctx, &loop, bb, insn)) {
+					changed = true;
+					break;
+				}
+			}
+		}
+	} while (changed);
+}
+
+int licm(struct compilation_unit *cu)
+{
+	struct licm_context ctx = { .cu = cu };
+	int err;
+
+	err = init_def_bbs(&ctx);
+	if (err)
+		return err;
+
+	ctx.eh_uses = ssa_eh_uses(cu);
+	if (!ctx.eh_uses) {
+		free(ctx.def_bbs);
+		return -ENOMEM;
+	}
+
+	for (unsigned long i = nr_bblocks(cu); i-- > 0; ) {
+		struct basic_block *bb = cu->bb_df_array[i];
+
+		if (bb && bb->natural_loop)
+			hoist_loop(&ctx, bb);
+	}
+
+	free(ctx.eh_uses);
+	free(ctx.def_bbs);
+
+	return 0;
+}
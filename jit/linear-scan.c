@@ -36,8 +36,10 @@
  */
 
 #include "jit/compiler.h"
+#include "jit/instruction.h"
 #include "jit/vars.h"
 
+#include "lib/arena.h"
 #include "lib/bitset.h"
 #include "lib/pqueue.h"
 
@@ -112,6 +114,75 @@ static enum machine_reg pick_register(unsigned long *free_until_pos, enum vm_typ
 	return ret;
 }
 
+/*
+ * Returns the register that @it's hint, or the child of the hint that
+ * contains the hint position, was allocated or MACH_REG_UNASSIGNED.
+ */
+static enum machine_reg hint_reg(struct live_interval *it)
+{
+	struct live_interval *hint = it->hint;
+
+	if (!hint)
+		return MACH_REG_UNASSIGNED;
+
+	if (interval_has_fixed_reg(hint))
+		return hint->reg;
+
+	while (hint && interval_end(hint) <= it->hint_pos)
+		hint = hint->next_child;
+
+	if (!hint)
+		return MACH_REG_UNASSIGNED;
+
+	if (list_is_empty(&hint->expired_range_list) && interval_start(hint) > it->hint_pos)
+		return MACH_REG_UNASSIGNED;
+
+	return hint->reg;
+}
+
+static void set_hint(struct live_interval *it, struct live_interval *hint, unsigned long pos)
+{
+	if (it->hint || interval_has_fixed_reg(it))
+		return;
+
+	it->hint = hint;
+	it->hint_pos = pos;
+}
+
+/*
+ * The source and destination of a register move should get the same
+ * register so that the move becomes redundant and is removed by the
+ * peephole optimizer. Values moved to or from fixed registers, like call
+ * arguments and return values, prefer the fixed register.
+ */
+static void compute_hints(struct compilation_unit *cu)
+{
+	struct basic_block *bb;
+	struct insn *insn;
+
+	for_each_basic_block(bb, &cu->bb_list) {
+		for_each_insn(insn, &bb->insn_list) {
+			struct var_info *uses[MAX_REG_OPERANDS];
+			struct var_info *defs[MAX_REG_OPERANDS];
+			struct live_interval *src, *dest;
+
+			if (!insn_is_copy(insn))
+				continue;
+
+			if (insn_uses(cu, insn, uses) != 1 || insn_defs(cu, insn, defs) != 1)
+				continue;
+
+			src = uses[0]->interval;
+			dest = defs[0]->interval;
+
+			set_hint(dest, src, insn->lir_pos);
+
+			if (interval_has_fixed_reg(dest))
+				set_hint(src, dest, insn->lir_pos);
+		}
+	}
+}
+
 static void spill_interval(struct compilation_unit *cu, struct live_interval *it, unsigned long pos, struct pqueue *unhandled)
 {
 	struct live_interval *new;
@@ -152,6 +223,14 @@ static void spill_interval(struct compilation_unit *cu, struct live_interval *it
 			mark_need_reload(new, it);
 
 		mark_need_spill(it);
+
+		/*
+		 * Reloading into the register that @it had avoids moves
+		 * when the data flow between basic blocks is resolved.
+		 */
+		new->hint = it;
+		new->hint_pos = interval_end(it) - 1;
+
 		pqueue_insert(unhandled, interval_start(new), new);
 	}
 }
@@ -313,6 +392,13 @@ static void try_to_allocate_free_reg(struct compilation_unit *cu,
 		}
 	}
 
+	reg = hint_reg(current);
+	if (reg < NR_REGISTERS && reg_supports_type(reg, current->var_info->vm_type)
+	    && interval_end(current) <= free_until_pos[reg]) {
+		current->reg = reg;
+		return;
+	}
+
 	reg = pick_register(free_until_pos, current->var_info->vm_type);
 	if (free_until_pos[reg] == 0) {
 		/*
@@ -335,6 +421,30 @@ static void try_to_allocate_free_reg(struct compilation_unit *cu,
 	}
 }
 
+/*
+ * In large methods intervals are allocated without their lifetime holes.
+ * Intervals without holes are never inactive, so the allocator does not
+ * have to test them for intersection with every new interval. The price
+ * is higher register pressure.
+ */
+static void fill_lifetime_holes(struct compilation_unit *cu, struct live_interval *it)
+{
+	struct live_range *first, *this, *next;
+
+	first = interval_first_range(it);
+	first->end = interval_end(it);
+
+	this = next_range(&it->range_list, first);
+	while (this) {
+		next = next_range(&it->range_list, this);
+
+		list_del(&this->range_list_node);
+		arena_free(cu->arena, this);
+
+		this = next;
+	}
+}
+
 int allocate_registers(struct compilation_unit *cu)
 {
 	struct list_head inactive = LIST_HEAD_INIT(inactive);
@@ -350,6 +460,8 @@ int allocate_registers(struct compilation_unit *cu)
 
 	bitset_set_all(registers);
 
+	compute_hints(cu);
+
 	unhandled = pqueue_alloc();
 	if (!unhandled) {
 		free(registers);
@@ -368,8 +480,15 @@ int allocate_registers(struct compilation_unit *cu)
 		if (interval_has_fixed_reg(var->interval)) {
 			if (var->interval->reg < NR_REGISTERS)
 				list_add(&var->interval->interval_node, &inactive);
-		} else
-			pqueue_insert(unhandled, interval_start(var->interval), var->interval);
+			continue;
+		}
+
+		if (cu->flags & CU_FLAG_LARGE_METHOD)
+			fill_lifetime_holes(cu, var->interval);
+
+		interval_cache_use_positions(var->interval);
+
+		pqueue_insert(unhandled, interval_start(var->interval), var->interval);
 	}
 
 	while (!pqueue_is_empty(unhandled)) {
@@ -429,6 +548,7 @@ int allocate_registers(struct compilation_unit *cu)
 
 		while (it) {
 			interval_restore_expired_ranges(it);
+			interval_free_use_positions_cache(it);
 			it = it->next_child;
 		}
 	}
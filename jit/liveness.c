@@ -60,7 +60,7 @@ static void __update_live_ranges(struct compilation_unit *cu, struct basic_block
 			r->start = insn->lir_pos + 1;
 		}
 
-		nr_uses = insn_uses(insn, uses);
+		nr_uses = insn_uses(bb->b_parent, insn, uses);
 		for (i = 0; i < nr_uses; i++)
 			interval_add_range(cu, uses[i]->interval, bb->start_insn, insn->lir_pos + 1);
 
@@ -160,7 +160,7 @@ static void __analyze_use_def(struct basic_block *bb, struct insn *insn)
 	int nr_defs;
 	int i;
 
-	nr_uses = insn_uses(insn, uses);
+	nr_uses = insn_uses(bb->b_parent, insn, uses);
 	for (i = 0; i < nr_uses; i++) {
 		struct var_info *var = uses[i];
 
@@ -0,0 +1,451 @@
+/*
+ * Null check elimination.
+ *
+ * This file is released under the GPL version 2. Please refer to the file
+ * LICENSE for details.
+ *
+ * The bytecode parser wraps every object reference that is dereferenced in
+ * an EXPR_NULL_CHECK. Many of them are redundant: the receiver of a
+ * non-static method is never null on entry, freshly allocated objects are
+ * never null, and a local variable that has already been checked or
+ * dereferenced cannot be null until it is stored to again.
+ *
+ * We run a forward must-dataflow analysis over Java local variables on the
+ * tree IR and remove null checks of references that are known to be
+ * non-null on every path. Temporaries are tracked within a basic block
+ * only which is enough for the values that get_pure_expr() spills before
+ * array accesses and for the results of 'new' that are kept on the mimic
+ * stack.
+ *
+ * Exception handlers are entered from any point of the protected range so
+ * we only assume 'this' to be non-null there, and only if the method never
+ * stores to local variable zero.
+ */
+
+#include "jit/compilation-unit.h"
+#include "jit/basic-block.h"
+#include "jit/expression.h"
+#include "jit/statement.h"
+#include "jit/compiler.h"
+
+#include "lib/hash-map.h"
+#include "lib/bitset.h"
+
+#include "vm/method.h"
+#include "vm/types.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#define MAX_NONNULL_TEMPS 16
+
+struct temp_set {
+	struct var_info *vars[MAX_NONNULL_TEMPS];
+	unsigned long nr;
+};
+
+struct null_check_context {
+	struct compilation_unit *cu;
+	unsigned long nr_locals;
+	bool rewrite;
+
+	/* Maps basic blocks to the set of non-null locals on exit. */
+	struct hash_map *out;
+
+	/* Locals that are known to be non-null on method entry. */
+	struct bitset *entry_in;
+
+	/* Locals that are known to be non-null on handler entry. */
+	struct bitset *handler_in;
+
+	/* Facts at the beginning of the current statement. */
+	struct bitset *state;
+	struct temp_set temps;
+
+	/* Facts established by the current statement. */
+	struct bitset *pending;
+	struct temp_set pending_temps;
+};
+
+static bool temp_set_contains(struct temp_set *set, struct var_info *var)
+{
+	unsigned long i;
+
+	for (i = 0; i < set->nr && i < MAX_NONNULL_TEMPS; i++) {
+		if (set->vars[i] == var)
+			return true;
+	}
+
+	return false;
+}
+
+static void temp_set_add(struct temp_set *set, struct var_info *var)
+{
+	if (temp_set_contains(set, var))
+		return;
+
+	/* Forget the oldest temporary when the set is full. */
+	set->vars[set->nr++ % MAX_NONNULL_TEMPS] = var;
+}
+
+static void temp_set_remove(struct temp_set *set, struct var_info *var)
+{
+	unsigned long i;
+
+	for (i = 0; i < set->nr && i < MAX_NONNULL_TEMPS; i++) {
+		if (set->vars[i] == var)
+			set->vars[i] = NULL;
+	}
+}
+
+static bool is_nonnull_local(struct null_check_context *ctx, struct expression *expr)
+{
+	if (expr->vm_type != J_REFERENCE)
+		return false;
+
+	if (expr->local_index >= ctx->nr_locals)
+		return false;
+
+	return test_bit(ctx->state->bits, expr->local_index);
+}
+
+static bool expr_is_nonnull(struct null_check_context *ctx, struct expression *expr)
+{
+	switch (expr_type(expr)) {
+	case EXPR_LOCAL:
+		return is_nonnull_local(ctx, expr);
+	case EXPR_TEMPORARY:
+		return expr->vm_type == J_REFERENCE && temp_set_contains(&ctx->temps, expr->tmp_low);
+	case EXPR_NEW:
+	case EXPR_NEWARRAY:
+	case EXPR_ANEWARRAY:
+	case EXPR_MULTIANEWARRAY:
+	case EXPR_EXCEPTION_REF:
+	case EXPR_NULL_CHECK:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static void record_null_check(struct null_check_context *ctx, struct expression *ref)
+{
+	switch (expr_type(ref)) {
+	case EXPR_LOCAL:
+		if (ref->local_index < ctx->nr_locals)
+			set_bit(ctx->pending->bits, ref->local_index);
+		break;
+	case EXPR_TEMPORARY:
+		temp_set_add(&ctx->pending_temps, ref->tmp_low);
+		break;
+	default:
+		break;
+	}
+}
+
+/*
+ * The kid slot pointed to by @kidp may only be replaced when the parent
+ * node is not shared with other trees which is what @owned tells.
+ */
+static void visit_expr(struct null_check_context *ctx, struct tree_node **kidp, bool owned)
+{
+	struct expression *expr, *ref;
+	int i;
+
+	expr = to_expr(*kidp);
+
+	for (i = 0; i < expr_nr_kids(expr); i++) {
+		if (expr->node.kids[i])
+			visit_expr(ctx, &expr->node.kids[i], owned && expr->refcount == 1);
+	}
+
+	if (expr_type(expr) != EXPR_NULL_CHECK)
+		return;
+
+	ref = to_expr(expr->null_check_ref);
+
+	if (ctx->rewrite && owned && expr_is_nonnull(ctx, ref)) {
+		expr_get(ref);
+		*kidp = &ref->node;
+		expr_put(expr);
+		return;
+	}
+
+	record_null_check(ctx, ref);
+}
+
+static void commit_pending(struct null_check_context *ctx)
+{
+	unsigned long i;
+
+	bitset_union_to(ctx->pending, ctx->state);
+	bitset_clear_all(ctx->pending);
+
+	for (i = 0; i < ctx->pending_temps.nr && i < MAX_NONNULL_TEMPS; i++) {
+		if (ctx->pending_temps.vars[i])
+			temp_set_add(&ctx->temps, ctx->pending_temps.vars[i]);
+	}
+	ctx->pending_temps.nr = 0;
+}
+
+static void kill_local(struct null_check_context *ctx, struct expression *local)
+{
+	unsigned long idx;
+	int i;
+
+	for (i = 0; i < vm_type_slot_size(local->vm_type); i++) {
+		idx = local->local_index + i;
+		if (idx < ctx->nr_locals)
+			clear_bit(ctx->state->bits, idx);
+	}
+}
+
+static void transfer_store(struct null_check_context *ctx, struct statement *stmt, bool nonnull)
+{
+	struct expression *dest = to_expr(stmt->store_dest);
+
+	switch (expr_type(dest)) {
+	case EXPR_LOCAL:
+		kill_local(ctx, dest);
+		if (nonnull && dest->vm_type == J_REFERENCE && dest->local_index < ctx->nr_locals)
+			set_bit(ctx->state->bits, dest->local_index);
+		break;
+	case EXPR_FLOAT_LOCAL:
+		kill_local(ctx, dest);
+		break;
+	case EXPR_TEMPORARY:
+		temp_set_remove(&ctx->temps, dest->tmp_low);
+		if (nonnull && dest->vm_type == J_REFERENCE)
+			temp_set_add(&ctx->temps, dest->tmp_low);
+		break;
+	default:
+		break;
+	}
+}
+
+/*
+ * Returns true if @stmt is a standalone null check that is redundant and
+ * can be removed altogether.
+ */
+static bool is_redundant_null_check_stmt(struct null_check_context *ctx, struct statement *stmt)
+{
+	struct expression *expr, *ref;
+
+	if (stmt_type(stmt) != STMT_EXPRESSION)
+		return false;
+
+	expr = to_expr(stmt->expression);
+	if (expr_type(expr) != EXPR_NULL_CHECK)
+		return false;
+
+	ref = to_expr(expr->null_check_ref);
+
+	return expr_is_pure(ref) && expr_is_nonnull(ctx, ref);
+}
+
+static bool visit_stmt(struct null_check_context *ctx, struct statement *stmt)
+{
+	struct expression *result;
+	bool nonnull = false;
+	int i;
+
+	if (ctx->rewrite && is_redundant_null_check_stmt(ctx, stmt))
+		return true;
+
+	for (i = 0; i < stmt_nr_kids(stmt); i++) {
+		if (stmt->node.kids[i])
+			visit_expr(ctx, &stmt->node.kids[i], true);
+	}
+
+	if (stmt_type(stmt) == STMT_STORE)
+		nonnull = expr_is_nonnull(ctx, to_expr(stmt->store_src));
+
+	commit_pending(ctx);
+
+	switch (stmt_type(stmt)) {
+	case STMT_STORE:
+		transfer_store(ctx, stmt, nonnull);
+		break;
+	case STMT_INVOKE:
+	case STMT_INVOKEVIRTUAL:
+	case STMT_INVOKEINTERFACE:
+		result = stmt->invoke_result;
+		if (result && expr_type(result) == EXPR_TEMPORARY)
+			temp_set_remove(&ctx->temps, result->tmp_low);
+		break;
+	default:
+		break;
+	}
+
+	return false;
+}
+
+static struct bitset *block_out(struct null_check_context *ctx, struct basic_block *bb)
+{
+	struct bitset *out;
+
+	if (hash_map_get(ctx->out, bb, (void **) &out))
+		return NULL;
+
+	return out;
+}
+
+static void compute_block_in(struct null_check_context *ctx, struct basic_block *bb)
+{
+	bool constrained = false;
+	unsigned long i;
+
+	bitset_set_all(ctx->state);
+
+	if (bb == ctx->cu->entry_bb) {
+		bitset_intersect_to(ctx->entry_in, ctx->state);
+		constrained = true;
+	}
+
+	if (bb->is_eh) {
+		bitset_intersect_to(ctx->handler_in, ctx->state);
+		constrained = true;
+	}
+
+	for (i = 0; i < bb->nr_predecessors; i++) {
+		struct bitset *out = block_out(ctx, bb->predecessors[i]);
+
+		if (!out)
+			continue;
+
+		bitset_intersect_to(out, ctx->state);
+		constrained = true;
+	}
+
+	if (!constrained)
+		bitset_clear_all(ctx->state);
+}
+
+static void process_block(struct null_check_context *ctx, struct basic_block *bb)
+{
+	struct statement *stmt, *next;
+
+	compute_block_in(ctx, bb);
+
+	ctx->temps.nr = 0;
+	ctx->pending_temps.nr = 0;
+	bitset_clear_all(ctx->pending);
+
+	list_for_each_entry_safe(stmt, next, &bb->stmt_list, stmt_list_node) {
+		if (visit_stmt(ctx, stmt)) {
+			list_del(&stmt->stmt_list_node);
+			free_statement(stmt);
+		}
+	}
+}
+
+static bool stores_to_local(struct compilation_unit *cu, unsigned long idx)
+{
+	struct basic_block *bb;
+	struct statement *stmt;
+
+	for_each_basic_block(bb, &cu->bb_list) {
+		for_each_stmt(stmt, &bb->stmt_list) {
+			struct expression *dest;
+
+			if (stmt_type(stmt) != STMT_STORE)
+				continue;
+
+			dest = to_expr(stmt->store_dest);
+			if (expr_type(dest) != EXPR_LOCAL && expr_type(dest) != EXPR_FLOAT_LOCAL)
+				continue;
+
+			if (dest->local_index <= idx &&
+			    idx < dest->local_index + vm_type_slot_size(dest->vm_type))
+				return true;
+		}
+	}
+
+	return false;
+}
+
+static void free_block_outs(struct null_check_context *ctx)
+{
+	struct basic_block *bb;
+
+	for_each_basic_block(bb, &ctx->cu->bb_list)
+		free(block_out(ctx, bb));
+
+	free_hash_map(ctx->out);
+}
+
+int remove_null_checks(struct compilation_unit *cu)
+{
+	struct null_check_context ctx;
+	struct basic_block *bb;
+	bool changed;
+	int err = -ENOMEM;
+
+	memset(&ctx, 0, sizeof(ctx));
+
+	ctx.cu = cu;
+	ctx.nr_locals = cu->method->code_attribute.max_locals;
+
+	ctx.out = alloc_hash_map(&pointer_key);
+	if (!ctx.out)
+		return -ENOMEM;
+
+	ctx.entry_in = alloc_bitset(ctx.nr_locals + 1);
+	ctx.handler_in = alloc_bitset(ctx.nr_locals + 1);
+	ctx.state = alloc_bitset(ctx.nr_locals + 1);
+	ctx.pending = alloc_bitset(ctx.nr_locals + 1);
+	if (!ctx.entry_in || !ctx.handler_in || !ctx.state || !ctx.pending)
+		goto out;
+
+	if (!vm_method_is_static(cu->method) && ctx.nr_locals > 0) {
+		set_bit(ctx.entry_in->bits, 0);
+
+		if (!stores_to_local(cu, 0))
+			set_bit(ctx.handler_in->bits, 0);
+	}
+
+	for_each_basic_block(bb, &cu->bb_list) {
+		struct bitset *out = alloc_bitset(ctx.nr_locals + 1);
+
+		if (!out)
+			goto out;
+
+		bitset_set_all(out);
+
+		if (hash_map_put(ctx.out, bb, out)) {
+			free(out);
+			goto out;
+		}
+	}
+
+	do {
+		changed = false;
+
+		for_each_basic_block(bb, &cu->bb_list) {
+			struct bitset *out = block_out(&ctx, bb);
+
+			process_block(&ctx, bb);
+
+			if (!bitset_equal(ctx.state, out)) {
+				bitset_copy_to(ctx.state, out);
+				changed = true;
+			}
+		}
+	} while (changed);
+
+	ctx.rewrite = true;
+
+	for_each_basic_block(bb, &cu->bb_list)
+		process_block(&ctx, bb);
+
+	err = 0;
+out:
+	free_block_outs(&ctx);
+	free(ctx.pending);
+	free(ctx.state);
+	free(ctx.handler_in);
+	free(ctx.entry_in);
+
+	return err;
+}
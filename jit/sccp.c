@@ -0,0 +1,540 @@
+/*
+ * Sparse conditional constant propagation.
+ *
+ * This file is released under the GPL version 2. Please refer to the file
+ * LICENSE for details.
+ *
+ * This is the algorithm of Wegman and Zadeck: every SSA variable starts
+ * out as "no value yet" and is lowered to a constant or to "not constant"
+ * as the instructions that define it are evaluated, and only blocks that
+ * are reachable from the entry through edges whose branches can be taken
+ * are evaluated at all. Phi instructions ignore the values that flow in
+ * over edges that are never taken, which is what lets constants pass
+ * through loops and merges that a simple folder would give up on.
+ *
+ * Only int variables are tracked, with the 32-bit wrap-around semantics
+ * of Java. Definitions that turn out to be constant are replaced with
+ * constant loads and conditional branches whose outcome is known become
+ * unconditional jumps. The edges of the branch that is never taken are
+ * left in the control flow graph so that the SSA deconstruction and
+ * register allocation don't have to deal with a changed graph.
+ *
+ * Exception handlers are entered from anywhere so they are evaluated from
+ * the start and the phis in them are never constant.
+ */
+
+#include "jit/bc-offset-mapping.h"
+#include "jit/compilation-unit.h"
+#include "jit/compiler.h"
+#include "jit/instruction.h"
+#include "jit/ssa.h"
+#include "jit/vars.h"
+
+#include "lib/bitset.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+enum sccp_state {
+	SCCP_TOP,		/* no value seen yet */
+	SCCP_CONST,
+	SCCP_BOTTOM,		/* not a constant */
+};
+
+struct sccp_value {
+	enum sccp_state state;
+	int32_t value;
+};
+
+enum sccp_outcome {
+	SCCP_NONE,		/* no successor is executed yet */
+	SCCP_TAKEN,
+	SCCP_NOT_TAKEN,
+	SCCP_ALL,
+};
+
+struct sccp_context {
+	struct compilation_unit *cu;
+	struct sccp_value *values;
+	unsigned long nr_values;
+	struct bitset *executable;
+	bool changed;
+};
+
+static bool bb_is_unreachable(struct compilation_unit *cu, struct basic_block *bb)
+{
+	return !bb->dfn && cu->entry_bb != bb;
+}
+
+static bool var_is_tracked(struct sccp_context *ctx, struct var_info *var)
+{
+	return var && var->vreg < ctx->nr_values && var->vm_type == J_INT &&
+		!interval_has_fixed_reg(var->interval);
+}
+
+static struct sccp_value var_value(struct sccp_context *ctx, struct var_info *var)
+{
+	if (!var_is_tracked(ctx, var))
+		return (struct sccp_value) { .state = SCCP_BOTTOM };
+
+	return ctx->values[var->vreg];
+}
+
+static void lower(struct sccp_context *ctx, struct var_info *var,
+		  struct sccp_value value)
+{
+	struct sccp_value *old;
+
+	if (!var_is_tracked(ctx, var))
+		return;
+
+	old = &ctx->values[var->vreg];
+
+	if (old->state == SCCP_CONST && value.state == SCCP_CONST &&
+	    old->value != value.value)
+		value.state = SCCP_BOTTOM;
+
+	if (value.state <= old->state)
+		return;
+
+	*old = value;
+	ctx->changed = true;
+}
+
+static struct sccp_value constant(int32_t value)
+{
+	return (struct sccp_value) { .state = SCCP_CONST, .value = value };
+}
+
+static struct sccp_value meet(struct sccp_value a, struct sccp_value b)
+{
+	if (a.state == SCCP_TOP)
+		return b;
+
+	if (b.state == SCCP_TOP)
+		return a;
+
+	if (a.state == SCCP_CONST && b.state == SCCP_CONST && a.value == b.value)
+		return a;
+
+	return (struct sccp_value) { .state = SCCP_BOTTOM };
+}
+
+static int32_t eval_op(enum ssa_op op, uint32_t a, uint32_t b)
+{
+	switch (op) {
+	case SSA_OP_ADD:
+		return a + b;
+	case SSA_OP_SUB:
+		return a - b;
+	case SSA_OP_MUL:
+		return a * b;
+	case SSA_OP_AND:
+		return a & b;
+	case SSA_OP_OR:
+		return a | b;
+	case SSA_OP_XOR:
+		return a ^ b;
+	case SSA_OP_NEG:
+		return -a;
+	}
+
+	return 0;
+}
+
+static struct sccp_value eval_insn(struct sccp_context *ctx,
+				   struct ssa_insn_info *info)
+{
+	struct sccp_value a, b;
+
+	switch (info->kind) {
+	case SSA_INSN_CONST:
+		return constant(info->imm);
+	case SSA_INSN_ADD_IMM:
+		a = var_value(ctx, info->src);
+		if (a.state != SCCP_CONST)
+			return a;
+
+		return constant(eval_op(SSA_OP_ADD, a.value, info->imm));
+	case SSA_INSN_ARITH:
+		a = var_value(ctx, info->src);
+		b = info->src2 ? var_value(ctx, info->src2) : constant(0);
+
+		if (a.state == SCCP_BOTTOM || b.state == SCCP_BOTTOM)
+			return (struct sccp_value) { .state = SCCP_BOTTOM };
+
+		if (a.state == SCCP_TOP || b.state == SCCP_TOP)
+			return (struct sccp_value) { .state = SCCP_TOP };
+
+		return constant(eval_op(info->op, a.value, b.value));
+	default:
+		return (struct sccp_value) { .state = SCCP_BOTTOM };
+	}
+}
+
+static bool cond_holds(enum ssa_cond cond, int32_t a, int32_t b)
+{
+	switch (cond) {
+	case SSA_COND_EQ:
+		return a == b;
+	case SSA_COND_NE:
+		return a != b;
+	case SSA_COND_LT:
+		return a < b;
+	case SSA_COND_GE:
+		return a >= b;
+	case SSA_COND_GT:
+		return a > b;
+	case SSA_COND_LE:
+		return a <= b;
+	}
+
+	return false;
+}
+
+/*
+ * Returns true if @bb ends in a compare and conditional branch pair that
+ * is the only branch in the block. The branch and compare are stored in
+ * @branch and @cmp.
+ */
+static bool foldable_branch(struct sccp_context *ctx, struct basic_block *bb,
+			    struct ssa_insn_info *branch, struct ssa_insn_info *cmp)
+{
+	struct insn *last, *insn;
+
+	if (bb->nr_successors != 2)
+		return false;
+
+	last = bb_last_insn(bb);
+	if (!last)
+		return false;
+
+	ssa_classify_insn(ctx->cu, bb, last, branch);
+	if (branch->kind != SSA_INSN_BRANCH)
+		return false;
+
+	if (last->insn_list_node.prev == &bb->insn_list)
+		return false;
+
+	insn = prev_insn(last);
+	ssa_classify_insn(ctx->cu, bb, insn, cmp);
+	if (cmp->kind != SSA_INSN_CMP || cmp->slot)
+		return false;
+
+	for_each_insn(insn, &bb->insn_list) {
+		if (insn != last && insn_is_branch(insn))
+			return false;
+	}
+
+	return true;
+}
+
+static enum sccp_outcome branch_outcome(struct sccp_context *ctx,
+					struct basic_block *bb)
+{
+	struct ssa_insn_info branch, cmp;
+	struct sccp_value a, b;
+
+	if (!foldable_branch(ctx, bb, &branch, &cmp))
+		return SCCP_ALL;
+
+	a = var_value(ctx, cmp.var);
+	b = cmp.src ? var_value(ctx, cmp.src) : constant(cmp.imm);
+
+	if (a.state == SCCP_BOTTOM || b.state == SCCP_BOTTOM)
+		return SCCP_ALL;
+
+	if (a.state == SCCP_TOP || b.state == SCCP_TOP)
+		return SCCP_NONE;
+
+	return cond_holds(branch.cond, a.value, b.value) ? SCCP_TAKEN : SCCP_NOT_TAKEN;
+}
+
+static bool edge_is_executable(struct sccp_context *ctx, struct basic_block *from,
+			       struct basic_block *to)
+{
+	enum sccp_outcome outcome;
+	struct basic_block *target;
+	struct insn *last;
+
+	if (!test_bit(ctx->executable->bits, from->dfn))
+		return false;
+
+	outcome = branch_outcome(ctx, from);
+	if (outcome == SCCP_NONE)
+		return false;
+
+	if (outcome == SCCP_ALL)
+		return true;
+
+	last = bb_last_insn(from);
+	target = last->operand.branch_target;
+
+	if (outcome == SCCP_TAKEN)
+		return to == target;
+
+	return to != target || from->successors[0] == from->successors[1];
+}
+
+static void mark_executable(struct sccp_context *ctx, struct basic_block *bb)
+{
+	if (test_bit(ctx->executable->bits, bb->dfn))
+		return;
+
+	set_bit(ctx->executable->bits, bb->dfn);
+	ctx->changed = true;
+}
+
+static void visit_phi(struct sccp_context *ctx, struct basic_block *bb,
+		      struct insn *phi)
+{
+	struct sccp_value value = { .state = SCCP_TOP };
+	struct var_info *var;
+	unsigned long arg = 0;
+
+	var = phi->ssa_dest.reg.interval->var_info;
+
+	if (bb->is_eh) {
+		lower(ctx, var, (struct sccp_value) { .state = SCCP_BOTTOM });
+		return;
+	}
+
+	for (unsigned long i = 0; i < bb->nr_predecessors; i++) {
+		struct basic_block *pred = bb->predecessors[i];
+		struct var_info *src;
+
+		if (bb_is_unreachable(ctx->cu, pred))
+			continue;
+
+		src = phi->ssa_srcs[arg++].reg.interval->var_info;
+
+		if (edge_is_executable(ctx, pred, bb))
+			value = meet(value, var_value(ctx, src));
+	}
+
+	lower(ctx, var, value);
+}
+
+static void visit_block(struct sccp_context *ctx, struct basic_block *bb)
+{
+	struct insn *insn;
+
+	for_each_insn(insn, &bb->insn_list) {
+		struct use_position *defs[MAX_REG_OPERANDS + 1];
+		struct ssa_insn_info info;
+		struct sccp_value value;
+		int nr_defs;
+
+		if (insn_is_phi(insn)) {
+			visit_phi(ctx, bb, insn);
+			continue;
+		}
+
+		nr_defs = insn_defs_reg(insn, defs);
+		if (!nr_defs)
+			continue;
+
+		ssa_classify_insn(ctx->cu, bb, insn, &info);
+		value = eval_insn(ctx, &info);
+
+		for (int i = 0; i < nr_defs; i++) {
+			struct var_info *var = defs[i]->interval->var_info;
+
+			lower(ctx, var, var == info.var ? value :
+			      (struct sccp_value) { .state = SCCP_BOTTOM });
+		}
+	}
+
+	for (unsigned long i = 0; i < bb->nr_successors; i++) {
+		struct basic_block *succ = bb->successors[i];
+
+		if (edge_is_executable(ctx, bb, succ))
+			mark_executable(ctx, succ);
+	}
+}
+
+/*
+ * Variables that are not defined by any instruction, such as the ones
+ * that are live on entry to exception handlers, are never constant.
+ */
+static void init_values(struct sccp_context *ctx)
+{
+	struct compilation_unit *cu = ctx->cu;
+	struct basic_block *bb;
+	struct insn *insn;
+
+	for (unsigned long i = 0; i < ctx->nr_values; i++)
+		ctx->values[i].state = SCCP_BOTTOM;
+
+	for_each_basic_block(bb, &cu->bb_list) {
+		if (bb_is_unreachable(cu, bb))
+			continue;
+
+		if (bb == cu->entry_bb || bb->is_eh)
+			set_bit(ctx->executable->bits, bb->dfn);
+
+		for_each_insn(insn, &bb->insn_list) {
+			struct use_position *defs[MAX_REG_OPERANDS + 1];
+			int nr_defs;
+
+			nr_defs = insn_defs_reg(insn, defs);
+			for (int i = 0; i < nr_defs; i++) {
+				struct var_info *var = defs[i]->interval->var_info;
+
+				if (var_is_tracked(ctx, var))
+					ctx->values[var->vreg].state = SCCP_TOP;
+			}
+		}
+	}
+}
+
+static void replace_def(struct sccp_context *ctx, struct basic_block *bb,
+			struct insn *insn, struct var_info *var, int32_t value)
+{
+	struct insn *new, *pos;
+
+	new = ssa_const_insn(var, value);
+	if (!new)
+		return;
+
+	if (!insn_is_phi(insn)) {
+		insn_set_bc_offset(new, insn->bc_offset);
+		list_add_tail(&new->insn_list_node, &insn->insn_list_node);
+		ssa_remove_insn(ctx->cu, insn);
+		return;
+	}
+
+	for_each_insn(pos, &bb->insn_list) {
+		if (!insn_is_phi(pos))
+			break;
+	}
+
+	if (&pos->insn_list_node != &bb->insn_list)
+		insn_set_bc_offset(new, pos->bc_offset);
+	else
+		insn_set_bc_offset(new, bb->start);
+
+	list_add_tail(&new->insn_list_node, &pos->insn_list_node);
+	ssa_remove_insn(ctx->cu, insn);
+}
+
+static void fold_branch(struct sccp_context *ctx, struct basic_block *bb)
+{
+	struct basic_block *target, *fallthrough;
+	enum sccp_outcome outcome;
+	struct insn *last, *jump;
+
+	outcome = branch_outcome(ctx, bb);
+	if (outcome != SCCP_TAKEN && outcome != SCCP_NOT_TAKEN)
+		return;
+
+	last = bb_last_insn(bb);
+	target = last->operand.branch_target;
+
+	if (bb->successors[0] == target)
+		fallthrough = bb->successors[1];
+	else
+		fallthrough = bb->successors[0];
+
+	jump = jump_insn(outcome == SCCP_TAKEN ? target : fallthrough);
+	if (!jump)
+		return;
+
+	insn_set_bc_offset(jump, last->bc_offset);
+
+	ssa_remove_insn(ctx->cu, prev_insn(last));
+	list_add_tail(&jump->insn_list_node, &last->insn_list_node);
+	ssa_remove_insn(ctx->cu, last);
+}
+
+static void rewrite(struct sccp_context *ctx)
+{
+	struct compilation_unit *cu = ctx->cu;
+	struct basic_block *bb;
+
+	for_each_basic_block(bb, &cu->bb_list) {
+		struct insn *insn, *tmp;
+
+		if (bb_is_unreachable(cu, bb))
+			continue;
+
+		if (!test_bit(ctx->executable->bits, bb->dfn))
+			continue;
+
+		list_for_each_entry_safe(insn, tmp, &bb->insn_list, insn_list_node) {
+			struct use_position *defs[MAX_REG_OPERANDS + 1];
+			struct ssa_insn_info info;
+			struct sccp_value value;
+			struct var_info *var;
+
+			if (insn_defs_reg(insn, defs) != 1)
+				continue;
+
+			var = defs[0]->interval->var_info;
+
+			value = var_value(ctx, var);
+			if (value.state != SCCP_CONST)
+				continue;
+
+			if (!insn_is_phi(insn)) {
+				ssa_classify_insn(cu, bb, insn, &info);
+				if (info.kind == SSA_INSN_CONST || info.var != var)
+					continue;
+			}
+
+			replace_def(ctx, bb, insn, var, value.value);
+		}
+	}
+
+	/*
+	 * Branches are folded after all the definitions have been rewritten
+	 * because edge_is_executable() looks at the branches.
+	 */
+	for_each_basic_block(bb, &cu->bb_list) {
+		if (bb_is_unreachable(cu, bb))
+			continue;
+
+		if (test_bit(ctx->executable->bits, bb->dfn))
+			fold_branch(ctx, bb);
+	}
+}
+
+int sccp(struct compilation_unit *cu)
+{
+	struct sccp_context ctx;
+	struct basic_block *bb;
+	int err = -ENOMEM;
+
+	ctx = (struct sccp_context) {
+		.cu		= cu,
+		.nr_values	= cu->ssa_nr_vregs,
+	};
+
+	ctx.values = malloc(ctx.nr_values * sizeof *ctx.values);
+	ctx.executable = alloc_bitset(nr_bblocks(cu));
+
+	if (!ctx.values || !ctx.executable)
+		goto out;
+
+	init_values(&ctx);
+
+	do {
+		ctx.changed = false;
+
+		for_each_basic_block(bb, &cu->bb_list) {
+			if (bb_is_unreachable(cu, bb))
+				continue;
+
+			if (test_bit(ctx.executable->bits, bb->dfn))
+				visit_block(&ctx, bb);
+		}
+	} while (ctx.changed);
+
+	rewrite(&ctx);
+	err = 0;
+out:
+	free(ctx.executable);
+	free(ctx.values);
+
+	return err;
+}
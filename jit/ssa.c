@@ -112,6 +112,70 @@ void remove_insn(struct insn *insn)
 	free_insn(insn);
 }
 
+/*
+ * Removes an instruction from a method in SSA form. Unlike remove_insn(),
+ * this also releases the operand that insn_add_ons keeps for instructions
+ * that use and define the same register and handles phi instructions.
+ */
+void ssa_remove_insn(struct compilation_unit *cu, struct insn *insn)
+{
+	list_del(&insn->insn_list_node);
+
+	if (insn_use_def(insn))
+		hash_map_remove(cu->insn_add_ons, insn);
+
+	if (insn_is_phi(insn))
+		free_ssa_insn(insn);
+	else
+		free_insn(insn);
+}
+
+static bool use_is_def(struct use_position *reg)
+{
+	struct use_position *defs[MAX_REG_OPERANDS + 1];
+	int nr_defs;
+
+	nr_defs = insn_defs_reg(reg->insn, defs);
+	for (int i = 0; i < nr_defs; i++) {
+		if (defs[i] == reg)
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Returns the instruction that defines @var or NULL if there is none.
+ */
+struct insn *ssa_def_insn(struct var_info *var)
+{
+	struct use_position *reg;
+
+	list_for_each_entry(reg, &var->interval->use_positions, use_pos_list) {
+		if (use_is_def(reg))
+			return reg->insn;
+	}
+
+	return NULL;
+}
+
+/*
+ * Makes every instruction that uses @from use @to instead. The instruction
+ * that defines @from is left for dce() to remove.
+ */
+void ssa_replace_uses(struct var_info *from, struct var_info *to)
+{
+	struct use_position *this, *next;
+
+	list_for_each_entry_safe(this, next, &from->interval->use_positions, use_pos_list) {
+		if (use_is_def(this))
+			continue;
+
+		list_move(&this->use_pos_list, &to->interval->use_positions);
+		this->interval = to->interval;
+	}
+}
+
 static int ssa_analyze_liveness(struct compilation_unit *cu)
 {
 	int err = 0;
@@ -155,7 +219,7 @@ static struct changed_var_stack *alloc_changed_var_stack(unsigned long vreg)
 	return changed;
 }
 
-static int list_changed_stacks_add(struct changed_var_stack *list_changed_stacks,
+static int list_changed_stacks_add(struct changed_var_stack **list_changed_stacks,
 	unsigned long vreg)
 {
 	struct changed_var_stack *changed;
@@ -164,20 +228,90 @@ static int list_changed_stacks_add(struct changed_var_stack *list_changed_stacks
 	if (!changed)
 		return -ENOMEM;
 
-	insert_list(changed, &list_changed_stacks);
+	insert_list(changed, list_changed_stacks);
 
 	return 0;
 }
 
 /*
- * This function returns true if the basic block is part of
- * the exception handler control flow.
+ * This function returns true if the basic block is not reachable from the
+ * entry block or from an exception handler. Such basic blocks contain no
+ * instructions and have no depth first number.
  */
-static bool bb_is_eh(struct compilation_unit *cu, struct basic_block *bb)
+static bool bb_is_unreachable(struct compilation_unit *cu, struct basic_block *bb)
 {
 	return !bb->dfn && cu->entry_bb != bb;
 }
 
+static void mark_phi_eh_uses(struct compilation_unit *cu, struct bitset *set,
+			     struct basic_block *bb, struct insn *phi)
+{
+	unsigned long arg = 0;
+
+	for (unsigned long i = 0; i < bb->nr_predecessors; i++) {
+		struct basic_block *pred = bb->predecessors[i];
+		struct var_info *var;
+
+		if (bb_is_unreachable(cu, pred))
+			continue;
+
+		var = phi->ssa_srcs[arg++].reg.interval->var_info;
+
+		if (pred->eh_reachable && pred != cu->entry_bb)
+			set_bit(set->bits, var->vreg);
+	}
+}
+
+/*
+ * Returns the set of variables that are used in code that is reachable
+ * from an exception handler, not counting the entry block. The uses of
+ * such a variable must not be replaced with a value that is defined in
+ * the entry block: the value would then be live on entry to the handler
+ * where it is not defined.
+ */
+struct bitset *ssa_eh_uses(struct compilation_unit *cu)
+{
+	struct use_position *regs[MAX_REG_OPERANDS];
+	struct use_position *add_on;
+	struct basic_block *bb;
+	struct bitset *set;
+	struct insn *insn;
+
+	set = alloc_bitset(cu->ssa_nr_vregs);
+	if (!set)
+		return NULL;
+
+	for_each_basic_block(bb, &cu->bb_list) {
+		if (bb_is_unreachable(cu, bb))
+			continue;
+
+		for_each_insn(insn, &bb->insn_list) {
+			unsigned long nr;
+
+			if (insn_is_phi(insn)) {
+				mark_phi_eh_uses(cu, set, bb, insn);
+				continue;
+			}
+
+			if (!bb->eh_reachable || bb == cu->entry_bb)
+				continue;
+
+			nr = insn_uses_reg(insn, regs);
+			for (unsigned long i = 0; i < nr; i++)
+				set_bit(set->bits, regs[i]->interval->var_info->vreg);
+
+			add_on = NULL;
+			if (insn_use_def(insn))
+				hash_map_get(cu->insn_add_ons, insn, (void **) &add_on);
+
+			if (add_on)
+				set_bit(set->bits, add_on->interval->var_info->vreg);
+		}
+	}
+
+	return set;
+}
+
 static void free_ssa_liveness(struct compilation_unit *cu)
 {
 	struct basic_block *bb;
@@ -200,7 +334,7 @@ static void free_positions_as_predecessor(struct compilation_unit *cu)
 	struct basic_block *bb;
 
 	for_each_basic_block(bb, &cu->bb_list) {
-		if (bb_is_eh(cu, bb))
+		if (bb_is_unreachable(cu, bb))
 			continue;
 
 		free(bb->positions_as_predecessor);
@@ -217,7 +351,7 @@ static void free_ssa(struct compilation_unit *cu)
                 free(bb->live_in_set);
                 free(bb->live_out_set);
 
-		if (bb_is_eh(cu, bb))
+		if (bb_is_unreachable(cu, bb))
 			continue;
 
 		free(bb->positions_as_predecessor);
@@ -237,7 +371,7 @@ static void compute_dominators(struct compilation_unit *cu)
 	struct basic_block *bb, *bb_it;
 
 	for_each_basic_block(bb, &cu->bb_list) {
-		if (bb_is_eh(cu, bb))
+		if (bb_is_unreachable(cu, bb))
 			continue;
 
 		bb->dominators = alloc_bitset(cu->nr_bb);
@@ -276,7 +410,7 @@ static int compute_dom_successors(struct compilation_unit *cu)
 	for_each_basic_block(bb, &cu->bb_list) {
 		positions[idx++] = 0;
 
-		if (bb_is_eh(cu, bb)
+		if (bb_is_unreachable(cu, bb)
 				|| bb->nr_dom_successors == 0)
 			continue;
 
@@ -307,7 +441,7 @@ static int compute_positions_as_predecessor(struct compilation_unit *cu)
 	struct basic_block *bb;
 
 	for_each_basic_block(bb, &cu->bb_list) {
-		if (bb_is_eh(cu, bb))
+		if (bb_is_unreachable(cu, bb))
 			continue;
 
 		bb->positions_as_predecessor = malloc(bb->nr_successors * sizeof(unsigned long));
@@ -321,7 +455,7 @@ static int compute_positions_as_predecessor(struct compilation_unit *cu)
 			position = 0;
 			for (unsigned long j = 0; j < succ->nr_predecessors; j++) {
 				struct basic_block *pred = succ->predecessors[j];
-				if (bb_is_eh(cu, pred))
+				if (bb_is_unreachable(cu, pred))
 					continue;
 
 				if (pred == bb) {
@@ -337,19 +471,19 @@ static int compute_positions_as_predecessor(struct compilation_unit *cu)
 	return 0;
 }
 
-static void compute_nr_predecessors_no_eh(struct compilation_unit *cu)
+static void compute_nr_reachable_predecessors(struct compilation_unit *cu)
 {
 	struct basic_block *bb;
 	unsigned long i;
 
 	for_each_basic_block(bb, &cu->bb_list) {
-		if (bb_is_eh(cu, bb))
+		if (bb_is_unreachable(cu, bb))
 			continue;
 
 		for (i = 0; i < bb->nr_predecessors; i++) {
-			if (bb_is_eh(cu, bb->predecessors[i]))
+			if (bb_is_unreachable(cu, bb->predecessors[i]))
 				continue;
-			else bb->nr_predecessors_no_eh++;
+			else bb->nr_reachable_predecessors++;
 		}
 	}
 }
@@ -396,7 +530,7 @@ static int determine_loop(struct basic_block *header,
 
 			pred = work_bb->predecessors[j];
 
-			if (bb_is_eh(cu, pred))
+			if (bb_is_unreachable(cu, pred))
 				continue;
 
 			nloop = header->natural_loop;
@@ -423,7 +557,7 @@ static int compute_natural_loops(struct compilation_unit *cu)
 	int error;
 
 	for_each_basic_block(bb, &cu->bb_list) {
-		if (bb_is_eh(cu, bb))
+		if (bb_is_unreachable(cu, bb))
 			continue;
 
 		for (unsigned i = 0; i < bb->nr_successors; i++) {
@@ -431,7 +565,7 @@ static int compute_natural_loops(struct compilation_unit *cu)
 
 			header = bb->successors[i];
 
-			if (bb_is_eh(cu, header))
+			if (bb_is_unreachable(cu, header))
 				continue;
 
 			if (test_bit(bb->dominators->bits, header->dfn)) {
@@ -455,13 +589,13 @@ static void insert_phi(struct basic_block *bb, struct var_info *var)
 {
 	struct insn *insn;
 
-	insn = ssa_phi_insn(var, bb->nr_predecessors_no_eh);
+	insn = ssa_phi_insn(var, bb->nr_reachable_predecessors);
 	bb_add_first_insn(bb, insn);
 }
 
 static int do_insn_is_copy(struct use_position *reg,
 		struct use_position **regs_uses,
-		struct changed_var_stack *list_changed_stacks,
+		struct changed_var_stack **list_changed_stacks,
 		struct stack **name_stack)
 {
 	struct var_info *var;
@@ -475,7 +609,7 @@ static int do_insn_is_copy(struct use_position *reg,
 
 static int add_var_info(struct compilation_unit *cu,
 	struct use_position *reg,
-	struct changed_var_stack *list_changed_stacks,
+	struct changed_var_stack **list_changed_stacks,
 	struct stack **name_stack)
 {
 	struct live_interval *it;
@@ -515,7 +649,8 @@ static void replace_parameter_var_info(struct use_position *reg,
 	change_operand_var(reg, new_var);
 }
 
-static void eh_replace_var_info(struct compilation_unit *cu,
+static int replace_var_info(struct compilation_unit *cu,
+			struct basic_block *bb,
 			struct use_position *reg,
 			struct stack **name_stack,
 			struct insn *insn)
@@ -526,37 +661,24 @@ static void eh_replace_var_info(struct compilation_unit *cu,
 	it = reg->interval;
 	var = it->var_info;
 
-	if (stack_is_empty(name_stack[var->vreg])){
+	if (stack_is_empty(name_stack[var->vreg])) {
+		/*
+		 * Code that is reachable from an exception handler can see
+		 * a variable that is only defined along the normal control
+		 * flow. Its value is undefined there anyway.
+		 */
+		if (!bb->eh_reachable)
+			return warn("Variable %d not initialized for ssa renaming", var->vreg), -EINVAL;
+
 		if (interval_has_fixed_reg(it))
 			new_var = ssa_get_fixed_var(cu, var->interval->reg);
 		else
 			new_var = ssa_get_var(cu, var->vm_type);
 
 		stack_push(name_stack[var->vreg], new_var);
-	}
-	else
+	} else
 		new_var = stack_peek(name_stack[var->vreg]);
 
-	change_operand_var(reg, new_var);
-}
-
-static int replace_var_info(struct compilation_unit *cu,
-			struct use_position *reg,
-			struct changed_var_stack *list_changed_stacks,
-			struct stack **name_stack,
-			struct insn *insn)
-{
-	struct live_interval *it;
-	struct var_info *var, *new_var;
-
-	it = reg->interval;
-	var = it->var_info;
-
-	if (stack_is_empty(name_stack[var->vreg]))
-		return warn("Variable %d not initialized for ssa renaming", var->vreg), -EINVAL;
-
-	new_var = stack_peek(name_stack[var->vreg]);
-
 	/*
 	 * If the instruction uses and defines the same register, then we
 	 * keep track of the used register in insn_add_ons.
@@ -576,7 +698,7 @@ static int replace_var_info(struct compilation_unit *cu,
 
 static int insert_stack_fixed_var(struct compilation_unit *cu,
 				struct stack **name_stack,
-				struct changed_var_stack *list_changed_stacks)
+				struct changed_var_stack **list_changed_stacks)
 {
 	struct var_info *var, *new_var;
 	int err;
@@ -611,7 +733,7 @@ static int __rename_variables(struct compilation_unit *cu,
 	list_changed_stacks = NULL;
 
 	if (bb == cu->entry_bb) {
-		err = insert_stack_fixed_var(cu, name_stack, list_changed_stacks);
+		err = insert_stack_fixed_var(cu, name_stack, &list_changed_stacks);
 		if (err)
 			return err;
 	}
@@ -622,7 +744,7 @@ static int __rename_variables(struct compilation_unit *cu,
 			for (i = 0; i < nr_uses; i++) {
 				reg = regs_uses[i];
 
-				err = replace_var_info(cu, reg, list_changed_stacks, name_stack, insn);
+				err = replace_var_info(cu, bb, reg, name_stack, insn);
 				if (err)
 					return err;
 			}
@@ -643,11 +765,11 @@ static int __rename_variables(struct compilation_unit *cu,
 						&& !interval_has_fixed_reg((*regs_uses)->interval)) {
 				delete = true;
 
-				err = do_insn_is_copy(reg, regs_uses, list_changed_stacks, name_stack);
+				err = do_insn_is_copy(reg, regs_uses, &list_changed_stacks, name_stack);
 				if (err)
 					return err;
 			} else {
-				err = add_var_info(cu, reg, list_changed_stacks, name_stack);
+				err = add_var_info(cu, reg, &list_changed_stacks, name_stack);
 				if (err)
 					return err;
 			}
@@ -679,7 +801,9 @@ static int __rename_variables(struct compilation_unit *cu,
 	for (unsigned long i = 0; i < bb->nr_dom_successors; i++) {
 		struct basic_block *dom_succ = bb->dom_successors[i];
 
-		__rename_variables(cu, dom_succ, name_stack);
+		err = __rename_variables(cu, dom_succ, name_stack);
+		if (err)
+			return err;
 	}
 
 	/*
@@ -705,46 +829,6 @@ static int __rename_variables(struct compilation_unit *cu,
 	return 0;
 }
 
-static void eh_rename_variables(struct compilation_unit *cu,
-				struct basic_block *bb,
-				struct stack **name_stack)
-{
-	struct insn *insn;
-	struct use_position *reg;
-	struct use_position *regs_uses[MAX_REG_OPERANDS],
-			*regs_defs[MAX_REG_OPERANDS + 1];
-	int nr_defs, nr_uses, i;
-
-	for_each_insn(insn, &bb->insn_list) {
-		nr_uses = insn_uses_reg(insn, regs_uses);
-		for (i = 0; i < nr_uses; i++) {
-			reg = regs_uses[i];
-
-			if (insn_use_def_src(insn) && &insn->src.reg == reg)
-				continue;
-
-			if (insn_use_def_dst(insn) && &insn->dest.reg == reg)
-				continue;
-
-			eh_replace_var_info(cu, reg, name_stack, insn);
-		}
-
-		nr_defs = insn_defs_reg(insn, regs_defs);
-		for (i = 0; i < nr_defs; i++) {
-			reg = regs_defs[i];
-
-			eh_replace_var_info(cu, reg, name_stack, insn);
-		}
-	}
-
-	bb->is_renamed = true;
-
-	for (unsigned int i = 0; i < bb->nr_successors; i++)
-		if (bb_is_eh(cu, bb->successors[i]) && !bb->successors[i]->is_renamed) {
-			eh_rename_variables(cu, bb->successors[i], name_stack);
-		}
-}
-
 /*
  * See section 4.2 "Renaming of variables" of
  * "Optimizations in Static Single Assignment Form, Sassa Laboratory"
@@ -753,33 +837,22 @@ static void eh_rename_variables(struct compilation_unit *cu,
 static int rename_variables(struct compilation_unit *cu)
 {
 	struct stack *name_stack[cu->nr_vregs];
-	struct basic_block *bb;
 	int err;
 
 	for (unsigned long i = 0; i < cu->nr_vregs; i++)
 		name_stack[i] = alloc_stack();
 
-	err = __rename_variables(cu, cu->entry_bb, name_stack);
-	if (err)
-		return err;
-
 	/*
-	 * Virtual registers need to be renamed even in exception
-	 * handler basic blocks because, otherwise, there would
-	 * be different virtual registers with the same vreg value
-	 * and the register allocator would issue incorrect results.
-	 * Exception handler basic blocks are still in non-SSA
-	 * form because we just rename the variables.
+	 * Exception handlers are children of the entry block in the
+	 * dominator tree so they are renamed along with the rest of the
+	 * method.
 	 */
-	for_each_basic_block(bb, &cu->bb_list) {
-		if (bb->is_eh && !bb->is_renamed)
-			eh_rename_variables(cu, bb, name_stack);
-	}
+	err = __rename_variables(cu, cu->entry_bb, name_stack);
 
 	for (unsigned long i = 0; i < cu->nr_vregs; i++)
 		free_stack(name_stack[i]);
 
-	return 0;
+	return err;
 }
 
 static void iterate_dom_frontier_set(struct compilation_unit *cu,
@@ -843,7 +916,7 @@ static int insert_phi_insns(struct compilation_unit *cu)
 
 	for_each_basic_block(bb, &cu->bb_list) {
 		/* skip exception handler basic blocks */
-		if (bb_is_eh(cu, bb))
+		if (bb_is_unreachable(cu, bb))
 			continue;
 
 		work[bb->dfn] = SSA_INIT_BLOCK;
@@ -855,7 +928,7 @@ static int insert_phi_insns(struct compilation_unit *cu)
 	for_each_variable(var, cu->var_infos) {
 		ndx = -1;
 		for_each_basic_block(bb, &cu->bb_list) {
-			if (bb_is_eh(cu, bb))
+			if (bb_is_unreachable(cu, bb))
 				continue;
 
 			if (test_bit(bb->def_set->bits, var->vreg)) {
@@ -938,7 +1011,7 @@ static void insert_instruction_pass(struct compilation_unit *cu)
 	struct basic_block *bb;
 
 	for_each_basic_block(bb, &cu->bb_list) {
-		if (bb_is_eh(cu, bb))
+		if (bb_is_unreachable(cu, bb))
 			continue;
 
 		__insert_instruction_pass(cu, bb);
@@ -1081,7 +1154,7 @@ static int __ssa_deconstruction(struct compilation_unit *cu,
 		struct basic_block *pred_bb;
 
 		pred_bb = bb->predecessors[i];
-		if (bb_is_eh(cu, pred_bb))
+		if (bb_is_unreachable(cu, pred_bb))
 			continue;
 
 		last_insn = bb_last_insn(pred_bb);
@@ -1144,7 +1217,7 @@ static int init_ssa(struct compilation_unit *cu)
 {
 	int err;
 
-	compute_nr_predecessors_no_eh(cu);
+	compute_nr_reachable_predecessors(cu);
 
 	err = compute_positions_as_predecessor(cu);
 	if (err)
@@ -86,7 +86,6 @@ void free_statement(struct statement *stmt)
 
 struct tableswitch *alloc_tableswitch(struct tableswitch_info *info,
 				      struct compilation_unit *cu,
-				      struct basic_block *bb,
 				      unsigned long offset)
 {
 	struct tableswitch *table;
@@ -95,7 +94,7 @@ struct tableswitch *alloc_tableswitch(struct tableswitch_info *info,
 	if (!table)
 		return NULL;
 
-	table->src = bb;
+	table->src = NULL;
 
 	table->low = info->low;
 	table->high = info->high;
@@ -118,6 +117,53 @@ struct tableswitch *alloc_tableswitch(struct tableswitch_info *info,
 	return table;
 }
 
+/*
+ * Builds a tableswitch jump table for a lookupswitch. The keys of a
+ * lookupswitch are sorted so the table spans from the first to the last
+ * key and the values in between that have no match jump to @default_bb.
+ */
+struct tableswitch *alloc_dense_lookupswitch(struct lookupswitch_info *info,
+					     struct compilation_unit *cu,
+					     struct basic_block *default_bb,
+					     unsigned long offset)
+{
+	struct tableswitch *table;
+	uint32_t count;
+
+	table = malloc(sizeof(*table));
+	if (!table)
+		return NULL;
+
+	table->src = NULL;
+
+	table->low = read_lookupswitch_match(info, 0);
+	table->high = read_lookupswitch_match(info, info->count - 1);
+
+	count = table->high - table->low + 1;
+
+	table->bb_lookup_table = malloc(sizeof(void *) * count);
+	if (!table->bb_lookup_table) {
+		free(table);
+		return NULL;
+	}
+
+	for (unsigned int i = 0; i < count; i++)
+		table->bb_lookup_table[i] = default_bb;
+
+	for (unsigned int i = 0; i < info->count; i++) {
+		uint32_t match;
+		int32_t target;
+
+		match = read_lookupswitch_match(info, i);
+		target = read_lookupswitch_target(info, i);
+		table->bb_lookup_table[match - table->low] = find_bb(cu, offset + target);
+	}
+
+	list_add(&table->list_node, &cu->tableswitch_list);
+
+	return table;
+}
+
 void free_tableswitch(struct tableswitch *table)
 {
 	free(table->lookup_table);
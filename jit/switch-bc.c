@@ -37,6 +37,25 @@
 #include "lib/stack.h"
 
 #include <errno.h>
+#include <stdlib.h>
+
+/*
+ * A lookupswitch whose keys are dense enough is lowered like a tableswitch
+ * with the holes between the keys jumping to the default target. The jump
+ * table costs a pointer for every value in the key range so both the range
+ * and the number of slots per key are bounded.
+ */
+#define LOOKUPSWITCH_TABLE_MIN_KEYS	4
+#define LOOKUPSWITCH_TABLE_MAX_RANGE	4096
+#define LOOKUPSWITCH_TABLE_MAX_SLOTS	3	/* per key */
+
+/*
+ * Other lookupswitches are lowered to a balanced tree of compares that ends
+ * in short sequences of equality tests. Very large sparse key sets call the
+ * out of line binary search instead to keep the code size in check.
+ */
+#define LOOKUPSWITCH_LINEAR_KEYS	3
+#define LOOKUPSWITCH_TREE_MAX_KEYS	256
 
 static struct statement *branch_if_lesser_stmt(struct basic_block *target,
 					       struct expression *left,
@@ -64,6 +83,19 @@ static struct statement *branch_if_greater_stmt(struct basic_block *target,
 	return if_stmt(target, J_INT, OP_GT, left, right_expr);
 }
 
+static struct statement *branch_if_equal_stmt(struct basic_block *target,
+					      struct expression *left,
+					      int32_t right)
+{
+	struct expression *right_expr;
+
+	right_expr = value_expr(J_INT, right);
+	if (!right_expr)
+		return NULL;
+
+	return if_stmt(target, J_INT, OP_EQ, left, right_expr);
+}
+
 static struct statement *branch_if_null_stmt(struct basic_block *target,
 					     struct expression *left)
 {
@@ -76,21 +108,30 @@ static struct statement *branch_if_null_stmt(struct basic_block *target,
 	return if_stmt(target, J_NATIVE_PTR, OP_EQ, left, right_expr);
 }
 
-int convert_tableswitch(struct parse_context *ctx)
+static int add_successor(struct basic_block *bb, struct basic_block *successor)
 {
-	struct tableswitch_info info;
-	struct tableswitch *table;
+	if (bb_successors_contains(bb, successor))
+		return 0;
+
+	return bb_add_successor(bb, successor);
+}
+
+/*
+ * Converts a switch whose index is bounds checked against the jump table
+ * of @table. The index is popped from the mimic stack.
+ */
+static int convert_jump_table(struct parse_context *ctx,
+			      struct tableswitch *table,
+			      struct basic_block *default_bb)
+{
+	struct statement *if_lesser_stmt;
+	struct statement *if_greater_stmt;
 	struct basic_block *master_bb;
-	struct basic_block *default_bb;
+	struct expression *pure_index;
+	struct statement *stmt;
 	struct basic_block *b1;
 	struct basic_block *b2;
-
-	get_tableswitch_info(ctx->code, ctx->offset, &info);
-	ctx->buffer->pos += info.insn_size;
-
-	default_bb = find_bb(ctx->cu, ctx->offset + info.default_target);
-	if (!default_bb)
-		goto fail_default_bb;
+	uint32_t count;
 
 	master_bb = ctx->bb;
 
@@ -109,36 +150,25 @@ int convert_tableswitch(struct parse_context *ctx)
 	bb_add_successor(b1, default_bb );
 	bb_add_successor(b1, b2);
 
-	for (unsigned int i = 0; i < info.count; i++) {
-		struct basic_block *target_bb;
-		int32_t target;
+	count = table->high - table->low + 1;
 
-		target = read_s32(info.targets + i * 4);
-		target_bb = find_bb(ctx->cu, ctx->offset + target);
-
-		if (!bb_successors_contains(b2, target_bb))
-			bb_add_successor(b2, target_bb);
+	for (unsigned int i = 0; i < count; i++) {
+		if (add_successor(b2, table->bb_lookup_table[i]))
+			return -ENOMEM;
 	}
 
-	table = alloc_tableswitch(&info, ctx->cu, b2, ctx->offset);
-	if (!table)
-		return -ENOMEM;
-
-	struct statement *if_lesser_stmt;
-	struct statement *if_greater_stmt;
-	struct statement *stmt;
-	struct expression *pure_index;
+	table->src = b2;
 
 	pure_index = get_pure_expr(ctx, stack_pop(ctx->bb->mimic_stack));
 
 	if_lesser_stmt =
-		branch_if_lesser_stmt(default_bb, pure_index, info.low);
+		branch_if_lesser_stmt(default_bb, pure_index, table->low);
 	if (!if_lesser_stmt)
 		goto fail_lesser_stmt;
 
 	expr_get(pure_index);
 	if_greater_stmt =
-		branch_if_greater_stmt(default_bb, pure_index, info.high);
+		branch_if_greater_stmt(default_bb, pure_index, table->high);
 	if (!if_greater_stmt)
 		goto fail_greater_stmt;
 
@@ -160,25 +190,177 @@ int convert_tableswitch(struct parse_context *ctx)
  fail_greater_stmt:
 	free_statement(if_lesser_stmt);
  fail_lesser_stmt:
-	free_tableswitch(table);
- fail_default_bb:
-	return -1;
+	return -ENOMEM;
 }
 
-int convert_lookupswitch(struct parse_context *ctx)
+int convert_tableswitch(struct parse_context *ctx)
 {
-	struct lookupswitch_info info;
-	struct lookupswitch *table;
-	struct basic_block *master_bb;
+	struct tableswitch_info info;
+	struct tableswitch *table;
 	struct basic_block *default_bb;
-	struct basic_block *b1;
 
-	get_lookupswitch_info(ctx->code, ctx->offset, &info);
+	get_tableswitch_info(ctx->code, ctx->offset, &info);
 	ctx->buffer->pos += info.insn_size;
 
 	default_bb = find_bb(ctx->cu, ctx->offset + info.default_target);
 	if (!default_bb)
-		goto fail_default_bb;
+		return -1;
+
+	table = alloc_tableswitch(&info, ctx->cu, ctx->offset);
+	if (!table)
+		return -ENOMEM;
+
+	return convert_jump_table(ctx, table, default_bb);
+}
+
+/*
+ * Compare trees are laid out in preorder with the right subtree first so
+ * that every conditional branch falls through to the next basic block.
+ */
+struct compare_tree {
+	struct parse_context		*ctx;
+	struct lookupswitch_info	*info;
+	struct basic_block		*default_bb;
+	struct expression		*key;
+
+	struct basic_block		**bbs;
+	unsigned int			next;
+};
+
+static unsigned int compare_tree_size(unsigned int nr_keys)
+{
+	unsigned int half = nr_keys / 2;
+
+	if (nr_keys <= LOOKUPSWITCH_LINEAR_KEYS)
+		return nr_keys + 1;
+
+	return 1 + compare_tree_size(nr_keys - half) + compare_tree_size(half);
+}
+
+static int compare_tree_branch(struct compare_tree *tree, struct basic_block *bb,
+			       struct statement *stmt, struct basic_block *next)
+{
+	if (!stmt)
+		return -ENOMEM;
+
+	expr_get(tree->key);
+	do_convert_statement(bb, stmt, tree->ctx->offset);
+
+	bb->has_branch = true;
+
+	if (add_successor(bb, stmt->if_true))
+		return -ENOMEM;
+
+	return add_successor(bb, next);
+}
+
+static int convert_compare_tree(struct compare_tree *tree, unsigned int lo, unsigned int hi)
+{
+	struct basic_block *left, *right;
+	struct statement *stmt;
+	struct basic_block *bb;
+	unsigned int mid;
+	int err;
+
+	bb = tree->bbs[tree->next++];
+
+	if (hi - lo > LOOKUPSWITCH_LINEAR_KEYS) {
+		mid = lo + (hi - lo) / 2;
+
+		right = tree->bbs[tree->next];
+		err = convert_compare_tree(tree, mid, hi);
+		if (err)
+			return err;
+
+		left = tree->bbs[tree->next];
+		err = convert_compare_tree(tree, lo, mid);
+		if (err)
+			return err;
+
+		stmt = branch_if_lesser_stmt(left, tree->key,
+			read_lookupswitch_match(tree->info, mid));
+
+		return compare_tree_branch(tree, bb, stmt, right);
+	}
+
+	for (unsigned int i = lo; i < hi; i++) {
+		struct basic_block *target_bb;
+		int32_t target;
+
+		target = read_lookupswitch_target(tree->info, i);
+		target_bb = find_bb(tree->ctx->cu, tree->ctx->offset + target);
+
+		stmt = branch_if_equal_stmt(target_bb, tree->key,
+			read_lookupswitch_match(tree->info, i));
+
+		err = compare_tree_branch(tree, bb, stmt, tree->bbs[tree->next]);
+		if (err)
+			return err;
+
+		bb = tree->bbs[tree->next++];
+	}
+
+	stmt = alloc_statement(STMT_GOTO);
+	if (!stmt)
+		return -ENOMEM;
+
+	stmt->goto_target = tree->default_bb;
+	do_convert_statement(bb, stmt, tree->ctx->offset);
+
+	bb->has_branch = true;
+
+	return add_successor(bb, tree->default_bb);
+}
+
+static int convert_lookupswitch_tree(struct parse_context *ctx,
+				     struct lookupswitch_info *info,
+				     struct basic_block *default_bb)
+{
+	struct compare_tree tree;
+	unsigned int nr_bbs;
+	int err;
+
+	nr_bbs = compare_tree_size(info->count);
+
+	tree.bbs = malloc(sizeof(struct basic_block *) * nr_bbs);
+	if (!tree.bbs)
+		return -ENOMEM;
+
+	/*
+	 * Splitting a basic block moves its successors to the new block so
+	 * allocate all blocks before connecting any of them.
+	 */
+	tree.bbs[0] = ctx->bb;
+
+	for (unsigned int i = 1; i < nr_bbs; i++) {
+		tree.bbs[i] = bb_split(tree.bbs[i - 1], ctx->bb->end);
+		if (!tree.bbs[i]) {
+			err = -ENOMEM;
+			goto out;
+		}
+	}
+
+	tree.ctx = ctx;
+	tree.info = info;
+	tree.default_bb = default_bb;
+	tree.key = get_pure_expr(ctx, stack_pop(ctx->bb->mimic_stack));
+	tree.next = 0;
+
+	err = convert_compare_tree(&tree, 0, info->count);
+
+	expr_put(tree.key);
+ out:
+	free(tree.bbs);
+	return err;
+}
+
+static int convert_lookupswitch_bsearch(struct parse_context *ctx,
+					struct lookupswitch_info *info,
+					struct basic_block *default_bb)
+{
+	struct lookupswitch *table;
+	struct basic_block *master_bb;
+	struct basic_block *b1;
 
 	master_bb = ctx->bb;
 
@@ -191,18 +373,18 @@ int convert_lookupswitch(struct parse_context *ctx)
 	bb_add_successor(master_bb, default_bb );
 	bb_add_successor(master_bb, b1);
 
-	for (unsigned int i = 0; i < info.count; i++) {
+	for (unsigned int i = 0; i < info->count; i++) {
 		struct basic_block *target_bb;
 		int32_t target;
 
-		target = read_lookupswitch_target(&info, i);
+		target = read_lookupswitch_target(info, i);
 		target_bb = find_bb(ctx->cu, ctx->offset + target);
 
 		if (!bb_successors_contains(b1, target_bb))
 			bb_add_successor(b1, target_bb);
 	}
 
-	table = alloc_lookupswitch(&info, ctx->cu, b1, ctx->offset);
+	table = alloc_lookupswitch(info, ctx->cu, b1, ctx->offset);
 	if (!table)
 		return -ENOMEM;
 
@@ -223,7 +405,7 @@ int convert_lookupswitch(struct parse_context *ctx)
 	if_null_stmt =
 		branch_if_null_stmt(default_bb, pure_bsearch);
 	if (!if_null_stmt)
-		goto fail_null_stmt;
+		return -ENOMEM;
 
 	stmt = alloc_statement(STMT_LOOKUPSWITCH_JUMP);
 	if (!stmt)
@@ -238,8 +420,51 @@ int convert_lookupswitch(struct parse_context *ctx)
 
  fail_stmt:
 	free_statement(if_null_stmt);
- fail_null_stmt:
-	free_lookupswitch(table);
- fail_default_bb:
-	return -1;
+	return -ENOMEM;
+}
+
+/*
+ * Chooses how to lower a lookupswitch from the number of keys and their
+ * range: a jump table costs two compares and an indirect jump, a compare
+ * tree about log2(count) + LOOKUPSWITCH_LINEAR_KEYS compares.
+ */
+static bool lookupswitch_is_dense(struct lookupswitch_info *info)
+{
+	int64_t range;
+
+	if (info->count < LOOKUPSWITCH_TABLE_MIN_KEYS)
+		return false;
+
+	range = (int64_t) read_lookupswitch_match(info, info->count - 1)
+		- read_lookupswitch_match(info, 0) + 1;
+
+	return range <= LOOKUPSWITCH_TABLE_MAX_RANGE
+		&& range <= (int64_t) info->count * LOOKUPSWITCH_TABLE_MAX_SLOTS;
+}
+
+int convert_lookupswitch(struct parse_context *ctx)
+{
+	struct lookupswitch_info info;
+	struct basic_block *default_bb;
+	struct tableswitch *table;
+
+	get_lookupswitch_info(ctx->code, ctx->offset, &info);
+	ctx->buffer->pos += info.insn_size;
+
+	default_bb = find_bb(ctx->cu, ctx->offset + info.default_target);
+	if (!default_bb)
+		return -1;
+
+	if (lookupswitch_is_dense(&info)) {
+		table = alloc_dense_lookupswitch(&info, ctx->cu, default_bb, ctx->offset);
+		if (!table)
+			return -ENOMEM;
+
+		return convert_jump_table(ctx, table, default_bb);
+	}
+
+	if (info.count <= LOOKUPSWITCH_TREE_MAX_KEYS)
+		return convert_lookupswitch_tree(ctx, &info, default_bb);
+
+	return convert_lookupswitch_bsearch(ctx, &info, default_bb);
 }
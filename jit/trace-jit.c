@@ -54,6 +54,7 @@ bool opt_trace_lir;
 bool opt_trace_liveness;
 bool opt_trace_regalloc;
 bool opt_trace_machine_code;
+bool opt_trace_peephole;
 bool opt_trace_magic_trampoline;
 bool opt_trace_bytecode_offset;
 bool opt_trace_invoke;
@@ -497,6 +498,14 @@ void trace_machine_code(struct compilation_unit *cu)
 	trace_printf("\n");
 }
 
+void trace_code_size(struct compilation_unit *cu)
+{
+	if (!cu_matches_regex(cu))
+		return;
+
+	trace_printf("  Machine code size: %lu bytes\n\n", cu_native_size(cu));
+}
+
 void trace_magic_trampoline(struct compilation_unit *cu)
 {
 	if (!cu_matches_regex(cu))
@@ -28,6 +28,7 @@
 
 #include "jit/compiler.h"
 #include "jit/cu-mapping.h"
+#include "jit/cha.h"
 #include "jit/emit-code.h"
 #include "jit/exception.h"
 
@@ -129,9 +130,10 @@ void *jit_magic_trampoline(struct compilation_unit *cu)
 	else
 		ret = jit_java_trampoline(cu);
 
-	if (ret)
+	if (ret) {
 		cu->state = COMPILATION_STATE_COMPILED;
-	else
+		cha_install(cu);
+	} else
 		cu->state = COMPILATION_STATE_INITIAL;
 
 	shrink_compilation_unit(cu);
@@ -143,7 +145,13 @@ out_fixup:
 	if (!ret)
 		return rethrow_exception();
 
-	fixup_direct_calls(method->trampoline, (unsigned long) ret);
+	/*
+	 * The call sites of a replaced compilation unit have been moved to
+	 * the new trampoline already. See cha_install().
+	 */
+	if (cu == method->compilation_unit)
+		fixup_direct_calls(method->trampoline, (unsigned long) ret);
+
 	return ret;
 }
 
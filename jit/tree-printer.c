@@ -586,6 +586,20 @@ static const char *op_names[] = {
 	[OP_GT] = "gt",
 	[OP_LE] = "le",
 	[OP_NEG] = "neg",
+	[OP_MIN] = "min",
+	[OP_MAX] = "max",
+	[OP_ROL] = "rol",
+	[OP_ROR] = "ror",
+	[OP_ABS] = "abs",
+	[OP_FABS] = "fabs",
+	[OP_DABS] = "dabs",
+	[OP_DSQRT] = "dsqrt",
+	[OP_BITCOUNT] = "bitcount",
+	[OP_LEADING_ZEROS] = "leading_zeros",
+	[OP_TRAILING_ZEROS] = "trailing_zeros",
+	[OP_BSWAP] = "bswap",
+	[OP_FLOAT_BITS] = "float_bits",
+	[OP_DOUBLE_BITS] = "double_bits",
 };
 
 static int print_binop_expr(int lvl, struct string *str,
@@ -1044,6 +1058,68 @@ out:
 	return err;
 }
 
+static int print_unsafe_field_expr(int lvl, struct string *str,
+				   struct expression *expr)
+{
+	int err;
+
+	err = append_formatted(lvl, str, "UNSAFE_FIELD:\n");
+	if (err)
+		goto out;
+
+	err = append_simple_attr(lvl + 1, str, "vm_type",
+				 type_names[expr->vm_type]);
+	if (err)
+		goto out;
+
+	err = append_tree_attr(lvl + 1, str, "unsafe_objectref", expr->unsafe_objectref);
+	if (err)
+		goto out;
+
+	err = append_tree_attr(lvl + 1, str, "unsafe_offset", expr->unsafe_offset);
+
+out:
+	return err;
+}
+
+static int print_compare_and_swap_expr(int lvl, struct string *str,
+				       struct expression *expr)
+{
+	int err;
+
+	err = append_formatted(lvl, str, "COMPARE_AND_SWAP:\n");
+	if (err)
+		goto out;
+
+	err = append_tree_attr(lvl + 1, str, "cas_field", expr->cas_field);
+	if (err)
+		goto out;
+
+	err = append_tree_attr(lvl + 1, str, "cas_values", expr->cas_values);
+
+out:
+	return err;
+}
+
+static int print_cas_values_expr(int lvl, struct string *str,
+				 struct expression *expr)
+{
+	int err;
+
+	err = append_formatted(lvl, str, "CAS_VALUES:\n");
+	if (err)
+		goto out;
+
+	err = append_tree_attr(lvl + 1, str, "cas_expect", expr->cas_expect);
+	if (err)
+		goto out;
+
+	err = append_tree_attr(lvl + 1, str, "cas_update", expr->cas_update);
+
+out:
+	return err;
+}
+
 typedef int (*print_expr_fn) (int, struct string * str, struct expression *);
 
 static print_expr_fn expr_printers[] = {
@@ -1083,6 +1159,9 @@ static print_expr_fn expr_printers[] = {
 	[EXPR_ARRAY_SIZE_CHECK] = print_array_size_check_expr,
 	[EXPR_MIMIC_STACK_SLOT] = print_mimic_stack_slot_expr,
 	[EXPR_LOOKUPSWITCH_BSEARCH] = print_lookupswitch_bsearch_expr,
+	[EXPR_UNSAFE_FIELD] = print_unsafe_field_expr,
+	[EXPR_COMPARE_AND_SWAP] = print_compare_and_swap_expr,
+	[EXPR_CAS_VALUES] = print_cas_values_expr,
 };
 
 static int print_expr(int lvl, struct tree_node *root, struct string *str)
@@ -64,9 +64,22 @@ void fixup_vtable(struct compilation_unit *cu, struct vm_object *this,
 	 * We must not fixup vtable entry in the class of this when this method
 	 * was invoked by invokespecial.
 	 */
+	/* The method has been recompiled, see jit/cha.c */
+	if (cu != vmm->compilation_unit)
+		return;
+
         if (vmc->vtable.native_ptr[index] == vm_method_trampoline_ptr(vmm))
 		vmc->vtable.native_ptr[index] = target;
 
+	/* Entries that still point to the code this unit replaces */
+	if (cu->cha_replaced_entry) {
+		void *entry = vmc->vtable.native_ptr[index];
+
+		if (entry == cu->cha_replaced_entry
+		    || entry == cu->cha_replaced_trampoline)
+			vmc->vtable.native_ptr[index] = target;
+	}
+
 	/* Fixup the vtable entry in declaring class */
 	vmm->class->vtable.native_ptr[index] = target;
 }
@@ -1,7 +1,6 @@
 #include "lib/arena.h"
 
 #include <stdlib.h>
-#include <assert.h>
 
 #define ARENA_BLOCK_MIN_LEN		256
 
@@ -63,10 +62,16 @@ void arena_delete(struct arena *self)
 void *arena_alloc_expand(struct arena *arena, size_t size)
 {
 	struct arena_block *block;
+	size_t len;
 
-	assert(size < ARENA_BLOCK_MIN_LEN);
+	/* arena_alloc_noexpand() needs one byte of slack at the end. */
+	len		= ARENA_BLOCK_MIN_LEN;
+	if (size >= len)
+		len	= size + 1;
 
-	block		= arena_block_new(ARENA_BLOCK_MIN_LEN);
+	block		= arena_block_new(len);
+	if (!block)
+		return NULL;
 
 	block->next = arena->head;
 
@@ -83,6 +83,19 @@ void bitset_sub(struct bitset *from, struct bitset *to)
 		dest[i] &= ~src[i];
 }
 
+void bitset_intersect_to(struct bitset *from, struct bitset *to)
+{
+	unsigned long *src, *dest;
+	unsigned long i, size;
+
+	dest = to->bits;
+	src = from->bits;
+	size = max(from->size, to->size);
+
+	for (i = 0; i < size / BYTES_PER_LONG; i++)
+		dest[i] &= src[i];
+}
+
 bool bitset_equal(struct bitset *from, struct bitset *to)
 {
 	unsigned long *src, *dest;
@@ -70,6 +70,20 @@
  *
  */
 
+/*
+ * Lookups may run concurrently with insertions and removals when
+ * ->lockless_lookup is set, so they read every slot exactly once.
+ */
+static inline void *read_slot(struct radix_tree_node *node, int index)
+{
+	return *(void * volatile *) &node->slots[index];
+}
+
+static inline unsigned long read_nr_values(struct radix_tree_node *node)
+{
+	return *(volatile unsigned long *) &node->nr_values;
+}
+
 static unsigned long level_mask(struct radix_tree *tree)
 {
 	return (1UL << tree->bits_per_level) - 1;
@@ -115,6 +129,7 @@ alloc_radix_tree(unsigned int bits_per_level, unsigned int key_bits)
 		return NULL;
 
 	tree->bits_per_level = bits_per_level;
+	tree->lockless_lookup = false;
 
 	tree->level_count = (key_bits + bits_per_level - 1) / bits_per_level;
 
@@ -153,25 +168,44 @@ void free_radix_tree(struct radix_tree *tree)
 	free(tree);
 }
 
+/*
+ * Returns true if @child, which is in a slot of a node at @level, is a node
+ * without any values below it. Trees with lockless lookup keep such nodes
+ * around and lookups must not descend into them.
+ */
+static bool is_empty_subtree(struct radix_tree *tree, void *child, int level)
+{
+	if (level + 1 == level_count(tree))
+		return false;
+
+	return read_nr_values(child) == 0;
+}
+
+/*
+ * Returns the value with the greatest key below @node.
+ */
 static void *
 radix_tree_last(struct radix_tree *tree, struct radix_tree_node *node,
 		int level)
 {
-	while (level < level_count(tree)) {
-		int i;
+	int i;
 
-		for (i = slot_count(tree) - 1; i >= 0; i--)
-			if (node->slots[i] != NULL)
-				break;
+	if (level == level_count(tree))
+		return node;
 
-		if (i < 0)
-			return NULL;
+	for (i = slot_count(tree) - 1; i >= 0; i--) {
+		void *child, *value;
 
-		node = node->slots[i];
-		level++;
+		child = read_slot(node, i);
+		if (child == NULL || is_empty_subtree(tree, child, level))
+			continue;
+
+		value = radix_tree_last(tree, child, level + 1);
+		if (value != NULL)
+			return value;
 	}
 
-	return node;
+	return NULL;
 }
 
 static unsigned long get_index(struct radix_tree *tree, unsigned long key,
@@ -191,11 +225,15 @@ radix_tree_previous(struct radix_tree *tree, struct radix_tree_node *node,
 	while (node) {
 		index = get_index(tree, key, level) - 1;
 		for (; index >= 0; index--) {
-			if (node->slots[index] == NULL)
+			void *child, *value;
+
+			child = read_slot(node, index);
+			if (child == NULL || is_empty_subtree(tree, child, level))
 				continue;
 
-			return radix_tree_last(tree, node->slots[index],
-					       level + 1);
+			value = radix_tree_last(tree, child, level + 1);
+			if (value != NULL)
+				return value;
 		}
 
 		/*
@@ -212,6 +250,16 @@ radix_tree_previous(struct radix_tree *tree, struct radix_tree_node *node,
 	return NULL;
 }
 
+/*
+ * Adds @delta to the value count of @node and of all its ancestors.
+ */
+static void
+update_nr_values(struct radix_tree_node *node, long delta)
+{
+	for (; node != NULL; node = node->parent)
+		node->nr_values += delta;
+}
+
 /**
  * radix_tree_insert - Insert key->value mapping into the tree.
  *                     Returns 0 on success.
@@ -231,17 +279,31 @@ int radix_tree_insert(struct radix_tree *tree, unsigned long key, void *value)
 		int index = get_index(tree, key, i);
 
 		if (node->slots[index] == NULL) {
-			node->slots[index] = alloc_radix_tree_node(tree, node);
-			if (node->slots[index] == NULL)
+			struct radix_tree_node *child;
+
+			child = alloc_radix_tree_node(tree, node);
+			if (child == NULL)
 				return -ENOMEM;
 
+			/* Publish the node only after it is initialized. */
+			if (tree->lockless_lookup)
+				__sync_synchronize();
+
+			node->slots[index] = child;
 			node->count++;
 		}
 
 		node = node->slots[index];
 	}
 
-	node->count++;
+	if (tree->lockless_lookup)
+		__sync_synchronize();
+
+	if (node->slots[get_index(tree, key, i)] == NULL) {
+		node->count++;
+		update_nr_values(node, 1);
+	}
+
 	node->slots[get_index(tree, key, i)] = value;
 
 	return 0;
@@ -254,6 +316,10 @@ free_slot(struct radix_tree *tree, struct radix_tree_node *node,
 	node->slots[get_index(tree, key, level)] = NULL;
 	node->count--;
 
+	/* Concurrent lookups may still be walking through this node. */
+	if (tree->lockless_lookup)
+		return;
+
 	if (node->count == 0 && node->parent != NULL) {
 		free_slot(tree, node->parent, key, level - 1);
 		free(node);
@@ -279,6 +345,10 @@ void radix_tree_remove(struct radix_tree *tree, unsigned long key)
 		node = node->slots[index];
 	}
 
+	if (node->slots[get_index(tree, key, i)] == NULL)
+		return;
+
+	update_nr_values(node, -1);
 	free_slot(tree, node, key, i);
 }
 
@@ -290,15 +360,17 @@ static void *__radix_tree_lookup(struct radix_tree *tree, unsigned long key,
 
 	for (i = 0; i < level_count(tree); i++) {
 		int index = get_index(tree, key, i);
+		struct radix_tree_node *child;
 
-		if (node->slots[index] == NULL) {
+		child = read_slot(node, index);
+		if (child == NULL) {
 			if (try_previous)
 				return radix_tree_previous(tree, node, key, i);
 			else
 				return NULL;
 		}
 
-		node = node->slots[index];
+		node = child;
 	}
 
 	return node;
@@ -40,7 +40,7 @@
 #define INITIAL_CAPACITY 100
 
 static struct hash_map		*literals;
-static pthread_mutex_t		literals_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_rwlock_t		literals_rwlock = PTHREAD_RWLOCK_INITIALIZER;
 
 struct string *alloc_str(void)
 {
@@ -86,11 +86,34 @@ struct string *string_from_cstr_dup(const char *s)
 	return string_from_cstr(dup);
 }
 
+/*
+ * Returns the interned string for @s or NULL if @s has not been interned.
+ * This never allocates so it can be used to probe member lookup tables that
+ * are keyed by interned names.
+ */
+struct string *string_intern_find(const char *s)
+{
+	struct string *result;
+
+	pthread_rwlock_rdlock(&literals_rwlock);
+
+	if (hash_map_get(literals, s, (void **) &result))
+		result = NULL;
+
+	pthread_rwlock_unlock(&literals_rwlock);
+
+	return result;
+}
+
 struct string *string_intern_cstr(const char *s)
 {
         struct string *result;
 
-        pthread_mutex_lock(&literals_mutex);
+	result = string_intern_find(s);
+	if (result)
+		return result;
+
+        pthread_rwlock_wrlock(&literals_rwlock);
 
         if (!hash_map_get(literals, s, (void **) &result))
 		goto out;
@@ -104,11 +127,29 @@ struct string *string_intern_cstr(const char *s)
 		result = NULL;
 	}
  out:
-        pthread_mutex_unlock(&literals_mutex);
+        pthread_rwlock_unlock(&literals_rwlock);
 
         return result;
 }
 
+/*
+ * Interns the first @len bytes of @s which need not be NUL-terminated.
+ */
+struct string *string_intern_cstrn(const char *s, unsigned long len)
+{
+	struct string *result;
+	char *dup;
+
+	dup = strndup(s, len);
+	if (!dup)
+		return NULL;
+
+	result = string_intern_cstr(dup);
+	free(dup);
+
+	return result;
+}
+
 void init_string_intern(void)
 {
 	literals = alloc_hash_map(&string_key);
@@ -29,6 +29,8 @@
 #include "jit/exception.h"
 #include "jit/args.h"
 
+#include "arch/atomic.h"
+
 #include "vm/classloader.h"
 #include "vm/annotation.h"
 #include "vm/preload.h"
@@ -39,6 +41,8 @@
 #include "vm/call.h"
 #include "vm/die.h"
 
+#include <stdlib.h>
+
 static int marshall_call_arguments(struct vm_method *vmm, unsigned long *args,
 				   struct vm_object *args_array);
 
@@ -600,30 +604,225 @@ struct vm_object *jvalue_to_object(union jvalue *value, enum vm_type vm_type)
 	return NULL;
 }
 
+/*
+ * Reflective calls convert their arguments with an invoker that is built
+ * for the target method on its first reflective call. The invoker has the
+ * parameter classes resolved so that a call only needs to type check the
+ * arguments and read primitive values directly from their wrappers.
+ */
+struct reflection_invoker_arg {
+	enum vm_type		type;
+
+	/* Parameter class for J_REFERENCE arguments. */
+	struct vm_class		*class;
+};
+
+struct reflection_invoker {
+	unsigned int			nr_args;
+	struct reflection_invoker_arg	args[];
+};
+
+static struct reflection_invoker *alloc_reflection_invoker(struct vm_method *vmm)
+{
+	struct reflection_invoker *invoker;
+	struct vm_method_arg *arg;
+	unsigned int nr_args;
+	unsigned int i;
+
+	nr_args = count_java_arguments(vmm);
+
+	invoker = malloc(sizeof(*invoker) + sizeof(struct reflection_invoker_arg) * nr_args);
+	if (!invoker) {
+		throw_oom_error();
+		return NULL;
+	}
+
+	invoker->nr_args = nr_args;
+
+	i = 0;
+	list_for_each_entry(arg, &vmm->args, list_node) {
+		struct reflection_invoker_arg *iarg = &invoker->args[i++];
+
+		iarg->type = arg->type_info.vm_type;
+		iarg->class = NULL;
+
+		if (iarg->type != J_REFERENCE)
+			continue;
+
+		iarg->class = vm_type_to_class(vmm->class->classloader, &arg->type_info);
+		if (!iarg->class || exception_occurred()) {
+			free(invoker);
+			return NULL;
+		}
+	}
+
+	return invoker;
+}
+
+static struct reflection_invoker *vm_method_reflection_invoker(struct vm_method *vmm)
+{
+	struct reflection_invoker *invoker, *old;
+
+	invoker = vmm->reflection_invoker;
+	if (invoker)
+		return invoker;
+
+	invoker = alloc_reflection_invoker(vmm);
+	if (!invoker)
+		return NULL;
+
+	old = cmpxchg_ptr(&vmm->reflection_invoker, NULL, invoker);
+	if (old) {
+		free(invoker);
+		return old;
+	}
+
+	return invoker;
+}
+
+/*
+ * Returns true if a primitive of type @from converts to @to by identity
+ * or widening primitive conversion.
+ */
+static bool is_widening_conversion(enum vm_type from, enum vm_type to)
+{
+	if (from == to)
+		return true;
+
+	switch (from) {
+	case J_BYTE:
+		if (to == J_SHORT)
+			return true;
+		/* Fall through */
+	case J_SHORT:
+	case J_CHAR:
+		if (to == J_INT)
+			return true;
+		/* Fall through */
+	case J_INT:
+		if (to == J_LONG)
+			return true;
+		/* Fall through */
+	case J_LONG:
+		if (to == J_FLOAT)
+			return true;
+		/* Fall through */
+	case J_FLOAT:
+		return to == J_DOUBLE;
+	default:
+		return false;
+	}
+}
+
+/*
+ * Unwraps @value into the argument slot @arg of type @type. Returns -1
+ * if @value is not a primitive wrapper or its value does not widen to
+ * @type.
+ */
+static int unbox_argument(unsigned long *arg, enum vm_type type, struct vm_object *value)
+{
+	struct vm_class *class = value->class;
+	enum vm_type from;
+	jdouble d = 0;
+	jlong j = 0;
+
+	if (class == vm_java_lang_Integer) {
+		from = J_INT;
+		j = field_get_int(value, vm_java_lang_Integer_value);
+	} else if (class == vm_java_lang_Long) {
+		from = J_LONG;
+		j = field_get_long(value, vm_java_lang_Long_value);
+	} else if (class == vm_java_lang_Boolean) {
+		from = J_BOOLEAN;
+		j = field_get_boolean(value, vm_java_lang_Boolean_value);
+	} else if (class == vm_java_lang_Character) {
+		from = J_CHAR;
+		j = field_get_char(value, vm_java_lang_Character_value);
+	} else if (class == vm_java_lang_Byte) {
+		from = J_BYTE;
+		j = field_get_byte(value, vm_java_lang_Byte_value);
+	} else if (class == vm_java_lang_Short) {
+		from = J_SHORT;
+		j = field_get_short(value, vm_java_lang_Short_value);
+	} else if (class == vm_java_lang_Float) {
+		from = J_FLOAT;
+		d = field_get_float(value, vm_java_lang_Float_value);
+	} else if (class == vm_java_lang_Double) {
+		from = J_DOUBLE;
+		d = field_get_double(value, vm_java_lang_Double_value);
+	} else
+		return -1;
+
+	if (!is_widening_conversion(from, type))
+		return -1;
+
+	switch (type) {
+	case J_FLOAT:
+		if (from == J_FLOAT)
+			*(jfloat *) arg = d;
+		else
+			*(jfloat *) arg = j;
+		return 0;
+	case J_DOUBLE:
+		if (from == J_FLOAT || from == J_DOUBLE)
+			*(jdouble *) arg = d;
+		else
+			*(jdouble *) arg = j;
+		return 0;
+	case J_LONG:
+		*(jlong *) arg = j;
+		return 0;
+	default:
+		/*
+		 * Sub-int types are passed like ints, see
+		 * object_to_jvalue().
+		 */
+		*(long *) arg = j;
+		return 0;
+	}
+}
+
 static int marshall_call_arguments(struct vm_method *vmm, unsigned long *args,
 				   struct vm_object *args_array)
 {
-	struct vm_method_arg *arg;
-	int args_array_idx;
+	struct reflection_invoker *invoker;
+	unsigned int nr_args;
 	int idx;
 
-	args_array_idx = 0;
-	idx = 0;
+	invoker = vm_method_reflection_invoker(vmm);
+	if (!invoker)
+		return -1;
 
-	if (args_array == NULL)
-		return 0;
+	nr_args = args_array ? vm_array_length(args_array) : 0;
+	if (nr_args != invoker->nr_args)
+		goto throw_illegal;
 
-	list_for_each_entry(arg, &vmm->args, list_node) {
+	idx = 0;
+
+	for (unsigned int i = 0; i < nr_args; i++) {
+		struct reflection_invoker_arg *iarg = &invoker->args[i];
 		struct vm_object *arg_obj;
 
-		arg_obj = array_get_field_ptr(args_array, args_array_idx++);
-		if (object_to_jvalue(&args[idx], arg->type_info.vm_type, arg_obj))
-			return -1;
+		arg_obj = array_get_field_ptr(args_array, i);
 
-		idx += get_arg_size(arg->type_info.vm_type);
+		if (iarg->type == J_REFERENCE) {
+			if (arg_obj && !vm_object_is_instance_of(arg_obj, iarg->class))
+				goto throw_illegal;
+
+			*(struct vm_object **) &args[idx] = arg_obj;
+		} else {
+			if (!arg_obj || unbox_argument(&args[idx], iarg->type, arg_obj))
+				goto throw_illegal;
+		}
+
+		idx += get_arg_size(iarg->type);
 	}
 
 	return 0;
+
+ throw_illegal:
+	signal_new_exception(vm_java_lang_IllegalArgumentException, NULL);
+	return -1;
 }
 
 static struct vm_object *
@@ -34,6 +34,12 @@
 #include "vm/object.h"
 #include "vm/class.h"
 #include "vm/jni.h"
+#include "vm/thread.h"
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <time.h>
 
 jint sun_misc_Unsafe_arrayBaseOffset(jobject this, jobject class)
 {
@@ -176,43 +182,65 @@ jint native_unsafe_compare_and_swap_object(struct vm_object *this,
 	return cmpxchg_ptr(p, expect, update) == expect;
 }
 
+static int park_state_xchg(atomic_t *state, int new)
+{
+	int old;
+
+	do {
+		old = atomic_read(state);
+	} while (atomic_cmpxchg(state, old, new) != old);
+
+	return old;
+}
+
+static int park_futex(atomic_t *state, int op, int val, const struct timespec *timeout)
+{
+	return syscall(SYS_futex, &state->counter, op, val, timeout, NULL, FUTEX_BITSET_MATCH_ANY);
+}
+
+/*
+ * Threads sleep on the park_state futex word. unpark() only enters the
+ * kernel if the thread is actually sleeping in park() so the uncontended
+ * case of java.util.concurrent locks costs one locked instruction on each
+ * side. Spurious returns are allowed by the specification.
+ */
 void native_unsafe_park(struct vm_object *this, jboolean isAbsolute,
 			jlong timeout)
 {
 	struct vm_thread *self = vm_thread_self();
 	struct timespec timespec;
 
+	if (park_state_xchg(&self->park_state, VM_THREAD_PARK_NONE) == VM_THREAD_PARK_PERMIT)
+		return;
 
-	pthread_mutex_lock(&self->park_mutex);
+	/* The deadline has already passed. */
+	if (timeout < 0 || (isAbsolute && timeout == 0))
+		return;
 
-	if (self->unpark_called) {
-		self->unpark_called = false;
-		pthread_mutex_unlock(&self->park_mutex);
+	if (atomic_cmpxchg(&self->park_state, VM_THREAD_PARK_NONE, VM_THREAD_PARK_WAITING) != VM_THREAD_PARK_NONE) {
+		/* unpark() was called in between. */
+		atomic_set(&self->park_state, VM_THREAD_PARK_NONE);
 		return;
 	}
 
 	if (timeout == 0) {
-		pthread_cond_wait(&self->park_cond, &self->park_mutex);
+		park_futex(&self->park_state, FUTEX_WAIT_PRIVATE, VM_THREAD_PARK_WAITING, NULL);
+	} else if (isAbsolute) {
+		/* Milliseconds since the epoch */
+		timespec.tv_sec  = timeout / 1000l;
+		timespec.tv_nsec = (timeout % 1000l) * 1000000l;
+
+		park_futex(&self->park_state, FUTEX_WAIT_BITSET_PRIVATE | FUTEX_CLOCK_REALTIME,
+			   VM_THREAD_PARK_WAITING, &timespec);
 	} else {
-		/* If isAbsolute == true then timeout is in
-		 * miliseconds otherwise in nanoseconds. */
-		if (isAbsolute) {
-			timespec.tv_sec  = timeout / 1000l;
-			timespec.tv_nsec = timeout % 1000l;
-		} else {
-			clock_gettime(CLOCK_REALTIME, &timespec);
-			timespec.tv_sec  += timeout / 1000000000l;
-			timespec.tv_nsec += timeout % 1000000000l;
-		}
-
-		pthread_cond_timedwait(&self->park_cond, &self->park_mutex, &timespec);
-	}
+		/* Nanoseconds from now */
+		timespec.tv_sec  = timeout / 1000000000l;
+		timespec.tv_nsec = timeout % 1000000000l;
 
-	if (self->unpark_called) {
-		self->unpark_called = false;
+		park_futex(&self->park_state, FUTEX_WAIT_PRIVATE, VM_THREAD_PARK_WAITING, &timespec);
 	}
 
-	pthread_mutex_unlock(&self->park_mutex);
+	park_state_xchg(&self->park_state, VM_THREAD_PARK_NONE);
 }
 
 void native_unsafe_unpark(struct vm_object *this, struct vm_object *vmthread)
@@ -220,9 +248,9 @@ void native_unsafe_unpark(struct vm_object *this, struct vm_object *vmthread)
 	struct vm_thread *thread;
 
 	thread = vm_thread_from_java_thread(vmthread);
+	if (!thread)
+		return;
 
-	pthread_mutex_lock(&thread->park_mutex);
-	thread->unpark_called = true;
-	pthread_cond_signal(&thread->park_cond);
-	pthread_mutex_unlock(&thread->park_mutex);
+	if (park_state_xchg(&thread->park_state, VM_THREAD_PARK_PERMIT) == VM_THREAD_PARK_WAITING)
+		park_futex(&thread->park_state, FUTEX_WAKE_PRIVATE, 1, NULL);
 }
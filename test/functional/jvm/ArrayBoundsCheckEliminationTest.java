@@ -0,0 +1,155 @@
+package jvm;
+
+/**
+ * Exercises array accesses whose bounds checks can be proven redundant and
+ * accesses that look similar but must still throw.
+ */
+public class ArrayBoundsCheckEliminationTest extends TestCase {
+    private static int sum(int[] a) {
+        int sum = 0;
+
+        for (int i = 0; i < a.length; i++)
+            sum += a[i];
+
+        return sum;
+    }
+
+    private static int sumWithLengthInLocal(int[] a) {
+        int n = a.length;
+        int sum = 0;
+
+        for (int i = 0; i < n; i++)
+            sum += a[i];
+
+        return sum;
+    }
+
+    private static void scale(double[] x, double[] y, double factor) {
+        for (int i = 0; i < x.length; i++)
+            y[i] = x[i] * factor;
+    }
+
+    private static int sumConstant() {
+        int[] a = new int[10];
+
+        for (int i = 0; i < 10; i++)
+            a[i] = i;
+
+        int sum = 0;
+        for (int i = 0; i <= 9; i++)
+            sum += a[i];
+
+        return sum + a[3];
+    }
+
+    private static int sumFrom(int[] a, int start) {
+        int sum = 0;
+
+        for (int i = start; i < a.length; i++)
+            sum += a[i];
+
+        return sum;
+    }
+
+    private static int sumUpTo(int[] a, int n) {
+        int sum = 0;
+
+        for (int i = 0; i <= n; i++)
+            sum += a[i];
+
+        return sum;
+    }
+
+    private static int sumOther(int[] a, int[] b) {
+        int sum = 0;
+
+        for (int i = 0; i < a.length; i++)
+            sum += b[i];
+
+        return sum;
+    }
+
+    private static int sumReassigned(int[] a, int[] b) {
+        int sum = 0;
+
+        for (int i = 0; i < a.length; i++) {
+            a = b;
+            sum += a[i];
+        }
+
+        return sum;
+    }
+
+    private static int sumSkipping(int[] a) {
+        int sum = 0;
+
+        for (int i = 0; i < a.length; i++) {
+            i = i + 1;
+            sum += a[i];
+        }
+
+        return sum;
+    }
+
+    public static void testEliminatedChecks() {
+        int[] a = { 1, 2, 3, 4 };
+        double[] x = { 1.0, 2.0 };
+        double[] y = new double[2];
+
+        assertEquals(10, sum(a));
+        assertEquals(10, sumWithLengthInLocal(a));
+        assertEquals(0, sum(new int[0]));
+
+        scale(x, y, 2.0);
+        assertEquals(2.0, y[0]);
+        assertEquals(4.0, y[1]);
+
+        assertEquals(48, sumConstant());
+        assertEquals(7, sumFrom(a, 2));
+    }
+
+    public static void testRetainedChecks() {
+        int[] a = { 1, 2, 3, 4 };
+
+        try {
+            sumFrom(a, -1);
+            fail();
+        } catch (ArrayIndexOutOfBoundsException e) {
+        }
+
+        try {
+            sumUpTo(a, 4);
+            fail();
+        } catch (ArrayIndexOutOfBoundsException e) {
+        }
+
+        try {
+            sumOther(a, new int[2]);
+            fail();
+        } catch (ArrayIndexOutOfBoundsException e) {
+        }
+
+        try {
+            sumReassigned(a, new int[2]);
+            fail();
+        } catch (ArrayIndexOutOfBoundsException e) {
+        }
+
+        try {
+            sumSkipping(new int[3]);
+            fail();
+        } catch (ArrayIndexOutOfBoundsException e) {
+        }
+
+        try {
+            scale(new double[3], new double[2], 1.0);
+            fail();
+        } catch (ArrayIndexOutOfBoundsException e) {
+        }
+    }
+
+    public static void main(String[] args) {
+        testEliminatedChecks();
+        testRetainedChecks();
+    }
+}
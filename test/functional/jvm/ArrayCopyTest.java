@@ -0,0 +1,144 @@
+package jvm;
+
+/**
+ * Exercises System.arraycopy() which the JIT calls as an intrinsic.
+ */
+public class ArrayCopyTest extends TestCase {
+    private static int[] range(int n) {
+        int[] array = new int[n];
+
+        for (int i = 0; i < n; i++)
+            array[i] = i;
+
+        return array;
+    }
+
+    public static void testPrimitiveCopy() {
+        int[] src = range(100);
+        int[] dest = new int[100];
+
+        System.arraycopy(src, 0, dest, 0, 3);
+        assertArrayEquals(new int[] { 0, 1, 2 }, new int[] { dest[0], dest[1], dest[2] });
+
+        System.arraycopy(src, 0, dest, 0, 100);
+        assertArrayEquals(src, dest);
+
+        long[] longs = new long[] { 1L, 2L, 1L << 40 };
+        long[] longCopy = new long[3];
+        System.arraycopy(longs, 0, longCopy, 0, 3);
+        assertArrayEquals(longs, longCopy);
+
+        byte[] bytes = new byte[] { 1, 2, 3, 4 };
+        byte[] byteCopy = new byte[4];
+        System.arraycopy(bytes, 1, byteCopy, 2, 2);
+        assertArrayEquals(new byte[] { 0, 0, 2, 3 }, byteCopy);
+    }
+
+    public static void testOverlappingCopy() {
+        int[] array = range(8);
+
+        System.arraycopy(array, 0, array, 2, 6);
+        assertArrayEquals(new int[] { 0, 1, 0, 1, 2, 3, 4, 5 }, array);
+
+        array = range(8);
+        System.arraycopy(array, 2, array, 0, 6);
+        assertArrayEquals(new int[] { 2, 3, 4, 5, 6, 7, 6, 7 }, array);
+
+        array = range(100);
+        System.arraycopy(array, 0, array, 1, 99);
+        assertEquals(0, array[0]);
+        assertEquals(0, array[1]);
+        assertEquals(98, array[99]);
+    }
+
+    public static void testReferenceCopy() {
+        String[] strings = new String[] { "a", "b", "c" };
+        Object[] objects = new Object[3];
+
+        System.arraycopy(strings, 0, objects, 0, 3);
+        assertArrayEquals(strings, objects);
+
+        objects = new Object[] { "x", null, "y" };
+        String[] stringCopy = new String[3];
+        System.arraycopy(objects, 0, stringCopy, 0, 3);
+        assertArrayEquals(objects, stringCopy);
+    }
+
+    public static void testStoreCheckedCopy() {
+        Object[] objects = new Object[] { "a", "b", new Integer(1), "c" };
+        String[] strings = new String[4];
+
+        try {
+            System.arraycopy(objects, 0, strings, 0, 4);
+            fail();
+        } catch (ArrayStoreException e) {
+        }
+
+        assertEquals("a", strings[0]);
+        assertEquals("b", strings[1]);
+        assertNull(strings[2]);
+        assertNull(strings[3]);
+    }
+
+    public static void testExceptions() {
+        int[] ints = new int[4];
+
+        try {
+            System.arraycopy(null, 0, ints, 0, 1);
+            fail();
+        } catch (NullPointerException e) {
+        }
+
+        try {
+            System.arraycopy(ints, 0, new long[4], 0, 1);
+            fail();
+        } catch (ArrayStoreException e) {
+        }
+
+        try {
+            System.arraycopy(new boolean[4], 0, new byte[4], 0, 1);
+            fail();
+        } catch (ArrayStoreException e) {
+        }
+
+        try {
+            System.arraycopy(ints, 0, new Object[4], 0, 1);
+            fail();
+        } catch (ArrayStoreException e) {
+        }
+
+        try {
+            System.arraycopy("not an array", 0, ints, 0, 1);
+            fail();
+        } catch (ArrayStoreException e) {
+        }
+
+        try {
+            System.arraycopy(ints, 2, ints, 0, 3);
+            fail();
+        } catch (ArrayIndexOutOfBoundsException e) {
+        }
+
+        try {
+            System.arraycopy(ints, 0, ints, 0, -1);
+            fail();
+        } catch (ArrayIndexOutOfBoundsException e) {
+        }
+
+        try {
+            System.arraycopy(ints, 1, ints, 0, Integer.MAX_VALUE);
+            fail();
+        } catch (ArrayIndexOutOfBoundsException e) {
+        }
+
+        System.arraycopy(ints, 4, ints, 0, 0);
+    }
+
+    public static void main(String[] args) {
+        testPrimitiveCopy();
+        testOverlappingCopy();
+        testReferenceCopy();
+        testStoreCheckedCopy();
+        testExceptions();
+    }
+}
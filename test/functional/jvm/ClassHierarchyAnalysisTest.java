@@ -0,0 +1,71 @@
+package jvm;
+
+/**
+ * Exercises virtual calls that the JIT binds directly because no loaded
+ * class overrides the target, and the recompilation of their callers when
+ * an overriding class is loaded later.
+ */
+public class ClassHierarchyAnalysisTest extends TestCase {
+    private static class Shape {
+        public int sides() {
+            return 0;
+        }
+
+        public int twice() {
+            return sides() * 2;
+        }
+    }
+
+    private static class Square extends Shape {
+        public int sides() {
+            return 4;
+        }
+    }
+
+    private static class Circle extends Shape {
+    }
+
+    private static int sidesOf(Shape s) {
+        return s.sides();
+    }
+
+    private static int twiceOf(Shape s) {
+        return s.twice();
+    }
+
+    private static Shape newSquare() {
+        return new Square();
+    }
+
+    public static void testMonomorphicCall() {
+        assertEquals(0, sidesOf(new Shape()));
+        assertEquals(0, sidesOf(new Circle()));
+        assertEquals(0, twiceOf(new Shape()));
+    }
+
+    public static void testOverridingClassLoadedLater() {
+        Shape square = newSquare();
+
+        assertEquals(4, sidesOf(square));
+        assertEquals(8, twiceOf(square));
+        assertEquals(0, sidesOf(new Shape()));
+    }
+
+    public static void testNullReceiver() {
+        try {
+            sidesOf(null);
+            fail();
+        } catch (NullPointerException e) {
+        }
+    }
+
+    public static void main(String[] args) {
+        for (int i = 0; i < 10; i++)
+            testMonomorphicCall();
+
+        testNullReceiver();
+
+        for (int i = 0; i < 10; i++)
+            testOverridingClassLoadedLater();
+    }
+}
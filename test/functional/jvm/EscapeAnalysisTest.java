@@ -0,0 +1,129 @@
+package jvm;
+
+/**
+ * Exercises allocations that the JIT replaces with scalars because the
+ * objects never leave the method, together with allocations that escape and
+ * must stay on the heap.
+ */
+public class EscapeAnalysisTest extends TestCase {
+    private static Object sink;
+
+    private static class Pair {
+        int first;
+        long second;
+        double third;
+        byte small;
+        char character;
+        Object ref;
+
+        Pair(int first, long second) {
+            this.first = first;
+            this.second = second;
+        }
+
+        int sum() {
+            return first + (int) second;
+        }
+    }
+
+    private static int tuple(int a, long b) {
+        Pair p = new Pair(a, b);
+        return p.sum();
+    }
+
+    private static int defaults() {
+        Pair p = new Pair(1, 2);
+        if (p.ref != null || p.third != 0.0 || p.small != 0 || p.character != 0)
+            return -1;
+        return p.first;
+    }
+
+    private static int truncation(int value) {
+        Pair p = new Pair(0, 0);
+        p.small = (byte) value;
+        p.character = (char) value;
+        return p.small + p.character;
+    }
+
+    private static int loop(int n) {
+        int sum = 0;
+
+        for (int i = 0; i < n; i++) {
+            Pair p = new Pair(i, i * 2);
+            p.first += 1;
+            sum += p.sum();
+        }
+
+        return sum;
+    }
+
+    private static int branches(boolean flag) {
+        Pair p = new Pair(1, 1);
+
+        if (flag)
+            p.first = 10;
+        else
+            p.second = 20;
+
+        return p.sum();
+    }
+
+    private static int locked(int a) {
+        Pair p = new Pair(a, 0);
+
+        synchronized (p) {
+            p.first++;
+        }
+
+        return p.first;
+    }
+
+    private static int escapesToStatic(int a) {
+        Pair p = new Pair(a, 0);
+        sink = p;
+        p.first++;
+        return ((Pair) sink).first;
+    }
+
+    private static Pair escapesThroughReturn(int a) {
+        Pair p = new Pair(a, 0);
+        p.first *= 2;
+        return p;
+    }
+
+    private static int escapesToField(Pair outer, int a) {
+        Pair p = new Pair(a, 0);
+        outer.ref = p;
+        p.first = a + 1;
+        return ((Pair) outer.ref).first;
+    }
+
+    private static boolean identity() {
+        Pair p = new Pair(0, 0);
+        Pair q = p;
+        return p == q;
+    }
+
+    public static void testScalarReplacement() {
+        assertEquals(5, tuple(2, 3));
+        assertEquals(1, defaults());
+        assertEquals(254, truncation(255));
+        assertEquals(130, truncation(0x10041));
+        assertEquals(22, loop(4));
+        assertEquals(11, branches(true));
+        assertEquals(21, branches(false));
+        assertEquals(8, locked(7));
+        assertTrue(identity());
+    }
+
+    public static void testEscapingAllocations() {
+        assertEquals(4, escapesToStatic(3));
+        assertEquals(6, escapesThroughReturn(3).first);
+        assertEquals(5, escapesToField(new Pair(0, 0), 4));
+    }
+
+    public static void main(String[] args) {
+        testScalarReplacement();
+        testEscapingAllocations();
+    }
+}
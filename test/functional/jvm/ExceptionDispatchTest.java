@@ -0,0 +1,106 @@
+package jvm;
+
+/**
+ * Throws exceptions of different classes repeatedly from the same throw
+ * sites so that cached handler lookups are exercised together with the
+ * first lookup for each class.
+ */
+public class ExceptionDispatchTest extends TestCase {
+    private static class ParseException extends Exception {
+    }
+
+    private static class BadNumberException extends ParseException {
+    }
+
+    private static void raise(int kind) throws Exception {
+        switch (kind) {
+        case 0:
+            throw new BadNumberException();
+        case 1:
+            throw new ParseException();
+        case 2:
+            throw new IllegalStateException();
+        case 3:
+            throw new Exception();
+        }
+    }
+
+    private static int dispatch(int kind) {
+        try {
+            raise(kind);
+        } catch (BadNumberException e) {
+            return 1;
+        } catch (ParseException e) {
+            return 2;
+        } catch (RuntimeException e) {
+            return 3;
+        } catch (Exception e) {
+            return 4;
+        }
+        return 0;
+    }
+
+    private static int nested(int kind) {
+        int result = 0;
+
+        try {
+            try {
+                raise(kind);
+            } catch (ParseException e) {
+                result += 10;
+            } finally {
+                result += 100;
+            }
+        } catch (Exception e) {
+            result += 1000;
+        }
+
+        return result;
+    }
+
+    private static int propagate(int kind) throws Exception {
+        try {
+            raise(kind);
+        } catch (ParseException e) {
+            return 1;
+        }
+        return 0;
+    }
+
+    public static void testDispatchToMatchingHandler() {
+        for (int i = 0; i < 3; i++) {
+            assertEquals(1, dispatch(0));
+            assertEquals(2, dispatch(1));
+            assertEquals(3, dispatch(2));
+            assertEquals(4, dispatch(3));
+            assertEquals(0, dispatch(4));
+        }
+    }
+
+    public static void testNestedHandlersAndFinally() {
+        for (int i = 0; i < 3; i++) {
+            assertEquals(110, nested(0));
+            assertEquals(110, nested(1));
+            assertEquals(1100, nested(2));
+            assertEquals(1100, nested(3));
+            assertEquals(100, nested(4));
+        }
+    }
+
+    public static void testPropagatesUnhandledExceptions() throws Exception {
+        for (int i = 0; i < 3; i++) {
+            assertEquals(1, propagate(0));
+            try {
+                propagate(2);
+                fail();
+            } catch (IllegalStateException e) {
+            }
+        }
+    }
+
+    public static void main(String[] args) throws Exception {
+        testDispatchToMatchingHandler();
+        testNestedHandlersAndFinally();
+        testPropagatesUnhandledExceptions();
+    }
+}
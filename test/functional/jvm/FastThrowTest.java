@@ -0,0 +1,71 @@
+package jvm;
+
+/**
+ * Raises implicit exceptions repeatedly at the same throw sites. Run with
+ * -XX:+OmitStackTraceInFastThrow so that hot sites throw preallocated
+ * exceptions.
+ */
+public class FastThrowTest extends TestCase {
+    private static class Holder {
+        int value;
+    }
+
+    private static int npe(Holder holder) {
+        try {
+            return holder.value;
+        } catch (NullPointerException e) {
+            return -1;
+        }
+    }
+
+    private static int divide(int a, int b) {
+        try {
+            return a / b;
+        } catch (ArithmeticException e) {
+            return -1;
+        }
+    }
+
+    private static int index(int[] array, int i) {
+        try {
+            return array[i];
+        } catch (ArrayIndexOutOfBoundsException e) {
+            return -1;
+        }
+    }
+
+    public static void testHotThrowSites() {
+        int[] array = new int[] { 1, 2, 3 };
+        Holder holder = new Holder();
+
+        holder.value = 7;
+
+        for (int i = 0; i < 1000; i++) {
+            assertEquals(-1, npe(null));
+            assertEquals(-1, divide(i, 0));
+            assertEquals(-1, index(array, 3 + i));
+        }
+
+        assertEquals(7, npe(holder));
+        assertEquals(5, divide(10, 2));
+        assertEquals(3, index(array, 2));
+    }
+
+    public static void testColdThrowSiteHasStackTrace() {
+        try {
+            Holder holder = null;
+            holder.value = 1;
+            fail();
+        } catch (NullPointerException e) {
+            StackTraceElement[] trace = e.getStackTrace();
+
+            assertTrue(trace.length > 0);
+            assertEquals("testColdThrowSiteHasStackTrace", trace[0].getMethodName());
+        }
+    }
+
+    public static void main(String[] args) {
+        testHotThrowSites();
+        testColdThrowSiteHasStackTrace();
+    }
+}
@@ -0,0 +1,174 @@
+package jvm;
+
+/**
+ * Exceptions signalled by runtime helpers called from JIT code, such as
+ * the checkcast, array store and array bounds checks, must reach handlers
+ * in the same method and in its callers.
+ */
+public class HelperExceptionsTest extends TestCase {
+    private static Object string() {
+        return "foo";
+    }
+
+    private static Integer checkcast(Object o) {
+        return (Integer) o;
+    }
+
+    private static void arrayStore(Object[] array, Object o) {
+        array[0] = o;
+    }
+
+    private static int arrayLoad(int[] array, int index) {
+        return array[index];
+    }
+
+    private static int[] newArray(int size) {
+        return new int[size];
+    }
+
+    private static long ldiv(long dividend, long divisor) {
+        return dividend / divisor;
+    }
+
+    private static long lrem(long dividend, long divisor) {
+        return dividend % divisor;
+    }
+
+    private static int compareTo(String s, String other) {
+        return s.compareTo(other);
+    }
+
+    public static void testCheckcastCaughtInSameFrame() {
+        int result = 1;
+        try {
+            Integer i = (Integer) string();
+            result = i.intValue();
+        } catch (ClassCastException e) {
+            result += 2;
+        }
+        assertEquals(3, result);
+    }
+
+    public static void testCheckcastCaughtInCaller() {
+        int result = 1;
+        try {
+            result = checkcast(string()).intValue();
+        } catch (ClassCastException e) {
+            result += 2;
+        }
+        assertEquals(3, result);
+    }
+
+    public static void testArrayStoreCaughtInSameFrame() {
+        Object[] array = new String[1];
+        int result = 1;
+        try {
+            array[0] = new Object();
+            result = 0;
+        } catch (ArrayStoreException e) {
+            result += 2;
+        }
+        assertEquals(3, result);
+        assertNull(array[0]);
+    }
+
+    public static void testArrayStoreCaughtInCaller() {
+        Object[] array = new String[1];
+        int result = 1;
+        try {
+            arrayStore(array, new Object());
+            result = 0;
+        } catch (ArrayStoreException e) {
+            result += 2;
+        }
+        assertEquals(3, result);
+        assertNull(array[0]);
+    }
+
+    public static void testArrayBoundsCaughtInSameFrame() {
+        int[] array = new int[1];
+        int result = 1;
+        try {
+            result = array[1];
+        } catch (ArrayIndexOutOfBoundsException e) {
+            result += 2;
+        }
+        assertEquals(3, result);
+    }
+
+    public static void testArrayBoundsCaughtInCaller() {
+        int result = 1;
+        try {
+            result = arrayLoad(new int[1], -1);
+        } catch (ArrayIndexOutOfBoundsException e) {
+            result += 2;
+        }
+        assertEquals(3, result);
+    }
+
+    public static void testNegativeArraySizeCaughtInCaller() {
+        int[] array = null;
+        try {
+            array = newArray(-1);
+        } catch (NegativeArraySizeException e) {
+        }
+        assertNull(array);
+    }
+
+    public static void testLongDivisionByZeroCaughtInCaller() {
+        long result = 1;
+        try {
+            result = ldiv(1, 0);
+        } catch (ArithmeticException e) {
+            result += 2;
+        }
+        assertEquals(3, result);
+
+        result = 1;
+        try {
+            result = lrem(1, 0);
+        } catch (ArithmeticException e) {
+            result += 2;
+        }
+        assertEquals(3, result);
+    }
+
+    public static void testStringIntrinsicCaughtInCaller() {
+        int result = 1;
+        try {
+            result = compareTo("foo", null);
+        } catch (NullPointerException e) {
+            result += 2;
+        }
+        assertEquals(3, result);
+    }
+
+    public static void testRepeatedThrowsFromSameSite() {
+        Object[] values = { "foo", Integer.valueOf(1), "bar", Integer.valueOf(2) };
+        int caught = 0;
+        int sum = 0;
+
+        for (int i = 0; i < values.length; i++) {
+            try {
+                sum += checkcast(values[i]).intValue();
+            } catch (ClassCastException e) {
+                caught++;
+            }
+        }
+        assertEquals(2, caught);
+        assertEquals(3, sum);
+    }
+
+    public static void main(String[] args) {
+        testCheckcastCaughtInSameFrame();
+        testCheckcastCaughtInCaller();
+        testArrayStoreCaughtInSameFrame();
+        testArrayStoreCaughtInCaller();
+        testArrayBoundsCaughtInSameFrame();
+        testArrayBoundsCaughtInCaller();
+        testNegativeArraySizeCaughtInCaller();
+        testLongDivisionByZeroCaughtInCaller();
+        testStringIntrinsicCaughtInCaller();
+        testRepeatedThrowsFromSameSite();
+    }
+}
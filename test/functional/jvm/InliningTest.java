@@ -0,0 +1,116 @@
+package jvm;
+
+/**
+ * Exercises calls that the JIT inlines at the call site.
+ */
+public class InliningTest extends TestCase {
+    private static class Point {
+        private int x;
+        private long y;
+        static int count;
+
+        public Point(int x, long y) {
+            this.x = x;
+            this.y = y;
+        }
+
+        public final int getX() {
+            return x;
+        }
+
+        private long getY() {
+            return y;
+        }
+
+        public final void setX(int x) {
+            this.x = x;
+        }
+
+        public final int sum() {
+            return getX() + 1;
+        }
+
+        public long scaledY(long factor) {
+            return getY() * factor;
+        }
+
+        public static int getCount() {
+            return count;
+        }
+
+        public static void setCount(int n) {
+            count = n;
+        }
+    }
+
+    private static final class Empty {
+    }
+
+    private static int add(int a, int b) {
+        return a + b;
+    }
+
+    private static long shift(long value, int n) {
+        return value << n;
+    }
+
+    private static double half(double d) {
+        return d * 0.5d;
+    }
+
+    public static void testGetterAndSetter() {
+        Point p = new Point(1, 2);
+
+        assertEquals(1, p.getX());
+        p.setX(3);
+        assertEquals(3, p.getX());
+        assertEquals(4, p.sum());
+    }
+
+    public static void testLongArguments() {
+        Point p = new Point(0, 5);
+
+        assertEquals(15L, p.scaledY(3));
+        assertEquals(40L, shift(5L, 3));
+    }
+
+    public static void testStaticHelpers() {
+        assertEquals(5, add(2, 3));
+        assertEquals(1.5d, half(3.0d));
+
+        Point.setCount(7);
+        assertEquals(7, Point.getCount());
+    }
+
+    public static void testEmptyConstructorChain() {
+        assertNotNull(new Empty());
+    }
+
+    private static int getXOf(Point p) {
+        return p.getX();
+    }
+
+    public static void testNullReceiver() {
+        StackTraceElement[] st = null;
+
+        try {
+            getXOf(null);
+            fail();
+        } catch (NullPointerException e) {
+            st = e.getStackTrace();
+        }
+
+        assertNotNull(st);
+        assertEquals("getXOf", st[0].getMethodName());
+    }
+
+    public static void main(String[] args) {
+        for (int i = 0; i < 100; i++) {
+            testGetterAndSetter();
+            testLongArguments();
+            testStaticHelpers();
+            testEmptyConstructorChain();
+            testNullReceiver();
+        }
+    }
+}
@@ -0,0 +1,93 @@
+package jvm;
+
+/**
+ * Exercises Math and bit manipulation methods that the JIT replaces with
+ * machine instructions.
+ */
+public class MathIntrinsicsTest extends TestCase {
+    public static void testAbs() {
+        assertEquals(5, Math.abs(-5));
+        assertEquals(5, Math.abs(5));
+        assertEquals(Integer.MIN_VALUE, Math.abs(Integer.MIN_VALUE));
+        assertEquals(1L << 40, Math.abs(-(1L << 40)));
+        assertEquals(Long.MIN_VALUE, Math.abs(Long.MIN_VALUE));
+        assertEquals(1.5f, Math.abs(-1.5f));
+        assertEquals(2.5, Math.abs(-2.5));
+        assertEquals(0, Float.floatToRawIntBits(Math.abs(-0.0f)));
+        assertEquals(0L, Double.doubleToRawLongBits(Math.abs(-0.0)));
+        assertEquals(7, StrictMath.abs(-7));
+    }
+
+    public static void testMinMax() {
+        assertEquals(-3, Math.min(-3, 4));
+        assertEquals(4, Math.max(-3, 4));
+        assertEquals(Integer.MIN_VALUE, Math.min(Integer.MIN_VALUE, Integer.MAX_VALUE));
+        assertEquals(-(1L << 40), Math.min(1L << 40, -(1L << 40)));
+        assertEquals(1L << 40, Math.max(1L << 40, -(1L << 40)));
+        assertEquals(2, StrictMath.max(1, 2));
+    }
+
+    public static void testSqrt() {
+        assertEquals(3.0, Math.sqrt(9.0));
+        assertEquals(1.4142135623730951, Math.sqrt(2.0));
+        assertTrue(Double.isNaN(Math.sqrt(-1.0)));
+        assertEquals(4.0, StrictMath.sqrt(16.0));
+    }
+
+    public static void testBitCount() {
+        assertEquals(0, Integer.bitCount(0));
+        assertEquals(32, Integer.bitCount(-1));
+        assertEquals(3, Integer.bitCount(0x10101));
+        assertEquals(64, Long.bitCount(-1L));
+        assertEquals(2, Long.bitCount((1L << 40) | 1L));
+    }
+
+    public static void testLeadingAndTrailingZeros() {
+        assertEquals(32, Integer.numberOfLeadingZeros(0));
+        assertEquals(0, Integer.numberOfLeadingZeros(-1));
+        assertEquals(31, Integer.numberOfLeadingZeros(1));
+        assertEquals(64, Long.numberOfLeadingZeros(0L));
+        assertEquals(23, Long.numberOfLeadingZeros(1L << 40));
+
+        assertEquals(32, Integer.numberOfTrailingZeros(0));
+        assertEquals(4, Integer.numberOfTrailingZeros(0x30));
+        assertEquals(31, Integer.numberOfTrailingZeros(Integer.MIN_VALUE));
+        assertEquals(64, Long.numberOfTrailingZeros(0L));
+        assertEquals(40, Long.numberOfTrailingZeros(1L << 40));
+    }
+
+    public static void testReverseBytes() {
+        assertEquals(0x78563412, Integer.reverseBytes(0x12345678));
+        assertEquals(0xefcdab8967452301L, Long.reverseBytes(0x0123456789abcdefL));
+    }
+
+    public static void testRotate() {
+        int distance = 36;
+
+        assertEquals(0x23456781, Integer.rotateLeft(0x12345678, 4));
+        assertEquals(0x81234567, Integer.rotateRight(0x12345678, 4));
+        assertEquals(0x23456781, Integer.rotateLeft(0x12345678, distance));
+        assertEquals(0x81234567, Integer.rotateLeft(0x12345678, -4));
+        assertEquals(0x23456789abcdef01L, Long.rotateLeft(0x0123456789abcdefL, 8));
+        assertEquals(0xef0123456789abcdL, Long.rotateRight(0x0123456789abcdefL, 8));
+        assertEquals(0xef0123456789abcdL, Long.rotateRight(0x0123456789abcdefL, distance + 36));
+    }
+
+    public static void testRawBits() {
+        assertEquals(0x3fc00000, Float.floatToRawIntBits(1.5f));
+        assertEquals(0x80000000, Float.floatToRawIntBits(-0.0f));
+        assertEquals(0x3ff8000000000000L, Double.doubleToRawLongBits(1.5));
+        assertEquals(0x8000000000000000L, Double.doubleToRawLongBits(-0.0));
+    }
+
+    public static void main(String[] args) {
+        testAbs();
+        testMinMax();
+        testSqrt();
+        testBitCount();
+        testLeadingAndTrailingZeros();
+        testReverseBytes();
+        testRotate();
+        testRawBits();
+    }
+}
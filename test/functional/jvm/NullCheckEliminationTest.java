@@ -0,0 +1,143 @@
+package jvm;
+
+/**
+ * Exercises code where the JIT drops null checks that are known to be
+ * redundant or relies on the first field access faulting, together with the
+ * cases where a NullPointerException must still be thrown.
+ */
+public class NullCheckEliminationTest extends TestCase {
+    private static class Node {
+        int value;
+        long wide;
+        Node next;
+
+        Node(int value) {
+            this.value = value;
+        }
+
+        int sumWithThis() {
+            return this.value + value + next().value;
+        }
+
+        Node next() {
+            return next != null ? next : this;
+        }
+    }
+
+    private static int repeatedAccess(Node n) {
+        int a = n.value;
+        n.value = a + 1;
+        n.wide = a;
+        return n.value + (int) n.wide;
+    }
+
+    private static int freshObject() {
+        Node n = new Node(3);
+        n.value += 4;
+        n.next = n;
+        return n.next.value;
+    }
+
+    private static int reassigned(Node n, boolean clear) {
+        int a = n.value;
+        if (clear)
+            n = null;
+        return a + n.value;
+    }
+
+    private static int joined(Node n, boolean flag) {
+        if (flag)
+            n.value++;
+        else
+            n.value--;
+        return n.value;
+    }
+
+    private static int arrays(int[] a) {
+        a[0] = 1;
+        a[1] = a[0] + 1;
+        return a.length + a[1];
+    }
+
+    private static int handler(Node n) {
+        int result = 0;
+
+        try {
+            result = n.value;
+            n = null;
+            result += n.value;
+        } catch (NullPointerException e) {
+            result += n == null ? 100 : 200;
+        }
+
+        return result;
+    }
+
+    private static int loop(Node n, int count) {
+        int sum = 0;
+
+        for (int i = 0; i < count; i++) {
+            sum += n.value;
+            n = n.next;
+        }
+
+        return sum;
+    }
+
+    public static void testRedundantChecks() {
+        Node n = new Node(5);
+
+        assertEquals(11, repeatedAccess(n));
+        assertEquals(6, n.value);
+        assertEquals(7, freshObject());
+        assertEquals(18, n.sumWithThis());
+        assertEquals(6, joined(n, true) - 1);
+        assertEquals(6, joined(n, false));
+        assertEquals(4, arrays(new int[2]));
+    }
+
+    public static void testNullPointerExceptions() {
+        try {
+            repeatedAccess(null);
+            fail();
+        } catch (NullPointerException e) {
+        }
+
+        try {
+            reassigned(new Node(1), true);
+            fail();
+        } catch (NullPointerException e) {
+        }
+
+        assertEquals(2, reassigned(new Node(1), false));
+
+        try {
+            arrays(null);
+            fail();
+        } catch (NullPointerException e) {
+        }
+
+        assertEquals(101, handler(new Node(1)));
+    }
+
+    public static void testLoops() {
+        Node a = new Node(1);
+        Node b = new Node(2);
+
+        a.next = b;
+
+        assertEquals(3, loop(a, 2));
+
+        try {
+            loop(a, 3);
+            fail();
+        } catch (NullPointerException e) {
+        }
+    }
+
+    public static void main(String[] args) {
+        testRedundantChecks();
+        testNullPointerExceptions();
+        testLoops();
+    }
+}
@@ -0,0 +1,169 @@
+package jvm;
+
+/**
+ * Exercises code that global value numbering, constant propagation and
+ * loop-invariant code motion rewrite when the JIT compiles it in SSA form,
+ * together with the cases where those optimizations must stay away.
+ */
+public class SSAOptimizationTest extends TestCase {
+    private static class Point {
+        int x;
+        int y;
+        volatile int counter;
+
+        Point(int x, int y) {
+            this.x = x;
+            this.y = y;
+        }
+    }
+
+    private static int repeatedFieldLoads(Point p) {
+        return p.x + p.y + p.x * p.y + p.x;
+    }
+
+    private static int fieldLoadAfterStore(Point p) {
+        int a = p.x;
+        p.x = a + 1;
+        return a + p.x;
+    }
+
+    private static int repeatedArithmetic(int a, int b) {
+        int c = a * b + 3;
+        int d = b * a + 3;
+        return c - d;
+    }
+
+    private static int constants() {
+        int a = 6;
+        int b = a * 7;
+        int c = b - 40;
+        int d = c << 3;
+
+        if (b > 40)
+            return d + c;
+
+        return -1;
+    }
+
+    private static int constantThroughLoop() {
+        int k = 3;
+        int sum = 0;
+
+        for (int i = 0; i < 10; i++) {
+            if (k != 3)
+                k = i;
+            sum += k;
+        }
+
+        return sum;
+    }
+
+    private static int overflow() {
+        int a = Integer.MAX_VALUE;
+        return a + 1;
+    }
+
+    private static int loopInvariant(Point p, int n) {
+        int sum = 0;
+
+        for (int i = 0; i < n; i++)
+            sum += p.x * p.y + i;
+
+        return sum;
+    }
+
+    private static int loopWithStore(Point p, int n) {
+        int sum = 0;
+
+        for (int i = 0; i < n; i++) {
+            sum += p.x;
+            p.x = i;
+        }
+
+        return sum;
+    }
+
+    private static int loopNullCheck(Point p, int n) {
+        int sum = 0;
+
+        for (int i = 0; i < n; i++)
+            sum += p.y;
+
+        return sum;
+    }
+
+    private static int volatileLoads(Point p) {
+        int a = p.counter;
+        p.counter = a + 1;
+        return p.counter + a;
+    }
+
+    private static int tryCatch(Point p, int a) {
+        int b = a * 2;
+
+        try {
+            b += p.x;
+        } catch (NullPointerException e) {
+            b = a * 2 + 1;
+        }
+
+        return b;
+    }
+
+    public static void testFieldLoads() {
+        Point p = new Point(2, 3);
+
+        assertEquals(13, repeatedFieldLoads(p));
+        assertEquals(5, fieldLoadAfterStore(p));
+        assertEquals(3, p.x);
+    }
+
+    public static void testArithmetic() {
+        assertEquals(0, repeatedArithmetic(5, 7));
+        assertEquals(0, repeatedArithmetic(-1, Integer.MIN_VALUE));
+    }
+
+    public static void testConstantPropagation() {
+        assertEquals(18, constants());
+        assertEquals(30, constantThroughLoop());
+        assertEquals(Integer.MIN_VALUE, overflow());
+    }
+
+    public static void testLoopInvariants() {
+        Point p = new Point(2, 3);
+
+        assertEquals(105, loopInvariant(p, 10));
+        assertEquals(0, loopInvariant(p, 0));
+        assertEquals(38, loopWithStore(p, 10));
+        assertEquals(9, p.x);
+        assertEquals(30, loopNullCheck(p, 10));
+        assertEquals(0, loopNullCheck(null, 0));
+
+        try {
+            loopNullCheck(null, 1);
+            fail();
+        } catch (NullPointerException e) {
+        }
+    }
+
+    public static void testVolatile() {
+        Point p = new Point(0, 0);
+
+        assertEquals(1, volatileLoads(p));
+        assertEquals(3, volatileLoads(p));
+    }
+
+    public static void testExceptionHandlers() {
+        assertEquals(9, tryCatch(new Point(5, 0), 2));
+        assertEquals(5, tryCatch(null, 2));
+    }
+
+    public static void main(String[] args) {
+        testFieldLoads();
+        testArithmetic();
+        testConstantPropagation();
+        testLoopInvariants();
+        testVolatile();
+        testExceptionHandlers();
+    }
+}
@@ -0,0 +1,110 @@
+package jvm;
+
+/**
+ * Exercises the String methods that the JIT calls as intrinsics. The
+ * strings are long enough to cover both the vectorized loops and their
+ * scalar tails, and substrings check that the offset is honoured.
+ */
+public class StringIntrinsicsTest extends TestCase {
+    private static final String LONG = "The quick brown fox jumps over the lazy dog \u1234\uabcd";
+
+    private static int hash(String s) {
+        int h = 0;
+
+        for (int i = 0; i < s.length(); i++)
+            h = 31 * h + s.charAt(i);
+
+        return h;
+    }
+
+    public static void testEquals() {
+        assertTrue("".equals(""));
+        assertTrue("abc".equals(new String("abc")));
+        assertTrue(LONG.equals(new String(LONG)));
+        assertTrue(LONG.substring(4, 9).equals("quick"));
+
+        assertFalse("abc".equals("abd"));
+        assertFalse("abc".equals("abcd"));
+        assertFalse(LONG.equals(LONG.replace('\uabcd', '\uabce')));
+        assertFalse("abc".equals(null));
+        assertFalse("abc".equals(new Object()));
+    }
+
+    public static void testCompareTo() {
+        assertEquals(0, "".compareTo(""));
+        assertEquals(0, LONG.compareTo(new String(LONG)));
+        assertEquals('c' - 'd', "abc".compareTo("abd"));
+        assertEquals(-1, "abc".compareTo("abcd"));
+        assertEquals(1, "abcd".compareTo("abc"));
+        assertEquals('q' - 'b', LONG.substring(4).compareTo(LONG.substring(10)));
+        assertEquals(0xabcd - 0xabce, LONG.compareTo(LONG.replace('\uabcd', '\uabce')));
+
+        try {
+            "abc".compareTo(null);
+            fail();
+        } catch (NullPointerException e) {
+        }
+    }
+
+    public static void testIndexOfChar() {
+        assertEquals(-1, "".indexOf('a'));
+        assertEquals(0, LONG.indexOf('T'));
+        assertEquals(4, LONG.indexOf('q'));
+        assertEquals(LONG.length() - 1, LONG.indexOf('\uabcd'));
+        assertEquals(-1, LONG.indexOf('!'));
+        assertEquals(0, LONG.substring(4).indexOf('q'));
+        assertEquals(-1, LONG.substring(5).indexOf('T'));
+        assertEquals(-1, "abc".indexOf(0x10061));
+    }
+
+    public static void testIndexOfString() {
+        assertEquals(0, "".indexOf(""));
+        assertEquals(0, LONG.indexOf(""));
+        assertEquals(4, LONG.indexOf("quick"));
+        assertEquals(40, LONG.indexOf("dog"));
+        assertEquals(LONG.length() - 2, LONG.indexOf("\u1234\uabcd"));
+        assertEquals(-1, LONG.indexOf("cat"));
+        assertEquals(-1, "ab".indexOf("abc"));
+        assertEquals(2, "aaab".indexOf("ab"));
+        assertEquals(0, LONG.substring(40).indexOf("dog"));
+
+        try {
+            "abc".indexOf((String) null);
+            fail();
+        } catch (NullPointerException e) {
+        }
+    }
+
+    public static void testHashCode() {
+        assertEquals(0, "".hashCode());
+        assertEquals(hash("abc"), "abc".hashCode());
+        assertEquals(hash(LONG), LONG.hashCode());
+        assertEquals(hash(LONG), new String(LONG).hashCode());
+        assertEquals(hash("quick"), LONG.substring(4, 9).hashCode());
+    }
+
+    public static void testNullReceiver() {
+        String s = null;
+
+        try {
+            s.hashCode();
+            fail();
+        } catch (NullPointerException e) {
+        }
+
+        try {
+            s.equals("abc");
+            fail();
+        } catch (NullPointerException e) {
+        }
+    }
+
+    public static void main(String[] args) {
+        testEquals();
+        testCompareTo();
+        testIndexOfChar();
+        testIndexOfString();
+        testHashCode();
+        testNullReceiver();
+    }
+}
@@ -133,10 +133,82 @@ class SwitchTest extends TestCase {
         assertEquals(-7, index);
     }
 
+    private static int sparseLookupswitch(int key) {
+        switch (key) {
+        case Integer.MIN_VALUE: return 1;
+        case -65536: return 2;
+        case -100: return 3;
+        case -1: return 4;
+        case 0: return 5;
+        case 7: return 6;
+        case 100: return 7;
+        case 1000: return 8;
+        case 4096: return 9;
+        case 65536: return 10;
+        case 1000000: return 11;
+        case Integer.MAX_VALUE: return 12;
+        default: return 0;
+        }
+    }
+
+    public static void testSparseLookupswitch() {
+        int[] keys = { Integer.MIN_VALUE, -65536, -100, -1, 0, 7, 100, 1000, 4096, 65536, 1000000, Integer.MAX_VALUE };
+        int[] others = { Integer.MIN_VALUE + 1, -65535, -101, -2, 1, 6, 8, 999, 4097, 65535, 1000001, Integer.MAX_VALUE - 1 };
+
+        for (int i = 0; i < keys.length; i++) {
+            assertEquals(i + 1, sparseLookupswitch(keys[i]));
+            assertEquals(0, sparseLookupswitch(others[i]));
+        }
+    }
+
+    private static int denseLookupswitch(int key) {
+        switch (key) {
+        case -3: return 1;
+        case 0: return 2;
+        case 5: return 3;
+        case 8: return 4;
+        default: return key;
+        }
+    }
+
+    public static void testDenseLookupswitch() {
+        assertEquals(1, denseLookupswitch(-3));
+        assertEquals(2, denseLookupswitch(0));
+        assertEquals(3, denseLookupswitch(5));
+        assertEquals(4, denseLookupswitch(8));
+
+        assertEquals(-4, denseLookupswitch(-4));
+        assertEquals(-2, denseLookupswitch(-2));
+        assertEquals(6, denseLookupswitch(6));
+        assertEquals(9, denseLookupswitch(9));
+    }
+
+    private static int tableswitchKeepsIndex(int key) {
+        int result;
+
+        switch (key) {
+        case 10: result = 1; break;
+        case 11: result = 2; break;
+        case 12: result = 3; break;
+        case 13: result = 4; break;
+        default: result = 0;
+        }
+
+        return result * 100 + key;
+    }
+
+    public static void testSwitchKeepsKey() {
+        assertEquals(112, tableswitchKeepsIndex(12));
+        assertEquals(9, tableswitchKeepsIndex(9));
+    }
+
     public static void main(String []args) {
         testSwitchCaseMatches();
         testSwitchDefault();
         testLookupswitchCaseMatches();
         testLookupswitchDefault();
+        testSparseLookupswitch();
+        testDenseLookupswitch();
+        testSwitchKeepsKey();
     }
 }
\ No newline at end of file
@@ -323,8 +323,13 @@ public class JNITest extends TestCase {
     }, InstantiationException.class);
   }
 
+  public static class Initialized {
+    public int value = 42;
+  }
+
   public static void testNewObject() {
     assertEquals("test", testNewObject(String.class, "(Ljava/lang/String;)V", "test"));
+    assertEquals(42, ((Initialized) testNewObject(Initialized.class, "()V", null)).value);
     assertEquals("test", testNewObject(String.class, "([C)V", "test".toCharArray()));
 
     assertThrows(new Block() {
@@ -342,6 +347,7 @@ public class JNITest extends TestCase {
 
   public static void testNewObjectA() {
     assertEquals("test", testNewObjectA(String.class, "(Ljava/lang/String;)V", "test"));
+    assertEquals(42, ((Initialized) testNewObjectA(Initialized.class, "()V", null)).value);
     assertEquals("test", testNewObjectA(String.class,  "([C)V", "test".toCharArray()));
 
     assertThrows(new Block() {
@@ -359,6 +365,7 @@ public class JNITest extends TestCase {
 
   public static void testNewObjectV() {
     assertEquals("test", testNewObjectV(String.class, "(Ljava/lang/String;)V", "test"));
+    assertEquals(42, ((Initialized) testNewObjectV(Initialized.class, "()V", null)).value);
     assertEquals("test", testNewObjectV(String.class,  "([C)V", "test".toCharArray()));
 
     assertThrows(new Block() {
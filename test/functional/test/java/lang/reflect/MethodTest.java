@@ -243,6 +243,31 @@ public class MethodTest extends TestCase {
 
     public static void throwsMethod() throws Exception {
     }
+
+    public static double mixed(byte a, int b, long c, float d, double e, String f) {
+      return a + b + c + d + e + f.length();
+    }
+
+    public static long longMirror(long x) {
+      return x;
+    }
+
+    public static double doubleMirror(double x) {
+      return x;
+    }
+
+    public static String stringMirror(String x) {
+      return x;
+    }
+
+    public long sum;
+
+    public Klass() {
+    }
+
+    public Klass(int x, long y) {
+      sum = x + y;
+    }
   }
 
   public static Object invoke(String name, Class<?> arg_class, Object arg) {
@@ -262,6 +287,58 @@ public class MethodTest extends TestCase {
     assertEquals(Character.valueOf('x'), invoke("charMirror", char.class, Character.valueOf('x')));
   }
 
+  public static void testMethodReflectionInvokeArguments() throws Exception {
+    Method m = Klass.class.getMethod("mixed", new Class[] { byte.class, int.class, long.class, float.class, double.class, String.class });
+    Object[] args = new Object[] { Byte.valueOf((byte) 1), Integer.valueOf(2), Long.valueOf(3), Float.valueOf(0.5f), Double.valueOf(0.25), "abc" };
+
+    for (int i = 0; i < 3; i++)
+      assertEquals(Double.valueOf(9.75), m.invoke(null, args));
+  }
+
+  public static void testMethodReflectionInvokeWidening() {
+    assertEquals(Long.valueOf(1), invoke("longMirror", long.class, Integer.valueOf(1)));
+    assertEquals(Long.valueOf('x'), invoke("longMirror", long.class, Character.valueOf('x')));
+    assertEquals(Long.valueOf(-1), invoke("longMirror", long.class, Short.valueOf((short) -1)));
+    assertEquals(Integer.valueOf(-2), invoke("intIncrement", int.class, Byte.valueOf((byte) -3)));
+    assertEquals(Double.valueOf(0.5), invoke("doubleMirror", double.class, Float.valueOf(0.5f)));
+    assertEquals(Double.valueOf(1L << 40), invoke("doubleMirror", double.class, Long.valueOf(1L << 40)));
+    assertNull(invoke("stringMirror", String.class, null));
+  }
+
+  private static void assertIllegalArgument(String name, Class<?> arg_class, Object[] args) throws Exception {
+    Method m = Klass.class.getMethod(name, new Class[] { arg_class });
+
+    try {
+      m.invoke(null, args);
+      fail();
+    } catch (IllegalArgumentException e) {
+    }
+  }
+
+  public static void testMethodReflectionInvokeIllegalArguments() throws Exception {
+    assertIllegalArgument("intIncrement", int.class, new Object[] { Long.valueOf(1) });
+    assertIllegalArgument("intIncrement", int.class, new Object[] { Boolean.TRUE });
+    assertIllegalArgument("intIncrement", int.class, new Object[] { "1" });
+    assertIllegalArgument("intIncrement", int.class, new Object[] { null });
+    assertIllegalArgument("intIncrement", int.class, new Object[] { });
+    assertIllegalArgument("intIncrement", int.class, null);
+    assertIllegalArgument("charMirror", char.class, new Object[] { Byte.valueOf((byte) 1) });
+    assertIllegalArgument("boolMirror", boolean.class, new Object[] { Integer.valueOf(1) });
+    assertIllegalArgument("stringMirror", String.class, new Object[] { Integer.valueOf(1) });
+    assertIllegalArgument("stringMirror", String.class, new Object[] { "a", "b" });
+  }
+
+  public static void testConstructorNewInstance() throws Exception {
+    Klass k = (Klass) Klass.class.getConstructor(new Class[] { int.class, long.class }).newInstance(new Object[] { Integer.valueOf(1), Integer.valueOf(2) });
+    assertEquals(3, k.sum);
+
+    try {
+      Klass.class.getConstructor(new Class[] { int.class, long.class }).newInstance(new Object[] { Integer.valueOf(1) });
+      fail();
+    } catch (IllegalArgumentException e) {
+    }
+  }
+
   public static void testInvokeOnInterfaceMethod() {
     A a = new A();
     Object result = null;
@@ -284,6 +361,10 @@ public class MethodTest extends TestCase {
   public static void main(String[] args) throws Exception {
     testMethodModifiers();
     testMethodReflectionInvoke();
+    testMethodReflectionInvokeArguments();
+    testMethodReflectionInvokeWidening();
+    testMethodReflectionInvokeIllegalArguments();
+    testConstructorNewInstance();
     testInvokeOnInterfaceMethod();
     testMethodGetExceptionTypes();
     testGetAnnotation();
@@ -235,6 +235,55 @@ public class UnsafeTest extends TestCase {
     public Object value;
   }
 
+  public static void testArrayCompareAndSwapInt() {
+    int[] array = new int[] { 1, 2, 3 };
+    long offset = arrayOffset(array, 1);
+
+    for (int i = 0; i < 100; i++) {
+      int value = unsafe.getIntVolatile(array, offset);
+      assertTrue(unsafe.compareAndSwapInt(array, offset, value, value + 1));
+      assertFalse(unsafe.compareAndSwapInt(array, offset, value, value + 1));
+    }
+    assertEquals(1, array[0]);
+    assertEquals(102, array[1]);
+    assertEquals(3, array[2]);
+  }
+
+  public static void testCompareAndSwapResultIgnored() throws Exception {
+    UnsafeLongObject object = new UnsafeLongObject();
+    long offset = unsafe.objectFieldOffset(UnsafeLongObject.class.getDeclaredField("value"));
+
+    unsafe.compareAndSwapLong(object, offset, 0, 1L << 40);
+    assertEquals(1L << 40, unsafe.getLongVolatile(object, offset));
+  }
+
+  public static void testUnparkBeforePark() {
+    unsafe.unpark(Thread.currentThread());
+    unsafe.park(false, 0L);
+  }
+
+  public static void testParkTimeout() {
+    unsafe.park(false, 1000000L);
+    unsafe.park(true, System.currentTimeMillis() + 1);
+    unsafe.park(true, 0L);
+  }
+
+  public static void testUnparkParkedThread() throws Exception {
+    final Thread main = Thread.currentThread();
+    final int[] done = new int[1];
+
+    Thread thread = new Thread() {
+      public void run() {
+        while (unsafe.getIntVolatile(done, arrayOffset(done, 0)) == 0)
+          unsafe.unpark(main);
+      }
+    };
+    thread.start();
+    unsafe.park(false, 0L);
+    unsafe.putIntVolatile(done, arrayOffset(done, 0), 1);
+    thread.join();
+  }
+
   public static void main(String[] args) throws Exception {
     testArrayGetIntVolatile();
     testArrayGetLongVolatile();
@@ -254,5 +303,10 @@ public class UnsafeTest extends TestCase {
     testCompareAndSwapInt();
     testCompareAndSwapLong();
     testCompareAndSwapObject();
+    testArrayCompareAndSwapInt();
+    testCompareAndSwapResultIgnored();
+    testUnparkBeforePark();
+    testParkTimeout();
+    testUnparkParkedThread();
   }
 }
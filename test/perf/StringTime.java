@@ -0,0 +1,100 @@
+public class StringTime {
+  private static final int NUM_ITERATIONS = 100000;
+
+  private static final String[] KEYS = {
+    "Host",
+    "Content-Type",
+    "Content-Length",
+    "Accept-Encoding",
+    "/api/v1/accounts/12345/transactions?from=2010-01-01&to=2010-12-31",
+  };
+
+  private static long start, stop;
+  private static int sink;
+
+  private static String[] copies() {
+    String[] result = new String[KEYS.length];
+
+    for (int i = 0; i < KEYS.length; i++)
+      result[i] = new String(KEYS[i]);
+
+    return result;
+  }
+
+  private static void report(String name) {
+    System.out.println(name + " = " + (stop - start) / (NUM_ITERATIONS * KEYS.length) + "ns");
+  }
+
+  private static void profileEquals() {
+    String[] other = copies();
+
+    start = System.nanoTime();
+    for (int i = 0; i < NUM_ITERATIONS; ++i) {
+      for (int j = 0; j < KEYS.length; ++j) {
+        if (KEYS[j].equals(other[j]))
+          sink++;
+      }
+    }
+    stop = System.nanoTime();
+    report("equals");
+  }
+
+  private static void profileCompareTo() {
+    String[] other = copies();
+
+    start = System.nanoTime();
+    for (int i = 0; i < NUM_ITERATIONS; ++i) {
+      for (int j = 0; j < KEYS.length; ++j)
+        sink += KEYS[j].compareTo(other[j]);
+    }
+    stop = System.nanoTime();
+    report("compareTo");
+  }
+
+  private static void profileIndexOfChar() {
+    start = System.nanoTime();
+    for (int i = 0; i < NUM_ITERATIONS; ++i) {
+      for (int j = 0; j < KEYS.length; ++j)
+        sink += KEYS[j].indexOf('?');
+    }
+    stop = System.nanoTime();
+    report("indexOf(char)");
+  }
+
+  private static void profileIndexOfString() {
+    start = System.nanoTime();
+    for (int i = 0; i < NUM_ITERATIONS; ++i) {
+      for (int j = 0; j < KEYS.length; ++j)
+        sink += KEYS[j].indexOf("to=");
+    }
+    stop = System.nanoTime();
+    report("indexOf(String)");
+  }
+
+  /* Fresh strings so that the cached hash code doesn't help. */
+  private static void profileHashCode() {
+    long total = 0;
+
+    for (int i = 0; i < NUM_ITERATIONS; ++i) {
+      String[] keys = copies();
+
+      start = System.nanoTime();
+      for (int j = 0; j < keys.length; ++j)
+        sink += keys[j].hashCode();
+      stop = System.nanoTime();
+
+      total += stop - start;
+    }
+    start = 0;
+    stop = total;
+    report("hashCode");
+  }
+
+  public static void main(String[] args) {
+    profileEquals();
+    profileCompareTo();
+    profileIndexOfChar();
+    profileIndexOfString();
+    profileHashCode();
+  }
+}
@@ -304,6 +304,26 @@ void test_encoding_reg_reg(void)
 	teardown();
 }
 
+void test_encoding_test_reg_reg(void)
+{
+	uint8_t encoding[] = { 0x85, 0xdb };
+	struct insn insn = { };
+
+	setup();
+
+	/* test   %ebx,%ebx */
+	insn.type			= INSN_TEST_REG_REG;
+	insn.src.reg.interval		= &reg_ebx;
+	insn.dest.reg.interval		= &reg_ebx;
+
+	insn_encode(&insn, buffer, NULL);
+
+	assert_int_equals(ARRAY_SIZE(encoding), buffer_offset(buffer));
+	assert_mem_equals(encoding, buffer_ptr(buffer), ARRAY_SIZE(encoding));
+
+	teardown();
+}
+
 void test_encoding_mem_reg(void)
 {
 	uint8_t encoding[] = { 0x8b, 0x18 };
@@ -1074,3 +1094,146 @@ void test_encoding_fstp_64_memlocal(void)
 
 	teardown();
 }
+
+void test_encoding_popcnt_reg_reg(void)
+{
+	uint8_t encoding[] = { 0xf3, 0x0f, 0xb8, 0xd8 };
+	struct insn insn = { };
+
+	setup();
+
+	/* popcnt %eax,%ebx */
+	insn.type			= INSN_POPCNT_REG_REG;
+	insn.src.reg.interval		= &reg_eax;
+	insn.dest.reg.interval		= &reg_ebx;
+
+	insn_encode(&insn, buffer, NULL);
+
+	assert_int_equals(ARRAY_SIZE(encoding), buffer_offset(buffer));
+	assert_mem_equals(encoding, buffer_ptr(buffer), ARRAY_SIZE(encoding));
+
+	teardown();
+}
+
+void test_encoding_cmovg_reg_reg(void)
+{
+	uint8_t encoding[] = { 0x0f, 0x4f, 0xd8 };
+	struct insn insn = { };
+
+	setup();
+
+	/* cmovg  %eax,%ebx */
+	insn.type			= INSN_CMOVG_REG_REG;
+	insn.src.reg.interval		= &reg_eax;
+	insn.dest.reg.interval		= &reg_ebx;
+
+	insn_encode(&insn, buffer, NULL);
+
+	assert_int_equals(ARRAY_SIZE(encoding), buffer_offset(buffer));
+	assert_mem_equals(encoding, buffer_ptr(buffer), ARRAY_SIZE(encoding));
+
+	teardown();
+}
+
+void test_encoding_bswap_reg(void)
+{
+	uint8_t encoding[] = { 0x0f, 0xcb };
+	struct insn insn = { };
+
+	setup();
+
+	/* bswap  %ebx */
+	insn.type			= INSN_BSWAP_REG;
+	insn.dest.reg.interval		= &reg_ebx;
+
+	insn_encode(&insn, buffer, NULL);
+
+	assert_int_equals(ARRAY_SIZE(encoding), buffer_offset(buffer));
+	assert_mem_equals(encoding, buffer_ptr(buffer), ARRAY_SIZE(encoding));
+
+	teardown();
+}
+
+void test_encoding_bswap_reg_high(void)
+{
+#ifdef CONFIG_X86_64
+	uint8_t encoding[] = { 0x49, 0x0f, 0xcc };
+	struct insn insn = { };
+
+	setup();
+
+	/* bswap  %r12 */
+	insn.type			= INSN_BSWAP_REG;
+	insn.dest.reg.interval		= &reg_r12;
+	insn.dest.type			= OPERAND_REG;
+
+	insn_encode(&insn, buffer, NULL);
+
+	assert_int_equals(ARRAY_SIZE(encoding), buffer_offset(buffer));
+	assert_mem_equals(encoding, buffer_ptr(buffer), ARRAY_SIZE(encoding));
+
+	teardown();
+#endif
+}
+
+void test_encoding_rol_imm_reg(void)
+{
+	uint8_t encoding[] = { 0xc1, 0xc3, 0x05 };
+	struct insn insn = { };
+
+	setup();
+
+	/* rol    $0x5,%ebx */
+	insn.type			= INSN_ROL_IMM_REG;
+	insn.src.imm			= 0x05;
+	insn.dest.reg.interval		= &reg_ebx;
+
+	insn_encode(&insn, buffer, NULL);
+
+	assert_int_equals(ARRAY_SIZE(encoding), buffer_offset(buffer));
+	assert_mem_equals(encoding, buffer_ptr(buffer), ARRAY_SIZE(encoding));
+
+	teardown();
+}
+
+void test_encoding_sqrtsd_xmm_xmm(void)
+{
+	uint8_t encoding[] = { 0xf2, 0x0f, 0x51, 0xfe };
+	struct insn insn = { };
+
+	setup();
+
+	/* sqrtsd %xmm6,%xmm7 */
+	insn.type			= INSN_SQRTSD_XMM_XMM;
+	insn.src.reg.interval		= &reg_xmm6;
+	insn.src.type			= OPERAND_REG;
+	insn.dest.reg.interval		= &reg_xmm7;
+	insn.dest.type			= OPERAND_REG;
+
+	insn_encode(&insn, buffer, NULL);
+
+	assert_int_equals(ARRAY_SIZE(encoding), buffer_offset(buffer));
+	assert_mem_equals(encoding, buffer_ptr(buffer), ARRAY_SIZE(encoding));
+
+	teardown();
+}
+
+void test_encoding_movd_xmm_reg(void)
+{
+	uint8_t encoding[] = { 0x66, 0x0f, 0x7e, 0xfb };
+	struct insn insn = { };
+
+	setup();
+
+	/* movd   %xmm7,%ebx */
+	insn.type			= INSN_MOVD_XMM_REG;
+	insn.src.reg.interval		= &reg_xmm7;
+	insn.dest.reg.interval		= &reg_ebx;
+
+	insn_encode(&insn, buffer, NULL);
+
+	assert_int_equals(ARRAY_SIZE(encoding), buffer_offset(buffer));
+	assert_mem_equals(encoding, buffer_ptr(buffer), ARRAY_SIZE(encoding));
+
+	teardown();
+}
@@ -0,0 +1,26 @@
+#include "jit/exception.h"
+#include "jit/ssa.h"
+
+#include "vm/object.h"
+
+void remove_insn(struct insn *insn)
+{
+}
+
+void exception_check(void)
+{
+}
+
+struct vm_object *vm_object_alloc_primitive_array(int type, int count)
+{
+	return NULL;
+}
+
+void vm_object_check_array(struct vm_object *obj, jsize index)
+{
+}
+
+struct insn *ssa_def_insn(struct var_info *var)
+{
+	return NULL;
+}
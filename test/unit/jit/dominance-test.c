@@ -140,3 +140,73 @@ void test_dominance(void)
 	clear_bit(expected->bits, 3);
 	assert_bitset_equals(bb7->dom_frontier, expected, bb7->dfn);
 }
+
+/*
+	public int dominance_eh()
+	{
+		int a;
+
+		try {
+			a = 1;
+		} catch (Exception e) {
+			a = 2;
+		}
+
+		return a;
+	}
+*/
+static unsigned char dominance_eh[10] = {
+	/* 0 */ OPC_ICONST_1,
+	/* 1 */ OPC_ISTORE_1,
+	/* 2 */ OPC_GOTO, 0x00, 0x06,
+	/* 5 */ OPC_ASTORE_2,
+	/* 6 */ OPC_ICONST_2,
+	/* 7 */ OPC_ISTORE_1,
+	/* 8 */ OPC_ILOAD_1,
+	/* 9 */ OPC_IRETURN,
+};
+
+static struct cafebabe_code_attribute_exception dominance_eh_table[] = {
+	{ .start_pc = 0, .end_pc = 2, .handler_pc = 5 },
+};
+
+void test_exception_handler_is_dominated_by_entry(void)
+{
+	struct basic_block *entry_bb, *handler_bb, *join_bb;
+	struct compilation_unit *cu;
+
+	struct cafebabe_method_info method_info;
+	struct vm_method method = {
+			.code_attribute.code = dominance_eh,
+			.code_attribute.code_length = ARRAY_SIZE(dominance_eh),
+			.code_attribute.exception_table = dominance_eh_table,
+			.code_attribute.exception_table_length = ARRAY_SIZE(dominance_eh_table),
+			.method = &method_info,
+	};
+
+	memset(&method_info, 0, sizeof(method_info));
+
+	cu = compilation_unit_alloc(&method);
+
+	analyze_control_flow(cu);
+
+	entry_bb = cu->entry_bb;
+	handler_bb = find_bb(cu, 5);
+	join_bb = find_bb(cu, 8);
+
+	compute_dfns(cu);
+	compute_dom(cu);
+	compute_dom_frontier(cu);
+
+	assert_true(handler_bb->is_eh);
+	assert_true(handler_bb->dfn != 0);
+
+	assert_ptr_equals(entry_bb, cu->doms[handler_bb->dfn]);
+	assert_ptr_equals(entry_bb, cu->doms[join_bb->dfn]);
+
+	assert_true(test_bit(handler_bb->dom_frontier->bits, join_bb->dfn));
+
+	assert_false(entry_bb->eh_reachable);
+	assert_true(handler_bb->eh_reachable);
+	assert_true(join_bb->eh_reachable);
+}
@@ -9,6 +9,8 @@
 #include "vm/method.h"
 #include "vm/vm.h"
 
+#include <limits.h>
+
 static struct cafebabe_method_info method_info;
 static struct vm_method method = { .method = &method_info };
 
@@ -71,3 +73,100 @@ void test_honors_fixed_interval_register_constraint_for_overlapping_intervals(vo
 
 	free_compilation_unit(cu);
 }
+
+void test_prefers_hinted_register(void)
+{
+	struct compilation_unit *cu;
+	struct var_info *v1, *v2;
+
+	cu = compilation_unit_alloc(&method);
+
+	v1 = get_fixed_var(cu, MACH_REG_R1);
+	interval_add_range(cu, v1->interval, 2, 4);
+
+	v2 = get_var(cu, J_INT);
+	interval_add_range(cu, v2->interval, 0, 2);
+	v2->interval->hint = v1->interval;
+
+	allocate_registers(cu);
+
+	assert_int_equals(MACH_REG_R1, v2->interval->reg);
+
+	free_compilation_unit(cu);
+}
+
+void test_ignores_hinted_register_that_is_not_free(void)
+{
+	struct compilation_unit *cu;
+	struct var_info *v1, *v2;
+
+	cu = compilation_unit_alloc(&method);
+
+	v1 = get_fixed_var(cu, MACH_REG_R1);
+	interval_add_range(cu, v1->interval, 1, 4);
+
+	v2 = get_var(cu, J_INT);
+	interval_add_range(cu, v2->interval, 0, 2);
+	v2->interval->hint = v1->interval;
+
+	allocate_registers(cu);
+
+	assert(v2->interval->reg != MACH_REG_R1);
+
+	free_compilation_unit(cu);
+}
+
+void test_next_use_pos_with_cached_use_positions(void)
+{
+	struct insn insns[3] = { { .lir_pos = 2 }, { .lir_pos = 6 }, { .lir_pos = 4 } };
+	struct use_position uses[3];
+	struct compilation_unit *cu;
+	struct var_info *v;
+
+	cu = compilation_unit_alloc(&method);
+
+	v = get_var(cu, J_INT);
+	interval_add_range(cu, v->interval, 0, 8);
+
+	for (unsigned int i = 0; i < 3; i++) {
+		uses[i].kind = USE_KIND_INPUT;
+		init_register(&uses[i], &insns[i], v->interval);
+	}
+
+	interval_cache_use_positions(v->interval);
+
+	assert_int_equals(2, next_use_pos(v->interval, 0));
+	assert_int_equals(4, next_use_pos(v->interval, 3));
+	assert_int_equals(4, next_use_pos(v->interval, 4));
+	assert_int_equals(6, next_use_pos(v->interval, 5));
+	assert_int_equals(LONG_MAX, next_use_pos(v->interval, 7));
+
+	interval_free_use_positions_cache(v->interval);
+
+	assert_int_equals(6, next_use_pos(v->interval, 5));
+
+	free_compilation_unit(cu);
+}
+
+void test_fills_lifetime_holes_in_large_methods(void)
+{
+	struct compilation_unit *cu;
+	struct live_range *range;
+	struct var_info *v;
+
+	cu = compilation_unit_alloc(&method);
+	cu->flags |= CU_FLAG_LARGE_METHOD;
+
+	v = get_var(cu, J_INT);
+	interval_add_range(cu, v->interval, 0, 2);
+	interval_add_range(cu, v->interval, 6, 8);
+
+	allocate_registers(cu);
+
+	range = interval_first_range(v->interval);
+	assert_int_equals(0, range->start);
+	assert_int_equals(8, range->end);
+	assert_ptr_equals(NULL, next_range(&v->interval->range_list, range));
+
+	free_compilation_unit(cu);
+}
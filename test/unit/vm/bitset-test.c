@@ -106,6 +106,29 @@ void test_bitset_sub(void)
 	free(half_set);
 }
 
+void test_bitset_intersect(void)
+{
+	struct bitset *half_set, *bitset;
+	int i;
+
+	half_set = alloc_bitset(BITSET_SIZE);
+	bitset = alloc_bitset(BITSET_SIZE);
+
+	for (i = 0; i < BITSET_SIZE/2; i++)
+		set_bit(half_set->bits, i);
+
+	for (i = 0; i < BITSET_SIZE; i += 2)
+		set_bit(bitset->bits, i);
+
+	bitset_intersect_to(half_set, bitset);
+
+	for (i = 0; i < BITSET_SIZE; i++)
+		assert_int_equals(i < BITSET_SIZE/2 && i % 2 == 0, test_bit(bitset->bits, i));
+
+	free(bitset);
+	free(half_set);
+}
+
 void test_bitset_equal(void)
 {
 	struct bitset *half_set, *ones, *zeros;
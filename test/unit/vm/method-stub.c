@@ -8,3 +8,8 @@ struct vm_method *vm_method_get_overridden(struct vm_method *vmm)
 {
 	return NULL;
 }
+
+void *vm_method_call_ptr(struct vm_method *vmm)
+{
+	return NULL;
+}
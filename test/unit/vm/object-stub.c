@@ -19,6 +19,12 @@ vm_object_alloc_string_from_c(const char *bytes)
 	return NULL;
 }
 
+struct vm_object *vm_object_alloc_array(struct vm_class *class, int count)
+{
+	NOT_IMPLEMENTED;
+	return NULL;
+}
+
 struct vm_object *new_exception(struct vm_class *class, const char *message)
 {
 	return NULL;
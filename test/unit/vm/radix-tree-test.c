@@ -67,3 +67,57 @@ void test_radix_tree_lookup_previous_in_the_same_node(void)
 
 	free_radix_tree(tree);
 }
+
+void test_radix_tree_lookup_previous_skips_empty_nodes(void)
+{
+	struct radix_tree *tree;
+	void *result;
+
+	tree = alloc_radix_tree(2, 16);
+	tree->lockless_lookup = true;
+
+	radix_tree_insert(tree, 0x0010, (void*)0xcafebabe);
+	radix_tree_insert(tree, 0x1000, (void*)0xdeadbeef);
+	radix_tree_remove(tree, 0x1000);
+
+	result = radix_tree_lookup(tree, 0x1000);
+	assert_ptr_equals(NULL, result);
+
+	result = radix_tree_lookup_prev(tree, 0x2000);
+	assert_ptr_equals((void*)0xcafebabe, result);
+
+	result = radix_tree_lookup_prev(tree, 0x1001);
+	assert_ptr_equals((void*)0xcafebabe, result);
+
+	radix_tree_insert(tree, 0x1000, (void*)0xdeadbeef);
+	result = radix_tree_lookup_prev(tree, 0x2000);
+	assert_ptr_equals((void*)0xdeadbeef, result);
+
+	free_radix_tree(tree);
+}
+
+void test_radix_tree_counts_values_below_nodes(void)
+{
+	struct radix_tree_node *node;
+	struct radix_tree *tree;
+
+	tree = alloc_radix_tree(2, 16);
+	tree->lockless_lookup = true;
+
+	radix_tree_insert(tree, 0x0010, (void*)0xcafebabe);
+	radix_tree_insert(tree, 0x1000, (void*)0xdeadbeef);
+	radix_tree_insert(tree, 0x1000, (void*)0xdeadbeef);
+
+	node = tree->root->slots[0];
+	assert_int_equals(2, node->nr_values);
+	assert_int_equals(2, tree->root->nr_values);
+
+	radix_tree_remove(tree, 0x1000);
+	radix_tree_remove(tree, 0x1000);
+	assert_int_equals(1, tree->root->nr_values);
+
+	node = node->slots[1];
+	assert_int_equals(0, node->nr_values);
+
+	free_radix_tree(tree);
+}
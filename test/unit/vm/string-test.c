@@ -60,3 +60,20 @@ void test_should_append_formatted_string_to_value(void)
 	
 	free_str(str);
 }
+
+void test_intern_returns_unique_string(void)
+{
+	struct string *str1, *str2, *str3;
+
+	init_string_intern();
+
+	assert_ptr_equals(NULL, string_intern_find("interned"));
+
+	str1 = string_intern_cstr("interned");
+	str2 = string_intern_cstrn("interned string", 8);
+	str3 = string_intern_find("interned");
+
+	assert_string_equals("interned", 8, str1);
+	assert_ptr_equals(str1, str2);
+	assert_ptr_equals(str1, str3);
+}
@@ -1,4 +1,9 @@
+#include "cafebabe/method_info.h"
+#include "cafebabe/class.h"
+
 #include "vm/method.h"
+#include "vm/class.h"
+#include "vm/opcodes.h"
 #include "vm/verifier.h"
 #include "lib/list.h"
 
@@ -323,3 +328,104 @@ void test_transition_verifier_local_var(void)
 	free_verifier_block(nextb);
 	free(chk);
 }
+
+static int verify_static_method(const char *type, unsigned char *code,
+				unsigned long code_length, uint16_t max_stack,
+				uint16_t max_locals,
+				struct cafebabe_stack_map_frame_entry *frames,
+				uint16_t nr_frames)
+{
+	struct cafebabe_method_info method = {
+		.access_flags	= CAFEBABE_METHOD_ACC_STATIC,
+	};
+	struct cafebabe_class class = {
+		.major_version	= 50,
+	};
+	struct verifier_context *vrf;
+	struct vm_class vmc = {
+		.class		= &class,
+		.name		= (char *) "Test",
+	};
+	struct vm_method vmm = {
+		.class		= &vmc,
+		.method		= &method,
+		.name		= (char *) "test",
+		.type		= (char *) type,
+	};
+	int err;
+
+	vmm.code_attribute.code			= code;
+	vmm.code_attribute.code_length		= code_length;
+	vmm.code_attribute.max_stack		= max_stack;
+	vmm.code_attribute.max_locals		= max_locals;
+	vmm.stack_map_table_attribute.stack_map_frame		= frames;
+	vmm.stack_map_table_attribute.stack_map_frame_length	= nr_frames;
+
+	vrf = alloc_verifier_context(&vmm);
+	assert_not_null(vrf);
+
+	err = verify_stack_maps(vrf);
+
+	free_verifier_context(vrf);
+
+	return err;
+}
+
+void test_stack_map_verifier_accepts_branch_with_frame(void)
+{
+	unsigned char code[] = {
+		OPC_ILOAD_0,
+		OPC_IFEQ, 0x00, 0x05,
+		OPC_ICONST_1,
+		OPC_IRETURN,
+		OPC_ICONST_2,		/* frame */
+		OPC_IRETURN,
+	};
+	struct cafebabe_stack_map_frame_entry frames[] = {
+		{ .tag = CAFEBABE_STACK_MAP_TAG_SAME_FRAME, .offset_delta = 6 },
+	};
+
+	assert_int_equals(0, verify_static_method("(I)I", code, sizeof(code), 1, 1, frames, 1));
+}
+
+void test_stack_map_verifier_rejects_branch_without_frame(void)
+{
+	unsigned char code[] = {
+		OPC_ILOAD_0,
+		OPC_IFEQ, 0x00, 0x05,
+		OPC_ICONST_1,
+		OPC_IRETURN,
+		OPC_ICONST_2,
+		OPC_IRETURN,
+	};
+
+	assert_int_equals(E_INVALID_BRANCH, verify_static_method("(I)I", code, sizeof(code), 1, 1, NULL, 0));
+}
+
+void test_stack_map_verifier_checks_types(void)
+{
+	unsigned char wrong_return[] = {
+		OPC_ICONST_0,
+		OPC_IRETURN,
+	};
+	unsigned char long_to_int[] = {
+		OPC_LCONST_0,
+		OPC_L2I,
+		OPC_IRETURN,
+	};
+	unsigned char split_long[] = {
+		OPC_LCONST_0,
+		OPC_POP,
+		OPC_POP,
+		OPC_RETURN,
+	};
+	unsigned char wrong_local[] = {
+		OPC_FLOAD_0,
+		OPC_FRETURN,
+	};
+
+	assert_int_equals(E_TYPE_CHECKING, verify_static_method("()V", wrong_return, sizeof(wrong_return), 1, 0, NULL, 0));
+	assert_int_equals(0, verify_static_method("()I", long_to_int, sizeof(long_to_int), 2, 0, NULL, 0));
+	assert_int_equals(E_TYPE_CHECKING, verify_static_method("()V", split_long, sizeof(split_long), 2, 0, NULL, 0));
+	assert_int_equals(E_TYPE_CHECKING, verify_static_method("(I)F", wrong_local, sizeof(wrong_local), 1, 1, NULL, 0));
+}
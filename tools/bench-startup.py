@@ -0,0 +1,103 @@
+#!/usr/bin/env python
+
+# Run VM startup benchmarks and report time-to-main and total wall time.
+#
+# Each benchmark is started N times with -Xlog:startup and the per-phase
+# breakdown printed by the VM is averaged over all runs.  Torture benchmarks
+# are skipped unless their jar files have been downloaded with "make torture".
+
+from __future__ import print_function
+
+import subprocess
+import argparse
+import zipfile
+import time
+import sys
+import os
+
+PERF_DIR = "test/perf"
+
+HELLO_JAR = os.path.join(PERF_DIR, "HelloWorld.jar")
+
+CLOJURE_JAR = "torture/clojure/clojure-1.1.0/clojure.jar"
+JRUBY_JAR = "torture/jruby/jruby-1.5.0.RC3/lib/jruby.jar"
+
+BENCHMARKS = [
+  #  Name          Required file  VM arguments
+  # ============== ============== ===================================================
+  ( "hello",       None,          [ "-cp", PERF_DIR, "HelloWorld" ] )
+, ( "hello-jar",   HELLO_JAR,     [ "-jar", HELLO_JAR ] )
+, ( "clojure",     CLOJURE_JAR,   [ "-cp", CLOJURE_JAR, "clojure.main", "torture/clojure/hello.clj" ] )
+, ( "jruby",       JRUBY_JAR,     [ "-jar", JRUBY_JAR, "torture/jruby/hello.rb" ] )
+]
+
+def make_hello_jar():
+  manifest = "Manifest-Version: 1.0\nMain-Class: HelloWorld\n"
+  jar = zipfile.ZipFile(HELLO_JAR, "w")
+  jar.writestr("META-INF/MANIFEST.MF", manifest)
+  jar.write(os.path.join(PERF_DIR, "HelloWorld.class"), "HelloWorld.class")
+  jar.close()
+
+def parse_startup_log(output):
+  phases = []
+  for line in output.splitlines():
+    if not line.startswith("startup: "):
+      continue
+    name, value, unit = line[len("startup: "):].rsplit(None, 2)
+    phases.append((name.strip(), float(value)))
+  return phases
+
+def run_once(java, args):
+  command = [ java, "-Xlog:startup" ] + args
+  fnull = open(os.devnull, "w")
+  start = time.time()
+  proc = subprocess.Popen(command, stdout = fnull, stderr = subprocess.PIPE)
+  _, err = proc.communicate()
+  wall = (time.time() - start) * 1000.0
+  if proc.returncode != 0:
+    return None
+  return parse_startup_log(err.decode("utf-8", "replace")), wall
+
+def report(name, runs):
+  print("%s (%d runs)" % (name, len(runs)))
+  phases = [ p for p, _ in runs[0][0] ]
+  for i, phase in enumerate(phases):
+    values = [ r[0][i][1] for r in runs ]
+    print("  %-36s %10.3f ms" % (phase, sum(values) / len(values)))
+  walls = [ wall for _, wall in runs ]
+  print("  %-36s %10.3f ms (min %.3f, max %.3f)" % ("wall", sum(walls) / len(walls), min(walls), max(walls)))
+
+def main():
+  optparser = argparse.ArgumentParser("Run Jato startup benchmarks.")
+  optparser.add_argument("-n", dest="runs", type=int, default=10,
+                         help="number of times to run each benchmark")
+  optparser.add_argument("--java", dest="java", default="./jato",
+                         help="path to the VM executable")
+  optparser.add_argument("benchmarks", nargs="*",
+                         help="benchmarks to run (default: all)")
+  opts = optparser.parse_args()
+
+  make_hello_jar()
+
+  status = 0
+  for name, required, args in BENCHMARKS:
+    if opts.benchmarks and name not in opts.benchmarks:
+      continue
+    if required and not os.path.exists(required):
+      print("%s: skipped, %s not found" % (name, required))
+      continue
+    runs = []
+    for i in range(opts.runs):
+      result = run_once(opts.java, args)
+      if result is None:
+        print("%s: FAILED" % name)
+        status = 1
+        break
+      runs.append(result)
+    else:
+      report(name, runs)
+
+  sys.exit(status)
+
+if __name__ == '__main__':
+  main()
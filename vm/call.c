@@ -32,6 +32,7 @@
 
 #include "vm/call.h"
 #include "vm/class.h"
+#include "vm/errors.h"
 #include "vm/method.h"
 #include "vm/object.h"
 #include "vm/stack-trace.h"
@@ -42,6 +43,11 @@ call_method_a(struct vm_method *method, void *target, unsigned long *args,
 {
 	struct vm_object *exception;
 
+	if (!target) {
+		throw_oom_error();
+		return;
+	}
+
 	/*
 	 * XXX: We cannot call JIT code with exception signalled
 	 * because it will be caught by the nearest exception
@@ -80,7 +86,16 @@ void vm_call_method_this_a(struct vm_method *method,
 
 	assert(args[0] == (unsigned long) this);
 
-	if (vm_class_is_interface(method->class)) {
+	/*
+	 * Constructors, private and static methods are bound statically.
+	 * Static methods and constructors have no vtable slot, and the slot of
+	 * a private method may be shared with a subclass method of the same
+	 * signature.
+	 */
+	if (vm_method_is_special(method) || vm_method_is_private(method)
+	    || vm_method_is_static(method)) {
+		target = vm_method_call_ptr(method);
+	} else if (vm_class_is_interface(method->class)) {
 		struct vm_method *vmm
 			= vm_class_get_method_recursive(this->class, method->name, method->type);
 		target = vm_method_call_ptr(vmm);
@@ -36,7 +36,10 @@
 #include "cafebabe/stream.h"
 #include "cafebabe/class.h"
 
+#include "arch/memory.h"
+
 #include "jit/exception.h"
+#include "jit/cha.h"
 #include "jit/compiler.h"
 #include "jit/vtable.h"
 #include "jit/cu-mapping.h"
@@ -90,7 +93,164 @@ trace_vtable(struct vm_class *vmc)
 }
 
 
-static void
+static inline unsigned long member_hash(const char *name, const char *type)
+{
+	unsigned long hash;
+
+	hash = ((unsigned long) name >> 3) * 31 + ((unsigned long) type >> 3);
+
+	return hash ^ (hash >> 11);
+}
+
+static unsigned int member_hash_size(unsigned int nr_members)
+{
+	unsigned int size = 4;
+
+	/* Keep the load factor at or below 0.5 */
+	while (size < nr_members * 2)
+		size <<= 1;
+
+	return size;
+}
+
+static int init_field_hash(struct vm_class *vmc)
+{
+	unsigned int size;
+
+	size = member_hash_size(vmc->nr_fields);
+
+	vmc->field_hash = vm_zalloc(sizeof(*vmc->field_hash) * size);
+	if (!vmc->field_hash)
+		return -ENOMEM;
+
+	vmc->field_hash_mask = size - 1;
+
+	for (unsigned int i = 0; i < vmc->nr_fields; ++i) {
+		struct vm_field *vmf = &vmc->fields[i];
+		unsigned long slot;
+
+		slot = member_hash(vmf->name, vmf->type) & vmc->field_hash_mask;
+
+		while (vmc->field_hash[slot]) {
+			struct vm_field *other = vmc->field_hash[slot];
+
+			/* The first declaration wins like in a linear search. */
+			if (other->name == vmf->name && other->type == vmf->type)
+				break;
+
+			slot = (slot + 1) & vmc->field_hash_mask;
+		}
+
+		if (!vmc->field_hash[slot])
+			vmc->field_hash[slot] = vmf;
+	}
+
+	return 0;
+}
+
+static int init_method_hash(struct vm_class *vmc)
+{
+	unsigned int size;
+
+	size = member_hash_size(vmc->nr_methods);
+
+	vmc->method_hash = vm_zalloc(sizeof(*vmc->method_hash) * size);
+	if (!vmc->method_hash)
+		return -ENOMEM;
+
+	vmc->method_hash_mask = size - 1;
+
+	for (unsigned int i = 0; i < vmc->nr_methods; ++i) {
+		struct vm_method *vmm = &vmc->methods[i];
+		unsigned long slot;
+
+		slot = member_hash(vmm->name, vmm->type) & vmc->method_hash_mask;
+
+		while (vmc->method_hash[slot]) {
+			struct vm_method *other = vmc->method_hash[slot];
+
+			if (other->name == vmm->name && other->type == vmm->type)
+				break;
+
+			slot = (slot + 1) & vmc->method_hash_mask;
+		}
+
+		if (!vmc->method_hash[slot])
+			vmc->method_hash[slot] = vmm;
+	}
+
+	return 0;
+}
+
+/*
+ * Looks up a field declared by @vmc. @name and @type must be interned.
+ */
+static struct vm_field *
+lookup_field(const struct vm_class *vmc, const char *name, const char *type)
+{
+	unsigned long slot;
+
+	/* Not linked yet or linking failed */
+	if (vmc->kind != VM_CLASS_KIND_REGULAR || !vmc->field_hash)
+		return NULL;
+
+	slot = member_hash(name, type) & vmc->field_hash_mask;
+
+	for (;;) {
+		struct vm_field *vmf = vmc->field_hash[slot];
+
+		if (!vmf)
+			return NULL;
+
+		if (vmf->name == name && vmf->type == type)
+			return vmf;
+
+		slot = (slot + 1) & vmc->field_hash_mask;
+	}
+}
+
+/*
+ * Looks up a method declared by @vmc. @name and @type must be interned.
+ */
+static struct vm_method *
+lookup_method(const struct vm_class *vmc, const char *name, const char *type)
+{
+	unsigned long slot;
+
+	/* Not linked yet or linking failed */
+	if (vmc->kind != VM_CLASS_KIND_REGULAR || !vmc->method_hash)
+		return NULL;
+
+	slot = member_hash(name, type) & vmc->method_hash_mask;
+
+	for (;;) {
+		struct vm_method *vmm = vmc->method_hash[slot];
+
+		if (!vmm)
+			return NULL;
+
+		if (vmm->name == name && vmm->type == type)
+			return vmm;
+
+		slot = (slot + 1) & vmc->method_hash_mask;
+	}
+}
+
+static struct vm_method *
+lookup_method_recursive(const struct vm_class *vmc, const char *name, const char *type)
+{
+	do {
+		struct vm_method *vmm = lookup_method(vmc, name, type);
+		if (vmm)
+			return vmm;
+
+		vmc = vmc->super;
+	} while (vmc);
+
+	return NULL;
+}
+
+static int
 setup_vtable(struct vm_class *vmc)
 {
 	struct vm_class *super;
@@ -108,16 +268,26 @@ setup_vtable(struct vm_class *vmc)
 		super_vtable = NULL;
 	}
 
+	/*
+	 * Static methods, constructors and class initializers are never
+	 * dispatched through the vtable so they get no slot.
+	 */
 	vtable_size = 0;
 	for (uint16_t i = 0; i < vmc->nr_methods; ++i) {
 		struct vm_method *vmm = &vmc->methods[i];
 
+		if (vm_method_is_static(vmm) || vm_method_is_special(vmm))
+			continue;
+
 		if (super) {
 			struct vm_method *vmm2
-				= vm_class_get_method_recursive(super,
+				= lookup_method_recursive(super,
 					vmm->name, vmm->type);
-			if (vmm2) {
+			if (vmm2 && !vm_method_is_static(vmm2)) {
 				vmm->virtual_index = vmm2->virtual_index;
+
+				if (method_is_virtual(vmm) && method_is_virtual(vmm2))
+					cha_method_overridden(vmm2);
 				continue;
 			}
 		}
@@ -129,6 +299,8 @@ setup_vtable(struct vm_class *vmc)
 	vmc->vtable_size = super_vtable_size + vtable_size;
 
 	vtable_init(&vmc->vtable, vmc->vtable_size);
+	if (!vmc->vtable.native_ptr && vmc->vtable_size)
+		return -ENOMEM;
 
 	/* Superclass methods */
 	for (uint16_t i = 0; i < super_vtable_size; ++i)
@@ -138,14 +310,24 @@ setup_vtable(struct vm_class *vmc)
 	/* Our methods */
 	for (uint16_t i = 0; i < vmc->nr_methods; ++i) {
 		struct vm_method *vmm = &vmc->methods[i];
+		void *target;
+
+		if (vm_method_is_static(vmm) || vm_method_is_special(vmm))
+			continue;
+
+		target = vm_method_call_ptr(vmm);
+		if (!target) {
+			vtable_release(&vmc->vtable);
+			return -ENOMEM;
+		}
 
-		vtable_setup_method(&vmc->vtable,
-				    vmm->virtual_index,
-				    vm_method_call_ptr(vmm));
+		vtable_setup_method(&vmc->vtable, vmm->virtual_index, target);
 	}
 
 	if (opt_trace_vtable)
 		trace_vtable(vmc);
+
+	return 0;
 }
 
 /*
@@ -303,11 +485,15 @@ int vm_class_link(struct vm_class *vmc, const struct cafebabe_class *class)
 	if (vm_class_link_common(vmc))
 		return -1;
 
-	if (cafebabe_class_constant_get_class(class, class->this_class, &constant_class))
+	vmc->resolved_entries = vm_zalloc(sizeof(*vmc->resolved_entries) * class->constant_pool_count);
+	if (!vmc->resolved_entries)
 		return -1;
 
+	if (cafebabe_class_constant_get_class(class, class->this_class, &constant_class))
+		goto error_free_resolved_entries;
+
 	if (cafebabe_class_constant_get_utf8(class, constant_class->name_index, &name))
-		return -1;
+		goto error_free_resolved_entries;
 
 	vmc->name = strndup((char *) name->bytes, name->length);
 
@@ -380,6 +566,9 @@ int vm_class_link(struct vm_class *vmc, const struct cafebabe_class *class)
 			goto error_free_fields;
 	}
 
+	if (init_field_hash(vmc))
+		goto error_free_fields;
+
 	if (vmc->super) {
 		vmc->static_size = vmc->super->static_size;
 		vmc->object_size = vmc->super->object_size;
@@ -496,22 +685,29 @@ int vm_class_link(struct vm_class *vmc, const struct cafebabe_class *class)
 			goto error_free_methods;
 	}
 
+	if (init_method_hash(vmc))
+		goto error_free_methods;
+
+	/*
+	 * Compilation units and trampolines are created lazily by
+	 * vm_method_ensure_jit() when a method is first resolved or invoked.
+	 */
 	for (uint16_t i = 0; i < vmc->nr_methods; ++i) {
 		struct vm_method *vmm = &vmc->methods[i];
 
 		vmm->itable_index = itable_hash(vmm);
-
-		if (vm_method_prepare_jit(vmm))
-			goto error_free_methods;
 	}
 
 	array_destroy(&extra_methods);
 
 	if (!vm_class_is_interface(vmc)) {
-		setup_vtable(vmc);
+		if (setup_vtable(vmc))
+			goto error_free_methods;
 
-		if (!vm_class_is_abstract(vmc))
-			vm_itable_setup(vmc);
+		if (!vm_class_is_abstract(vmc) && vm_itable_setup(vmc)) {
+			vtable_release(&vmc->vtable);
+			goto error_free_methods;
+		}
 	}
 
 	INIT_LIST_HEAD(&vmc->static_fixup_site_list);
@@ -520,7 +716,7 @@ int vm_class_link(struct vm_class *vmc, const struct cafebabe_class *class)
 
 	memset(&inner_classes_attribute, 0, sizeof(inner_classes_attribute));
 	if (cafebabe_read_inner_classes_attribute(class, &class->attributes, &inner_classes_attribute))
-		return -1;
+		goto error_free_methods;
 
 	nr_inner_classes = 0;
 	for (unsigned int i = 0; i < inner_classes_attribute.number_of_classes; i++) {
@@ -582,6 +778,8 @@ error_free_annotations:
 	}
 	vm_free(vmc->annotations);
 error_free_methods:
+	vm_free(vmc->method_hash);
+	vmc->method_hash = NULL;
 	vm_free(vmc->methods);
 error_free_inner_classes:
 	vm_free(vmc->inner_classes);
@@ -590,11 +788,16 @@ error_free_static_values:
 error_free_buckets:
 	free_buckets(2, VM_TYPE_MAX, field_buckets);
 error_free_fields:
+	vm_free(vmc->field_hash);
+	vmc->field_hash = NULL;
 	vm_free(vmc->fields);
 error_free_interfaces:
 	free(vmc->interfaces);
 error_free_name:
 	free(vmc->name);
+error_free_resolved_entries:
+	vm_free(vmc->resolved_entries);
+	vmc->resolved_entries = NULL;
 
 	return -1;
 }
@@ -692,6 +895,21 @@ int vm_class_ensure_object(struct vm_class *vmc)
 	return 0;
 }
 
+/*
+ * Returns true if @vmc has been initialized. Compiled code can then skip
+ * the initialization checks that allocations and static accesses do.
+ */
+bool vm_class_is_initialized(struct vm_class *vmc)
+{
+	enum vm_class_state state;
+
+	vm_object_lock(vmc->object);
+	state = vmc->state;
+	vm_object_unlock(vmc->object);
+
+	return state == VM_CLASS_INITIALIZED;
+}
+
 int vm_class_init(struct vm_class *vmc)
 {
 	struct vm_object *exception;
@@ -745,6 +963,11 @@ int vm_class_init(struct vm_class *vmc)
 			void (*clinit_trampoline)(void)
 				= vm_method_trampoline_ptr(&vmc->methods[i]);
 
+			if (!clinit_trampoline) {
+				throw_oom_error();
+				goto error;
+			}
+
 			clinit_trampoline();
 			if (exception_occurred())
 				goto error;
@@ -778,9 +1001,46 @@ int vm_class_init(struct vm_class *vmc)
 	return -1;
 }
 
+/*
+ * Resolved constant pool entries are published with release semantics so
+ * that a reader that sees a non-NULL slot also sees the fully initialized
+ * object it points to. Two threads may race to resolve the same entry but
+ * they always store the same pointer.
+ */
+static void *get_resolved_entry(const struct vm_class *vmc, uint16_t i,
+				enum cafebabe_constant_tag tag)
+{
+	void *entry;
+
+	if (i >= vmc->class->constant_pool_count)
+		return NULL;
+
+	if (vmc->class->constant_pool[i].tag != tag)
+		return NULL;
+
+	entry = vmc->resolved_entries[i];
+
+	/* Pairs with smp_wmb() in set_resolved_entry() */
+	smp_rmb();
+
+	return entry;
+}
+
+static void set_resolved_entry(const struct vm_class *vmc, uint16_t i, void *entry)
+{
+	smp_wmb();
+
+	vmc->resolved_entries[i] = entry;
+}
+
 struct vm_class *vm_class_resolve_class(const struct vm_class *vmc, uint16_t i)
 {
 	const struct cafebabe_constant_info_class *constant_class;
+	struct vm_class *cached;
+
+	cached = get_resolved_entry(vmc, i, CAFEBABE_CONSTANT_TAG_CLASS);
+	if (cached)
+		return cached;
 
 	if (cafebabe_class_constant_get_class(vmc->class, i, &constant_class))
 		return NULL;
@@ -806,6 +1066,8 @@ struct vm_class *vm_class_resolve_class(const struct vm_class *vmc, uint16_t i)
 		warn("failed to load class %s", class_name_str);
 		goto out;
 	}
+
+	set_resolved_entry(vmc, i, class);
 out:
 	free(class_name_str);
 	return class;
@@ -872,27 +1134,34 @@ int vm_class_resolve_field(const struct vm_class *vmc, uint16_t i,
 struct vm_field *vm_class_get_field(const struct vm_class *vmc,
 	const char *name, const char *type)
 {
+	struct string *name_str, *type_str;
+
 	if (vmc->kind != VM_CLASS_KIND_REGULAR)
 		return NULL;
 
-	unsigned int index = 0;
-	if (!cafebabe_class_get_field(vmc->class, name, type, &index))
-		return &vmc->fields[index];
+	/* A name that was never interned can't match any member. */
+	name_str = string_intern_find(name);
+	if (!name_str)
+		return NULL;
 
-	return NULL;
+	type_str = string_intern_find(type);
+	if (!type_str)
+		return NULL;
+
+	return lookup_field(vmc, name_str->value, type_str->value);
 }
 
-struct vm_field *vm_class_get_field_recursive(const struct vm_class *vmc,
+static struct vm_field *lookup_field_recursive(const struct vm_class *vmc,
 	const char *name, const char *type)
 {
 	/* See JVM Spec, 2nd ed., 5.4.3.2 "Field Resolution" */
 	do {
-		struct vm_field *vmf = vm_class_get_field(vmc, name, type);
+		struct vm_field *vmf = lookup_field(vmc, name, type);
 		if (vmf)
 			return vmf;
 
 		for (unsigned int i = 0; i < vmc->nr_interfaces; ++i) {
-			vmf = vm_class_get_field_recursive(
+			vmf = lookup_field_recursive(
 				vmc->interfaces[i], name, type);
 			if (vmf)
 				return vmf;
@@ -904,6 +1173,22 @@ struct vm_field *vm_class_get_field_recursive(const struct vm_class *vmc,
 	return NULL;
 }
 
+struct vm_field *vm_class_get_field_recursive(const struct vm_class *vmc,
+	const char *name, const char *type)
+{
+	struct string *name_str, *type_str;
+
+	name_str = string_intern_find(name);
+	if (!name_str)
+		return NULL;
+
+	type_str = string_intern_find(type);
+	if (!type_str)
+		return NULL;
+
+	return lookup_field_recursive(vmc, name_str->value, type_str->value);
+}
+
 struct vm_field *
 vm_class_resolve_field_recursive(const struct vm_class *vmc, uint16_t i)
 {
@@ -912,12 +1197,18 @@ vm_class_resolve_field_recursive(const struct vm_class *vmc, uint16_t i)
 	char *type;
 	struct vm_field *result;
 
+	result = get_resolved_entry(vmc, i, CAFEBABE_CONSTANT_TAG_FIELD_REF);
+	if (result)
+		return result;
+
 	if (vm_class_resolve_field(vmc, i, &class, &name, &type)) {
 		NOT_IMPLEMENTED;
 		return NULL;
 	}
 
 	result = vm_class_get_field_recursive(class, name, type);
+	if (result)
+		set_resolved_entry(vmc, i, result);
 
 	free(name);
 	free(type);
@@ -990,42 +1281,47 @@ int vm_class_resolve_method(const struct vm_class *vmc, uint16_t i,
 struct vm_method *vm_class_get_method(const struct vm_class *vmc,
 	const char *name, const char *type)
 {
+	struct string *name_str, *type_str;
+
 	if (vmc->kind != VM_CLASS_KIND_REGULAR)
 		return NULL;
 
-	for (unsigned int i = 0; i < vmc->nr_methods; ++i) {
-		struct vm_method *vmm = &vmc->methods[i];
+	name_str = string_intern_find(name);
+	if (!name_str)
+		return NULL;
 
-		if (!strcmp(vmm->name, name) && !strcmp(vmm->type, type))
-			return vmm;
-	}
+	type_str = string_intern_find(type);
+	if (!type_str)
+		return NULL;
 
-	return NULL;
+	return lookup_method(vmc, name_str->value, type_str->value);
 }
 
 struct vm_method *vm_class_get_method_recursive(const struct vm_class *vmc,
 	const char *name, const char *type)
 {
-	do {
-		struct vm_method *vmf = vm_class_get_method(vmc, name, type);
-		if (vmf)
-			return vmf;
+	struct string *name_str, *type_str;
 
-		vmc = vmc->super;
-	} while(vmc);
+	name_str = string_intern_find(name);
+	if (!name_str)
+		return NULL;
 
-	return NULL;
+	type_str = string_intern_find(type);
+	if (!type_str)
+		return NULL;
+
+	return lookup_method_recursive(vmc, name_str->value, type_str->value);
 }
 
-static struct vm_method *vm_class_get_interface_method_recursive(
+static struct vm_method *lookup_interface_method_recursive(
 	const struct vm_class *vmc, const char *name, const char *type)
 {
-	struct vm_method *vmm = vm_class_get_method(vmc, name, type);
+	struct vm_method *vmm = lookup_method(vmc, name, type);
 	if (vmm)
 		return vmm;
 
 	for (unsigned int i = 0; i < vmc->nr_interfaces; ++i) {
-		vmm = vm_class_get_interface_method_recursive(
+		vmm = lookup_interface_method_recursive(
 			vmc->interfaces[i], name, type);
 		if (vmm)
 			return vmm;
@@ -1034,6 +1330,22 @@ static struct vm_method *vm_class_get_interface_method_recursive(
 	return NULL;
 }
 
+static struct vm_method *vm_class_get_interface_method_recursive(
+	const struct vm_class *vmc, const char *name, const char *type)
+{
+	struct string *name_str, *type_str;
+
+	name_str = string_intern_find(name);
+	if (!name_str)
+		return NULL;
+
+	type_str = string_intern_find(type);
+	if (!type_str)
+		return NULL;
+
+	return lookup_interface_method_recursive(vmc, name_str->value, type_str->value);
+}
+
 int vm_class_resolve_interface_method(const struct vm_class *vmc, uint16_t i,
 	struct vm_class **r_vmc, char **r_name, char **r_type)
 {
@@ -1098,6 +1410,8 @@ static struct vm_method *
 missing_method(struct vm_class *vmc, char *name, char *type, uint16_t access_flags)
 {
 	struct cafebabe_method_info *method;
+	struct string *name_str;
+	struct string *type_str;
 	struct vm_method *vmm;
 
 	method		= vm_alloc(sizeof *method);
@@ -1112,25 +1426,24 @@ missing_method(struct vm_class *vmc, char *name, char *type, uint16_t access_fla
 
 	vmm->class	= vmc;
 
-	vmm->name	= strdup(name);
-	if (!vmm->name)
+	name_str	= string_intern_cstr(name);
+	if (!name_str)
 		goto error_free_vmm;
 
-	vmm->type	= strdup(type);
-	if (!vmm->type)
-		goto error_free_name;
+	type_str	= string_intern_cstr(type);
+	if (!type_str)
+		goto error_free_vmm;
 
+	vmm->name	= name_str->value;
+	vmm->type	= type_str->value;
 	vmm->method	= method;
+	vmm->flags	= VM_METHOD_FLAG_MISSING;
 
 	if (vm_method_do_init(vmm))
-		goto error_free_type;
+		goto error_free_vmm;
 
 	return vmm;
 
-error_free_type:
-	free(vmm->type);
-error_free_name:
-	free(vmm->name);
 error_free_vmm:
 	free(vmm);
 error_free_method:
@@ -1147,13 +1460,23 @@ vm_class_resolve_method_recursive(const struct vm_class *vmc, uint16_t i, uint16
 	char *name;
 	char *type;
 
+	result = get_resolved_entry(vmc, i, CAFEBABE_CONSTANT_TAG_METHOD_REF);
+	if (result)
+		return result;
+
 	if (vm_class_resolve_method(vmc, i, &class, &name, &type)) {
 		NOT_IMPLEMENTED;
 		return NULL;
 	}
 
+	/*
+	 * The stub for a missing method carries the access flags of the call
+	 * site that asked for it so it is not cached for other call kinds.
+	 */
 	result = vm_class_get_method_recursive(class, name, type);
-	if (!result)
+	if (result)
+		set_resolved_entry(vmc, i, result);
+	else
 		result = missing_method(class, name, type, access_flags);
 
 	free(name);
@@ -1171,12 +1494,18 @@ vm_class_resolve_interface_method_recursive(const struct vm_class *vmc,
 	char *type;
 	struct vm_method *result;
 
+	result = get_resolved_entry(vmc, i, CAFEBABE_CONSTANT_TAG_INTERFACE_METHOD_REF);
+	if (result)
+		return result;
+
 	if (vm_class_resolve_interface_method(vmc, i, &class, &name, &type)) {
 		NOT_IMPLEMENTED;
 		return NULL;
 	}
 
 	result = vm_class_get_interface_method_recursive(class, name, type);
+	if (result)
+		set_resolved_entry(vmc, i, result);
 
 	free(name);
 	free(type);
@@ -12,6 +12,7 @@
 #include "vm/method.h"
 #include "vm/object.h"
 #include "vm/stdlib.h"
+#include "vm/utf8.h"
 #include "vm/annotation.h"
 
 int vm_field_init(struct vm_field *vmf,
@@ -34,7 +35,7 @@ int vm_field_init(struct vm_field *vmf,
 		return -1;
 	}
 
-	vmf->name = strndup((char *) name->bytes, name->length);
+	vmf->name = utf8_intern(name);
 	if (!vmf->name) {
 		NOT_IMPLEMENTED;
 		return -1;
@@ -48,7 +49,7 @@ int vm_field_init(struct vm_field *vmf,
 		return -1;
 	}
 
-	vmf->type = strndup((char *) type->bytes, type->length);
+	vmf->type = utf8_intern(type);
 	if (!vmf->type)
 		return -ENOMEM;
 
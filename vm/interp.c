@@ -27,9 +27,11 @@
 #include "vm/interp.h"
 
 #include "cafebabe/code_attribute.h"
+#include "jit/compilation-unit.h"
 #include "vm/method.h"
 
 #include <assert.h>
+#include <pthread.h>
 #include <stdio.h>
 
 enum interp_status {
@@ -253,7 +255,20 @@ static enum interp_status interp(uint8_t opc)
 
 void vm_interp_method_v(struct vm_method *method, va_list args, union jvalue *result)
 {
+	struct compilation_unit *cu;
 	uint32_t pc;
+	int err;
+
+	if (vm_method_ensure_jit(method))
+		return;
+
+	/* Serialize with the compiler, see vm_method_load_code() */
+	cu = method->compilation_unit;
+	pthread_mutex_lock(&cu->compile_mutex);
+	err = vm_method_load_code(method);
+	pthread_mutex_unlock(&cu->compile_mutex);
+	if (err)
+		return;
 
 	pc = 0;
 	while (pc < method->code_attribute.code_length) {
@@ -212,6 +212,8 @@ static void trace_itable(struct vm_class *vmc, struct list_head *itable)
 
 int vm_itable_setup(struct vm_class *vmc)
 {
+	int err = 0;
+
 	/* We need a temporary array of lists for storing multiple results.
 	 * The final itable (the one that gets stored in the class struct
 	 * itself) will only have one method per slot. */
@@ -247,6 +249,8 @@ int vm_itable_setup(struct vm_class *vmc)
 	for (unsigned int i = 0; i < VM_ITABLE_SIZE; ++i) {
 		vmc->itable[i]
 			= itable_create_conflict_resolver(vmc, &itable[i]);
+		if (!vmc->itable[i])
+			err = -ENOMEM;
 	}
 
 	/* Free the temporary itable */
@@ -258,5 +262,5 @@ int vm_itable_setup(struct vm_class *vmc)
 	}
 
 	free(itable);
-	return 0;
+	return err;
 }
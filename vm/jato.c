@@ -54,10 +54,14 @@
 #include "runtime/runtime.h"
 
 #include "jit/compiler.h"
+#include "jit/compile-stats.h"
 #include "jit/cu-mapping.h"
 #include "jit/gdb.h"
 #include "jit/exception.h"
 #include "jit/inline-cache.h"
+#include "jit/intrinsics.h"
+#include "jit/inline.h"
+#include "jit/cha.h"
 #include "jit/perf-map.h"
 #include "jit/debug.h"
 #include "jit/text.h"
@@ -80,6 +84,7 @@
 #include "vm/object.h"
 #include "vm/reference.h"
 #include "vm/signal.h"
+#include "vm/startup.h"
 #include "vm/static.h"
 #include "vm/string.h"
 #include "vm/system.h"
@@ -94,6 +99,7 @@
 #include "vm/java-version.h"
 
 #include "arch/init.h"
+#include "arch/string.h"
 
 #include "runtime/gnu_java_lang_management_VMThreadMXBeanImpl.h"
 #include "runtime/java_lang_reflect_VMMethod.h"
@@ -131,6 +137,9 @@ bool running_on_valgrind;
 
 static void vm_atexit(void)
 {
+	startup_log_exit();
+	compile_stats_exit();
+
 	classloader_destroy();
 }
 
@@ -155,6 +164,8 @@ static void vm_properties_set_property(struct vm_object *p,
 
 	trampoline
 		= vm_method_trampoline_ptr(vm_java_util_Properties_setProperty);
+	if (!trampoline)
+		die("out of memory");
 
 	struct vm_object *key_obj = vm_object_alloc_string_from_c(key);
 	struct vm_object *value_obj = vm_object_alloc_string_from_c(value);
@@ -589,7 +600,11 @@ static void jit_init_natives(void)
 	"  -version	   print out version number and copyright information\n"	\
 	"\n"										\
 	"  -Xint           operate in interpreter-only mode\n"				\
-	"  -XX:+PrintCompilation Print a message when a method is compiled\n"
+	"  -Xlog:startup   print time spent in each VM startup phase\n"		\
+	"  -Xlog:compile   print time spent in each JIT compiler phase\n"		\
+	"  -Xverify:all    parse and verify all methods when their class is linked\n" \
+	"  -XX:+PrintCompilation Print a message when a method is compiled\n"	\
+	"  -XX:+OmitStackTraceInFastThrow reuse preallocated implicit exceptions at hot throw sites\n"
 
 static void usage(FILE *f, int retval)
 {
@@ -723,6 +738,21 @@ static void handle_no_ic(void)
 	opt_ic_enabled  = false;
 }
 
+static void handle_no_inline(void)
+{
+	opt_inline_enabled = false;
+}
+
+static void handle_no_cha(void)
+{
+	opt_cha_enabled = false;
+}
+
+static void handle_no_intrinsics(void)
+{
+	opt_intrinsics_enabled = false;
+}
+
 static void handle_int(void)
 {
 	opt_interp_only  = true;
@@ -832,6 +862,12 @@ static void handle_trace_bytecode(void)
 	opt_trace_compile = true;
 }
 
+static void handle_trace_peephole(void)
+{
+	opt_trace_peephole = true;
+	opt_trace_compile = true;
+}
+
 static void handle_trace_trampoline(void)
 {
 	opt_trace_magic_trampoline = true;
@@ -891,11 +927,43 @@ static void handle_thread_stack_size(const char *arg)
 	/* Ignore */
 }
 
+static void handle_large_method_size(const char *arg)
+{
+	char *end;
+
+	opt_large_method_size = strtoul(arg, &end, 10);
+
+	if (*arg == '\0' || *end != '\0') {
+		fprintf(stderr, "%s: unparseable method size '%s'\n", program_name, arg);
+		usage(stderr, EXIT_FAILURE);
+	}
+}
+
 static void handle_print_compilation(void)
 {
 	opt_print_compilation = true;
 }
 
+static void handle_fast_throw(void)
+{
+	opt_fast_throw = true;
+}
+
+static void handle_log_startup(void)
+{
+	opt_log_startup = true;
+}
+
+static void handle_log_compile(void)
+{
+	opt_log_compile = true;
+}
+
+static void handle_verify_all(void)
+{
+	opt_verify_all = true;
+}
+
 struct option {
 	const char *name;
 
@@ -932,8 +1000,15 @@ const struct option options[] = {
 	DEFINE_OPTION("Xperf",			handle_perf),
 	DEFINE_OPTION("Xssa",			handle_ssa),
 	DEFINE_OPTION("Xnoic",			handle_no_ic),
+	DEFINE_OPTION("Xnoinline",		handle_no_inline),
+	DEFINE_OPTION("Xnocha",			handle_no_cha),
+	DEFINE_OPTION("Xnointrinsics",		handle_no_intrinsics),
 	DEFINE_OPTION("Xint",			handle_int),
 
+	DEFINE_OPTION("Xlog:startup",		handle_log_startup),
+	DEFINE_OPTION("Xlog:compile",		handle_log_compile),
+	DEFINE_OPTION("Xverify:all",		handle_verify_all),
+
 	DEFINE_OPTION("Xdebug:stack",		handle_debug_stack),
 	DEFINE_OPTION("Xtrace:asm",		handle_trace_asm),
 	DEFINE_OPTION("Xtrace:bytecode",	handle_trace_bytecode),
@@ -946,6 +1021,7 @@ const struct option options[] = {
 	DEFINE_OPTION("Xtrace:itable",		handle_trace_itable),
 	DEFINE_OPTION("Xtrace:jit",		handle_trace_jit),
 	DEFINE_OPTION("Xtrace:liveness",	handle_trace_liveness),
+	DEFINE_OPTION("Xtrace:peephole",	handle_trace_peephole),
 	DEFINE_OPTION("Xtrace:trampoline",	handle_trace_trampoline),
 	DEFINE_OPTION("Xtrace:verifier",	handle_trace_verifier),
 	DEFINE_OPTION("Xtrace:vtable",		handle_trace_vtable),
@@ -961,8 +1037,10 @@ const struct option options[] = {
 	DEFINE_OPTION_ADJACENT_ARG("D",		handle_define),
 	DEFINE_OPTION_ADJACENT_ARG("Xmx",	handle_max_heap_size),
 	DEFINE_OPTION_ADJACENT_ARG("Xss",	handle_thread_stack_size),
+	DEFINE_OPTION_ADJACENT_ARG("Xlarge-method:",	handle_large_method_size),
 
 	DEFINE_OPTION("XX:+PrintCompilation",	handle_print_compilation),
+	DEFINE_OPTION("XX:+OmitStackTraceInFastThrow",	handle_fast_throw),
 };
 
 static const struct option *get_option(const char *name)
@@ -1084,12 +1162,17 @@ do_main_class(void)
 		array_set_field_object(args, i, arg);
 	}
 
+	startup_enter_main();
+
 	if (opt_interp_only) {
 		vm_interp_method(vmm, args);
 	} else {
 		void (*java_main)(void *);
 
 		java_main = vm_method_trampoline_ptr(vmm);
+		if (!java_main)
+			die("out of memory");
+
 		java_main(args);
 	}
 
@@ -1180,6 +1263,9 @@ int
 main(int argc, char *argv[])
 {
 	int status = EXIT_FAILURE;
+	uint64_t start;
+
+	startup_log_init();
 
 	program_name = argv[0];
 
@@ -1197,6 +1283,7 @@ main(int argc, char *argv[])
 	}
 
 	arch_init();
+	arch_init_string_ops();
 	init_string_intern();
 	init_literals_hash_map();
 	init_system_properties();
@@ -1206,11 +1293,16 @@ main(int argc, char *argv[])
 	if (dump_maps)
 		print_proc_maps();
 
+	start = startup_clock();
 	gc_init();
+	startup_phase_end(STARTUP_PHASE_GC_INIT, start);
+
 	init_exec_env();
 	vm_reference_init();
 
+	start = startup_clock();
 	classloader_init();
+	startup_phase_end(STARTUP_PHASE_CLASSLOADER_INIT, start);
 
 	init_vm_objects();
 
@@ -1230,21 +1322,28 @@ main(int argc, char *argv[])
 	static_fixup_init();
 	vm_jni_init();
 
+	start = startup_clock();
 	if (!init_classpath()) {
 		fprintf(stderr, "Unable to locate GNU Classpath. Please specify 'java.boot.class.path' and 'java.library.path' manually.\n");
 		exit(EXIT_FAILURE);
 	}
+	startup_phase_end(STARTUP_PHASE_INIT_CLASSPATH, start);
 
+	start = startup_clock();
 	if (preload_vm_classes()) {
 		fprintf(stderr, "Unable to preload system classes\n");
 		exit(EXIT_FAILURE);
 	}
+	startup_phase_end(STARTUP_PHASE_PRELOAD_VM_CLASSES, start);
 
 	init_stack_trace_printing();
+
+	start = startup_clock();
 	if (init_threading()) {
 		fprintf(stderr, "could not initialize threading\n");
 		goto out_check_exception;
 	}
+	startup_phase_end(STARTUP_PHASE_INIT_THREADING, start);
 
 	switch (operation) {
 	case OPERATION_MAIN_CLASS:
@@ -10,9 +10,11 @@
 
 #include "vm/annotation.h"
 #include "vm/verifier.h"
+#include "vm/errors.h"
 #include "vm/natives.h"
 #include "vm/method.h"
 #include "vm/class.h"
+#include "vm/utf8.h"
 #include "vm/die.h"
 
 #include "jit/compilation-unit.h"
@@ -20,6 +22,9 @@
 #include "jit/args.h"
 #include "jit/gdb.h"
 
+#include "arch/memory.h"
+
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -50,9 +55,10 @@ struct vm_method *vm_method_get_overridden(struct vm_method *vmm)
 	if (!super)
 		return NULL;
 
+	/* Method names and types are interned so pointers can be compared. */
 	for (i = 0; i < super->nr_methods; i++) {
-		if (!strcmp(super->methods[i].name, vmm->name)
-			&& !strcmp(super->methods[i].type, vmm->type))
+		if (super->methods[i].name == vmm->name
+			&& super->methods[i].type == vmm->type)
 			return &super->methods[i];
 	}
 
@@ -102,6 +108,24 @@ int vm_method_do_init(struct vm_method *vmm)
 	return 0;
 }
 
+static int read_code_header(struct vm_method *vmm)
+{
+	const struct cafebabe_attribute_info *attribute = vmm->code_attribute_info;
+	struct cafebabe_stream stream;
+	int err;
+
+	cafebabe_stream_open_buffer(&stream,
+		attribute->info, attribute->attribute_length);
+
+	err = cafebabe_stream_read_uint16(&stream, &vmm->code_attribute.max_stack);
+	if (!err)
+		err = cafebabe_stream_read_uint16(&stream, &vmm->code_attribute.max_locals);
+
+	cafebabe_stream_close_buffer(&stream);
+
+	return err;
+}
+
 int vm_method_init(struct vm_method *vmm,
 	struct vm_class *vmc, unsigned int method_index)
 {
@@ -114,25 +138,31 @@ int vm_method_init(struct vm_method *vmm,
 	vmm->method = method;
 	vmm->flags = 0;
 	vmm->annotation_initialized = false;
+	vmm->code_attribute_info = NULL;
+	vmm->code_loaded = false;
+	vmm->code_load_error = NULL;
+	vmm->overridden = false;
+	vmm->cha_dependents = NULL;
+	vmm->reflection_invoker = NULL;
 
 	const struct cafebabe_constant_info_utf8 *name;
 	if (cafebabe_class_constant_get_utf8(class, method->name_index, &name))
 		return -1;
 
-	vmm->name = strndup((char *) name->bytes, name->length);
+	vmm->name = utf8_intern(name);
 	if (!vmm->name)
 		return -1;
 
 	const struct cafebabe_constant_info_utf8 *type;
 	if (cafebabe_class_constant_get_utf8(class, method->descriptor_index, &type))
-		goto error_free_name;
+		return -1;
 
-	vmm->type = strndup((char *) type->bytes, type->length);
+	vmm->type = utf8_intern(type);
 	if (!vmm->type)
-		goto error_free_name;
+		return -1;
 
 	if (vm_method_do_init(vmm))
-		goto error_free_type;
+		return -1;
 
 	/*
 	 * Note: We can return here because the rest of the function deals
@@ -145,43 +175,101 @@ int vm_method_init(struct vm_method *vmm,
 
 	unsigned int code_index = 0;
 	if (cafebabe_attribute_array_get(&method->attributes, "Code", class, &code_index))
-		goto error_free_type;
+		return -1;
 
 	/* There must be only one "Code" attribute for the method! */
 	unsigned int code_index2 = code_index + 1;
 	if (!cafebabe_attribute_array_get(&method->attributes, "Code", class, &code_index2))
-		goto error_free_type;
+		return -1;
+
+	vmm->code_attribute_info = &method->attributes.array[code_index];
+
+	/*
+	 * The rest of the code attribute is parsed and verified when the
+	 * method is compiled for the first time. The compilation unit needs
+	 * max_locals before that so read the fixed size header here.
+	 */
+	if (read_code_header(vmm))
+		return -1;
+
+	if (cafebabe_read_exceptions_attribute(class, &method->attributes, &vmm->exceptions_attribute))
+		return -1;
 
-	const struct cafebabe_attribute_info *attribute
-		= &method->attributes.array[code_index];
+	if (opt_verify_all)
+		return vm_method_load_code(vmm);
+
+	return 0;
+}
 
+/*
+ * Parses the code attribute of a method and verifies the bytecode. This is
+ * done lazily because most methods of a loaded class are never invoked.
+ * Called with the compilation unit's compile_mutex held, or while the class
+ * is being linked. A failure is remembered and signalled again on later
+ * calls instead of parsing the code attribute again.
+ */
+int vm_method_load_code(struct vm_method *vmm)
+{
+	const struct cafebabe_class *class = vmm->class->class;
 	struct cafebabe_stream stream;
-	cafebabe_stream_open_buffer(&stream,
-		attribute->info, attribute->attribute_length);
+	struct vm_object *exception;
+	int err;
+
+	if (vmm->code_loaded || !vmm->code_attribute_info)
+		return 0;
 
-	if (cafebabe_code_attribute_init(&vmm->code_attribute, &stream))
-		goto error_free_type;
+	if (vmm->code_load_error) {
+		signal_new_exception(vmm->code_load_error, "%s.%s%s",
+			vmm->class->name, vmm->name, vmm->type);
+		return -1;
+	}
 
-	if (vm_method_verify(vmm))
-		goto error_free_type;
+	cafebabe_stream_open_buffer(&stream,
+		vmm->code_attribute_info->info,
+		vmm->code_attribute_info->attribute_length);
+
+	err = cafebabe_code_attribute_init(&vmm->code_attribute, &stream);
 
 	cafebabe_stream_close_buffer(&stream);
 
-	if (cafebabe_read_exceptions_attribute(class, &method->attributes, &vmm->exceptions_attribute))
-		goto error_free_type;
+	if (err)
+		goto error_class_format;
+
+	if (cafebabe_read_stack_map_table_attribute(class, &vmm->code_attribute.attributes, &vmm->stack_map_table_attribute))
+		goto error_class_format_free_code;
 
 	if (cafebabe_read_line_number_table_attribute(class, &vmm->code_attribute.attributes, &vmm->line_number_table_attribute))
-		goto error_free_type;
+		goto error_class_format_free_stack_map;
 
-	if (cafebabe_read_stack_map_table_attribute(class, &vmm->code_attribute.attributes, &vmm->stack_map_table_attribute))
-		goto error_free_type;
+	if (vm_method_verify(vmm))
+		goto error_free_line_numbers;
+
+	vmm->code_loaded = true;
 
 	return 0;
 
-error_free_type:
-	free(vmm->type);
-error_free_name:
-	free(vmm->name);
+error_free_line_numbers:
+	cafebabe_line_number_table_attribute_deinit(&vmm->line_number_table_attribute);
+	cafebabe_stack_map_table_attribute_deinit(&vmm->stack_map_table_attribute);
+	cafebabe_code_attribute_deinit(&vmm->code_attribute);
+	goto error;
+
+error_class_format_free_stack_map:
+	cafebabe_stack_map_table_attribute_deinit(&vmm->stack_map_table_attribute);
+error_class_format_free_code:
+	cafebabe_code_attribute_deinit(&vmm->code_attribute);
+error_class_format:
+	if (vm_java_lang_ClassFormatError)
+		signal_new_exception(vm_java_lang_ClassFormatError, "%s.%s%s",
+			vmm->class->name, vmm->name, vmm->type);
+error:
+	memset(&vmm->code_attribute, 0, sizeof(vmm->code_attribute));
+	memset(&vmm->stack_map_table_attribute, 0, sizeof(vmm->stack_map_table_attribute));
+	memset(&vmm->line_number_table_attribute, 0, sizeof(vmm->line_number_table_attribute));
+
+	exception = exception_occurred();
+	if (exception)
+		vmm->code_load_error = exception->class;
 
 	return -1;
 }
@@ -246,6 +334,12 @@ int vm_method_init_from_interface(struct vm_method *vmm, struct vm_class *vmc,
 	vmm->type = interface_method->type;
 
 	vmm->flags = 0;
+	vmm->code_attribute_info = NULL;
+	vmm->code_loaded = false;
+	vmm->code_load_error = NULL;
+	vmm->overridden = false;
+	vmm->cha_dependents = NULL;
+	vmm->reflection_invoker = NULL;
 
 	if (parse_method_type(vmm)) {
 		warn("method type parsing failed for: %s", vmm->type);
@@ -260,15 +354,37 @@ int vm_method_init_from_interface(struct vm_method *vmm, struct vm_class *vmc,
 	return 0;
 }
 
+static int vm_method_link_vm_native(struct vm_method *vmm, struct compilation_unit *cu)
+{
+	cu->entry_point = vm_lookup_native(vmm->class->name, vmm->name);
+	if (!cu->entry_point)
+		return -1;
+
+	cu->state = COMPILATION_STATE_COMPILED;
+
+	return add_cu_mapping((unsigned long)cu->entry_point, cu);
+}
+
+static pthread_mutex_t prepare_jit_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * Allocates the compilation unit and the JIT trampoline of a method. This is
+ * done lazily on first resolution or invocation of the method because most
+ * methods of a loaded class are never called.
+ */
 int vm_method_prepare_jit(struct vm_method *vmm)
 {
+	struct jit_trampoline *trampoline;
 	struct compilation_unit *cu;
 
+	pthread_mutex_lock(&prepare_jit_mutex);
+
+	if (vmm->trampoline)
+		goto out_unlock;
+
 	cu = compilation_unit_alloc(vmm);
 	if (!cu)
-		return -1;
-
-	vmm->compilation_unit = cu;
+		goto error_unlock;
 
 	if (method_matches_regex(vmm))
 		vmm->flags |= VM_METHOD_FLAG_TRACE;
@@ -280,24 +396,105 @@ int vm_method_prepare_jit(struct vm_method *vmm)
 	 * VM native methods are linked on initialization.
 	 */
 	if (vm_method_is_vm_native(vmm)) {
-		cu->entry_point = vm_lookup_native(vmm->class->name, vmm->name);
-
-		cu->state = COMPILATION_STATE_COMPILED;
-
-		if (add_cu_mapping((unsigned long)cu->entry_point, cu))
+		if (vm_method_link_vm_native(vmm, cu))
 			goto error_free_cu;
 	}
 
-	vmm->trampoline = build_jit_trampoline(cu);
-	if (!vmm->trampoline)
+	trampoline = build_jit_trampoline(cu);
+	if (!trampoline)
 		goto error_free_cu;
 
+	/*
+	 * Publish the compilation unit before the trampoline because
+	 * vm_method_ensure_jit() only looks at the latter.
+	 */
+	vmm->compilation_unit = cu;
+	smp_wmb();
+	vmm->trampoline = trampoline;
+
 	gdb_register_trampoline(vmm);
 
+out_unlock:
+	pthread_mutex_unlock(&prepare_jit_mutex);
+
 	return 0;
 
 error_free_cu:
 	free_compilation_unit(cu);
+error_unlock:
+	pthread_mutex_unlock(&prepare_jit_mutex);
 
 	return -1;
 }
+
+/*
+ * Replaces the compilation unit and the JIT trampoline of a method so that
+ * the next invocation through the trampoline compiles the method again.
+ * The old code stays valid for activations that are still running it.
+ */
+int vm_method_reset_jit(struct vm_method *vmm)
+{
+	struct jit_trampoline *trampoline;
+	struct compilation_unit *cu;
+
+	cu = compilation_unit_alloc(vmm);
+	if (!cu)
+		return -1;
+
+	trampoline = build_jit_trampoline(cu);
+	if (!trampoline) {
+		free_compilation_unit(cu);
+		return -1;
+	}
+
+	pthread_mutex_lock(&prepare_jit_mutex);
+
+	/*
+	 * Publish the trampoline before the compilation unit so that
+	 * vm_method_call_ptr() never pairs the new, uncompiled unit with the
+	 * old trampoline.
+	 */
+	vmm->trampoline = trampoline;
+	smp_wmb();
+	vmm->compilation_unit = cu;
+
+	gdb_register_trampoline(vmm);
+
+	pthread_mutex_unlock(&prepare_jit_mutex);
+
+	return 0;
+}
+
+int vm_method_ensure_jit(struct vm_method *vmm)
+{
+	if (vmm->trampoline) {
+		smp_rmb();
+		return 0;
+	}
+
+	return vm_method_prepare_jit(vmm);
+}
+
+void *vm_method_trampoline_ptr(struct vm_method *vmm)
+{
+	if (vm_method_ensure_jit(vmm))
+		return NULL;
+
+	return buffer_ptr(vmm->trampoline->objcode);
+}
+
+void *vm_method_call_ptr(struct vm_method *vmm)
+{
+	struct compilation_unit *cu;
+
+	if (vm_method_ensure_jit(vmm))
+		return NULL;
+
+	/* The compilation unit is replaced by vm_method_reset_jit() */
+	cu = vmm->compilation_unit;
+	smp_rmb();
+	if (compilation_unit_is_compiled(cu))
+		return cu_entry_point(cu);
+
+	return vm_method_trampoline_ptr(vmm);
+}
@@ -20,6 +20,7 @@
 #include <stdbool.h>
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 #include <ctype.h>
 #include <errno.h>
 #include <stdio.h>
@@ -383,6 +384,7 @@ void vm_object_check_array(struct vm_object *obj, jsize index)
 	if (!vm_class_is_array_class(cb)) {
 		signal_new_exception(vm_java_lang_RuntimeException,
 				     "object is not an array");
+		helper_return_on_exception();
 		return;
 	}
 
@@ -399,8 +401,9 @@ void vm_object_check_array(struct vm_object *obj, jsize index)
 		return;
 
 	sprintf(index_str, "%d > %d", index, array_len - 1);
-	signal_new_exception(vm_java_lang_ArrayIndexOutOfBoundsException,
-			     index_str);
+	signal_implicit_exception(vm_java_lang_ArrayIndexOutOfBoundsException,
+				  index_str, (unsigned long) __builtin_return_address(0));
+	helper_return_on_exception();
 }
 
 void array_store_check(struct vm_object *arrayref, struct vm_object *obj)
@@ -418,6 +421,7 @@ void array_store_check(struct vm_object *arrayref, struct vm_object *obj)
 	if (!vm_class_is_array_class(class)) {
 		signal_new_exception(vm_java_lang_RuntimeException,
 				     "object is not an array");
+		helper_return_on_exception();
 		return;
 	}
 
@@ -433,6 +437,7 @@ void array_store_check(struct vm_object *arrayref, struct vm_object *obj)
 
 	signal_new_exception(vm_java_lang_ArrayStoreException, str->value);
 	free_str(str);
+	helper_return_on_exception();
 	return;
 
  error:
@@ -460,8 +465,10 @@ void vm_object_check_cast(struct vm_object *obj, struct vm_class *class)
 	if (!obj || vm_object_is_instance_of(obj, class))
 		return;
 
-	if (exception_occurred())
+	if (exception_occurred()) {
+		helper_return_on_exception();
 		return;
+	}
 
 	str = string_from_cstr(slash_to_dots(obj->class->name));
 	if (str == NULL) {
@@ -479,6 +486,7 @@ void vm_object_check_cast(struct vm_object *obj, struct vm_class *class)
 
 	signal_new_exception(vm_java_lang_ClassCastException, str->value);
 	free_str(str);
+	helper_return_on_exception();
 	return;
  error:
 	if (str)
@@ -496,6 +504,127 @@ void array_size_check(int size)
 		return;
 
 	signal_new_exception(vm_java_lang_NegativeArraySizeException, NULL);
+	helper_return_on_exception();
+}
+
+/*
+ * Copies shorter than this many elements are done with a word loop. The
+ * call overhead of memmove() dominates for them, while for longer copies
+ * the C library picks a kernel tuned for the CPU (SSE2, AVX2, ...).
+ */
+#define ARRAY_COPY_LOOP_MAX	16
+
+/*
+ * Array elements are stored in one or two machine words, see
+ * vmtype_get_size(), so they can always be copied word by word.
+ */
+static void copy_array_elems(void *dest, const void *src, jint len, int elem_size)
+{
+	const unsigned long *s = src;
+	unsigned long *d = dest;
+	unsigned long nr_words;
+	unsigned long i;
+
+	if (len > ARRAY_COPY_LOOP_MAX) {
+		memmove(dest, src, len * elem_size);
+		return;
+	}
+
+	nr_words = len * elem_size / sizeof(unsigned long);
+
+	if (d <= s) {
+		for (i = 0; i < nr_words; i++)
+			d[i] = s[i];
+	} else {
+		for (i = nr_words; i > 0; i--)
+			d[i - 1] = s[i - 1];
+	}
+}
+
+/*
+ * Copies references to an array whose element class is not assignable
+ * from the source array's one. Each element is checked like aastore does
+ * and the copy stops at the first element that can not be stored.
+ */
+static void copy_array_refs_checked(struct vm_object **dest, struct vm_object **src,
+				    jint len, struct vm_class *elem_class)
+{
+	jint i;
+
+	for (i = 0; i < len; i++) {
+		struct vm_object *obj = src[i];
+
+		if (obj && !vm_class_is_assignable_from(elem_class, obj->class)) {
+			signal_new_exception(vm_java_lang_ArrayStoreException, NULL);
+			return;
+		}
+
+		dest[i] = obj;
+	}
+}
+
+/*
+ * Implements System.arraycopy(). Primitive arrays must have the same
+ * element type. Reference arrays are copied without per-element checks
+ * when every element of @src can be stored to @dest.
+ */
+void vm_array_copy(struct vm_object *src, jint src_start,
+		   struct vm_object *dest, jint dest_start, jint len)
+{
+	struct vm_class *src_elem_class;
+	struct vm_class *dest_elem_class;
+	void *src_elems, *dest_elems;
+	int elem_size;
+
+	if (!src || !dest) {
+		signal_new_exception(vm_java_lang_NullPointerException, NULL);
+		return;
+	}
+
+	if (!vm_class_is_array_class(src->class) ||
+	    !vm_class_is_array_class(dest->class)) {
+		signal_new_exception(vm_java_lang_ArrayStoreException, NULL);
+		return;
+	}
+
+	src_elem_class = src->class->array_element_class;
+	dest_elem_class = dest->class->array_element_class;
+
+	if (src_elem_class != dest_elem_class &&
+	    (vm_class_is_primitive_class(src_elem_class) ||
+	     vm_class_is_primitive_class(dest_elem_class))) {
+		signal_new_exception(vm_java_lang_ArrayStoreException, NULL);
+		return;
+	}
+
+	if (len < 0 || src_start < 0 || dest_start < 0 ||
+	    src_start > vm_array_length(src) - len ||
+	    dest_start > vm_array_length(dest) - len) {
+		signal_new_exception(vm_java_lang_ArrayIndexOutOfBoundsException, NULL);
+		return;
+	}
+
+	elem_size = vmtype_get_size(vm_class_get_storage_vmtype(src_elem_class));
+	src_elems = vm_array_elems(src) + src_start * elem_size;
+	dest_elems = vm_array_elems(dest) + dest_start * elem_size;
+
+	if (src_elem_class == dest_elem_class ||
+	    vm_class_is_assignable_from(dest_elem_class, src_elem_class)) {
+		copy_array_elems(dest_elems, src_elems, len, elem_size);
+		return;
+	}
+
+	copy_array_refs_checked(dest_elems, src_elems, len, dest_elem_class);
+}
+
+/*
+ * Called from JIT code for System.arraycopy(), see jit/intrinsics.c.
+ */
+void array_copy(struct vm_object *src, jint src_start,
+		struct vm_object *dest, jint dest_start, jint len)
+{
+	vm_array_copy(src, src_start, dest, dest_start, len);
+	helper_return_on_exception();
 }
 
 char *vm_string_to_cstr(const struct vm_object *string_obj)
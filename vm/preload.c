@@ -111,6 +111,7 @@ struct vm_field *vm_java_lang_Class_vmdata;
 struct vm_field *vm_java_lang_String_offset;
 struct vm_field *vm_java_lang_String_count;
 struct vm_field *vm_java_lang_String_value;
+struct vm_field *vm_java_lang_String_cachedHashCode;
 struct vm_field *vm_java_lang_Throwable_detailMessage;
 struct vm_field *vm_java_lang_VMThrowable_vmdata;
 struct vm_field *vm_java_lang_Thread_daemon;
@@ -142,6 +143,14 @@ struct vm_field *vm_java_lang_reflect_VMMethod_clazz;
 struct vm_field *vm_java_lang_reflect_VMMethod_name;
 struct vm_field *vm_java_lang_reflect_VMMethod_slot;
 struct vm_field *vm_java_lang_reflect_VMMethod_m;
+struct vm_field *vm_java_lang_Boolean_value;
+struct vm_field *vm_java_lang_Byte_value;
+struct vm_field *vm_java_lang_Character_value;
+struct vm_field *vm_java_lang_Short_value;
+struct vm_field *vm_java_lang_Integer_value;
+struct vm_field *vm_java_lang_Long_value;
+struct vm_field *vm_java_lang_Float_value;
+struct vm_field *vm_java_lang_Double_value;
 struct vm_field *vm_java_lang_ref_Reference_referent;
 struct vm_field *vm_java_lang_ref_Reference_lock;
 struct vm_field *vm_java_nio_Buffer_address;
@@ -152,6 +161,7 @@ static const struct field_preload_entry field_preload_entries[] = {
 	{ &vm_java_lang_String, "offset", "I",	&vm_java_lang_String_offset },
 	{ &vm_java_lang_String, "count", "I",	&vm_java_lang_String_count },
 	{ &vm_java_lang_String, "value", "[C",	&vm_java_lang_String_value },
+	{ &vm_java_lang_String, "cachedHashCode", "I", &vm_java_lang_String_cachedHashCode, PRELOAD_OPTIONAL },
 	{ &vm_java_lang_Throwable, "detailMessage", "Ljava/lang/String;", &vm_java_lang_Throwable_detailMessage },
 	{ &vm_java_lang_VMThrowable, "vmdata", "Ljava/lang/Object;", &vm_java_lang_VMThrowable_vmdata },
 	{ &vm_java_lang_Thread, "daemon", "Z", &vm_java_lang_Thread_daemon },
@@ -198,6 +208,19 @@ static const struct field_preload_entry field_preload_entries[] = {
 	{ &vm_java_lang_reflect_VMMethod, "m", "Ljava/lang/reflect/Method;", &vm_java_lang_reflect_VMMethod_m, PRELOAD_OPTIONAL },
 	{ &vm_java_lang_reflect_VMMethod, "name", "Ljava/lang/String;", &vm_java_lang_reflect_VMMethod_name, PRELOAD_OPTIONAL },
 	{ &vm_java_lang_reflect_VMMethod, "slot", "I", &vm_java_lang_reflect_VMMethod_slot, PRELOAD_OPTIONAL },
+
+	/*
+	 * Primitive wrappers
+	 */
+	{ &vm_java_lang_Boolean, "value", "Z", &vm_java_lang_Boolean_value },
+	{ &vm_java_lang_Byte, "value", "B", &vm_java_lang_Byte_value },
+	{ &vm_java_lang_Character, "value", "C", &vm_java_lang_Character_value },
+	{ &vm_java_lang_Short, "value", "S", &vm_java_lang_Short_value },
+	{ &vm_java_lang_Integer, "value", "I", &vm_java_lang_Integer_value },
+	{ &vm_java_lang_Long, "value", "J", &vm_java_lang_Long_value },
+	{ &vm_java_lang_Float, "value", "F", &vm_java_lang_Float_value },
+	{ &vm_java_lang_Double, "value", "D", &vm_java_lang_Double_value },
+
 	{ &vm_java_lang_ref_Reference, "referent", "Ljava/lang/Object;", &vm_java_lang_ref_Reference_referent},
 	{ &vm_java_lang_ref_Reference, "lock", "Ljava/lang/Object;", &vm_java_lang_ref_Reference_lock},
 
@@ -345,7 +368,16 @@ int preload_vm_classes(void)
 		vmm = *native_override_entries[i];
 		vmm->flags |= VM_METHOD_FLAG_VM_NATIVE;
 
+		m_info = (struct cafebabe_method_info *)vmm->method;
+		m_info->access_flags |= CAFEBABE_METHOD_ACC_NATIVE;
+
+		/*
+		 * If the compilation unit does not exist yet, it will be
+		 * linked to the VM native when it's created.
+		 */
 		cu = vmm->compilation_unit;
+		if (!cu)
+			continue;
 
 		cu->entry_point = vm_lookup_native(vmm->class->name, vmm->name);
 		if (!cu->entry_point)
@@ -356,9 +388,6 @@ int preload_vm_classes(void)
 
 		if (add_cu_mapping((unsigned long)cu->entry_point, cu))
 			return -EINVAL;
-
-		m_info = (struct cafebabe_method_info *)vmm->method;
-		m_info->access_flags |= CAFEBABE_METHOD_ACC_NATIVE;
 	}
 
 	preload_finished = true;
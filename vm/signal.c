@@ -46,14 +46,14 @@
 
 static unsigned long throw_arithmetic_exception(unsigned long src_addr)
 {
-	signal_new_exception(vm_java_lang_ArithmeticException,
-			     "division by zero");
+	signal_implicit_exception(vm_java_lang_ArithmeticException,
+				  "division by zero", src_addr);
 	return throw_from_signal_bh(src_addr);
 }
 
 static unsigned long throw_null_pointer_exception(unsigned long src_addr)
 {
-	signal_new_exception(vm_java_lang_NullPointerException, NULL);
+	signal_implicit_exception(vm_java_lang_NullPointerException, NULL, src_addr);
 	return throw_from_signal_bh(src_addr);
 }
 
@@ -103,7 +103,7 @@ static void sigsegv_handler(int sig, siginfo_t *si, void *ctx)
 
 	/* Assume that zero-page access is caused by dereferencing a
 	   null pointer */
-	if (!si->si_addr) {
+	if ((unsigned long) si->si_addr < NULL_GUARD_SIZE) {
 		/* We must be extra caucious here because IP might be
 		   invalid */
 		if (get_signal_source_cu(ctx) == NULL)
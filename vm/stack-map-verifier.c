@@ -0,0 +1,1519 @@
+/*
+ * Type checking bytecode verifier for class files with stack map frames.
+ *
+ * This file is released under the GPL version 2. Please refer to the file
+ * LICENSE for details.
+ *
+ * Class files version 50 and later describe the types of local variables
+ * and operand stack entries at every branch target and exception handler in
+ * the StackMapTable attribute. That allows a method to be checked in one
+ * linear pass over its bytecode instead of iterating data flow to a fixed
+ * point. See section 4.10.1 of the JVM specification (Java SE 7 edition).
+ *
+ * Reference types are only checked for being references. The class
+ * hierarchy is never consulted so verification never loads classes.
+ */
+
+#include "cafebabe/constant_pool.h"
+#include "cafebabe/class.h"
+
+#include "vm/bytecode.h"
+#include "vm/opcodes.h"
+#include "vm/verifier.h"
+#include "vm/method.h"
+#include "vm/class.h"
+#include "vm/system.h"
+#include "vm/die.h"
+
+#include "lib/arena.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+enum vtype_tag {
+	VTYPE_TOP,
+	VTYPE_INT,
+	VTYPE_FLOAT,
+	VTYPE_LONG,
+	VTYPE_DOUBLE,
+	VTYPE_NULL,
+	VTYPE_UNINIT_THIS,
+	VTYPE_REF,
+	VTYPE_UNINIT,
+	VTYPE_HI,		/* Upper slot of a long or double */
+	VTYPE_VOID,		/* Return type only */
+};
+
+struct vtype {
+	uint8_t			tag;
+	uint16_t		offset;	/* of 'new' for VTYPE_UNINIT */
+};
+
+struct vframe {
+	struct vtype		*locals;
+	struct vtype		*stack;
+	unsigned int		sp;
+};
+
+struct stack_map_verifier {
+	struct verifier_context	*vrf;
+	struct vm_method	*vmm;
+	const struct cafebabe_class *class;
+
+	unsigned char		*code;
+	unsigned long		code_size;
+	unsigned int		max_locals;
+	unsigned int		max_stack;
+
+	struct arena		*arena;
+
+	unsigned int		nr_frames;
+	unsigned long		*frame_offsets;
+	struct vframe		*frames;
+
+	struct vframe		cur;
+	unsigned long		pc;
+};
+
+static inline bool is_category2(uint8_t tag)
+{
+	return tag == VTYPE_LONG || tag == VTYPE_DOUBLE;
+}
+
+static inline struct vtype vtype(uint8_t tag)
+{
+	return (struct vtype) { .tag = tag };
+}
+
+static void *smv_alloc(struct stack_map_verifier *smv, size_t size)
+{
+	return arena_alloc(smv->arena, ALIGN(size, sizeof(void *)));
+}
+
+static int alloc_vframe(struct stack_map_verifier *smv, struct vframe *frame)
+{
+	unsigned int nr_slots = smv->max_locals + smv->max_stack;
+
+	frame->locals = smv_alloc(smv, sizeof(struct vtype) * (nr_slots + 1));
+	if (!frame->locals)
+		return -ENOMEM;
+
+	frame->stack = frame->locals + smv->max_locals;
+	frame->sp = 0;
+
+	return 0;
+}
+
+static void copy_vframe(struct stack_map_verifier *smv, struct vframe *dst, const struct vframe *src)
+{
+	memcpy(dst->locals, src->locals, sizeof(struct vtype) * smv->max_locals);
+	memcpy(dst->stack, src->stack, sizeof(struct vtype) * src->sp);
+	dst->sp = src->sp;
+}
+
+static bool is_assignable(struct vtype from, struct vtype to)
+{
+	if (to.tag == VTYPE_TOP)
+		return true;
+
+	if (from.tag == to.tag)
+		return from.tag != VTYPE_UNINIT || from.offset == to.offset;
+
+	return from.tag == VTYPE_NULL && to.tag == VTYPE_REF;
+}
+
+static bool locals_assignable(struct stack_map_verifier *smv, const struct vframe *from, const struct vframe *to)
+{
+	for (unsigned int i = 0; i < smv->max_locals; i++) {
+		if (!is_assignable(from->locals[i], to->locals[i]))
+			return false;
+	}
+
+	return true;
+}
+
+static bool frame_assignable(struct stack_map_verifier *smv, const struct vframe *from, const struct vframe *to)
+{
+	if (from->sp != to->sp)
+		return false;
+
+	for (unsigned int i = 0; i < from->sp; i++) {
+		if (!is_assignable(from->stack[i], to->stack[i]))
+			return false;
+	}
+
+	return locals_assignable(smv, from, to);
+}
+
+/*
+ * Descriptors
+ */
+
+static int parse_descriptor_type(const char **p, const char *end, struct vtype *t)
+{
+	const char *s = *p;
+
+	if (s >= end)
+		return -1;
+
+	switch (*s) {
+	case 'Z': case 'B': case 'C': case 'S': case 'I':
+		*t = vtype(VTYPE_INT);
+		break;
+	case 'F':
+		*t = vtype(VTYPE_FLOAT);
+		break;
+	case 'J':
+		*t = vtype(VTYPE_LONG);
+		break;
+	case 'D':
+		*t = vtype(VTYPE_DOUBLE);
+		break;
+	case 'V':
+		*t = vtype(VTYPE_VOID);
+		break;
+	case '[':
+		while (s < end && *s == '[')
+			s++;
+
+		if (s >= end || *s == 'V')
+			return -1;
+
+		if (*s != 'L')
+			break;
+		/* Fall through */
+	case 'L':
+		while (s < end && *s != ';')
+			s++;
+
+		if (s >= end)
+			return -1;
+
+		*t = vtype(VTYPE_REF);
+		break;
+	default:
+		return -1;
+	}
+
+	if (**p == '[')
+		*t = vtype(VTYPE_REF);
+
+	*p = s + 1;
+
+	return 0;
+}
+
+struct member_ref {
+	const char		*name;
+	unsigned int		name_len;
+	const char		*desc;
+	const char		*desc_end;
+};
+
+static int get_member_ref(struct stack_map_verifier *smv, uint16_t index, struct member_ref *ref)
+{
+	const struct cafebabe_constant_info_name_and_type *name_and_type;
+	const struct cafebabe_constant_info_utf8 *name, *type;
+	const struct cafebabe_constant_pool *pool;
+	uint16_t nat_index;
+
+	if (index >= smv->class->constant_pool_count)
+		return E_WRONG_CONSTANT_POOL_INDEX;
+
+	pool = &smv->class->constant_pool[index];
+
+	switch (pool->tag) {
+	case CAFEBABE_CONSTANT_TAG_FIELD_REF:
+		nat_index = pool->field_ref.name_and_type_index;
+		break;
+	case CAFEBABE_CONSTANT_TAG_METHOD_REF:
+		nat_index = pool->method_ref.name_and_type_index;
+		break;
+	case CAFEBABE_CONSTANT_TAG_INTERFACE_METHOD_REF:
+		nat_index = pool->interface_method_ref.name_and_type_index;
+		break;
+	default:
+		return E_WRONG_CONSTANT_POOL_INDEX;
+	}
+
+	if (cafebabe_class_constant_get_name_and_type(smv->class, nat_index, &name_and_type))
+		return E_WRONG_CONSTANT_POOL_INDEX;
+
+	if (cafebabe_class_constant_get_utf8(smv->class, name_and_type->name_index, &name))
+		return E_WRONG_CONSTANT_POOL_INDEX;
+
+	if (cafebabe_class_constant_get_utf8(smv->class, name_and_type->descriptor_index, &type))
+		return E_WRONG_CONSTANT_POOL_INDEX;
+
+	ref->name	= (const char *) name->bytes;
+	ref->name_len	= name->length;
+	ref->desc	= (const char *) type->bytes;
+	ref->desc_end	= ref->desc + type->length;
+
+	return 0;
+}
+
+static int expect_constant(struct stack_map_verifier *smv, uint16_t index, enum cafebabe_constant_tag tag)
+{
+	if (index >= smv->class->constant_pool_count)
+		return E_WRONG_CONSTANT_POOL_INDEX;
+
+	if (smv->class->constant_pool[index].tag != tag)
+		return E_WRONG_CONSTANT_POOL_INDEX;
+
+	return 0;
+}
+
+/*
+ * Operand stack and local variables
+ */
+
+static int push_type(struct stack_map_verifier *smv, struct vtype t)
+{
+	struct vframe *f = &smv->cur;
+	unsigned int nr = is_category2(t.tag) ? 2 : 1;
+
+	if (t.tag == VTYPE_VOID)
+		return 0;
+
+	if (f->sp + nr > smv->max_stack)
+		return vrf_err("Operand stack overflow.\n"), E_TYPE_CHECKING;
+
+	f->stack[f->sp++] = t;
+	if (nr == 2)
+		f->stack[f->sp++] = vtype(VTYPE_HI);
+
+	return 0;
+}
+
+static inline int push(struct stack_map_verifier *smv, uint8_t tag)
+{
+	return push_type(smv, vtype(tag));
+}
+
+static int pop_type(struct stack_map_verifier *smv, struct vtype expected)
+{
+	struct vframe *f = &smv->cur;
+
+	if (is_category2(expected.tag)) {
+		if (f->sp < 2 || f->stack[f->sp - 1].tag != VTYPE_HI)
+			return E_TYPE_CHECKING;
+
+		f->sp--;
+	}
+
+	if (f->sp < 1)
+		return vrf_err("Operand stack underflow.\n"), E_TYPE_CHECKING;
+
+	if (!is_assignable(f->stack[f->sp - 1], expected))
+		return E_TYPE_CHECKING;
+
+	f->sp--;
+
+	return 0;
+}
+
+static inline int pop(struct stack_map_verifier *smv, uint8_t tag)
+{
+	return pop_type(smv, vtype(tag));
+}
+
+/*
+ * Pops an initialized reference or null.
+ */
+static inline int pop_ref(struct stack_map_verifier *smv)
+{
+	return pop(smv, VTYPE_REF);
+}
+
+/*
+ * Pops any reference including uninitialized ones.
+ */
+static int pop_any_ref(struct stack_map_verifier *smv, struct vtype *t)
+{
+	struct vframe *f = &smv->cur;
+
+	if (f->sp < 1)
+		return vrf_err("Operand stack underflow.\n"), E_TYPE_CHECKING;
+
+	*t = f->stack[f->sp - 1];
+
+	switch (t->tag) {
+	case VTYPE_REF:
+	case VTYPE_NULL:
+	case VTYPE_UNINIT:
+	case VTYPE_UNINIT_THIS:
+		f->sp--;
+		return 0;
+	default:
+		return E_TYPE_CHECKING;
+	}
+}
+
+static int load_local(struct stack_map_verifier *smv, unsigned int idx, uint8_t tag)
+{
+	struct vtype *locals = smv->cur.locals;
+
+	if (idx >= smv->max_locals)
+		return E_WRONG_LOCAL_INDEX;
+
+	if (tag == VTYPE_REF) {
+		switch (locals[idx].tag) {
+		case VTYPE_REF:
+		case VTYPE_NULL:
+		case VTYPE_UNINIT:
+		case VTYPE_UNINIT_THIS:
+			return push_type(smv, locals[idx]);
+		default:
+			return E_TYPE_CHECKING;
+		}
+	}
+
+	if (locals[idx].tag != tag)
+		return E_TYPE_CHECKING;
+
+	if (is_category2(tag)) {
+		if (idx + 1 >= smv->max_locals || locals[idx + 1].tag != VTYPE_HI)
+			return E_TYPE_CHECKING;
+	}
+
+	return push(smv, tag);
+}
+
+static int store_local(struct stack_map_verifier *smv, unsigned int idx, struct vtype t)
+{
+	struct vtype *locals = smv->cur.locals;
+	unsigned int nr = is_category2(t.tag) ? 2 : 1;
+
+	if (idx + nr > smv->max_locals)
+		return E_WRONG_LOCAL_INDEX;
+
+	/* Overwriting half of a long or double invalidates the other half. */
+	if (locals[idx].tag == VTYPE_HI && idx > 0)
+		locals[idx - 1] = vtype(VTYPE_TOP);
+
+	if (is_category2(locals[idx + nr - 1].tag) && idx + nr < smv->max_locals)
+		locals[idx + nr] = vtype(VTYPE_TOP);
+
+	locals[idx] = t;
+	if (nr == 2)
+		locals[idx + 1] = vtype(VTYPE_HI);
+
+	return 0;
+}
+
+static int store(struct stack_map_verifier *smv, unsigned int idx, uint8_t tag)
+{
+	struct vtype t;
+	int err;
+
+	if (tag == VTYPE_REF) {
+		err = pop_any_ref(smv, &t);
+		if (err)
+			return err;
+
+		return store_local(smv, idx, t);
+	}
+
+	err = pop(smv, tag);
+	if (err)
+		return err;
+
+	return store_local(smv, idx, vtype(tag));
+}
+
+/*
+ * Duplicates the top @n stack slots and inserts the copy @m slots below
+ * them. Category 2 values must not be split by either boundary.
+ */
+static int dup_slots(struct stack_map_verifier *smv, unsigned int n, unsigned int m)
+{
+	struct vframe *f = &smv->cur;
+	struct vtype copy[2];
+
+	if (f->sp < n + m)
+		return vrf_err("Operand stack underflow.\n"), E_TYPE_CHECKING;
+
+	if (f->sp + n > smv->max_stack)
+		return vrf_err("Operand stack overflow.\n"), E_TYPE_CHECKING;
+
+	if (f->stack[f->sp - n].tag == VTYPE_HI)
+		return E_TYPE_CHECKING;
+
+	if (m && f->stack[f->sp - n - m].tag == VTYPE_HI)
+		return E_TYPE_CHECKING;
+
+	memcpy(copy, &f->stack[f->sp - n], sizeof(struct vtype) * n);
+	memmove(&f->stack[f->sp - n - m + n], &f->stack[f->sp - n - m], sizeof(struct vtype) * (n + m));
+	memcpy(&f->stack[f->sp - n - m], copy, sizeof(struct vtype) * n);
+
+	f->sp += n;
+
+	return 0;
+}
+
+static int pop_slots(struct stack_map_verifier *smv, unsigned int n)
+{
+	struct vframe *f = &smv->cur;
+
+	if (f->sp < n)
+		return vrf_err("Operand stack underflow.\n"), E_TYPE_CHECKING;
+
+	if (f->stack[f->sp - n].tag == VTYPE_HI)
+		return E_TYPE_CHECKING;
+
+	f->sp -= n;
+
+	return 0;
+}
+
+static int swap(struct stack_map_verifier *smv)
+{
+	struct vframe *f = &smv->cur;
+	struct vtype tmp;
+
+	if (f->sp < 2)
+		return vrf_err("Operand stack underflow.\n"), E_TYPE_CHECKING;
+
+	if (f->stack[f->sp - 1].tag == VTYPE_HI || f->stack[f->sp - 2].tag == VTYPE_HI)
+		return E_TYPE_CHECKING;
+
+	tmp			= f->stack[f->sp - 1];
+	f->stack[f->sp - 1]	= f->stack[f->sp - 2];
+	f->stack[f->sp - 2]	= tmp;
+
+	return 0;
+}
+
+/*
+ * Stack map frames
+ */
+
+static struct vframe *lookup_frame(struct stack_map_verifier *smv, unsigned long offset)
+{
+	unsigned int lo = 0, hi = smv->nr_frames;
+
+	while (lo < hi) {
+		unsigned int mid = (lo + hi) / 2;
+
+		if (smv->frame_offsets[mid] == offset)
+			return &smv->frames[mid];
+
+		if (smv->frame_offsets[mid] < offset)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return NULL;
+}
+
+static int check_branch(struct stack_map_verifier *smv, long offset)
+{
+	long target = (long) smv->pc + offset;
+	struct vframe *frame;
+
+	if (target < 0 || (unsigned long) target >= smv->code_size)
+		return E_INVALID_BRANCH;
+
+	frame = lookup_frame(smv, target);
+	if (!frame)
+		return vrf_err("No stack map frame at branch target %ld.\n", target), E_INVALID_BRANCH;
+
+	if (!frame_assignable(smv, &smv->cur, frame))
+		return vrf_err("Incompatible stack map frame at branch target %ld.\n", target), E_TYPE_CHECKING;
+
+	return 0;
+}
+
+static int convert_type_info(struct stack_map_verifier *smv, const struct cafebabe_verification_type_info *info, struct vtype *t)
+{
+	switch (info->tag) {
+	case CAFEBABE_VERIFICATION_TAG_TOP_VARIABLE_INFO:
+		*t = vtype(VTYPE_TOP);
+		break;
+	case CAFEBABE_VERIFICATION_TAG_INTEGER_VARIABLE_INFO:
+		*t = vtype(VTYPE_INT);
+		break;
+	case CAFEBABE_VERIFICATION_TAG_FLOAT_VARIABLE_INFO:
+		*t = vtype(VTYPE_FLOAT);
+		break;
+	case CAFEBABE_VERIFICATION_TAG_LONG_VARIABLE_INFO:
+		*t = vtype(VTYPE_LONG);
+		break;
+	case CAFEBABE_VERIFICATION_TAG_DOUBLE_VARIABLE_INFO:
+		*t = vtype(VTYPE_DOUBLE);
+		break;
+	case CAFEBABE_VERIFICATION_TAG_NULL_VARIABLE_INFO:
+		*t = vtype(VTYPE_NULL);
+		break;
+	case CAFEBABE_VERIFICATION_TAG_UNINITIALIZEDTHIS_VARIABLE_INFO:
+		*t = vtype(VTYPE_UNINIT_THIS);
+		break;
+	case CAFEBABE_VERIFICATION_TAG_OBJECT_VARIABLE_INFO:
+		if (expect_constant(smv, info->object.cpool_index, CAFEBABE_CONSTANT_TAG_CLASS))
+			return E_WRONG_CONSTANT_POOL_INDEX;
+
+		*t = vtype(VTYPE_REF);
+		break;
+	case CAFEBABE_VERIFICATION_TAG_UNINITIALIZED_VARIABLE_INFO:
+		if (info->uninitialized.offset >= smv->code_size || smv->code[info->uninitialized.offset] != OPC_NEW)
+			return E_TYPE_CHECKING;
+
+		*t = vtype(VTYPE_UNINIT);
+		t->offset = info->uninitialized.offset;
+		break;
+	default:
+		return E_TYPE_CHECKING;
+	}
+
+	return 0;
+}
+
+/*
+ * Stack map frames describe local variables compactly: a long or double is
+ * a single entry and trailing unused locals are omitted. @logical holds
+ * that form so chop and append frames can be applied to it.
+ */
+struct logical_locals {
+	struct vtype		*types;
+	unsigned int		nr;
+};
+
+static int expand_locals(struct stack_map_verifier *smv, const struct logical_locals *logical, struct vframe *frame)
+{
+	unsigned int slot = 0;
+
+	for (unsigned int i = 0; i < logical->nr; i++) {
+		struct vtype t = logical->types[i];
+
+		if (slot + (is_category2(t.tag) ? 2 : 1) > smv->max_locals)
+			return E_WRONG_LOCAL_INDEX;
+
+		frame->locals[slot++] = t;
+		if (is_category2(t.tag))
+			frame->locals[slot++] = vtype(VTYPE_HI);
+	}
+
+	while (slot < smv->max_locals)
+		frame->locals[slot++] = vtype(VTYPE_TOP);
+
+	return 0;
+}
+
+static int expand_stack(struct stack_map_verifier *smv, const struct cafebabe_verification_type_info *infos, unsigned int nr, struct vframe *frame)
+{
+	frame->sp = 0;
+
+	for (unsigned int i = 0; i < nr; i++) {
+		struct vtype t;
+		int err;
+
+		err = convert_type_info(smv, &infos[i], &t);
+		if (err)
+			return err;
+
+		if (frame->sp + (is_category2(t.tag) ? 2 : 1) > smv->max_stack)
+			return E_TYPE_CHECKING;
+
+		frame->stack[frame->sp++] = t;
+		if (is_category2(t.tag))
+			frame->stack[frame->sp++] = vtype(VTYPE_HI);
+	}
+
+	return 0;
+}
+
+static int append_logical(struct stack_map_verifier *smv, struct logical_locals *logical, const struct cafebabe_verification_type_info *infos, unsigned int nr)
+{
+	for (unsigned int i = 0; i < nr; i++) {
+		int err;
+
+		if (logical->nr >= smv->max_locals)
+			return E_WRONG_LOCAL_INDEX;
+
+		err = convert_type_info(smv, &infos[i], &logical->types[logical->nr]);
+		if (err)
+			return err;
+
+		logical->nr++;
+	}
+
+	return 0;
+}
+
+static int init_method_frame(struct stack_map_verifier *smv, struct logical_locals *logical)
+{
+	struct vm_method *vmm = smv->vmm;
+	const char *p, *end;
+
+	logical->nr = 0;
+
+	if (!vm_method_is_static(vmm)) {
+		struct vtype this = vtype(VTYPE_REF);
+
+		if (!strcmp(vmm->name, "<init>") && strcmp(vmm->class->name, "java/lang/Object"))
+			this = vtype(VTYPE_UNINIT_THIS);
+
+		if (smv->max_locals < 1)
+			return E_WRONG_LOCAL_INDEX;
+
+		logical->types[logical->nr++] = this;
+	}
+
+	p = vmm->type + 1;
+	end = vmm->type + strlen(vmm->type);
+
+	while (p < end && *p != ')') {
+		struct vtype t;
+
+		if (parse_descriptor_type(&p, end, &t) || t.tag == VTYPE_VOID)
+			return E_TYPE_CHECKING;
+
+		if (logical->nr >= smv->max_locals)
+			return E_WRONG_LOCAL_INDEX;
+
+		logical->types[logical->nr++] = t;
+	}
+
+	return 0;
+}
+
+static int decode_stack_map(struct stack_map_verifier *smv)
+{
+	const struct cafebabe_stack_map_table_attribute *table = &smv->vmm->stack_map_table_attribute;
+	struct logical_locals logical;
+	unsigned long offset = 0;
+	int err;
+
+	logical.types = smv_alloc(smv, sizeof(struct vtype) * (smv->max_locals + 1));
+	if (!logical.types)
+		return -ENOMEM;
+
+	err = init_method_frame(smv, &logical);
+	if (err)
+		return err;
+
+	err = alloc_vframe(smv, &smv->cur);
+	if (err)
+		return err;
+
+	err = expand_locals(smv, &logical, &smv->cur);
+	if (err)
+		return err;
+
+	smv->nr_frames = table->stack_map_frame_length;
+	if (!smv->nr_frames)
+		return 0;
+
+	smv->frame_offsets = smv_alloc(smv, sizeof(unsigned long) * smv->nr_frames);
+	smv->frames = smv_alloc(smv, sizeof(struct vframe) * smv->nr_frames);
+	if (!smv->frame_offsets || !smv->frames)
+		return -ENOMEM;
+
+	for (unsigned int i = 0; i < smv->nr_frames; i++) {
+		const struct cafebabe_stack_map_frame_entry *e = &table->stack_map_frame[i];
+		struct vframe *frame = &smv->frames[i];
+
+		offset = i ? offset + e->offset_delta + 1 : e->offset_delta;
+		if (offset >= smv->code_size)
+			return E_INVALID_BRANCH;
+
+		smv->frame_offsets[i] = offset;
+
+		err = alloc_vframe(smv, frame);
+		if (err)
+			return err;
+
+		switch (e->tag) {
+		case CAFEBABE_STACK_MAP_TAG_SAME_FRAME:
+			break;
+		case CAFEBABE_STACK_MAP_TAG_SAME_LOCAlS_1_STACK_ITEM_FRAME:
+			err = expand_stack(smv, e->same_locals_1_stack_item_frame.stack, 1, frame);
+			break;
+		case CAFEBABE_STACK_MAP_TAG_CHOP_FRAME:
+			if (e->chop_frame.chopped > logical.nr)
+				return E_TYPE_CHECKING;
+
+			logical.nr -= e->chop_frame.chopped;
+			break;
+		case CAFEBABE_STACK_MAP_TAG_APPEND_FRAME:
+			err = append_logical(smv, &logical, e->append_frame.locals, e->append_frame.nr_locals);
+			break;
+		case CAFEBABE_STACK_MAP_TAG_FULL_FRAME:
+			logical.nr = 0;
+			err = append_logical(smv, &logical, e->full_frame.locals, e->full_frame.nr_locals);
+			if (!err)
+				err = expand_stack(smv, e->full_frame.stack, e->full_frame.nr_stack_items, frame);
+			break;
+		default:
+			return E_TYPE_CHECKING;
+		}
+
+		if (err)
+			return err;
+
+		err = expand_locals(smv, &logical, frame);
+		if (err)
+			return err;
+	}
+
+	return 0;
+}
+
+/*
+ * Instructions
+ */
+
+static int check_return(struct stack_map_verifier *smv, uint8_t tag)
+{
+	const char *p = strchr(smv->vmm->type, ')');
+	struct vtype ret;
+
+	if (!p)
+		return E_TYPE_CHECKING;
+
+	p++;
+	if (parse_descriptor_type(&p, p + strlen(p), &ret))
+		return E_TYPE_CHECKING;
+
+	if (tag == VTYPE_VOID)
+		return ret.tag == VTYPE_VOID ? 0 : E_TYPE_CHECKING;
+
+	if (ret.tag != tag)
+		return E_TYPE_CHECKING;
+
+	return pop(smv, tag);
+}
+
+static int check_field_access(struct stack_map_verifier *smv, uint8_t opc)
+{
+	struct member_ref ref;
+	struct vtype field, receiver;
+	const char *p;
+	int err;
+
+	err = get_member_ref(smv, read_u16(smv->code + smv->pc + 1), &ref);
+	if (err)
+		return err;
+
+	if (smv->class->constant_pool[read_u16(smv->code + smv->pc + 1)].tag != CAFEBABE_CONSTANT_TAG_FIELD_REF)
+		return E_WRONG_CONSTANT_POOL_INDEX;
+
+	p = ref.desc;
+	if (parse_descriptor_type(&p, ref.desc_end, &field) || field.tag == VTYPE_VOID || p != ref.desc_end)
+		return E_TYPE_CHECKING;
+
+	switch (opc) {
+	case OPC_GETSTATIC:
+		return push_type(smv, field);
+	case OPC_PUTSTATIC:
+		return pop_type(smv, field);
+	case OPC_GETFIELD:
+		err = pop_ref(smv);
+		if (err)
+			return err;
+
+		return push_type(smv, field);
+	case OPC_PUTFIELD:
+		err = pop_type(smv, field);
+		if (err)
+			return err;
+
+		/* Constructors may store to fields before calling super(). */
+		err = pop_any_ref(smv, &receiver);
+		if (err)
+			return err;
+
+		if (receiver.tag == VTYPE_UNINIT)
+			return E_TYPE_CHECKING;
+
+		return 0;
+	}
+
+	return E_TYPE_CHECKING;
+}
+
+static void initialize_uninit(struct stack_map_verifier *smv, struct vtype uninit)
+{
+	struct vframe *f = &smv->cur;
+
+	for (unsigned int i = 0; i < smv->max_locals; i++) {
+		if (f->locals[i].tag == uninit.tag && f->locals[i].offset == uninit.offset)
+			f->locals[i] = vtype(VTYPE_REF);
+	}
+
+	for (unsigned int i = 0; i < f->sp; i++) {
+		if (f->stack[i].tag == uninit.tag && f->stack[i].offset == uninit.offset)
+			f->stack[i] = vtype(VTYPE_REF);
+	}
+}
+
+static int check_invoke(struct stack_map_verifier *smv, uint8_t opc)
+{
+	uint16_t index = read_u16(smv->code + smv->pc + 1);
+	struct vtype args[256], ret, receiver;
+	unsigned int nr_args = 0;
+	struct member_ref ref;
+	bool is_init;
+	const char *p;
+	int err;
+
+	err = get_member_ref(smv, index, &ref);
+	if (err)
+		return err;
+
+	if (opc == OPC_INVOKEINTERFACE) {
+		if (smv->class->constant_pool[index].tag != CAFEBABE_CONSTANT_TAG_INTERFACE_METHOD_REF)
+			return E_WRONG_CONSTANT_POOL_INDEX;
+
+		if (!smv->code[smv->pc + 3] || smv->code[smv->pc + 4])
+			return E_MALFORMED_BC;
+	} else if (smv->class->constant_pool[index].tag == CAFEBABE_CONSTANT_TAG_FIELD_REF)
+		return E_WRONG_CONSTANT_POOL_INDEX;
+
+	is_init = ref.name_len == 6 && !memcmp(ref.name, "<init>", 6);
+
+	if (ref.name_len && ref.name[0] == '<' && (!is_init || opc != OPC_INVOKESPECIAL))
+		return E_TYPE_CHECKING;
+
+	if (ref.desc >= ref.desc_end || *ref.desc != '(')
+		return E_TYPE_CHECKING;
+
+	p = ref.desc + 1;
+	while (p < ref.desc_end && *p != ')') {
+		if (nr_args >= ARRAY_SIZE(args))
+			return E_TYPE_CHECKING;
+
+		if (parse_descriptor_type(&p, ref.desc_end, &args[nr_args]) || args[nr_args].tag == VTYPE_VOID)
+			return E_TYPE_CHECKING;
+
+		nr_args++;
+	}
+
+	if (p >= ref.desc_end)
+		return E_TYPE_CHECKING;
+
+	p++;
+	if (parse_descriptor_type(&p, ref.desc_end, &ret) || p != ref.desc_end)
+		return E_TYPE_CHECKING;
+
+	while (nr_args--) {
+		err = pop_type(smv, args[nr_args]);
+		if (err)
+			return err;
+	}
+
+	if (opc != OPC_INVOKESTATIC) {
+		err = pop_any_ref(smv, &receiver);
+		if (err)
+			return err;
+
+		if (is_init) {
+			if (receiver.tag != VTYPE_UNINIT && receiver.tag != VTYPE_UNINIT_THIS)
+				return E_TYPE_CHECKING;
+
+			initialize_uninit(smv, receiver);
+		} else if (receiver.tag == VTYPE_UNINIT || receiver.tag == VTYPE_UNINIT_THIS)
+			return E_TYPE_CHECKING;
+	}
+
+	return push_type(smv, ret);
+}
+
+static int check_ldc(struct stack_map_verifier *smv, uint8_t opc)
+{
+	uint16_t index;
+	uint8_t tag;
+
+	if (opc == OPC_LDC)
+		index = read_u8(smv->code + smv->pc + 1);
+	else
+		index = read_u16(smv->code + smv->pc + 1);
+
+	if (index >= smv->class->constant_pool_count)
+		return E_WRONG_CONSTANT_POOL_INDEX;
+
+	tag = smv->class->constant_pool[index].tag;
+
+	if (opc == OPC_LDC2_W) {
+		if (tag == CAFEBABE_CONSTANT_TAG_LONG)
+			return push(smv, VTYPE_LONG);
+		if (tag == CAFEBABE_CONSTANT_TAG_DOUBLE)
+			return push(smv, VTYPE_DOUBLE);
+
+		return E_WRONG_CONSTANT_POOL_INDEX;
+	}
+
+	switch (tag) {
+	case CAFEBABE_CONSTANT_TAG_INTEGER:
+		return push(smv, VTYPE_INT);
+	case CAFEBABE_CONSTANT_TAG_FLOAT:
+		return push(smv, VTYPE_FLOAT);
+	case CAFEBABE_CONSTANT_TAG_STRING:
+	case CAFEBABE_CONSTANT_TAG_CLASS:
+		return push(smv, VTYPE_REF);
+	}
+
+	return E_WRONG_CONSTANT_POOL_INDEX;
+}
+
+static int check_switch(struct stack_map_verifier *smv, uint8_t opc)
+{
+	int err;
+
+	err = pop(smv, VTYPE_INT);
+	if (err)
+		return err;
+
+	if (opc == OPC_TABLESWITCH) {
+		struct tableswitch_info info;
+
+		get_tableswitch_info(smv->code, smv->pc, &info);
+
+		err = check_branch(smv, info.default_target);
+		for (unsigned int i = 0; !err && i < info.count; i++)
+			err = check_branch(smv, read_s32(info.targets + i * 4));
+	} else {
+		struct lookupswitch_info info;
+
+		get_lookupswitch_info(smv->code, smv->pc, &info);
+
+		err = check_branch(smv, info.default_target);
+		for (unsigned int i = 0; !err && i < info.count; i++)
+			err = check_branch(smv, read_lookupswitch_target(&info, i));
+	}
+
+	return err;
+}
+
+static const uint8_t array_load_types[] = {
+	[OPC_IALOAD - OPC_IALOAD]	= VTYPE_INT,
+	[OPC_LALOAD - OPC_IALOAD]	= VTYPE_LONG,
+	[OPC_FALOAD - OPC_IALOAD]	= VTYPE_FLOAT,
+	[OPC_DALOAD - OPC_IALOAD]	= VTYPE_DOUBLE,
+	[OPC_AALOAD - OPC_IALOAD]	= VTYPE_REF,
+	[OPC_BALOAD - OPC_IALOAD]	= VTYPE_INT,
+	[OPC_CALOAD - OPC_IALOAD]	= VTYPE_INT,
+	[OPC_SALOAD - OPC_IALOAD]	= VTYPE_INT,
+};
+
+/* Indexed by (opc - OPC_IxxX) / 4 for the typed arithmetic groups. */
+static const uint8_t arith_types[] = {
+	VTYPE_INT, VTYPE_LONG, VTYPE_FLOAT, VTYPE_DOUBLE,
+};
+
+static int check_binop(struct stack_map_verifier *smv, uint8_t tag)
+{
+	int err;
+
+	err = pop(smv, tag);
+	if (!err)
+		err = pop(smv, tag);
+	if (!err)
+		err = push(smv, tag);
+
+	return err;
+}
+
+static int check_unop(struct stack_map_verifier *smv, uint8_t from, uint8_t to)
+{
+	int err;
+
+	err = pop(smv, from);
+	if (err)
+		return err;
+
+	return push(smv, to);
+}
+
+/*
+ * Checks the instruction of @size bytes at the current pc. Operands are only
+ * read within @size so a truncated method cannot make us read past the end
+ * of the code.
+ */
+static int check_insn(struct stack_map_verifier *smv, unsigned long size,
+		      bool *falls_through)
+{
+	unsigned char *insn = smv->code + smv->pc;
+	uint8_t opc = insn[0];
+	bool wide = false;
+	unsigned int idx = 0;
+	int err;
+
+	*falls_through = true;
+
+	if (size == 0 || smv->pc + size > smv->code_size)
+		return E_MALFORMED_BC;
+
+	if (opc == OPC_WIDE) {
+		if (size < 4)
+			return E_MALFORMED_BC;
+
+		wide = true;
+		opc = insn[1];
+	}
+
+	if (wide)
+		idx = read_u16(insn + 2);
+	else if (size > 1)
+		idx = read_u8(insn + 1);
+
+	switch (opc) {
+	case OPC_NOP:
+		return 0;
+	case OPC_ACONST_NULL:
+		return push(smv, VTYPE_NULL);
+	case OPC_ICONST_M1 ... OPC_ICONST_5:
+	case OPC_BIPUSH:
+	case OPC_SIPUSH:
+		return push(smv, VTYPE_INT);
+	case OPC_LCONST_0 ... OPC_LCONST_1:
+		return push(smv, VTYPE_LONG);
+	case OPC_FCONST_0 ... OPC_FCONST_2:
+		return push(smv, VTYPE_FLOAT);
+	case OPC_DCONST_0 ... OPC_DCONST_1:
+		return push(smv, VTYPE_DOUBLE);
+	case OPC_LDC:
+	case OPC_LDC_W:
+	case OPC_LDC2_W:
+		return check_ldc(smv, opc);
+
+	case OPC_ILOAD:
+		return load_local(smv, idx, VTYPE_INT);
+	case OPC_LLOAD:
+		return load_local(smv, idx, VTYPE_LONG);
+	case OPC_FLOAD:
+		return load_local(smv, idx, VTYPE_FLOAT);
+	case OPC_DLOAD:
+		return load_local(smv, idx, VTYPE_DOUBLE);
+	case OPC_ALOAD:
+		return load_local(smv, idx, VTYPE_REF);
+	case OPC_ILOAD_0 ... OPC_ILOAD_3:
+		return load_local(smv, opc - OPC_ILOAD_0, VTYPE_INT);
+	case OPC_LLOAD_0 ... OPC_LLOAD_3:
+		return load_local(smv, opc - OPC_LLOAD_0, VTYPE_LONG);
+	case OPC_FLOAD_0 ... OPC_FLOAD_3:
+		return load_local(smv, opc - OPC_FLOAD_0, VTYPE_FLOAT);
+	case OPC_DLOAD_0 ... OPC_DLOAD_3:
+		return load_local(smv, opc - OPC_DLOAD_0, VTYPE_DOUBLE);
+	case OPC_ALOAD_0 ... OPC_ALOAD_3:
+		return load_local(smv, opc - OPC_ALOAD_0, VTYPE_REF);
+
+	case OPC_IALOAD ... OPC_SALOAD:
+		err = pop(smv, VTYPE_INT);
+		if (!err)
+			err = pop_ref(smv);
+		if (!err)
+			err = push(smv, array_load_types[opc - OPC_IALOAD]);
+		return err;
+
+	case OPC_ISTORE:
+		return store(smv, idx, VTYPE_INT);
+	case OPC_LSTORE:
+		return store(smv, idx, VTYPE_LONG);
+	case OPC_FSTORE:
+		return store(smv, idx, VTYPE_FLOAT);
+	case OPC_DSTORE:
+		return store(smv, idx, VTYPE_DOUBLE);
+	case OPC_ASTORE:
+		return store(smv, idx, VTYPE_REF);
+	case OPC_ISTORE_0 ... OPC_ISTORE_3:
+		return store(smv, opc - OPC_ISTORE_0, VTYPE_INT);
+	case OPC_LSTORE_0 ... OPC_LSTORE_3:
+		return store(smv, opc - OPC_LSTORE_0, VTYPE_LONG);
+	case OPC_FSTORE_0 ... OPC_FSTORE_3:
+		return store(smv, opc - OPC_FSTORE_0, VTYPE_FLOAT);
+	case OPC_DSTORE_0 ... OPC_DSTORE_3:
+		return store(smv, opc - OPC_DSTORE_0, VTYPE_DOUBLE);
+	case OPC_ASTORE_0 ... OPC_ASTORE_3:
+		return store(smv, opc - OPC_ASTORE_0, VTYPE_REF);
+
+	case OPC_IASTORE ... OPC_SASTORE:
+		err = pop(smv, array_load_types[opc - OPC_IASTORE]);
+		if (!err)
+			err = pop(smv, VTYPE_INT);
+		if (!err)
+			err = pop_ref(smv);
+		return err;
+
+	case OPC_POP:
+		return pop_slots(smv, 1);
+	case OPC_POP2:
+		return pop_slots(smv, 2);
+	case OPC_DUP:
+		return dup_slots(smv, 1, 0);
+	case OPC_DUP_X1:
+		return dup_slots(smv, 1, 1);
+	case OPC_DUP_X2:
+		return dup_slots(smv, 1, 2);
+	case OPC_DUP2:
+		return dup_slots(smv, 2, 0);
+	case OPC_DUP2_X1:
+		return dup_slots(smv, 2, 1);
+	case OPC_DUP2_X2:
+		return dup_slots(smv, 2, 2);
+	case OPC_SWAP:
+		return swap(smv);
+
+	case OPC_IADD ... OPC_DREM:
+		return check_binop(smv, arith_types[(opc - OPC_IADD) % 4]);
+	case OPC_INEG ... OPC_DNEG:
+		return check_unop(smv, arith_types[opc - OPC_INEG], arith_types[opc - OPC_INEG]);
+	case OPC_ISHL:
+	case OPC_ISHR:
+	case OPC_IUSHR:
+		return check_binop(smv, VTYPE_INT);
+	case OPC_LSHL:
+	case OPC_LSHR:
+	case OPC_LUSHR:
+		err = pop(smv, VTYPE_INT);
+		if (err)
+			return err;
+
+		return check_unop(smv, VTYPE_LONG, VTYPE_LONG);
+	case OPC_IAND:
+	case OPC_IOR:
+	case OPC_IXOR:
+		return check_binop(smv, VTYPE_INT);
+	case OPC_LAND:
+	case OPC_LOR:
+	case OPC_LXOR:
+		return check_binop(smv, VTYPE_LONG);
+	case OPC_IINC:
+		if (idx >= smv->max_locals || smv->cur.locals[idx].tag != VTYPE_INT)
+			return E_TYPE_CHECKING;
+		return 0;
+
+	case OPC_I2L:
+		return check_unop(smv, VTYPE_INT, VTYPE_LONG);
+	case OPC_I2F:
+		return check_unop(smv, VTYPE_INT, VTYPE_FLOAT);
+	case OPC_I2D:
+		return check_unop(smv, VTYPE_INT, VTYPE_DOUBLE);
+	case OPC_L2I:
+		return check_unop(smv, VTYPE_LONG, VTYPE_INT);
+	case OPC_L2F:
+		return check_unop(smv, VTYPE_LONG, VTYPE_FLOAT);
+	case OPC_L2D:
+		return check_unop(smv, VTYPE_LONG, VTYPE_DOUBLE);
+	case OPC_F2I:
+		return check_unop(smv, VTYPE_FLOAT, VTYPE_INT);
+	case OPC_F2L:
+		return check_unop(smv, VTYPE_FLOAT, VTYPE_LONG);
+	case OPC_F2D:
+		return check_unop(smv, VTYPE_FLOAT, VTYPE_DOUBLE);
+	case OPC_D2I:
+		return check_unop(smv, VTYPE_DOUBLE, VTYPE_INT);
+	case OPC_D2L:
+		return check_unop(smv, VTYPE_DOUBLE, VTYPE_LONG);
+	case OPC_D2F:
+		return check_unop(smv, VTYPE_DOUBLE, VTYPE_FLOAT);
+	case OPC_I2B:
+	case OPC_I2C:
+	case OPC_I2S:
+		return check_unop(smv, VTYPE_INT, VTYPE_INT);
+
+	case OPC_LCMP:
+		err = pop(smv, VTYPE_LONG);
+		if (err)
+			return err;
+		return check_unop(smv, VTYPE_LONG, VTYPE_INT);
+	case OPC_FCMPL:
+	case OPC_FCMPG:
+		err = pop(smv, VTYPE_FLOAT);
+		if (err)
+			return err;
+		return check_unop(smv, VTYPE_FLOAT, VTYPE_INT);
+	case OPC_DCMPL:
+	case OPC_DCMPG:
+		err = pop(smv, VTYPE_DOUBLE);
+		if (err)
+			return err;
+		return check_unop(smv, VTYPE_DOUBLE, VTYPE_INT);
+
+	case OPC_IFEQ ... OPC_IFLE:
+		err = pop(smv, VTYPE_INT);
+		if (err)
+			return err;
+		return check_branch(smv, read_s16(insn + 1));
+	case OPC_IF_ICMPEQ ... OPC_IF_ICMPLE:
+		err = pop(smv, VTYPE_INT);
+		if (!err)
+			err = pop(smv, VTYPE_INT);
+		if (err)
+			return err;
+		return check_branch(smv, read_s16(insn + 1));
+	case OPC_IF_ACMPEQ:
+	case OPC_IF_ACMPNE:
+		err = pop_ref(smv);
+		if (!err)
+			err = pop_ref(smv);
+		if (err)
+			return err;
+		return check_branch(smv, read_s16(insn + 1));
+	case OPC_IFNULL:
+	case OPC_IFNONNULL:
+		err = pop_ref(smv);
+		if (err)
+			return err;
+		return check_branch(smv, read_s16(insn + 1));
+	case OPC_GOTO:
+		*falls_through = false;
+		return check_branch(smv, read_s16(insn + 1));
+	case OPC_GOTO_W:
+		*falls_through = false;
+		return check_branch(smv, read_s32(insn + 1));
+	case OPC_TABLESWITCH:
+	case OPC_LOOKUPSWITCH:
+		*falls_through = false;
+		return check_switch(smv, opc);
+
+	case OPC_IRETURN:
+		*falls_through = false;
+		return check_return(smv, VTYPE_INT);
+	case OPC_LRETURN:
+		*falls_through = false;
+		return check_return(smv, VTYPE_LONG);
+	case OPC_FRETURN:
+		*falls_through = false;
+		return check_return(smv, VTYPE_FLOAT);
+	case OPC_DRETURN:
+		*falls_through = false;
+		return check_return(smv, VTYPE_DOUBLE);
+	case OPC_ARETURN:
+		*falls_through = false;
+		return check_return(smv, VTYPE_REF);
+	case OPC_RETURN:
+		*falls_through = false;
+		return check_return(smv, VTYPE_VOID);
+
+	case OPC_GETSTATIC:
+	case OPC_PUTSTATIC:
+	case OPC_GETFIELD:
+	case OPC_PUTFIELD:
+		return check_field_access(smv, opc);
+	case OPC_INVOKEVIRTUAL:
+	case OPC_INVOKESPECIAL:
+	case OPC_INVOKESTATIC:
+	case OPC_INVOKEINTERFACE:
+		return check_invoke(smv, opc);
+
+	case OPC_NEW: {
+		struct vtype t = vtype(VTYPE_UNINIT);
+
+		err = expect_constant(smv, read_u16(insn + 1), CAFEBABE_CONSTANT_TAG_CLASS);
+		if (err)
+			return err;
+
+		t.offset = smv->pc;
+
+		/* A 'new' in a loop must not leave a stale uninitialized copy. */
+		for (unsigned int i = 0; i < smv->cur.sp; i++) {
+			if (smv->cur.stack[i].tag == VTYPE_UNINIT && smv->cur.stack[i].offset == t.offset)
+				return E_TYPE_CHECKING;
+		}
+
+		for (unsigned int i = 0; i < smv->max_locals; i++) {
+			if (smv->cur.locals[i].tag == VTYPE_UNINIT && smv->cur.locals[i].offset == t.offset)
+				smv->cur.locals[i] = vtype(VTYPE_TOP);
+		}
+
+		return push_type(smv, t);
+	}
+	case OPC_NEWARRAY:
+		return check_unop(smv, VTYPE_INT, VTYPE_REF);
+	case OPC_ANEWARRAY:
+		err = expect_constant(smv, read_u16(insn + 1), CAFEBABE_CONSTANT_TAG_CLASS);
+		if (err)
+			return err;
+		return check_unop(smv, VTYPE_INT, VTYPE_REF);
+	case OPC_MULTIANEWARRAY:
+		err = expect_constant(smv, read_u16(insn + 1), CAFEBABE_CONSTANT_TAG_CLASS);
+		if (err)
+			return err;
+
+		if (!insn[3])
+			return E_MALFORMED_BC;
+
+		for (unsigned int i = 0; i < insn[3]; i++) {
+			err = pop(smv, VTYPE_INT);
+			if (err)
+				return err;
+		}
+		return push(smv, VTYPE_REF);
+	case OPC_ARRAYLENGTH:
+		return check_unop(smv, VTYPE_REF, VTYPE_INT);
+	case OPC_ATHROW:
+		*falls_through = false;
+		return pop_ref(smv);
+	case OPC_CHECKCAST:
+		err = expect_constant(smv, read_u16(insn + 1), CAFEBABE_CONSTANT_TAG_CLASS);
+		if (err)
+			return err;
+		return check_unop(smv, VTYPE_REF, VTYPE_REF);
+	case OPC_INSTANCEOF:
+		err = expect_constant(smv, read_u16(insn + 1), CAFEBABE_CONSTANT_TAG_CLASS);
+		if (err)
+			return err;
+		return check_unop(smv, VTYPE_REF, VTYPE_INT);
+	case OPC_MONITORENTER:
+	case OPC_MONITOREXIT:
+		return pop_ref(smv);
+
+	case OPC_JSR:
+	case OPC_JSR_W:
+	case OPC_RET:
+		/* Subroutines are not allowed in class files with stack maps. */
+		return vrf_err("Subroutines are not allowed with stack maps.\n"), E_TYPE_CHECKING;
+	}
+
+	return E_MALFORMED_BC;
+}
+
+static bool valid_wide_insn(const unsigned char *insn)
+{
+	switch (insn[1]) {
+	case OPC_ILOAD ... OPC_ALOAD:
+	case OPC_ISTORE ... OPC_ASTORE:
+	case OPC_IINC:
+	case OPC_RET:
+		return true;
+	}
+
+	return false;
+}
+
+static int check_handlers(struct stack_map_verifier *smv)
+{
+	const struct cafebabe_code_attribute *ca = &smv->vmm->code_attribute;
+
+	for (unsigned int i = 0; i < ca->exception_table_length; i++) {
+		const struct cafebabe_code_attribute_exception *eh = &ca->exception_table[i];
+		struct vframe *handler;
+
+		if (smv->pc < eh->start_pc || smv->pc >= eh->end_pc)
+			continue;
+
+		handler = lookup_frame(smv, eh->handler_pc);
+		if (!handler)
+			return vrf_err("No stack map frame for handler %u.\n", eh->handler_pc), E_INVALID_EXCEPTION_HANDLER;
+
+		if (handler->sp != 1 || handler->stack[0].tag != VTYPE_REF)
+			return E_INVALID_EXCEPTION_HANDLER;
+
+		if (!locals_assignable(smv, &smv->cur, handler))
+			return E_TYPE_CHECKING;
+	}
+
+	return 0;
+}
+
+static int check_exception_table(struct stack_map_verifier *smv)
+{
+	const struct cafebabe_code_attribute *ca = &smv->vmm->code_attribute;
+
+	for (unsigned int i = 0; i < ca->exception_table_length; i++) {
+		const struct cafebabe_code_attribute_exception *eh = &ca->exception_table[i];
+
+		if (eh->start_pc >= eh->end_pc || eh->end_pc > smv->code_size)
+			return E_INVALID_EXCEPTION_HANDLER;
+
+		if (eh->catch_type && expect_constant(smv, eh->catch_type, CAFEBABE_CONSTANT_TAG_CLASS))
+			return E_INVALID_EXCEPTION_HANDLER;
+	}
+
+	return 0;
+}
+
+static int check_code(struct stack_map_verifier *smv)
+{
+	unsigned int frame_ndx = 0;
+	bool reachable = true;
+	long size;
+	int err;
+
+	err = check_exception_table(smv);
+	if (err)
+		return err;
+
+	for (smv->pc = 0; smv->pc < smv->code_size; smv->pc += size) {
+		size = bc_insn_size_safe(smv->code, smv->pc, smv->code_size);
+		if (size < 0)
+			return E_MALFORMED_BC;
+
+		if (smv->code[smv->pc] == OPC_WIDE && !valid_wide_insn(smv->code + smv->pc))
+			return E_MALFORMED_BC;
+
+		if (frame_ndx < smv->nr_frames && smv->frame_offsets[frame_ndx] < smv->pc)
+			return vrf_err("Stack map frame in the middle of an instruction.\n"), E_INVALID_BRANCH;
+
+		if (frame_ndx < smv->nr_frames && smv->frame_offsets[frame_ndx] == smv->pc) {
+			struct vframe *frame = &smv->frames[frame_ndx++];
+
+			if (reachable && !frame_assignable(smv, &smv->cur, frame))
+				return vrf_err("Incompatible stack map frame.\n"), E_TYPE_CHECKING;
+
+			copy_vframe(smv, &smv->cur, frame);
+			reachable = true;
+		} else if (!reachable)
+			return vrf_err("Missing stack map frame after unconditional branch.\n"), E_TYPE_CHECKING;
+
+		err = check_handlers(smv);
+		if (err)
+			return err;
+
+		err = check_insn(smv, size, &reachable);
+		if (err)
+			return err;
+	}
+
+	if (reachable)
+		return E_FALLING_OFF;
+
+	if (frame_ndx != smv->nr_frames)
+		return vrf_err("Stack map frame past the end of code.\n"), E_INVALID_BRANCH;
+
+	return 0;
+}
+
+/*
+ * Returns true if methods of @vmm's class must be verified by type checking.
+ * Class files older than version 50 have no stack maps.
+ */
+bool vm_method_needs_type_checking(struct vm_method *vmm)
+{
+	return vmm->class->class->major_version >= 50;
+}
+
+int verify_stack_maps(struct verifier_context *vrf)
+{
+	struct stack_map_verifier smv;
+	int err;
+
+	memset(&smv, 0, sizeof(smv));
+
+	smv.vrf		= vrf;
+	smv.vmm		= vrf->method;
+	smv.class	= vrf->method->class->class;
+	smv.code	= vrf->code;
+	smv.code_size	= vrf->code_size;
+	smv.max_locals	= vrf->max_locals;
+	smv.max_stack	= vrf->max_stack;
+
+	smv.arena = arena_new();
+	if (!smv.arena)
+		return -ENOMEM;
+
+	err = decode_stack_map(&smv);
+	if (!err)
+		err = check_code(&smv);
+
+	arena_delete(smv.arena);
+
+	if (err && err != -ENOMEM)
+		verify_error(err, smv.pc, vrf);
+
+	return err;
+}
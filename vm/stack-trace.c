@@ -50,6 +50,7 @@
 #include "lib/symbol.h"
 
 #include <stdlib.h>
+#include <string.h>
 #include <stdio.h>
 
 void *vm_native_stack_offset_guard;
@@ -372,18 +373,26 @@ int get_java_stack_trace_depth(struct stack_trace_elem *elem)
 	return depth;
 }
 
+/* Number of intermediate stack trace slots collected on the C stack. */
+#define NR_STACK_TRACE_SLOTS 128
+
 /**
  * get_intermediate_stack_trace - returns an array with intermediate
  *   java stack trace. Each stack trace element is described by two
- *   consequtive elements: a pointer to struct vm_method and bytecode
- *   offset.
+ *   consequtive elements: the element type and either the return
+ *   address or, for JNI methods, a pointer to struct compilation_unit.
+ *   The stack is walked once; the elements are decoded into
+ *   java.lang.StackTraceElement only when they are asked for.
  */
 static struct vm_object *get_intermediate_stack_trace(void)
 {
+	void *slots_buf[NR_STACK_TRACE_SLOTS];
 	struct stack_trace_elem st_elem;
 	struct vm_object *array;
-	int depth;
-	int i;
+	unsigned long nr_slots;
+	unsigned long max_slots;
+	void **slots;
+	unsigned long i;
 
 	init_stack_trace_elem_current(&st_elem);
 
@@ -396,25 +405,46 @@ static struct vm_object *get_intermediate_stack_trace(void)
 	if (skip_frames_from_class(&st_elem, vm_java_lang_Throwable))
 		return NULL;
 
-	depth = get_java_stack_trace_depth(&st_elem);
-	if (depth == 0)
-		return NULL;
+	slots = slots_buf;
+	max_slots = NR_STACK_TRACE_SLOTS;
+	nr_slots = 0;
 
-	array = vm_object_alloc_primitive_array(J_NATIVE_PTR, depth * 2);
-	if (!array)
-		return NULL;
-
-	i = 0;
 	do {
-		if (st_elem.type == STACK_TRACE_ELEM_TYPE_JNI) {
-			array_set_field_ptr(array, i++, (void*) st_elem.type);
-			array_set_field_ptr(array, i++, st_elem.cu);
-		} else {
-			array_set_field_ptr(array, i++, (void*) st_elem.type);
-			array_set_field_ptr(array, i++, (void*) st_elem.addr);
+		if (nr_slots == max_slots) {
+			void **new_slots;
+
+			new_slots = malloc(sizeof(void *) * max_slots * 2);
+			if (!new_slots) {
+				array = NULL;
+				goto out;
+			}
+
+			memcpy(new_slots, slots, sizeof(void *) * nr_slots);
+			if (slots != slots_buf)
+				free(slots);
+
+			slots = new_slots;
+			max_slots *= 2;
 		}
+
+		slots[nr_slots++] = (void *) st_elem.type;
+
+		if (st_elem.type == STACK_TRACE_ELEM_TYPE_JNI)
+			slots[nr_slots++] = st_elem.cu;
+		else
+			slots[nr_slots++] = (void *) st_elem.addr;
 	} while (stack_trace_elem_next_java(&st_elem) == 0);
 
+	array = vm_object_alloc_primitive_array(J_NATIVE_PTR, nr_slots);
+	if (!array)
+		goto out;
+
+	for (i = 0; i < nr_slots; i++)
+		array_set_field_ptr(array, i, slots[i]);
+out:
+	if (slots != slots_buf)
+		free(slots);
+
 	return array;
 }
 
@@ -0,0 +1,132 @@
+/*
+ * VM startup time logging.
+ *
+ * This file is released under the GPL version 2. Please refer to the file
+ * LICENSE for details.
+ */
+
+#include "vm/startup.h"
+
+#include "vm/method.h"
+#include "vm/class.h"
+#include "vm/die.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+
+/*
+ * Report VM startup time broken down by initialization phase. The output
+ * format is stable so that tools/bench-startup.py can parse it.
+ */
+bool opt_log_startup;
+
+static const char *startup_phase_names[STARTUP_PHASE_MAX] = {
+	[STARTUP_PHASE_GC_INIT]			= "gc_init",
+	[STARTUP_PHASE_CLASSLOADER_INIT]	= "classloader_init",
+	[STARTUP_PHASE_INIT_CLASSPATH]		= "init_classpath",
+	[STARTUP_PHASE_PRELOAD_VM_CLASSES]	= "preload_vm_classes",
+	[STARTUP_PHASE_INIT_THREADING]		= "init_threading",
+};
+
+static uint64_t startup_phase_time[STARTUP_PHASE_MAX];
+
+static pthread_mutex_t startup_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t vm_start_time;
+static bool main_entered;
+
+static struct vm_method *first_compiled_method;
+static uint64_t first_compile_time;
+
+static unsigned long nr_compiled_before_main;
+static uint64_t compile_time_before_main;
+
+uint64_t startup_clock(void)
+{
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &ts))
+		die("clock_gettime");
+
+	return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void print_time(const char *what, uint64_t ns)
+{
+	fprintf(stderr, "startup: %-32s %10.3f ms\n", what, ns / 1000000.0);
+}
+
+void startup_log_init(void)
+{
+	vm_start_time = startup_clock();
+}
+
+void startup_phase_end(enum startup_phase phase, uint64_t start)
+{
+	if (!opt_log_startup)
+		return;
+
+	startup_phase_time[phase] = startup_clock() - start;
+}
+
+void startup_record_compile(struct vm_method *vmm, uint64_t start)
+{
+	uint64_t elapsed;
+
+	if (!opt_log_startup)
+		return;
+
+	elapsed = startup_clock() - start;
+
+	pthread_mutex_lock(&startup_mutex);
+
+	if (!first_compiled_method) {
+		first_compiled_method	= vmm;
+		first_compile_time	= elapsed;
+	}
+
+	if (!main_entered) {
+		nr_compiled_before_main++;
+		compile_time_before_main += elapsed;
+	}
+
+	pthread_mutex_unlock(&startup_mutex);
+}
+
+void startup_enter_main(void)
+{
+	char buf[64];
+
+	if (!opt_log_startup)
+		return;
+
+	pthread_mutex_lock(&startup_mutex);
+
+	main_entered = true;
+
+	for (unsigned int i = 0; i < STARTUP_PHASE_MAX; i++)
+		print_time(startup_phase_names[i], startup_phase_time[i]);
+
+	if (first_compiled_method) {
+		snprintf(buf, sizeof(buf), "first compile (%s.%s)",
+			 first_compiled_method->class->name,
+			 first_compiled_method->name);
+		print_time(buf, first_compile_time);
+	}
+
+	snprintf(buf, sizeof(buf), "jit (%lu methods)", nr_compiled_before_main);
+	print_time(buf, compile_time_before_main);
+
+	print_time("time-to-main", startup_clock() - vm_start_time);
+
+	pthread_mutex_unlock(&startup_mutex);
+}
+
+void startup_log_exit(void)
+{
+	if (!opt_log_startup)
+		return;
+
+	print_time("total", startup_clock() - vm_start_time);
+}
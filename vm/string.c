@@ -33,6 +33,7 @@
 #include "vm/object.h"
 #include "vm/die.h"
 #include "vm/reference.h"
+#include "vm/system.h"
 
 #include "lib/hash-map.h"
 
@@ -42,51 +43,85 @@
 static struct hash_map *literals;
 static pthread_mutex_t literals_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+static jint string_mismatch(const unsigned long *s1, const unsigned long *s2, jint count)
+{
+	jint i;
+
+	for (i = 0; i < count; i++) {
+		if ((jchar) s1[i] != (jchar) s2[i])
+			break;
+	}
+
+	return i;
+}
+
+static jint string_index_of_scalar(const unsigned long *s, jint count, jchar c)
+{
+	for (jint i = 0; i < count; i++) {
+		if ((jchar) s[i] == c)
+			return i;
+	}
+
+	return -1;
+}
+
+static jint string_hash(const unsigned long *s, jint count)
+{
+	uint32_t hash = 0;
+
+	for (jint i = 0; i < count; i++)
+		hash = 31 * hash + (jchar) s[i];
+
+	return hash;
+}
+
+/*
+ * The architecture replaces these with vectorized versions if the CPU
+ * supports them.
+ */
+struct string_ops string_ops = {
+	.mismatch	= string_mismatch,
+	.index_of	= string_index_of_scalar,
+	.hash		= string_hash,
+};
+
+static const unsigned long *string_chars(const struct vm_object *string, jint *count)
+{
+	struct vm_object *array;
+	jint offset;
+
+	*count = field_get_int(string, vm_java_lang_String_count);
+	offset = field_get_int(string, vm_java_lang_String_offset);
+	array = field_get_object(string, vm_java_lang_String_value);
+
+	return (const unsigned long *) vm_array_elems(array) + offset;
+}
+
 /*
  * Compare key1 string and key2 weak reference to string.
  */
 static bool string_obj_equals(const void *key1, const void *key2)
 {
-	struct vm_object *array1, *array2;
-	jint offset1, offset2;
+	const unsigned long *s1, *s2;
 	jint count1, count2;
 
-	count1 = field_get_int(key1, vm_java_lang_String_count);
-	count2 = field_get_int(key2, vm_java_lang_String_count);
+	s1 = string_chars(key1, &count1);
+	s2 = string_chars(key2, &count2);
 
 	if (count1 != count2)
 		return false;
 
-	offset1 = field_get_int(key1, vm_java_lang_String_offset);
-	offset2 = field_get_int(key2, vm_java_lang_String_offset);
-
-	array1 = field_get_object(key1, vm_java_lang_String_value);
-	array2 = field_get_object(key2, vm_java_lang_String_value);
-
-	int fsize = vmtype_get_size(J_CHAR);
-
-	return memcmp(vm_array_elems(array1) + offset1 * fsize,
-		      vm_array_elems(array2) + offset2 * fsize,
-		      count1 * fsize) == 0;
+	return string_ops.mismatch(s1, s2, count1) == count1;
 }
 
 static unsigned long string_obj_hash(const void *key)
 {
-	struct vm_object *array;
-	unsigned long hash;
-	jint offset;
+	const unsigned long *s;
 	jint count;
 
-	offset = field_get_int(key, vm_java_lang_String_offset);
-	count = field_get_int(key, vm_java_lang_String_count);
-	array = field_get_object(key, vm_java_lang_String_value);
-
-	hash = 0;
+	s = string_chars(key, &count);
 
-	for (jint i = 0; i < count; i++)
-		hash = 31 * hash + array_get_field_char(array, i + offset);
-
-	return hash;
+	return (uint32_t) string_ops.hash(s, count);
 }
 
 static struct key_operations string_obj_key_ops = {
@@ -128,3 +163,122 @@ struct vm_object *vm_string_intern(struct vm_object *string)
 	pthread_mutex_unlock(&literals_mutex);
 	return result;
 }
+
+/*
+ * JIT intrinsics for java.lang.String methods. String is final so the JIT
+ * calls these directly after checking @self for null.
+ */
+
+jint string_equals(struct vm_object *self, struct vm_object *other)
+{
+	const unsigned long *s1, *s2;
+	jint count1, count2;
+
+	if (self == other)
+		return true;
+
+	if (!other || other->class != vm_java_lang_String)
+		return false;
+
+	s1 = string_chars(self, &count1);
+	s2 = string_chars(other, &count2);
+
+	if (count1 != count2)
+		return false;
+
+	return string_ops.mismatch(s1, s2, count1) == count1;
+}
+
+jint string_compare_to(struct vm_object *self, struct vm_object *other)
+{
+	const unsigned long *s1, *s2;
+	jint count1, count2;
+	jint i;
+
+	if (!other) {
+		signal_new_exception(vm_java_lang_NullPointerException, NULL);
+		helper_return_on_exception();
+		return 0;
+	}
+
+	s1 = string_chars(self, &count1);
+	s2 = string_chars(other, &count2);
+
+	i = string_ops.mismatch(s1, s2, min(count1, count2));
+	if (i < min(count1, count2))
+		return (jchar) s1[i] - (jchar) s2[i];
+
+	return count1 - count2;
+}
+
+jint string_index_of_char(struct vm_object *self, jint c)
+{
+	const unsigned long *s;
+	jint count;
+
+	/* Like Classpath, supplementary characters are never found. */
+	if ((jchar) c != c)
+		return -1;
+
+	s = string_chars(self, &count);
+
+	return string_ops.index_of(s, count, c);
+}
+
+jint string_index_of(struct vm_object *self, struct vm_object *str)
+{
+	const unsigned long *s, *t;
+	jint count, len;
+	jint i, limit;
+
+	if (!str) {
+		signal_new_exception(vm_java_lang_NullPointerException, NULL);
+		helper_return_on_exception();
+		return 0;
+	}
+
+	s = string_chars(self, &count);
+	t = string_chars(str, &len);
+
+	if (len == 0)
+		return 0;
+
+	limit = count - len;
+
+	/* Find candidates by the first character, then compare the rest. */
+	for (i = 0; i <= limit; i++) {
+		jint found;
+
+		found = string_ops.index_of(s + i, limit - i + 1, (jchar) t[0]);
+		if (found < 0)
+			break;
+
+		i += found;
+
+		if (string_ops.mismatch(s + i + 1, t + 1, len - 1) == len - 1)
+			return i;
+	}
+
+	return -1;
+}
+
+jint string_hash_code(struct vm_object *self)
+{
+	const unsigned long *s;
+	jint count;
+	jint hash;
+
+	if (vm_java_lang_String_cachedHashCode) {
+		hash = field_get_int(self, vm_java_lang_String_cachedHashCode);
+		if (hash)
+			return hash;
+	}
+
+	s = string_chars(self, &count);
+	hash = string_ops.hash(s, count);
+
+	if (vm_java_lang_String_cachedHashCode)
+		field_set_int(self, vm_java_lang_String_cachedHashCode, hash);
+
+	return hash;
+}
@@ -80,9 +80,7 @@ static struct vm_thread *vm_thread_alloc(void)
 	thread->interrupted = false;
 	thread->waiting_mon = NULL;
 	thread->thread_state = VM_THREAD_STATE_CONSISTENT;
-	pthread_cond_init(&thread->park_cond, NULL);
-	pthread_mutex_init(&thread->park_mutex, NULL);
-	thread->unpark_called = false;
+	atomic_set(&thread->park_state, VM_THREAD_PARK_NONE);
 	INIT_LIST_HEAD(&thread->list_node);
 
 	return thread;
@@ -95,8 +93,6 @@ static struct vm_thread *vm_thread_alloc(void)
 static void vm_thread_free(struct vm_thread *thread)
 {
 	pthread_mutex_destroy(&thread->mutex);
-	pthread_mutex_destroy(&thread->park_mutex);
-	pthread_cond_destroy(&thread->park_cond);
 	free(thread);
 }
 
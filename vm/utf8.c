@@ -1,5 +1,9 @@
 #include "vm/utf8.h"
 
+#include "cafebabe/constant_pool.h"
+
+#include "lib/string.h"
+
 #include "vm/errors.h"
 #include "vm/object.h"
 #include "vm/types.h"
@@ -107,3 +111,18 @@ char *slash_to_dots(const char *utf)
 
 	return result;
 }
+
+/*
+ * Returns the interned copy of a constant pool UTF-8 entry. Interned strings
+ * are never freed and two equal strings always share the same pointer.
+ */
+char *utf8_intern(const struct cafebabe_constant_info_utf8 *utf8)
+{
+	struct string *str;
+
+	str = string_intern_cstrn((char *) utf8->bytes, utf8->length);
+	if (!str)
+		return NULL;
+
+	return str->value;
+}
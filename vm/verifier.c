@@ -12,6 +12,7 @@
 
 #include "vm/bytecode.h"
 #include "vm/method.h"
+#include "vm/class.h"
 #include "vm/die.h"
 #include "vm/trace.h"
 #include "vm/preload.h"
@@ -35,6 +36,7 @@ static verify_fn_t verifiers[] = {
 #undef BYTECODE
 
 bool opt_trace_verifier;
+bool opt_verify_all;
 
 static const char *vm_type_to_str(enum vm_type vm_type)
 {
@@ -673,7 +675,7 @@ static int verify_exception_table(struct cafebabe_code_attribute *ca, struct ver
 
 const static char *verify_error_string = "No error";
 
-static void verify_error(int err, unsigned long pos, struct verifier_context *vrf)
+void verify_error(int err, unsigned long pos, struct verifier_context *vrf)
 {
 	switch (err) {
 		case E_MALFORMED_BC:
@@ -973,6 +975,18 @@ int vm_method_verify(struct vm_method *vmm)
 	if (err)
 		goto out;
 
+	/*
+	 * Class files version 50 and later are type checked against their
+	 * stack map frames. Version 50 is allowed to fail over to the old
+	 * verifier (JVM spec 4.10) because early compilers emitted broken
+	 * stack maps.
+	 */
+	if (vm_method_needs_type_checking(vmm)) {
+		err = verify_stack_maps(vrf);
+		if (!err || vmm->class->class->major_version > 50)
+			goto out;
+	}
+
 	err = verifier_first_pass(vrf);
 	if (err)
 		goto out;